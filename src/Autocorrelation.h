@@ -0,0 +1,103 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Integrated autocorrelation time of a Monte Carlo time series
+///
+/// Uses Sokal's automatic windowing: the normalized autocorrelation function
+/// is summed up to the first lag M with \f$M \ge c\,\tau(M)\f$, which keeps
+/// the statistical error of the estimate small without biasing it much.
+///
+/// \done Normalized autocorrelation function
+/// \done Integrated autocorrelation time with automatic windowing
+
+/// @file Autocorrelation.h
+/// @brief Autocorrelation of Monte Carlo observables
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_AUTOCORRELATION_H_
+#define SRC_AUTOCORRELATION_H_
+
+// C++ headers
+#include <cstddef>
+#include <vector>
+
+/// Sokal's window constant
+static constexpr double AUTOCORRELATION_WINDOW = 6.0;
+
+/// @brief Autocovariance of a time series at one lag
+///
+/// @param[in] series The measurements, one per sweep
+/// @param[in] mean   The mean of **series**
+/// @param[in] lag    The lag, less than the length of **series**
+/// @returns \f$C(t)\f$, the covariance of measurements **lag** sweeps apart
+inline double autocovariance(const std::vector<double>& series,
+                             const double mean,
+                             const std::size_t lag) noexcept {
+  const auto n = series.size();
+  auto sum = 0.0;
+  for (auto i = static_cast<std::size_t>(0); i + lag < n; ++i) {
+    sum += (series[i] - mean) * (series[i + lag] - mean);
+  }
+  return sum / (n - lag);
+}  // autocovariance()
+
+/// @returns The mean of **series**
+inline double series_mean(const std::vector<double>& series) noexcept {
+  auto mean = 0.0;
+  for (const auto x : series) mean += x;
+  return series.empty() ? 0.0 : mean / series.size();
+}  // series_mean()
+
+/// @brief Normalized autocorrelation function of a time series
+///
+/// @param[in] series  The measurements, one per sweep
+/// @param[in] max_lag The largest lag computed
+/// @returns \f$\rho(t)\f$ for t = 0 .. min(max_lag, size - 1), or an empty
+/// vector if the series is constant
+inline std::vector<double> autocorrelation(const std::vector<double>& series,
+                                           const std::size_t max_lag)
+                                           noexcept {
+  const auto n = series.size();
+  std::vector<double> rho;
+  if (n < 2) return rho;
+
+  const auto mean = series_mean(series);
+  const auto variance = autocovariance(series, mean, 0);
+  if (variance <= 0.0) return rho;
+
+  const auto lags = (max_lag < n) ? max_lag + 1 : n;
+  rho.resize(lags);
+  for (auto t = static_cast<std::size_t>(0); t < lags; ++t) {
+    rho[t] = autocovariance(series, mean, t) / variance;
+  }
+  return rho;
+}  // autocorrelation()
+
+/// @brief Integrated autocorrelation time of a time series
+///
+/// \f$\tau_{int} = \frac{1}{2} + \sum_{t=1}^{M} \rho(t)\f$, so uncorrelated
+/// measurements give 1/2. Lags are only computed up to the window M.
+///
+/// @param[in] series The measurements, one per sweep
+/// @returns \f$\tau_{int}\f$ in sweeps, or 0.5 if the series is too short
+/// or constant
+inline double integrated_autocorrelation_time(
+    const std::vector<double>& series) noexcept {
+  auto tau = 0.5;
+  if (series.size() < 2) return tau;
+
+  const auto mean = series_mean(series);
+  const auto variance = autocovariance(series, mean, 0);
+  if (variance <= 0.0) return tau;
+
+  for (auto t = static_cast<std::size_t>(1); t <= series.size() / 2; ++t) {
+    tau += autocovariance(series, mean, t) / variance;
+    if (t >= AUTOCORRELATION_WINDOW * tau) break;
+  }
+  return tau;
+}  // integrated_autocorrelation_time()
+
+#endif  // SRC_AUTOCORRELATION_H_
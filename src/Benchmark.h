@@ -0,0 +1,231 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Measurements and reports shared by the benchmark programs
+///
+/// A report is a list of rows, each an ordered list of named fields, written
+/// either as CSV with a header row taken from the first row, or as a JSON
+/// array of objects.
+///
+/// Performance baselines are plain text files of "name = value" lines.
+/// Timings are divided by the time taken by a fixed calibration workload, so
+/// a baseline recorded on one machine remains meaningful on a faster or
+/// slower one. Entries named "workload.*" describe the workload measured and
+/// must match exactly before timings are compared.
+///
+/// \done Peak resident set size
+/// \done CSV and JSON reports
+/// \done Baselines with tolerances
+
+/// @file Benchmark.h
+/// @brief Measurements and reports for benchmarks
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_BENCHMARK_H_
+#define SRC_BENCHMARK_H_
+
+// C headers
+#include <sys/resource.h>
+
+// C++ headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// @returns The peak resident set size of this process in kilobytes
+inline std::int64_t peak_rss_kilobytes() noexcept {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+  // Linux reports kilobytes
+  return static_cast<std::int64_t>(usage.ru_maxrss);
+}  // peak_rss_kilobytes()
+
+/// @returns Seconds since **start**
+inline double seconds_since(
+    const std::chrono::steady_clock::time_point start) noexcept {
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}  // seconds_since()
+
+/// @brief One named value in a report row
+struct Report_field {
+  std::string name;
+  std::string value;
+  /// Numbers are written to JSON unquoted
+  bool numeric;
+};
+
+using Report_row = std::vector<Report_field>;
+
+/// @brief Adds a numeric field to a row
+template <typename T>
+inline void add_field(Report_row* const row, const std::string& name,
+                      const T value) noexcept {
+  std::ostringstream formatted;
+  formatted << value;
+  row->push_back(Report_field{name, formatted.str(), true});
+}  // add_field()
+
+/// @brief Adds a text field to a row
+inline void add_field(Report_row* const row, const std::string& name,
+                      const std::string& value) noexcept {
+  row->push_back(Report_field{name, value, false});
+}  // add_field()
+
+/// @brief Writes rows as CSV, with the field names of the first row as the
+/// header
+inline void write_csv(const std::vector<Report_row>& rows,
+                      std::ostream& os) noexcept {
+  if (rows.empty()) return;
+  for (auto i = 0u; i < rows.front().size(); ++i) {
+    os << (i ? "," : "") << rows.front()[i].name;
+  }
+  os << "\n";
+  for (const auto& row : rows) {
+    for (auto i = 0u; i < row.size(); ++i) {
+      os << (i ? "," : "") << row[i].value;
+    }
+    os << "\n";
+  }
+}  // write_csv()
+
+/// @brief Writes rows as a JSON array of objects
+inline void write_json(const std::vector<Report_row>& rows,
+                       std::ostream& os) noexcept {
+  os << "[";
+  for (auto r = 0u; r < rows.size(); ++r) {
+    os << (r ? ",\n " : "\n ") << "{";
+    for (auto i = 0u; i < rows[r].size(); ++i) {
+      const auto& field = rows[r][i];
+      os << (i ? ", " : "") << "\"" << field.name << "\": ";
+      if (field.numeric) {
+        os << field.value;
+      } else {
+        os << "\"" << field.value << "\"";
+      }
+    }
+    os << "}";
+  }
+  os << "\n]\n";
+}  // write_json()
+
+/// Named costs, where larger is worse, and "workload.*" parameters
+using Baseline = std::map<std::string, double>;
+
+/// @brief Reads a baseline of "name = value" lines; # starts a comment
+///
+/// @param[in]  path     The baseline file
+/// @param[out] baseline The entries read
+/// @returns True if the file could be read
+inline bool read_baseline(const std::string& path,
+                          Baseline* const baseline) noexcept {
+  std::ifstream file(path);
+  if (!file) return false;
+  baseline->clear();
+  std::string line;
+  while (std::getline(file, line)) {
+    line = line.substr(0, line.find('#'));
+    const auto equals = line.find('=');
+    if (equals == std::string::npos) continue;
+    std::istringstream name(line.substr(0, equals));
+    std::istringstream value(line.substr(equals + 1));
+    std::string key;
+    auto number = 0.0;
+    if (name >> key && value >> number) (*baseline)[key] = number;
+  }
+  return true;
+}  // read_baseline()
+
+/// @brief Writes a baseline which **read_baseline()** reads back exactly
+inline bool write_baseline(const std::string& path,
+                           const Baseline& baseline) noexcept {
+  std::ofstream file(path);
+  if (!file) return false;
+  file << "# Performance baseline; timings are in calibration units\n";
+  file.precision(std::numeric_limits<double>::max_digits10);
+  for (const auto& entry : baseline) {
+    file << entry.first << " = " << entry.second << "\n";
+  }
+  return static_cast<bool>(file);
+}  // write_baseline()
+
+/// @brief A cost which exceeded its baseline by more than the tolerance
+struct Regression {
+  std::string name;
+  double baseline;
+  double measured;
+};
+
+/// @returns True if every "workload.*" entry of **baseline** is measured
+/// with the same value
+inline bool same_workload(const Baseline& baseline,
+                          const Baseline& measured) noexcept {
+  for (const auto& entry : baseline) {
+    if (entry.first.compare(0, 9, "workload.") != 0) continue;
+    const auto found = measured.find(entry.first);
+    if (found == measured.end() || found->second != entry.second) {
+      return false;
+    }
+  }
+  return true;
+}  // same_workload()
+
+/// @brief Compares measured costs against a baseline
+///
+/// Costs missing from either side are skipped, so metrics can be added to a
+/// benchmark without invalidating stored baselines.
+///
+/// @param[in] baseline  The stored costs
+/// @param[in] measured  The costs just measured
+/// @param[in] tolerance Fractional slowdown allowed, e.g. 0.25 for 25%
+/// @returns The costs which regressed
+inline std::vector<Regression> find_regressions(const Baseline& baseline,
+                                                const Baseline& measured,
+                                                const double tolerance)
+                                                noexcept {
+  std::vector<Regression> regressions;
+  for (const auto& entry : measured) {
+    if (entry.first.compare(0, 9, "workload.") == 0) continue;
+    const auto found = baseline.find(entry.first);
+    if (found == baseline.end()) continue;
+    if (entry.second > found->second * (1.0 + tolerance)) {
+      regressions.push_back(Regression{entry.first, found->second,
+                                       entry.second});
+    }
+  }
+  return regressions;
+}  // find_regressions()
+
+/// @brief Times a fixed workload to normalize timings across machines
+///
+/// Sorts a million pseudo-random integers, which like the triangulation
+/// code is dominated by memory access and branches. The fastest of three
+/// repetitions is used to shed scheduling noise.
+///
+/// @returns Seconds taken by the calibration workload
+inline double calibration_seconds() noexcept {
+  auto fastest = std::numeric_limits<double>::max();
+  for (auto repetition = 0; repetition < 3; ++repetition) {
+    std::mt19937_64 engine(1);
+    std::vector<std::uint64_t> values(1 << 20);
+    for (auto& value : values) value = engine();
+    const auto start = std::chrono::steady_clock::now();
+    std::sort(values.begin(), values.end());
+    fastest = std::min(fastest, seconds_since(start));
+  }
+  return fastest;
+}  // calibration_seconds()
+
+#endif  // SRC_BENCHMARK_H_
@@ -0,0 +1,683 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// A compact, index-based triangulation data structure
+///
+/// CGAL's Triangulation_data_structure_3 keeps each cell as an object with
+/// four vertex and four neighbor pointers, its info, and its own
+/// bookkeeping, scattered wherever the compact container put it.
+/// Compact_triangulation keeps the same combinatorics as 32-bit indices in
+/// contiguous arrays instead:
+///
+/// - **cell_vertices** and **cell_neighbors**, four per cell, so a cell and
+///   its neighbors' indices share a cache line
+/// - **cell_info**, the simplex type packed into a byte
+/// - per vertex, its point, timeslice, and one incident cell
+///
+/// Vertex 0 is the infinite vertex, as in CGAL's own file format. Deleted
+/// cells go on a free list and are reused by the next cells created, so
+/// the arrays do not grow as moves are made.
+///
+/// **make_compact_triangulation()** imports a Delaunay triangulation and
+/// **export_compact_triangulation()** writes one back, cell for cell. The
+/// (2,3) and (3,2) moves make the same checks as Triangulation_3::flip():
+/// the cells around the facet or edge must be finite, every new cell
+/// positively oriented, and the new edge or facet not already present. Like
+/// Delaunay::flip() after the first move, they keep a valid triangulation
+/// that is no longer Delaunay. Stars are walked by marking each cell as it
+/// is reached, so those checks are linear in the size of the star.
+///
+/// \done Contiguous 32-bit cell and vertex arrays with a free list
+/// \done Import from and export to Delaunay
+/// \done Classification of (3,1), (2,2), and (1,3) simplices
+/// \done (2,3) and (3,2) moves with CGAL's orientation checks
+/// \done Moves for Metropolis with move_store::COMPACT
+/// \todo (2,6) and (6,2) moves, which add and remove vertices
+
+/// @file CompactTriangulation.h
+/// @brief Index-based triangulation data structure
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_COMPACTTRIANGULATION_H_
+#define SRC_COMPACTTRIANGULATION_H_
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "TimesliceIndex.h"
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+/// An absent vertex or cell
+static constexpr std::uint32_t COMPACT_NO_INDEX =
+    std::numeric_limits<std::uint32_t>::max();
+
+/// The infinite vertex
+static constexpr std::uint32_t COMPACT_INFINITE_VERTEX = 0;
+
+/// **cell_info** of a cell on the free list
+static constexpr std::uint8_t COMPACT_FREE_CELL = 0xFF;
+
+/// @brief The cells a flip removed and those it created in their place
+struct Compact_flip {
+  std::array<std::uint32_t, 3> removed;
+  std::size_t number_removed;
+  std::array<std::uint32_t, 3> created;
+  std::size_t number_created;
+};
+
+/// @brief A 3-dimensional triangulation as 32-bit indices
+class Compact_triangulation {
+ public:
+  Compact_triangulation() noexcept { clear(); }
+
+  /// @brief Removes everything but the infinite vertex
+  void clear() noexcept {
+    points_.assign(1, Point(0, 0, 0));
+    timeslices_.assign(1, 0);
+    vertex_cells_.assign(1, COMPACT_NO_INDEX);
+    cell_vertices_.clear();
+    cell_neighbors_.clear();
+    cell_info_.clear();
+    free_cells_.clear();
+    finite_cells_ = 0;
+    cell_marks_.clear();
+    mark_ = 0;
+  }
+
+  /// @brief Reserves room for **vertices** finite vertices and **cells**
+  /// cells, finite and infinite
+  void reserve(const std::size_t vertices, const std::size_t cells) noexcept {
+    points_.reserve(vertices + 1);
+    timeslices_.reserve(vertices + 1);
+    vertex_cells_.reserve(vertices + 1);
+    cell_vertices_.reserve(4 * cells);
+    cell_neighbors_.reserve(4 * cells);
+    cell_info_.reserve(cells);
+  }
+
+  /// @returns The index of a new finite vertex, in no cell yet
+  std::uint32_t add_vertex(const Point& point,
+                           const std::uint32_t timeslice) noexcept {
+    points_.push_back(point);
+    timeslices_.push_back(timeslice);
+    vertex_cells_.push_back(COMPACT_NO_INDEX);
+    return static_cast<std::uint32_t>(points_.size() - 1);
+  }
+
+  /// @brief Makes a cell, reusing a free one if there is one
+  ///
+  /// Its neighbors are COMPACT_NO_INDEX and its info is 0 until set.
+  ///
+  /// @returns The index of the cell
+  std::uint32_t create_cell(const std::uint32_t v0,
+                            const std::uint32_t v1,
+                            const std::uint32_t v2,
+                            const std::uint32_t v3) noexcept {
+    std::uint32_t c;
+    if (free_cells_.empty()) {
+      c = static_cast<std::uint32_t>(cell_info_.size());
+      cell_vertices_.resize(cell_vertices_.size() + 4);
+      cell_neighbors_.resize(cell_neighbors_.size() + 4);
+      cell_info_.push_back(0);
+      cell_marks_.push_back(0);
+    } else {
+      c = free_cells_.back();
+      free_cells_.pop_back();
+      cell_info_[c] = 0;
+    }
+    const std::array<std::uint32_t, 4> vertices{{v0, v1, v2, v3}};
+    for (auto k = 0; k < 4; ++k) {
+      cell_vertices_[4 * c + k] = vertices[k];
+      cell_neighbors_[4 * c + k] = COMPACT_NO_INDEX;
+      vertex_cells_[vertices[k]] = c;
+    }
+    if (!is_infinite(c)) finite_cells_++;
+    return c;
+  }
+
+  /// @brief Puts a cell on the free list
+  ///
+  /// Its neighbors and vertices still referring to it must be updated by
+  /// the caller.
+  void delete_cell(const std::uint32_t c) noexcept {
+    if (!is_infinite(c)) finite_cells_--;
+    for (auto k = 0; k < 4; ++k) {
+      cell_vertices_[4 * c + k] = COMPACT_NO_INDEX;
+      cell_neighbors_[4 * c + k] = COMPACT_NO_INDEX;
+    }
+    cell_info_[c] = COMPACT_FREE_CELL;
+    free_cells_.push_back(c);
+  }
+
+  void set_neighbor(const std::uint32_t c,
+                    const int k,
+                    const std::uint32_t neighbor) noexcept {
+    cell_neighbors_[4 * c + k] = neighbor;
+  }
+  void set_info(const std::uint32_t c, const std::uint8_t info) noexcept {
+    cell_info_[c] = info;
+  }
+
+  bool is_cell(const std::uint32_t c) const noexcept {
+    return c < cell_info_.size() && cell_info_[c] != COMPACT_FREE_CELL;
+  }
+  std::uint32_t vertex(const std::uint32_t c, const int k) const noexcept {
+    return cell_vertices_[4 * c + k];
+  }
+  std::uint32_t neighbor(const std::uint32_t c, const int k) const noexcept {
+    return cell_neighbors_[4 * c + k];
+  }
+  std::uint8_t info(const std::uint32_t c) const noexcept {
+    return cell_info_[c];
+  }
+  const Point& point(const std::uint32_t v) const noexcept {
+    return points_[v];
+  }
+  std::uint32_t timeslice(const std::uint32_t v) const noexcept {
+    return timeslices_[v];
+  }
+  /// @returns Some cell containing **v**
+  std::uint32_t vertex_cell(const std::uint32_t v) const noexcept {
+    return vertex_cells_[v];
+  }
+
+  /// @returns The position of **v** in **c**, or -1
+  int index(const std::uint32_t c, const std::uint32_t v) const noexcept {
+    for (auto k = 0; k < 4; ++k) {
+      if (cell_vertices_[4 * c + k] == v) return k;
+    }
+    return -1;
+  }
+
+  /// @returns The position of **c** among the neighbors of **n**, or -1
+  int neighbor_index(const std::uint32_t n,
+                     const std::uint32_t c) const noexcept {
+    for (auto k = 0; k < 4; ++k) {
+      if (cell_neighbors_[4 * n + k] == c) return k;
+    }
+    return -1;
+  }
+
+  bool is_infinite(const std::uint32_t c) const noexcept {
+    return index(c, COMPACT_INFINITE_VERTEX) >= 0;
+  }
+
+  /// @returns The number of finite vertices
+  std::size_t number_of_vertices() const noexcept {
+    return points_.size() - 1;
+  }
+  /// @returns The number of cells, finite and infinite
+  std::size_t number_of_cells() const noexcept {
+    return cell_info_.size() - free_cells_.size();
+  }
+  std::size_t number_of_finite_cells() const noexcept {
+    return finite_cells_;
+  }
+  /// @returns One more than the largest vertex index
+  std::size_t vertex_capacity() const noexcept { return points_.size(); }
+  /// @returns One more than the largest cell index
+  std::size_t cell_capacity() const noexcept { return cell_info_.size(); }
+
+  /// @returns The bytes held by every array
+  std::size_t memory_bytes() const noexcept {
+    return points_.capacity() * sizeof(Point) +
+           (timeslices_.capacity() + vertex_cells_.capacity() +
+            cell_vertices_.capacity() + cell_neighbors_.capacity() +
+            free_cells_.capacity() + cell_marks_.capacity() +
+            star_.capacity()) * sizeof(std::uint32_t) +
+           cell_info_.capacity() * sizeof(std::uint8_t);
+  }
+
+  /// @brief Classifies a cell by its vertices' timeslices, as
+  /// **classify_3_simplex()** does, storing the result in its info
+  ///
+  /// @returns 13, 22, or 31, or 0 for an infinite cell
+  std::uint8_t classify(const std::uint32_t c) noexcept {
+    if (is_infinite(c)) return cell_info_[c] = 0;
+    const auto* const v = &cell_vertices_[4 * c];
+    const auto max_time = std::max(std::max(timeslices_[v[0]],
+                                            timeslices_[v[1]]),
+                                   std::max(timeslices_[v[2]],
+                                            timeslices_[v[3]]));
+    auto max_values = 0;
+    for (auto k = 0; k < 4; ++k) {
+      if (timeslices_[v[k]] == max_time) max_values++;
+    }
+    cell_info_[c] = (max_values == 3) ? 13 : (max_values == 2) ? 22 : 31;
+    return cell_info_[c];
+  }
+
+  /// @brief Classifies every finite cell
+  ///
+  /// @param[out] N3_31 The number of (3,1) simplices
+  /// @param[out] N3_22 The number of (2,2) simplices
+  /// @param[out] N3_13 The number of (1,3) simplices
+  void classify_cells(std::uint64_t* const N3_31,
+                      std::uint64_t* const N3_22,
+                      std::uint64_t* const N3_13) noexcept {
+    *N3_31 = *N3_22 = *N3_13 = 0;
+    const auto cells = static_cast<std::uint32_t>(cell_info_.size());
+    for (auto c = static_cast<std::uint32_t>(0); c < cells; ++c) {
+      if (cell_info_[c] == COMPACT_FREE_CELL) continue;
+      switch (classify(c)) {
+        case 13:
+          ++*N3_13;
+          break;
+        case 22:
+          ++*N3_22;
+          break;
+        case 31:
+          ++*N3_31;
+          break;
+      }
+    }
+  }
+
+  /// @brief Gathers the cells containing **v** by walking its star
+  void incident_cells(const std::uint32_t v,
+                      std::vector<std::uint32_t>* const cells) const
+                      noexcept {
+    search_star(v, [](const std::uint32_t) { return false; }, cells);
+  }
+
+  /// @returns True if **u** and **v** share an edge
+  bool is_edge(const std::uint32_t u, const std::uint32_t v) noexcept {
+    return search_star(u, [this, v](const std::uint32_t c) {
+      return index(c, v) >= 0;
+    }, &star_);
+  }
+
+  /// @returns True if **u**, **v**, and **w** share a facet
+  bool is_facet(const std::uint32_t u,
+                const std::uint32_t v,
+                const std::uint32_t w) noexcept {
+    return search_star(u, [this, v, w](const std::uint32_t c) {
+      return index(c, v) >= 0 && index(c, w) >= 0;
+    }, &star_);
+  }
+
+  /// @brief Gathers the cells around the edge between vertices **i** and
+  /// **j** of **c**
+  ///
+  /// @param[out] around The cells, starting with **c**
+  /// @returns True if the edge is in exactly three cells, all finite
+  bool cells_around_edge(const std::uint32_t c,
+                         const int i,
+                         const int j,
+                         std::array<std::uint32_t, 3>* const around) const
+                         noexcept {
+    const auto u = vertex(c, i);
+    const auto v = vertex(c, j);
+
+    // Walk around the edge, leaving each cell by a facet containing it
+    auto degree = 0;
+    auto previous = COMPACT_NO_INDEX;
+    auto current = c;
+    do {
+      if (degree == 3 || is_infinite(current)) return false;
+      (*around)[degree++] = current;
+      auto next = COMPACT_NO_INDEX;
+      for (auto k = 0; k < 4; ++k) {
+        const auto w = vertex(current, k);
+        if (w == u || w == v) continue;
+        if (neighbor(current, k) != previous) {
+          next = neighbor(current, k);
+          break;
+        }
+      }
+      if (next == COMPACT_NO_INDEX) return false;
+      previous = current;
+      current = next;
+    } while (current != c);
+    return degree == 3;
+  }
+
+  /// @brief The (2,3) move: replaces the facet opposite vertex **i** of
+  /// **c** with the edge between the vertices on either side of it
+  ///
+  /// @param[out] flip The cells removed and created, or nullptr
+  /// @returns True if both cells are finite, their union is convex so that
+  /// the new cells are positively oriented, and the edge is not already in
+  /// the triangulation
+  bool flip_23(const std::uint32_t c,
+               const int i,
+               Compact_flip* const flip = nullptr) noexcept {
+    if (!is_cell(c) || is_infinite(c)) return false;
+    const auto n = neighbor(c, i);
+    if (is_infinite(n)) return false;
+    const auto top = vertex(c, i);
+    const auto bottom = vertex(n, neighbor_index(n, c));
+
+    // Each new cell is c with one facet vertex swapped for bottom, which
+    // keeps the orientation of c
+    std::array<std::array<std::uint32_t, 4>, 3> created;
+    auto made = 0;
+    for (auto k = 0; k < 4; ++k) {
+      if (k == i) continue;
+      for (auto m = 0; m < 4; ++m) created[made][m] = vertex(c, m);
+      created[made][k] = bottom;
+      if (!is_positive(created[made++])) return false;
+    }
+    if (is_edge(top, bottom)) return false;
+
+    const std::array<std::uint32_t, 2> removed{{c, n}};
+    replace_cells(removed.data(), 2, created.data(), 3, flip);
+    return true;
+  }
+
+  /// @brief The (3,2) move: replaces the edge between vertices **i** and
+  /// **j** of **c** with the facet around it
+  ///
+  /// @param[out] flip The cells removed and created, or nullptr
+  /// @returns True if the edge is in exactly three finite cells, the new
+  /// cells are positively oriented, and the facet is not already in the
+  /// triangulation
+  bool flip_32(const std::uint32_t c,
+               const int i,
+               const int j,
+               Compact_flip* const flip = nullptr) noexcept {
+    if (!is_cell(c) || is_infinite(c) || i == j) return false;
+    const auto u = vertex(c, i);
+    const auto v = vertex(c, j);
+    std::array<std::uint32_t, 3> around;
+    if (!cells_around_edge(c, i, j, &around)) return false;
+
+    // The third vertex of the new facet is the one not in c
+    auto w = COMPACT_NO_INDEX;
+    for (auto k = 0; k < 4 && w == COMPACT_NO_INDEX; ++k) {
+      const auto x = vertex(around[1], k);
+      if (x != u && x != v && index(c, x) < 0) w = x;
+    }
+    std::array<std::uint32_t, 2> facet;
+    auto f = 0;
+    for (auto k = 0; k < 4; ++k) {
+      if (k != i && k != j) facet[f++] = vertex(c, k);
+    }
+
+    // Swapping v, then u, for w keeps the orientation of c
+    std::array<std::array<std::uint32_t, 4>, 2> created;
+    for (auto m = 0; m < 4; ++m) {
+      created[0][m] = created[1][m] = vertex(c, m);
+    }
+    created[0][j] = w;
+    created[1][i] = w;
+    if (!is_positive(created[0]) || !is_positive(created[1])) return false;
+    if (is_facet(w, facet[0], facet[1])) return false;
+
+    replace_cells(around.data(), 3, created.data(), 2, flip);
+    return true;
+  }
+
+  /// @brief Checks every neighbor and incident cell relation
+  ///
+  /// @returns True if neighbors are mutual and share the facet between
+  /// them, and every vertex's incident cell contains it
+  bool is_valid() const noexcept {
+    const auto cells = static_cast<std::uint32_t>(cell_info_.size());
+    auto live = static_cast<std::size_t>(0);
+    for (auto c = static_cast<std::uint32_t>(0); c < cells; ++c) {
+      if (cell_info_[c] == COMPACT_FREE_CELL) continue;
+      live++;
+      for (auto k = 0; k < 4; ++k) {
+        if (vertex(c, k) >= points_.size()) return false;
+        const auto n = neighbor(c, k);
+        if (!is_cell(n)) return false;
+        const auto back = neighbor_index(n, c);
+        if (back < 0) return false;
+        // The facet opposite k must be the facet opposite back
+        for (auto m = 0; m < 4; ++m) {
+          if (m != k && index(n, vertex(c, m)) < 0) return false;
+        }
+        if (index(c, vertex(n, back)) >= 0) return false;
+      }
+    }
+    if (live != number_of_cells()) return false;
+    for (auto v = static_cast<std::size_t>(0); v < points_.size(); ++v) {
+      const auto c = vertex_cells_[v];
+      if (c == COMPACT_NO_INDEX) continue;
+      if (!is_cell(c) || index(c, static_cast<std::uint32_t>(v)) < 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  /// @returns True if finite vertices **cell** are positively oriented, as
+  /// CGAL requires of every cell a flip creates
+  bool is_positive(const std::array<std::uint32_t, 4>& cell) const noexcept {
+    return CGAL::orientation(points_[cell[0]], points_[cell[1]],
+                             points_[cell[2]], points_[cell[3]]) ==
+           CGAL::POSITIVE;
+  }
+
+  /// @brief Replaces a ball of cells by others with the same boundary
+  ///
+  /// The new cells are glued to each other where they share facets, and
+  /// elsewhere to the cells outside the old ones, which are then freed.
+  /// The new cells are classified, and both sets recorded in **flip** if it
+  /// is not null.
+  void replace_cells(const std::uint32_t* const removed,
+                     const std::size_t number_removed,
+                     const std::array<std::uint32_t, 4>* const created,
+                     const std::size_t number_created,
+                     Compact_flip* const flip) noexcept {
+    std::array<std::uint32_t, 3> made;
+    for (auto n = static_cast<std::size_t>(0); n < number_created; ++n) {
+      made[n] = create_cell(created[n][0], created[n][1], created[n][2],
+                            created[n][3]);
+    }
+    for (auto n = static_cast<std::size_t>(0); n < number_created; ++n) {
+      for (auto k = 0; k < 4; ++k) {
+        const auto missing = created[n][k];
+        auto glued = false;
+        for (auto m = static_cast<std::size_t>(0);
+             m < number_created && !glued; ++m) {
+          if (m != n && shares_all_but(made[m], made[n], missing)) {
+            set_neighbor(made[n], k, made[m]);
+            glued = true;
+          }
+        }
+        for (auto r = static_cast<std::size_t>(0);
+             r < number_removed && !glued; ++r) {
+          const auto old = removed[r];
+          if (!shares_all_but(old, made[n], missing)) continue;
+          // The vertex of old opposite the facet is not in it
+          auto opposite = 0;
+          for (auto m = 0; m < 4; ++m) {
+            const auto x = vertex(old, m);
+            if (x == missing || index(made[n], x) < 0) opposite = m;
+          }
+          const auto outside = neighbor(old, opposite);
+          set_neighbor(made[n], k, outside);
+          set_neighbor(outside, neighbor_index(outside, old), made[n]);
+          glued = true;
+        }
+      }
+    }
+    for (auto r = static_cast<std::size_t>(0); r < number_removed; ++r) {
+      delete_cell(removed[r]);
+    }
+    for (auto n = static_cast<std::size_t>(0); n < number_created; ++n) {
+      classify(made[n]);
+    }
+    if (flip == nullptr) return;
+    std::copy(removed, removed + number_removed, flip->removed.begin());
+    flip->number_removed = number_removed;
+    std::copy(made.begin(), made.begin() + number_created,
+              flip->created.begin());
+    flip->number_created = number_created;
+  }
+
+  /// @brief Walks the star of **v** until **found** returns true for a
+  /// cell
+  ///
+  /// Each cell is marked as it is reached, so every cell of the star is
+  /// visited once.
+  ///
+  /// @param[in]  v     The vertex
+  /// @param[in]  found Called with each cell in the order reached
+  /// @param[out] cells The cells reached
+  /// @returns True if **found** returned true
+  template <typename Found>
+  bool search_star(const std::uint32_t v,
+                   Found found,
+                   std::vector<std::uint32_t>* const cells) const noexcept {
+    cells->clear();
+    if (vertex_cells_[v] == COMPACT_NO_INDEX) return false;
+    const auto mark = next_mark();
+    cells->push_back(vertex_cells_[v]);
+    cell_marks_[vertex_cells_[v]] = mark;
+    for (auto next = static_cast<std::size_t>(0); next < cells->size();
+         ++next) {
+      const auto c = (*cells)[next];
+      if (found(c)) return true;
+      for (auto k = 0; k < 4; ++k) {
+        if (vertex(c, k) == v) continue;
+        const auto n = neighbor(c, k);
+        if (cell_marks_[n] != mark) {
+          cell_marks_[n] = mark;
+          cells->push_back(n);
+        }
+      }
+    }
+    return false;
+  }
+
+  /// @returns A mark no cell has, clearing every mark when they run out
+  std::uint32_t next_mark() const noexcept {
+    if (++mark_ == 0) {
+      std::fill(cell_marks_.begin(), cell_marks_.end(), 0);
+      mark_ = 1;
+    }
+    return mark_;
+  }
+
+  /// @returns True if **c** has every vertex of **d** but **missing**
+  bool shares_all_but(const std::uint32_t c,
+                      const std::uint32_t d,
+                      const std::uint32_t missing) const noexcept {
+    for (auto k = 0; k < 4; ++k) {
+      const auto v = vertex(d, k);
+      if (v != missing && index(c, v) < 0) return false;
+    }
+    return true;
+  }
+
+  std::vector<Point> points_;
+  std::vector<std::uint32_t> timeslices_;
+  std::vector<std::uint32_t> vertex_cells_;
+  std::vector<std::uint32_t> cell_vertices_;
+  std::vector<std::uint32_t> cell_neighbors_;
+  std::vector<std::uint8_t> cell_info_;
+  std::vector<std::uint32_t> free_cells_;
+  std::size_t finite_cells_;
+  /// The mark each cell last got from a walk of a star
+  mutable std::vector<std::uint32_t> cell_marks_;
+  mutable std::uint32_t mark_;
+  /// Scratch space for stars of vertices
+  std::vector<std::uint32_t> star_;
+};
+
+/// @brief Copies a Delaunay triangulation into a Compact_triangulation
+///
+/// Finite vertices are numbered from 1 and cells from 0 in iteration
+/// order; cell info is kept.
+///
+/// @param[in]  D3      The Delaunay triangulation
+/// @param[out] compact The compact triangulation
+/// @returns False if **D3** is not 3-dimensional
+inline bool make_compact_triangulation(
+    const Delaunay& D3,
+    Compact_triangulation* const compact) noexcept {
+  if (D3.dimension() != 3) return false;
+  compact->clear();
+  compact->reserve(D3.number_of_vertices(), D3.number_of_cells());
+
+  std::unordered_map<Vertex_handle, std::uint32_t, Handle_hash<Vertex_handle>>
+      vertex_numbers(D3.number_of_vertices() + 1);
+  vertex_numbers.emplace(D3.infinite_vertex(), COMPACT_INFINITE_VERTEX);
+  Delaunay::Finite_vertices_iterator vit;
+  for (vit = D3.finite_vertices_begin(); vit != D3.finite_vertices_end();
+       ++vit) {
+    vertex_numbers.emplace(vit, compact->add_vertex(vit->point(),
+                                                    vit->info()));
+  }
+
+  std::unordered_map<Cell_handle, std::uint32_t, Handle_hash<Cell_handle>>
+      cell_numbers(D3.number_of_cells());
+  Delaunay::Cell_iterator cit;
+  for (cit = D3.all_cells_begin(); cit != D3.all_cells_end(); ++cit) {
+    const auto c = compact->create_cell(vertex_numbers[cit->vertex(0)],
+                                        vertex_numbers[cit->vertex(1)],
+                                        vertex_numbers[cit->vertex(2)],
+                                        vertex_numbers[cit->vertex(3)]);
+    if (!D3.is_infinite(cit)) {
+      compact->set_info(c, static_cast<std::uint8_t>(cit->info()));
+    }
+    cell_numbers.emplace(cit, c);
+  }
+  for (cit = D3.all_cells_begin(); cit != D3.all_cells_end(); ++cit) {
+    const auto c = cell_numbers[cit];
+    for (auto k = 0; k < 4; ++k) {
+      compact->set_neighbor(c, k, cell_numbers[cit->neighbor(k)]);
+    }
+  }
+  return true;
+}  // make_compact_triangulation()
+
+/// @brief Rebuilds a Delaunay triangulation from a Compact_triangulation
+///
+/// The cells are created in the triangulation data structure directly, as
+/// CGAL does when reading a triangulation from a file, so the result has
+/// exactly the combinatorics of **compact** even after moves have made it
+/// no longer Delaunay.
+///
+/// @param[in]  compact The compact triangulation
+/// @param[out] D3      The Delaunay triangulation, cleared first
+inline void export_compact_triangulation(
+    const Compact_triangulation& compact,
+    Delaunay* const D3) noexcept {
+  D3->clear();
+  auto& tds = D3->tds();
+  tds.set_dimension(3);
+
+  std::vector<Vertex_handle> vertices(compact.vertex_capacity());
+  vertices[COMPACT_INFINITE_VERTEX] = D3->infinite_vertex();
+  for (auto v = static_cast<std::uint32_t>(1); v < vertices.size(); ++v) {
+    vertices[v] = tds.create_vertex();
+    vertices[v]->set_point(compact.point(v));
+    vertices[v]->info() = compact.timeslice(v);
+  }
+
+  const auto capacity = static_cast<std::uint32_t>(compact.cell_capacity());
+  std::vector<Cell_handle> cells(capacity);
+  for (auto c = static_cast<std::uint32_t>(0); c < capacity; ++c) {
+    if (!compact.is_cell(c)) continue;
+    cells[c] = tds.create_cell(vertices[compact.vertex(c, 0)],
+                               vertices[compact.vertex(c, 1)],
+                               vertices[compact.vertex(c, 2)],
+                               vertices[compact.vertex(c, 3)]);
+    cells[c]->info() = compact.info(c);
+  }
+  for (auto c = static_cast<std::uint32_t>(0); c < capacity; ++c) {
+    if (!compact.is_cell(c)) continue;
+    for (auto k = 0; k < 4; ++k) {
+      cells[c]->set_neighbor(k, cells[compact.neighbor(c, k)]);
+    }
+  }
+  for (auto v = static_cast<std::uint32_t>(0); v < vertices.size(); ++v) {
+    vertices[v]->set_cell(cells[compact.vertex_cell(v)]);
+  }
+}  // export_compact_triangulation()
+
+#endif  // SRC_COMPACTTRIANGULATION_H_
@@ -0,0 +1,246 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Runtime control of a running simulation
+///
+/// A Control_channel accepts requests to snapshot the triangulation, pause
+/// or resume, change K or Lambda, and write the move trace, so that a
+/// thermalized run never has to be killed and restarted. Requests arrive as
+/// one-line text datagrams on a Unix socket, e.g. "k 2.5", or as signals:
+/// SIGUSR1 requests a snapshot, SIGUSR2 pauses, and SIGCONT resumes. The
+/// Monte Carlo loop calls **poll()** between sweeps, which costs one
+/// non-blocking recv(2) when nothing is pending. Signal handlers only set
+/// flags.
+///
+/// \done Unix datagram socket
+/// \done Signals for snapshot, pause, and resume
+/// \done Snapshot, pause, resume, status, K, and Lambda requests
+/// \done Move trace requests
+
+/// @file Control.h
+/// @brief Runtime control channel
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_CONTROL_H_
+#define SRC_CONTROL_H_
+
+// C headers
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// C++ headers
+#include <array>
+#include <csignal>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// Longest request accepted, in bytes
+static constexpr std::size_t CONTROL_REQUEST_SIZE = 4096;
+
+enum class control_command { SNAPSHOT, PAUSE, RESUME, STATUS, SET_K,
+                             SET_LAMBDA, TRACE };
+
+/// @brief One parsed request
+struct Control_request {
+  control_command command;
+  /// The new coupling for SET_K and SET_LAMBDA
+  long double value;
+  /// The file for SNAPSHOT, or empty for a default name
+  std::string path;
+};
+
+/// @brief Parses a request such as "snapshot run.cdt", "pause", or "k 2.5"
+///
+/// @param[in]  text    The request
+/// @param[out] request The parsed request
+/// @returns True if **text** is a valid request
+inline bool parse_control_request(const std::string& text,
+                                  Control_request* const request) noexcept {
+  std::istringstream words(text);
+  std::string command;
+  if (!(words >> command)) return false;
+  request->value = 0;
+  request->path.clear();
+  if (command == "snapshot") {
+    request->command = control_command::SNAPSHOT;
+    words >> request->path;
+    return true;
+  }
+  if (command == "pause") {
+    request->command = control_command::PAUSE;
+    return true;
+  }
+  if (command == "resume") {
+    request->command = control_command::RESUME;
+    return true;
+  }
+  if (command == "status") {
+    request->command = control_command::STATUS;
+    return true;
+  }
+  if (command == "k" || command == "K") {
+    request->command = control_command::SET_K;
+    return static_cast<bool>(words >> request->value);
+  }
+  if (command == "lambda") {
+    request->command = control_command::SET_LAMBDA;
+    return static_cast<bool>(words >> request->value);
+  }
+  if (command == "trace") {
+    request->command = control_command::TRACE;
+    return true;
+  }
+  return false;
+}  // parse_control_request()
+
+/// @returns Flags set by the control signal handler, indexed by
+/// **control_command**; only SNAPSHOT, PAUSE, and RESUME are used
+inline volatile std::sig_atomic_t* control_signal_flags() noexcept {
+  static volatile std::sig_atomic_t flags[3] = {0, 0, 0};
+  return flags;
+}  // control_signal_flags()
+
+/// @brief Records a control signal for the next **poll()**
+inline void control_signal_handler(const int signal) noexcept {
+  auto* flags = control_signal_flags();
+  if (signal == SIGUSR1) {
+    flags[static_cast<int>(control_command::SNAPSHOT)] = 1;
+  } else if (signal == SIGUSR2) {
+    flags[static_cast<int>(control_command::PAUSE)] = 1;
+  } else if (signal == SIGCONT) {
+    flags[static_cast<int>(control_command::RESUME)] = 1;
+  }
+}  // control_signal_handler()
+
+/// @brief Receives control requests from signals and a Unix socket
+class Control_channel {
+ public:
+  /// @param[in] path The socket to create, or empty for signals only
+  explicit Control_channel(const std::string& path) noexcept
+      : path_(path), fd_(-1) {
+    // Touch the flags so the handler never initializes them
+    control_signal_flags();
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = control_signal_handler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    for (auto i = 0u; i < signals_.size(); ++i) {
+      sigaction(signals_[i], &action, &previous_[i]);
+    }
+
+    if (path_.empty()) return;
+    struct sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path_.size() >= sizeof(address.sun_path)) return;
+    std::strncpy(address.sun_path, path_.c_str(),
+                 sizeof(address.sun_path) - 1);
+    fd_ = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if (fd_ < 0) return;
+    unlink(path_.c_str());
+    if (bind(fd_, reinterpret_cast<struct sockaddr*>(&address),
+             sizeof(address)) != 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+  }
+
+  ~Control_channel() {
+    for (auto i = 0u; i < signals_.size(); ++i) {
+      sigaction(signals_[i], &previous_[i], nullptr);
+    }
+    if (fd_ < 0) return;
+    close(fd_);
+    unlink(path_.c_str());
+  }
+
+  Control_channel(const Control_channel&) = delete;
+  Control_channel& operator=(const Control_channel&) = delete;
+
+  /// @returns True if the socket is listening
+  bool listening() const noexcept { return fd_ >= 0; }
+
+  const std::string& path() const noexcept { return path_; }
+
+  /// @brief Collects pending requests
+  ///
+  /// @param[out] requests   Requests received, in order; invalid ones are
+  ///                        dropped
+  /// @param[in]  timeout_ms Milliseconds to wait if nothing is pending,
+  ///                        e.g. while paused; 0 never blocks
+  void poll(std::vector<Control_request>* const requests,
+            const int timeout_ms) noexcept {
+    requests->clear();
+    take_signals(requests);
+    if (requests->empty() && timeout_ms > 0) {
+      struct pollfd descriptor{fd_, POLLIN, 0};
+      // Signals interrupt the wait, so they are never delayed by it
+      ::poll(fd_ >= 0 ? &descriptor : nullptr, fd_ >= 0 ? 1 : 0,
+             timeout_ms);
+      take_signals(requests);
+    }
+    if (fd_ < 0) return;
+
+    std::array<char, CONTROL_REQUEST_SIZE> buffer;
+    for (;;) {
+      const auto received = recv(fd_, buffer.data(), buffer.size() - 1,
+                                 MSG_DONTWAIT);
+      if (received < 0) break;
+      Control_request request;
+      if (parse_control_request(std::string(buffer.data(), received),
+                                &request)) {
+        requests->push_back(request);
+      }
+    }
+  }
+
+ private:
+  /// @brief Turns signal flags into requests and clears them
+  void take_signals(std::vector<Control_request>* const requests) noexcept {
+    auto* flags = control_signal_flags();
+    for (const auto command : {control_command::SNAPSHOT,
+                               control_command::PAUSE,
+                               control_command::RESUME}) {
+      if (flags[static_cast<int>(command)] == 0) continue;
+      flags[static_cast<int>(command)] = 0;
+      requests->push_back(Control_request{command, 0, std::string()});
+    }
+  }
+
+  std::string path_;
+  int fd_;
+  const std::array<int, 3> signals_{{SIGUSR1, SIGUSR2, SIGCONT}};
+  std::array<struct sigaction, 3> previous_;
+};
+
+/// @brief Sends a request to a running simulation
+///
+/// @param[in] path The simulation's control socket
+/// @param[in] text The request
+/// @returns True if the request was delivered
+inline bool send_control(const std::string& path,
+                         const std::string& text) noexcept {
+  struct sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) return false;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  const auto fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (fd < 0) return false;
+  const auto sent = sendto(fd, text.data(), text.size(), 0,
+                           reinterpret_cast<struct sockaddr*>(&address),
+                           sizeof(address));
+  close(fd);
+  return sent == static_cast<ssize_t>(text.size());
+}  // send_control()
+
+#endif  // SRC_CONTROL_H_
@@ -0,0 +1,252 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Differential testing of the Metropolis engine against plain flips
+///
+/// Two copies are made of the same universe. The optimized copy is evolved
+/// by Metropolis, with its Timeslice_index, incremental counts, and whichever
+/// sweep is selected. Every move it accepts is mirrored onto the reference
+/// copy by calling **Delaunay::flip()** directly on the corresponding cell,
+/// found from its vertices. Periodically both copies are recounted with
+/// **classify_edges()** and **classify_3_simplices()**, the incremental counts
+/// and the index are checked against a rebuild, and an order-independent
+/// hash of each triangulation is compared. Any optimization of the move
+/// engine which changes what it does shows up as a difference.
+///
+/// \done Mirror accepted moves onto a reference triangulation
+/// \done Compare counts, index, and state hash
+
+/// @file Differential.h
+/// @brief Differential tester for move engines
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_DIFFERENTIAL_H_
+#define SRC_DIFFERENTIAL_H_
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "TimesliceIndex.h"
+#include "Metropolis.h"
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+/// @returns **x** thoroughly mixed, by the SplitMix64 finalizer
+inline std::uint64_t mix_hash(std::uint64_t x) noexcept {
+  x += 0x9e3779b97f4a7c15ull;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}  // mix_hash()
+
+/// @returns A hash of a vertex's position and timeslice
+inline std::uint64_t vertex_hash(const Vertex_handle& vertex) noexcept {
+  auto hash = mix_hash(vertex->info());
+  const auto& point = vertex->point();
+  for (const double coordinate : {point.x(), point.y(), point.z()}) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &coordinate, sizeof(bits));
+    hash = mix_hash(hash ^ bits);
+  }
+  return hash;
+}  // vertex_hash()
+
+/// @brief Hashes the combinatorial state of a triangulation
+///
+/// Each finite cell is hashed from the sorted hashes of its vertices, and
+/// the cell hashes are summed, so the result does not depend on where CGAL
+/// stored anything. Two triangulations of the same points with the same
+/// cells hash equally.
+///
+/// @param[in] D3 The Delaunay triangulation
+/// @returns The state hash
+inline std::uint64_t triangulation_hash(const Delaunay& D3) noexcept {
+  auto hash = mix_hash(D3.number_of_vertices());
+  Delaunay::Finite_cells_iterator cit;
+  for (cit = D3.finite_cells_begin(); cit != D3.finite_cells_end(); ++cit) {
+    std::array<std::uint64_t, 4> vertices;
+    for (auto k = 0; k < 4; ++k) vertices[k] = vertex_hash(cit->vertex(k));
+    std::sort(vertices.begin(), vertices.end());
+    auto cell = static_cast<std::uint64_t>(0);
+    for (const auto v : vertices) cell = mix_hash(cell ^ v);
+    hash += cell;
+  }
+  return hash;
+}  // triangulation_hash()
+
+/// @brief Counts of a triangulation from a full recount
+struct Triangulation_counts {
+  unsigned N1_TL;
+  unsigned N1_SL;
+  std::size_t N3_31;
+  std::size_t N3_22;
+  std::size_t N3_13;
+};
+
+/// @brief Recounts edges and simplices with the classification functions
+///
+/// @param[in] D3 The Delaunay triangulation; its cell infos are refreshed
+/// @returns The counts
+inline Triangulation_counts classify_counts(Delaunay* const D3) noexcept {
+  Triangulation_counts counts{0, 0, 0, 0, 0};
+  classify_edges(*D3, &counts.N1_TL, &counts.N1_SL);
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  classify_3_simplices(D3, &three_one, &two_two, &one_three);
+  counts.N3_31 = three_one.size();
+  counts.N3_22 = two_two.size();
+  counts.N3_13 = one_three.size();
+  return counts;
+}  // classify_counts()
+
+/// @brief Evolves a universe with Metropolis and with plain flips in step
+class Differential_tester {
+ public:
+  /// @param[in] universe     The starting triangulation; it is copied twice
+  /// @param[in] timeslices   The number of timeslices
+  /// @param[in] coefficients The bulk action coefficients
+  /// @param[in] seed         Seed for the Metropolis random numbers
+  Differential_tester(const Delaunay& universe,
+                      const unsigned timeslices,
+                      const Action_coefficients& coefficients,
+                      const std::uint64_t seed) noexcept
+      : reference_(universe),
+        optimized_(universe),
+        timeslices_(timeslices),
+        moves_(0),
+        made_(0),
+        unmatched_(0) {
+    // Moves never create or destroy vertices, so they are matched once
+    Delaunay::All_vertices_iterator rit = reference_.all_vertices_begin();
+    Delaunay::All_vertices_iterator oit = optimized_.all_vertices_begin();
+    for (; oit != optimized_.all_vertices_end(); ++oit, ++rit) {
+      vertices_.emplace(oit, rit);
+    }
+    make_timeslice_index(optimized_, timeslices_, &index_);
+    metropolis_.reset(new Metropolis(&optimized_, &index_, coefficients,
+                                     seed));
+    metropolis_->set_move_observer(
+        [this](const Move_proposal& proposal) { mirror(proposal); });
+  }
+
+  Differential_tester(const Differential_tester&) = delete;
+  Differential_tester& operator=(const Differential_tester&) = delete;
+
+  /// @returns The optimized engine, to be swept as usual
+  Metropolis& optimized() noexcept { return *metropolis_; }
+
+  /// @brief Compares the two triangulations
+  ///
+  /// @param[out] difference A description of every difference found
+  /// @returns True if the triangulations, counts, and index agree
+  bool check(std::string* const difference) noexcept {
+    std::ostringstream report;
+    if (unmatched_ != 0) {
+      report << unmatched_ << " moves had no matching reference cell. ";
+    }
+
+    const auto reference = classify_counts(&reference_);
+    const auto optimized = classify_counts(&optimized_);
+    compare(&report, "classify_edges() N1_TL", reference.N1_TL,
+            optimized.N1_TL);
+    compare(&report, "classify_edges() N1_SL", reference.N1_SL,
+            optimized.N1_SL);
+    compare(&report, "classify_3_simplices() (3,1)", reference.N3_31,
+            optimized.N3_31);
+    compare(&report, "classify_3_simplices() (2,2)", reference.N3_22,
+            optimized.N3_22);
+    compare(&report, "classify_3_simplices() (1,3)", reference.N3_13,
+            optimized.N3_13);
+    compare(&report, "state hash", triangulation_hash(reference_),
+            triangulation_hash(optimized_));
+
+    // The incremental counts and index must match a rebuild
+    Timeslice_index rebuilt;
+    make_timeslice_index(optimized_, timeslices_, &rebuilt);
+    auto N3_31 = static_cast<std::uint64_t>(0);
+    auto N3_22 = static_cast<std::uint64_t>(0);
+    for (auto t = 0u; t < rebuilt.two_two.size(); ++t) {
+      N3_31 += rebuilt.three_one[t].size() + rebuilt.one_three[t].size();
+      N3_22 += rebuilt.two_two[t].size();
+      compare(&report, "indexed cells in slab " + std::to_string(t),
+              number_of_cells_in_slab(rebuilt, t),
+              number_of_cells_in_slab(index_, t));
+    }
+    compare(&report, "incremental N1_TL", optimized.N1_TL,
+            metropolis_->N1_TL());
+    compare(&report, "incremental N3_31", N3_31, metropolis_->N3_31());
+    compare(&report, "incremental N3_22", N3_22, metropolis_->N3_22());
+
+    *difference = report.str();
+    return difference->empty();
+  }
+
+  /// @returns The number of accepted moves mirrored
+  std::uint64_t moves() const noexcept { return moves_; }
+  /// @returns The number of mirrored moves CGAL made on the reference
+  std::uint64_t made() const noexcept { return made_; }
+
+ private:
+  /// @brief Makes **proposal** on the reference triangulation
+  void mirror(const Move_proposal& proposal) noexcept {
+    moves_++;
+    const auto& cell = proposal.cell;
+    Cell_handle reference;
+    int i0, i1, i2, i3;
+    if (!reference_.is_cell(vertices_[cell->vertex(0)],
+                            vertices_[cell->vertex(1)],
+                            vertices_[cell->vertex(2)],
+                            vertices_[cell->vertex(3)],
+                            reference, i0, i1, i2, i3)) {
+      unmatched_++;
+      return;
+    }
+    const auto i = reference->index(vertices_[cell->vertex(proposal.i)]);
+    auto made = false;
+    if (proposal.type == move_type::TWO_THREE) {
+      made = reference_.flip(reference, i);
+    } else if (proposal.type == move_type::THREE_TWO) {
+      const auto j = reference->index(vertices_[cell->vertex(proposal.j)]);
+      made = reference_.flip(reference, i, j);
+    }
+    if (made) made_++;
+  }
+
+  /// @brief Appends a difference between **expected** and **actual**
+  template <typename T, typename U>
+  static void compare(std::ostringstream* const report,
+                      const std::string& name,
+                      const T expected,
+                      const U actual) noexcept {
+    if (static_cast<std::uint64_t>(expected) ==
+        static_cast<std::uint64_t>(actual)) {
+      return;
+    }
+    *report << name << ": expected " << expected << ", found " << actual
+            << ". ";
+  }
+
+  Delaunay reference_;
+  Delaunay optimized_;
+  unsigned timeslices_;
+  Timeslice_index index_;
+  std::unique_ptr<Metropolis> metropolis_;
+  std::unordered_map<Vertex_handle, Vertex_handle, Handle_hash<Vertex_handle>>
+      vertices_;
+  std::uint64_t moves_;
+  std::uint64_t made_;
+  std::uint64_t unmatched_;
+};
+
+#endif  // SRC_DIFFERENTIAL_H_
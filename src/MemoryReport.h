@@ -0,0 +1,337 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Peak memory and container sizes for each phase of a run
+///
+/// A run is split into phases, e.g. construction, indexing, thermalization,
+/// and sweeps. At the start of each phase the kernel's resident set size
+/// high-water mark is reset by writing to /proc/self/clear_refs, so the peak
+/// recorded at the end of the phase belongs to that phase alone rather than
+/// to everything before it. Where the reset is not permitted the peak is
+/// cumulative, and the report says so.
+///
+/// The sizes of the containers which dominate memory, i.e. the triangulation
+/// data structure, the Timeslice_index, the Metropolis candidate buffers,
+/// and the simplex output vectors, are estimated from their capacities and
+/// attached to the phase in which they were measured.
+///
+/// A program which expands CDT_COUNT_ALLOCATIONS() once, at namespace scope,
+/// replaces the global operator new and operator delete with versions that
+/// count allocations and the bytes live on the heap. Each phase then also
+/// records how many allocations it made, how many bytes they took, and the
+/// most heap it used beyond what was live when it began. Unlike the RSS, this
+/// peak does not depend on what the allocator returns to the kernel.
+///
+/// \done Per-phase RSS high-water mark
+/// \done Container item counts and bytes
+/// \done Allocation counts and peak heap per phase
+
+/// @file MemoryReport.h
+/// @brief Per-phase memory accounting
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_MEMORYREPORT_H_
+#define SRC_MEMORYREPORT_H_
+
+// CDT headers
+#include "Benchmark.h"
+#include "Metropolis.h"
+#include "TimesliceIndex.h"
+
+// C headers
+#include <malloc.h>
+
+// C++ headers
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// @brief Reads a size from /proc/self/status
+///
+/// @param[in] key The field, e.g. "VmHWM" or "VmRSS"
+/// @returns The value in kilobytes, or -1 if it cannot be read
+inline std::int64_t status_kilobytes(const std::string& key) noexcept {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.compare(0, key.size() + 1, key + ":") != 0) continue;
+    std::istringstream fields(line.substr(key.size() + 1));
+    auto kilobytes = static_cast<std::int64_t>(-1);
+    fields >> kilobytes;
+    return kilobytes;
+  }
+  return -1;
+}  // status_kilobytes()
+
+/// @returns The current resident set size in kilobytes, or -1
+inline std::int64_t current_rss_kilobytes() noexcept {
+  return status_kilobytes("VmRSS");
+}  // current_rss_kilobytes()
+
+/// @brief Resets the resident set size high-water mark to the current RSS
+///
+/// @returns True if the kernel accepted the reset
+inline bool reset_peak_rss() noexcept {
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if (!clear_refs) return false;
+  clear_refs << "5" << std::flush;
+  return static_cast<bool>(clear_refs);
+}  // reset_peak_rss()
+
+/// @brief Heap use counted by the operators CDT_COUNT_ALLOCATIONS() defines
+///
+/// Zero-initialized before any dynamic initialization, so allocations made
+/// before main() are counted too.
+struct Allocation_counters {
+  std::atomic<bool> installed;
+  std::atomic<std::uint64_t> allocations;
+  std::atomic<std::uint64_t> allocated_bytes;
+  std::atomic<std::int64_t> live_bytes;
+  std::atomic<std::int64_t> peak_live_bytes;
+};
+
+/// @returns The process's Allocation_counters
+inline Allocation_counters& allocation_counters() noexcept {
+  static Allocation_counters counters;
+  return counters;
+}  // allocation_counters()
+
+/// @brief Counts an allocation of **bytes** usable bytes
+inline void count_allocation(const std::size_t bytes) noexcept {
+  auto& counters = allocation_counters();
+  counters.installed.store(true, std::memory_order_relaxed);
+  counters.allocations.fetch_add(1, std::memory_order_relaxed);
+  counters.allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  const auto live = counters.live_bytes.fetch_add(
+      static_cast<std::int64_t>(bytes), std::memory_order_relaxed) +
+      static_cast<std::int64_t>(bytes);
+  auto peak = counters.peak_live_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !counters.peak_live_bytes.compare_exchange_weak(
+                            peak, live, std::memory_order_relaxed)) {
+  }
+}  // count_allocation()
+
+/// @brief Counts a deallocation of **bytes** usable bytes
+inline void count_deallocation(const std::size_t bytes) noexcept {
+  allocation_counters().live_bytes.fetch_sub(
+      static_cast<std::int64_t>(bytes), std::memory_order_relaxed);
+}  // count_deallocation()
+
+/// @returns True if CDT_COUNT_ALLOCATIONS() is in effect
+inline bool counting_allocations() noexcept {
+  return allocation_counters().installed.load(std::memory_order_relaxed);
+}  // counting_allocations()
+
+/// @brief Replaces the global operator new and operator delete with versions
+/// that update allocation_counters()
+///
+/// Expand once per program, at namespace scope. Array and nothrow forms
+/// call these, and sized delete calls unsized delete.
+#define CDT_COUNT_ALLOCATIONS()                                   \
+  void* operator new(const std::size_t bytes) {                   \
+    auto* const p = std::malloc(bytes == 0 ? 1 : bytes);          \
+    if (p == nullptr) throw std::bad_alloc();                     \
+    count_allocation(malloc_usable_size(p));                      \
+    return p;                                                     \
+  }                                                               \
+  void operator delete(void* const p) noexcept {                  \
+    if (p == nullptr) return;                                     \
+    count_deallocation(malloc_usable_size(p));                    \
+    std::free(p);                                                 \
+  }                                                               \
+  void operator delete(void* const p, std::size_t) noexcept {     \
+    ::operator delete(p);                                         \
+  }
+
+/// @brief Items held by, and bytes used by, one container
+struct Container_usage {
+  std::string name;
+  std::size_t items;
+  std::size_t bytes;
+};
+
+/// @brief Memory measured over one phase of a run
+struct Memory_phase {
+  std::string name;
+  /// Highest RSS during the phase, or since the start if **isolated** is false
+  std::int64_t peak_rss_kilobytes;
+  /// RSS when the phase ended
+  std::int64_t rss_kilobytes;
+  /// Whether the high-water mark was reset when the phase began
+  bool isolated;
+  /// Heap allocations made during the phase, or -1 if not counted
+  std::int64_t allocations;
+  /// Usable bytes of those allocations, or -1
+  std::int64_t allocated_bytes;
+  /// Most heap bytes live during the phase beyond those live when it
+  /// began, or -1
+  std::int64_t peak_heap_bytes;
+  std::vector<Container_usage> containers;
+};
+
+/// @brief Records memory phase by phase
+///
+/// A disabled report records nothing, so callers need not guard each call.
+class Memory_report {
+ public:
+  explicit Memory_report(const bool enabled) noexcept : enabled_(enabled) {}
+
+  bool enabled() const noexcept { return enabled_; }
+
+  /// @brief Starts a phase, resetting the high-water mark
+  void begin_phase(const std::string& name) noexcept {
+    if (!enabled_) return;
+    const auto isolated = reset_peak_rss();
+    phases_.push_back(Memory_phase{name, -1, -1, isolated, -1, -1, -1, {}});
+    auto& counters = allocation_counters();
+    start_allocations_ = counters.allocations.load();
+    start_allocated_bytes_ = counters.allocated_bytes.load();
+    start_live_bytes_ = counters.live_bytes.load();
+    counters.peak_live_bytes.store(start_live_bytes_);
+  }
+
+  /// @brief Ends the current phase, recording its peak and final RSS
+  void end_phase() noexcept {
+    if (!enabled_ || phases_.empty()) return;
+    phases_.back().peak_rss_kilobytes = status_kilobytes("VmHWM");
+    if (phases_.back().peak_rss_kilobytes < 0) {
+      phases_.back().peak_rss_kilobytes = peak_rss_kilobytes();
+      phases_.back().isolated = false;
+    }
+    phases_.back().rss_kilobytes = current_rss_kilobytes();
+    if (!counting_allocations()) return;
+    const auto& counters = allocation_counters();
+    phases_.back().allocations = static_cast<std::int64_t>(
+        counters.allocations.load() - start_allocations_);
+    phases_.back().allocated_bytes = static_cast<std::int64_t>(
+        counters.allocated_bytes.load() - start_allocated_bytes_);
+    phases_.back().peak_heap_bytes =
+        counters.peak_live_bytes.load() - start_live_bytes_;
+  }
+
+  /// @brief Attaches a container's usage to the current phase
+  void add_container(const std::string& name,
+                     const std::size_t items,
+                     const std::size_t bytes) noexcept {
+    if (!enabled_ || phases_.empty()) return;
+    phases_.back().containers.push_back(Container_usage{name, items, bytes});
+  }
+
+  const std::vector<Memory_phase>& phases() const noexcept {
+    return phases_;
+  }
+
+ private:
+  bool enabled_;
+  std::vector<Memory_phase> phases_;
+  std::uint64_t start_allocations_{0};
+  std::uint64_t start_allocated_bytes_{0};
+  std::int64_t start_live_bytes_{0};
+};
+
+/// @brief Records the cells and vertices of the triangulation data structure
+inline void add_triangulation_usage(const Delaunay& D3,
+                                    Memory_report* const report) noexcept {
+  const auto& cells = D3.tds().cells();
+  const auto& vertices = D3.tds().vertices();
+  report->add_container("tds_cells", cells.size(),
+                        cells.capacity() * sizeof(Delaunay::Cell));
+  report->add_container("tds_vertices", vertices.size(),
+                        vertices.capacity() * sizeof(Delaunay::Vertex));
+}  // add_triangulation_usage()
+
+/// @brief Records the sets of the Timeslice_index
+inline void add_index_usage(const Timeslice_index& index,
+                            Memory_report* const report) noexcept {
+  auto items = static_cast<std::size_t>(0);
+  for (auto t = 0u; t < index.vertices.size(); ++t) {
+    items += index.vertices[t].size() + number_of_cells_in_slab(index, t);
+  }
+  report->add_container("timeslice_index", items,
+                        timeslice_index_bytes(index));
+}  // add_index_usage()
+
+/// @brief Records the (3,1), (2,2), and (1,3) output vectors
+inline void add_simplex_vectors_usage(
+    const std::vector<Cell_handle>& three_one,
+    const std::vector<Cell_handle>& two_two,
+    const std::vector<Cell_handle>& one_three,
+    Memory_report* const report) noexcept {
+  report->add_container(
+      "simplex_vectors",
+      three_one.size() + two_two.size() + one_three.size(),
+      (three_one.capacity() + two_two.capacity() + one_three.capacity()) *
+          sizeof(Cell_handle));
+}  // add_simplex_vectors_usage()
+
+/// @brief Records the Metropolis proposal buffers
+inline void add_metropolis_usage(const Metropolis& metropolis,
+                                 Memory_report* const report) noexcept {
+  report->add_container("candidate_buffers", metropolis.batch_size(),
+                        metropolis.buffer_bytes());
+}  // add_metropolis_usage()
+
+/// @brief One report row per container, or per phase if it has none
+inline std::vector<Report_row> memory_rows(
+    const Memory_report& report) noexcept {
+  std::vector<Report_row> rows;
+  for (const auto& phase : report.phases()) {
+    auto add_row = [&rows, &phase](const Container_usage& usage) {
+      Report_row row;
+      add_field(&row, "phase", phase.name);
+      add_field(&row, "peak_rss_kilobytes", phase.peak_rss_kilobytes);
+      add_field(&row, "rss_kilobytes", phase.rss_kilobytes);
+      add_field(&row, "isolated", phase.isolated ? 1 : 0);
+      add_field(&row, "container", usage.name);
+      add_field(&row, "items", usage.items);
+      add_field(&row, "bytes", usage.bytes);
+      add_field(&row, "allocations", phase.allocations);
+      add_field(&row, "allocated_bytes", phase.allocated_bytes);
+      add_field(&row, "peak_heap_bytes", phase.peak_heap_bytes);
+      rows.push_back(row);
+    };
+    if (phase.containers.empty()) add_row(Container_usage{"", 0, 0});
+    for (const auto& usage : phase.containers) add_row(usage);
+  }
+  return rows;
+}  // memory_rows()
+
+/// @brief Prints the report as a table
+inline void print_memory_report(const Memory_report& report,
+                                std::ostream& os) noexcept {
+  os << "Memory by phase (peak and final RSS in KB):" << std::endl;
+  for (const auto& phase : report.phases()) {
+    os << "  " << std::left << std::setw(16) << phase.name << std::right
+       << " peak " << std::setw(10) << phase.peak_rss_kilobytes
+       << (phase.isolated ? "  " : "* ") << " rss " << std::setw(10)
+       << phase.rss_kilobytes << std::endl;
+    if (phase.allocations >= 0) {
+      os << "    " << phase.allocations << " allocations of "
+         << phase.allocated_bytes << " bytes, peak heap "
+         << phase.peak_heap_bytes << " bytes" << std::endl;
+    }
+    for (const auto& usage : phase.containers) {
+      os << "    " << std::left << std::setw(18) << usage.name << std::right
+         << std::setw(12) << usage.items << " items " << std::setw(14)
+         << usage.bytes << " bytes" << std::endl;
+    }
+  }
+  for (const auto& phase : report.phases()) {
+    if (phase.isolated) continue;
+    os << "  * peak is cumulative; the high-water mark could not be reset"
+       << std::endl;
+    break;
+  }
+}  // print_memory_report()
+
+#endif  // SRC_MEMORYREPORT_H_
@@ -0,0 +1,1332 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Metropolis-Hastings evolution of S3 (2+1) spacetimes
+///
+/// The bulk action is linear in \f$N_1^{TL}\f$, \f$N_3^{(3,1)}\f$, and
+/// \f$N_3^{(2,2)}\f$, so its coefficients are computed once from
+/// **S3_bulk_action()** and the change in action of a move only depends on
+/// the local change in those counts. A move is proposed by picking a random
+/// (2,2) simplex from the Timeslice_index and a random facet or edge of it,
+/// and accepted with the Metropolis-Hastings probability including the ratio
+/// of forward and reverse proposal probabilities. The Move_scheduler picks
+/// which move to attempt, and adapts the mix while thermalizing.
+///
+/// With move_store::COMPACT, sweeps make their moves on a
+/// Compact_triangulation copy of the triangulation, with the same proposals
+/// and acceptance, and export it back after each sweep.
+///
+/// \done (2,3) and (3,2) moves
+/// \done Incremental N1_TL, N3_31, and N3_22
+/// \done Adaptive move mix during thermalization
+/// \done Batched proposals with a vectorized action change
+/// \done Sequential sweeps slab by slab
+/// \done Observer of accepted moves
+/// \done Tracer of attempted moves
+/// \done Moves on the compact triangulation
+/// \todo (2,6) and (6,2) moves
+/// \todo (4,4) move
+
+/// @file Metropolis.h
+/// @brief Metropolis-Hastings algorithm on 3D Delaunay Triangulations
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_METROPOLIS_H_
+#define SRC_METROPOLIS_H_
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "S3Action.h"
+#include "S3ErgodicMoves.h"
+#include "TimesliceIndex.h"
+#include "CompactTriangulation.h"
+#include "MoveScheduler.h"
+#include "Random.h"
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/// How a sweep picks the (2,2) simplex for each move: uniformly from the
+/// whole triangulation, or uniformly from one slab at a time
+enum class site_order { UNIFORM, SEQUENTIAL };
+
+/// Where a sweep makes its moves: on the Delaunay triangulation, or on a
+/// Compact_triangulation copy of it
+enum class move_store { CGAL, COMPACT };
+
+/// Coefficients of \f$N_1^{TL}\f$, \f$N_3^{(3,1)}\f$, and \f$N_3^{(2,2)}\f$
+/// in the bulk action
+struct Action_coefficients {
+  double N1_TL;
+  double N3_31;
+  double N3_22;
+};
+
+/// Change in \f$N_1^{TL}\f$, \f$N_3^{(3,1)}\f$, and \f$N_3^{(2,2)}\f$ made
+/// by a move. As in the action, N3_31 counts both (3,1) and (1,3) simplices.
+struct Move_delta {
+  int N1_TL;
+  int N3_31;
+  int N3_22;
+};
+
+/// @brief A candidate move, evaluated but not yet made
+struct Move_proposal {
+  move_type type;
+  /// The (2,2) simplex picked
+  Cell_handle cell;
+  /// The facet (i) or edge (i, j) of **cell** to flip
+  int i;
+  int j;
+  Move_delta delta;
+  /// Reverse over forward proposal probability, excluding the move mix
+  double proposal_ratio;
+  /// Vertices of every cell the move reads or replaces. Unused entries are
+  /// null handles.
+  std::array<Vertex_handle, 5> footprint;
+};
+
+/// @brief A candidate move on a Compact_triangulation, evaluated but not
+/// yet made
+struct Compact_proposal {
+  move_type type;
+  /// The (2,2) simplex picked
+  std::uint32_t cell;
+  /// The facet (i) or edge (i, j) of **cell** to flip
+  int i;
+  int j;
+  Move_delta delta;
+  /// Reverse over forward proposal probability, excluding the move mix
+  double proposal_ratio;
+};
+
+/// @brief Structure-of-arrays block of proposals for batched evaluation
+///
+/// All random numbers of a batch are drawn up front, and proposals are
+/// evaluated from them against the triangulation at the start of the batch.
+/// Their count changes, ratios, and acceptance draws are laid out
+/// contiguously so **evaluate_batch()** runs as one tight loop.
+struct Proposal_batch {
+  std::vector<Move_proposal> proposals;
+  /// Uniform draws picking the (2,2) simplex from those present
+  std::vector<double> site;
+  /// The facet or edge of the (2,2) simplex
+  std::vector<int> choice;
+  std::vector<char> possible;
+  std::vector<char> accepted;
+  std::vector<int> N1_TL;
+  std::vector<int> N3_31;
+  std::vector<int> N3_22;
+  /// Proposal ratio times the move mix ratio
+  std::vector<double> ratio;
+  /// Acceptance probability, filled in by **evaluate_batch()**
+  std::vector<double> weight;
+  /// Uniform acceptance draws
+  std::vector<double> u;
+
+  void resize(const std::size_t n) noexcept {
+    proposals.resize(n);
+    site.resize(n);
+    choice.resize(n);
+    possible.resize(n);
+    accepted.resize(n);
+    N1_TL.resize(n);
+    N3_31.resize(n);
+    N3_22.resize(n);
+    ratio.resize(n);
+    weight.resize(n);
+    u.resize(n);
+  }
+
+  std::size_t size() const noexcept { return proposals.size(); }
+};
+
+/// @brief Computes the coefficients of the bulk action
+///
+/// **S3_bulk_action()** has no constant term, so evaluating it on a single
+/// timelike edge, (3,1) simplex, or (2,2) simplex gives each coefficient.
+///
+/// @param[in] Alpha  \f$\alpha\f$ is the timelike edge length
+/// @param[in] K      \f$k=\frac{1}{8\pi G_{Newton}}\f$
+/// @param[in] Lambda \f$\lambda=k*\Lambda\f$
+/// @returns The Action_coefficients
+inline Action_coefficients make_action_coefficients(const long double Alpha,
+                                                    const long double K,
+                                                    const long double Lambda)
+                                                    noexcept {
+  Action_coefficients coefficients;
+  coefficients.N1_TL = CGAL::to_double(S3_bulk_action(1, 0, 0, Alpha, K,
+                                                      Lambda));
+  coefficients.N3_31 = CGAL::to_double(S3_bulk_action(0, 1, 0, Alpha, K,
+                                                      Lambda));
+  coefficients.N3_22 = CGAL::to_double(S3_bulk_action(0, 0, 1, Alpha, K,
+                                                      Lambda));
+  return coefficients;
+}  // make_action_coefficients()
+
+/// @returns The change in action for **delta**
+inline double action_change(const Move_delta& delta,
+                            const Action_coefficients& coefficients)
+                            noexcept {
+  return coefficients.N1_TL * delta.N1_TL +
+         coefficients.N3_31 * delta.N3_31 +
+         coefficients.N3_22 * delta.N3_22;
+}  // action_change()
+
+/// @brief Simplex type of four vertices from their timeslices **t**
+///
+/// @returns 31, 22, or 13 as in **classify_3_simplex()**, or 0 if the
+/// vertices do not span exactly one slab
+inline unsigned simplex_type(const std::array<unsigned, 4>& t) noexcept {
+  auto min_time = t[0];
+  auto max_time = t[0];
+  for (const auto time : t) {
+    if (time < min_time) min_time = time;
+    if (time > max_time) max_time = time;
+  }
+  if (max_time - min_time != 1) return 0;
+
+  auto max_values = 0;
+  for (const auto time : t) {
+    if (time == max_time) max_values++;
+  }
+  return (max_values == 3) ? 13 : (max_values == 2) ? 22 : 31;
+}  // simplex_type()
+
+/// @returns The simplex type of four vertices as in **simplex_type()**
+inline unsigned simplex_type(const Vertex_handle& a, const Vertex_handle& b,
+                             const Vertex_handle& c, const Vertex_handle& d)
+                             noexcept {
+  return simplex_type(std::array<unsigned, 4>{{a->info(), b->info(),
+                                               c->info(), d->info()}});
+}  // simplex_type()
+
+/// @returns The simplex type of four vertices of **compact** as in
+/// **simplex_type()**
+inline unsigned simplex_type(const Compact_triangulation& compact,
+                             const std::uint32_t a, const std::uint32_t b,
+                             const std::uint32_t c, const std::uint32_t d)
+                             noexcept {
+  return simplex_type(std::array<unsigned, 4>{{
+      compact.timeslice(a), compact.timeslice(b), compact.timeslice(c),
+      compact.timeslice(d)}});
+}  // simplex_type()
+
+/// @returns The simplex type of **cell** as in **simplex_type()**
+inline unsigned cell_type(const Cell_handle& cell) noexcept {
+  return simplex_type(cell->vertex(0), cell->vertex(1), cell->vertex(2),
+                      cell->vertex(3));
+}  // cell_type()
+
+/// @returns The simplex type of finite cell **c** of **compact** as in
+/// **simplex_type()**
+inline unsigned cell_type(const Compact_triangulation& compact,
+                          const std::uint32_t c) noexcept {
+  return simplex_type(compact, compact.vertex(c, 0), compact.vertex(c, 1),
+                      compact.vertex(c, 2), compact.vertex(c, 3));
+}  // cell_type()
+
+/// @brief Adds a simplex type to a Move_delta
+inline void count_simplex(const unsigned type, const int sign,
+                          Move_delta* const delta) noexcept {
+  if (type == 22) {
+    delta->N3_22 += sign;
+  } else {
+    delta->N3_31 += sign;
+  }
+}  // count_simplex()
+
+/// @brief Evaluates the acceptance probability of every proposal in a batch
+///
+/// Impossible proposals get weights too, which are simply never used, so
+/// that both loops run without branches.
+///
+/// @param[in]     coefficients The bulk action coefficients
+/// @param[in,out] batch        The Proposal_batch
+inline void evaluate_batch(const Action_coefficients& coefficients,
+                           Proposal_batch* const batch) noexcept {
+  const auto n = batch->size();
+  const int* const N1_TL = batch->N1_TL.data();
+  const int* const N3_31 = batch->N3_31.data();
+  const int* const N3_22 = batch->N3_22.data();
+  const double* const ratio = batch->ratio.data();
+  double* const weight = batch->weight.data();
+
+  for (auto k = static_cast<std::size_t>(0); k < n; ++k) {
+    weight[k] = coefficients.N1_TL * N1_TL[k] +
+                coefficients.N3_31 * N3_31[k] +
+                coefficients.N3_22 * N3_22[k];
+  }
+  for (auto k = static_cast<std::size_t>(0); k < n; ++k) {
+    weight[k] = ratio[k] * std::exp(-weight[k]);
+  }
+}  // evaluate_batch()
+
+/// @brief The (2,2) simplex at a position in the Timeslice_index
+///
+/// @param[in] index  The Timeslice_index
+/// @param[in] choice The position, counting slab by slab
+/// @returns The (2,2) simplex, or a null handle if **choice** is too large
+inline Cell_handle nth_two_two(const Timeslice_index& index,
+                               std::size_t choice) noexcept {
+  for (const auto& slab : index.two_two) {
+    if (choice < slab.size()) return slab[choice];
+    choice -= slab.size();
+  }
+  return Cell_handle();
+}  // nth_two_two()
+
+/// @brief Picks a uniformly random (2,2) simplex
+///
+/// @param[in]     index   The Timeslice_index
+/// @param[in]     N3_22   The total number of (2,2) simplices in **index**
+/// @param[in,out] rng     The random number generator; one draw is consumed
+/// @returns A random (2,2) simplex
+inline Cell_handle random_two_two(const Timeslice_index& index,
+                                  const std::size_t N3_22,
+                                  Random_engine* const rng) noexcept {
+  return nth_two_two(index, rng->uniform_index(N3_22));
+}  // random_two_two()
+
+/// @brief Evaluates a (2,3) move on a given facet of a (2,2) simplex
+///
+/// The move is rejected outright if the new edge would not be timelike, or
+/// any new cell would not span exactly one slab.
+///
+/// @param[in]  D3       The Delaunay triangulation
+/// @param[in]  two_two  The (2,2) simplex
+/// @param[in]  facet    The facet of **two_two**, 0 to 3
+/// @param[in]  N3_22    The number of (2,2) simplices
+/// @param[out] proposal The evaluated move
+/// @returns True if the move is possible
+inline bool evaluate_23_move(const Delaunay& D3,
+                             const Cell_handle& two_two,
+                             const int facet,
+                             const std::size_t N3_22,
+                             Move_proposal* const proposal) noexcept {
+  proposal->type = move_type::TWO_THREE;
+  proposal->cell = two_two;
+  proposal->i = facet;
+  proposal->j = 0;
+  proposal->delta = Move_delta{1, 0, 0};
+  for (auto k = 0; k < 4; ++k) {
+    proposal->footprint[k] = proposal->cell->vertex(k);
+  }
+  proposal->footprint[4] = Vertex_handle();
+
+  const auto cell = proposal->cell;
+  const auto i = proposal->i;
+  const auto neighbor = cell->neighbor(i);
+  if (D3.is_infinite(neighbor)) return false;
+
+  const auto top = cell->vertex(i);
+  const auto bottom = D3.mirror_vertex(cell, i);
+  proposal->footprint[4] = bottom;
+  // The new edge must be timelike
+  if (top->info() == bottom->info()) return false;
+
+  std::array<Vertex_handle, 3> shared;
+  for (auto k = 0, f = 0; k < 4; ++k) {
+    if (k != i) shared[f++] = cell->vertex(k);
+  }
+
+  auto two_two_before = 1;
+  count_simplex(22, -1, &proposal->delta);
+  const auto neighbor_type = cell_type(neighbor);
+  if (neighbor_type == 0) return false;
+  if (neighbor_type == 22) two_two_before++;
+  count_simplex(neighbor_type, -1, &proposal->delta);
+
+  auto two_two_after = 0;
+  for (auto k = 0; k < 3; ++k) {
+    const auto type = simplex_type(top, bottom, shared[k],
+                                   shared[(k + 1) % 3]);
+    if (type == 0) return false;
+    if (type == 22) two_two_after++;
+    count_simplex(type, 1, &proposal->delta);
+  }
+  // The reverse move is only proposed from a (2,2) simplex
+  if (two_two_after == 0) return false;
+
+  // Forward: pick one of two_two_before (2,2)s out of N3_22, and a facet.
+  // Reverse: pick one of two_two_after (2,2)s, and one of its 6 edges.
+  const auto N3_22_after = static_cast<double>(N3_22) +
+                           proposal->delta.N3_22;
+  proposal->proposal_ratio = (4.0 * N3_22 * two_two_after) /
+                             (6.0 * N3_22_after * two_two_before);
+  return true;
+}  // evaluate_23_move()
+
+/// @brief Proposes a (2,3) move on a random facet of a (2,2) simplex
+///
+/// @param[in]     D3       The Delaunay triangulation
+/// @param[in]     two_two  The (2,2) simplex
+/// @param[in]     N3_22    The number of (2,2) simplices
+/// @param[in,out] rng      The random number generator; one draw consumed
+/// @param[out]    proposal The evaluated move
+/// @returns True if the move is possible
+inline bool propose_23_move(const Delaunay& D3,
+                            const Cell_handle& two_two,
+                            const std::size_t N3_22,
+                            Random_engine* const rng,
+                            Move_proposal* const proposal) noexcept {
+  const auto facet = static_cast<int>(rng->uniform_index(4));
+  return evaluate_23_move(D3, two_two, facet, N3_22, proposal);
+}  // propose_23_move()
+
+/// @brief Evaluates a (3,2) move on a given edge of a (2,2) simplex
+///
+/// The move is rejected outright if the edge is spacelike, is not
+/// surrounded by exactly three cells, or any new cell would not span
+/// exactly one slab.
+///
+/// @param[in]  D3       The Delaunay triangulation
+/// @param[in]  two_two  The (2,2) simplex
+/// @param[in]  edge     The edge of **two_two**, 0 to 5
+/// @param[in]  N3_22    The number of (2,2) simplices
+/// @param[out] proposal The evaluated move
+/// @returns True if the move is possible
+inline bool evaluate_32_move(const Delaunay& D3,
+                             const Cell_handle& two_two,
+                             const int edge,
+                             const std::size_t N3_22,
+                             Move_proposal* const proposal) noexcept {
+  static const std::array<std::array<int, 2>, 6> edges{
+    {{{0, 1}}, {{0, 2}}, {{0, 3}}, {{1, 2}}, {{1, 3}}, {{2, 3}}}};
+  proposal->type = move_type::THREE_TWO;
+  proposal->cell = two_two;
+  proposal->i = edges[edge][0];
+  proposal->j = edges[edge][1];
+  proposal->delta = Move_delta{-1, 0, 0};
+  for (auto k = 0; k < 4; ++k) {
+    proposal->footprint[k] = proposal->cell->vertex(k);
+  }
+  proposal->footprint[4] = Vertex_handle();
+
+  const auto cell = proposal->cell;
+  const auto u = cell->vertex(proposal->i);
+  const auto v = cell->vertex(proposal->j);
+  if (u->info() == v->info()) return false;
+
+  std::array<Cell_handle, 3> incident;
+  auto degree = 0u;
+  Delaunay::Cell_circulator circulator = D3.incident_cells(cell, proposal->i,
+                                                           proposal->j);
+  Delaunay::Cell_circulator done = circulator;
+  do {
+    if (degree == 3 || D3.is_infinite(circulator)) return false;
+    incident[degree++] = circulator;
+  } while (++circulator != done);
+  if (degree != 3) return false;
+
+  std::array<Vertex_handle, 3> ring;
+  auto ring_size = 0u;
+  auto two_two_before = 0;
+  for (const auto& c : incident) {
+    const auto type = cell_type(c);
+    if (type == 0) return false;
+    if (type == 22) two_two_before++;
+    count_simplex(type, -1, &proposal->delta);
+    for (auto k = 0; k < 4; ++k) {
+      const auto w = c->vertex(k);
+      if (w == u || w == v) continue;
+      if (std::find(ring.begin(), ring.begin() + ring_size, w) ==
+          ring.begin() + ring_size) {
+        if (ring_size == 3) return false;
+        ring[ring_size++] = w;
+      }
+    }
+  }
+  if (ring_size != 3) return false;
+  for (const auto& w : ring) {
+    if (!cell->has_vertex(w)) proposal->footprint[4] = w;
+  }
+
+  auto two_two_after = 0;
+  for (const auto& apex : {u, v}) {
+    const auto type = simplex_type(ring[0], ring[1], ring[2], apex);
+    if (type == 0) return false;
+    if (type == 22) two_two_after++;
+    count_simplex(type, 1, &proposal->delta);
+  }
+  // The reverse move is only proposed from a (2,2) simplex
+  if (two_two_after == 0) return false;
+
+  // Forward: pick one of two_two_before (2,2)s out of N3_22, and an edge.
+  // Reverse: pick one of two_two_after (2,2)s, and one of its 4 facets.
+  const auto N3_22_after = static_cast<double>(N3_22) +
+                           proposal->delta.N3_22;
+  proposal->proposal_ratio = (6.0 * N3_22 * two_two_after) /
+                             (4.0 * N3_22_after * two_two_before);
+  return true;
+}  // evaluate_32_move()
+
+/// @brief Proposes a (3,2) move on a random edge of a (2,2) simplex
+///
+/// @param[in]     D3       The Delaunay triangulation
+/// @param[in]     two_two  The (2,2) simplex
+/// @param[in]     N3_22    The number of (2,2) simplices
+/// @param[in,out] rng      The random number generator; one draw consumed
+/// @param[out]    proposal The evaluated move
+/// @returns True if the move is possible
+inline bool propose_32_move(const Delaunay& D3,
+                            const Cell_handle& two_two,
+                            const std::size_t N3_22,
+                            Random_engine* const rng,
+                            Move_proposal* const proposal) noexcept {
+  const auto edge = static_cast<int>(rng->uniform_index(6));
+  return evaluate_32_move(D3, two_two, edge, N3_22, proposal);
+}  // propose_32_move()
+
+/// @brief Proposes a (2,3) move on a uniformly random (2,2) simplex
+///
+/// @param[in]     D3       The Delaunay triangulation
+/// @param[in]     index    The Timeslice_index
+/// @param[in]     N3_22    The number of (2,2) simplices
+/// @param[in,out] rng      The random number generator; two draws consumed
+/// @param[out]    proposal The evaluated move
+/// @returns True if the move is possible
+inline bool propose_23_move(const Delaunay& D3,
+                            const Timeslice_index& index,
+                            const std::size_t N3_22,
+                            Random_engine* const rng,
+                            Move_proposal* const proposal) noexcept {
+  const auto two_two = random_two_two(index, N3_22, rng);
+  return propose_23_move(D3, two_two, N3_22, rng, proposal);
+}  // propose_23_move()
+
+/// @brief Proposes a (3,2) move on a uniformly random (2,2) simplex
+///
+/// @param[in]     D3       The Delaunay triangulation
+/// @param[in]     index    The Timeslice_index
+/// @param[in]     N3_22    The number of (2,2) simplices
+/// @param[in,out] rng      The random number generator; two draws consumed
+/// @param[out]    proposal The evaluated move
+/// @returns True if the move is possible
+inline bool propose_32_move(const Delaunay& D3,
+                            const Timeslice_index& index,
+                            const std::size_t N3_22,
+                            Random_engine* const rng,
+                            Move_proposal* const proposal) noexcept {
+  const auto two_two = random_two_two(index, N3_22, rng);
+  return propose_32_move(D3, two_two, N3_22, rng, proposal);
+}  // propose_32_move()
+
+/// @brief Evaluates a (2,3) move on a Compact_triangulation, as
+/// **evaluate_23_move()** does on a Delaunay triangulation
+///
+/// @param[in]  compact  The compact triangulation
+/// @param[in]  two_two  The (2,2) simplex
+/// @param[in]  facet    The facet of **two_two**, 0 to 3
+/// @param[in]  N3_22    The number of (2,2) simplices
+/// @param[out] proposal The evaluated move
+/// @returns True if the move is possible
+inline bool evaluate_23_move(const Compact_triangulation& compact,
+                             const std::uint32_t two_two,
+                             const int facet,
+                             const std::size_t N3_22,
+                             Compact_proposal* const proposal) noexcept {
+  proposal->type = move_type::TWO_THREE;
+  proposal->cell = two_two;
+  proposal->i = facet;
+  proposal->j = 0;
+  proposal->delta = Move_delta{1, 0, 0};
+
+  const auto neighbor = compact.neighbor(two_two, facet);
+  if (compact.is_infinite(neighbor)) return false;
+
+  const auto top = compact.vertex(two_two, facet);
+  const auto bottom = compact.vertex(neighbor,
+                                     compact.neighbor_index(neighbor,
+                                                            two_two));
+  // The new edge must be timelike
+  if (compact.timeslice(top) == compact.timeslice(bottom)) return false;
+
+  std::array<std::uint32_t, 3> shared;
+  for (auto k = 0, f = 0; k < 4; ++k) {
+    if (k != facet) shared[f++] = compact.vertex(two_two, k);
+  }
+
+  auto two_two_before = 1;
+  count_simplex(22, -1, &proposal->delta);
+  const auto neighbor_type = cell_type(compact, neighbor);
+  if (neighbor_type == 0) return false;
+  if (neighbor_type == 22) two_two_before++;
+  count_simplex(neighbor_type, -1, &proposal->delta);
+
+  auto two_two_after = 0;
+  for (auto k = 0; k < 3; ++k) {
+    const auto type = simplex_type(compact, top, bottom, shared[k],
+                                   shared[(k + 1) % 3]);
+    if (type == 0) return false;
+    if (type == 22) two_two_after++;
+    count_simplex(type, 1, &proposal->delta);
+  }
+  if (two_two_after == 0) return false;
+
+  const auto N3_22_after = static_cast<double>(N3_22) +
+                           proposal->delta.N3_22;
+  proposal->proposal_ratio = (4.0 * N3_22 * two_two_after) /
+                             (6.0 * N3_22_after * two_two_before);
+  return true;
+}  // evaluate_23_move()
+
+/// @brief Evaluates a (3,2) move on a Compact_triangulation, as
+/// **evaluate_32_move()** does on a Delaunay triangulation
+///
+/// @param[in]  compact  The compact triangulation
+/// @param[in]  two_two  The (2,2) simplex
+/// @param[in]  edge     The edge of **two_two**, 0 to 5
+/// @param[in]  N3_22    The number of (2,2) simplices
+/// @param[out] proposal The evaluated move
+/// @returns True if the move is possible
+inline bool evaluate_32_move(const Compact_triangulation& compact,
+                             const std::uint32_t two_two,
+                             const int edge,
+                             const std::size_t N3_22,
+                             Compact_proposal* const proposal) noexcept {
+  static const std::array<std::array<int, 2>, 6> edges{
+    {{{0, 1}}, {{0, 2}}, {{0, 3}}, {{1, 2}}, {{1, 3}}, {{2, 3}}}};
+  proposal->type = move_type::THREE_TWO;
+  proposal->cell = two_two;
+  proposal->i = edges[edge][0];
+  proposal->j = edges[edge][1];
+  proposal->delta = Move_delta{-1, 0, 0};
+
+  const auto u = compact.vertex(two_two, proposal->i);
+  const auto v = compact.vertex(two_two, proposal->j);
+  if (compact.timeslice(u) == compact.timeslice(v)) return false;
+
+  std::array<std::uint32_t, 3> incident;
+  if (!compact.cells_around_edge(two_two, proposal->i, proposal->j,
+                                 &incident)) {
+    return false;
+  }
+
+  std::array<std::uint32_t, 3> ring;
+  auto ring_size = 0u;
+  auto two_two_before = 0;
+  for (const auto c : incident) {
+    const auto type = cell_type(compact, c);
+    if (type == 0) return false;
+    if (type == 22) two_two_before++;
+    count_simplex(type, -1, &proposal->delta);
+    for (auto k = 0; k < 4; ++k) {
+      const auto w = compact.vertex(c, k);
+      if (w == u || w == v) continue;
+      if (std::find(ring.begin(), ring.begin() + ring_size, w) ==
+          ring.begin() + ring_size) {
+        if (ring_size == 3) return false;
+        ring[ring_size++] = w;
+      }
+    }
+  }
+  if (ring_size != 3) return false;
+
+  auto two_two_after = 0;
+  for (const auto apex : {u, v}) {
+    const auto type = simplex_type(compact, ring[0], ring[1], ring[2], apex);
+    if (type == 0) return false;
+    if (type == 22) two_two_after++;
+    count_simplex(type, 1, &proposal->delta);
+  }
+  if (two_two_after == 0) return false;
+
+  const auto N3_22_after = static_cast<double>(N3_22) +
+                           proposal->delta.N3_22;
+  proposal->proposal_ratio = (6.0 * N3_22 * two_two_after) /
+                             (4.0 * N3_22_after * two_two_before);
+  return true;
+}  // evaluate_32_move()
+
+/// @brief Makes a proposed move
+///
+/// @param[in,out] D3       The Delaunay triangulation
+/// @param[in]     proposal The move
+/// @param[in,out] index    The Timeslice_index
+/// @returns True if CGAL could make the move
+inline bool make_move(Delaunay* const D3,
+                      const Move_proposal& proposal,
+                      Timeslice_index* const index) noexcept {
+  switch (proposal.type) {
+    case move_type::TWO_THREE:
+      return flip_facet(D3, proposal.cell, proposal.i, index);
+    case move_type::THREE_TWO:
+      return flip_edge(D3, proposal.cell, proposal.i, proposal.j, index);
+    default:
+      return false;
+  }
+}  // make_move()
+
+/// Called with each accepted proposal just before it is made
+using Move_observer = std::function<void(const Move_proposal&)>;
+
+/// What became of an attempted move
+enum class move_outcome : std::uint8_t { IMPOSSIBLE, REJECTED, ACCEPTED };
+
+/// Called with each attempted proposal, its outcome, its change in action,
+/// and its slot in its batch (0 outside batched sweeps) once it is decided,
+/// before an accepted proposal is made
+using Move_tracer = std::function<void(const Move_proposal&, move_outcome,
+                                       double, std::size_t)>;
+
+/// @brief Metropolis-Hastings evolution of a foliated triangulation
+///
+/// Keeps the Timeslice_index and the counts entering the bulk action current
+/// as moves are made.
+class Metropolis {
+ public:
+  /// @param[in,out] D3           The Delaunay triangulation to evolve
+  /// @param[in,out] index        A Timeslice_index of **D3**
+  /// @param[in]     coefficients The bulk action coefficients
+  /// @param[in]     seed         Seed for the random number generator
+  Metropolis(Delaunay* const D3,
+             Timeslice_index* const index,
+             const Action_coefficients& coefficients,
+             const std::uint64_t seed) noexcept
+      : D3_(D3),
+        index_(index),
+        coefficients_(coefficients),
+        rng_(seed),
+        // (2,6) and (6,2) are not yet proposed
+        scheduler_(std::array<double, NUMBER_OF_MOVE_TYPES>{{1, 1, 0, 0}}),
+        N1_TL_(0),
+        N3_31_(0),
+        N3_22_(0),
+        refused_(0),
+        batch_size_(1),
+        site_order_(site_order::UNIFORM),
+        store_(move_store::CGAL) {
+    recount();
+  }
+
+  /// @brief Recomputes N1_TL, N3_31, and N3_22 from the triangulation
+  void recount() noexcept {
+    N1_TL_ = 0;
+    Delaunay::Finite_edges_iterator eit;
+    for (eit = D3_->finite_edges_begin(); eit != D3_->finite_edges_end();
+         ++eit) {
+      if (eit->first->vertex(eit->second)->info() !=
+          eit->first->vertex(eit->third)->info()) {
+        N1_TL_++;
+      }
+    }
+    N3_31_ = 0;
+    N3_22_ = 0;
+    for (auto t = 0u; t < index_->two_two.size(); ++t) {
+      N3_31_ += index_->three_one[t].size() + index_->one_three[t].size();
+      N3_22_ += index_->two_two[t].size();
+    }
+  }
+
+  /// @brief Proposes one move
+  ///
+  /// @param[in]  move     The move type
+  /// @param[out] proposal The evaluated move
+  /// @returns True if the move is possible
+  bool propose(const move_type move, Move_proposal* const proposal) noexcept {
+    proposal->type = move;
+    proposal->footprint.fill(Vertex_handle());
+    if (N3_22_ == 0) return false;
+    switch (move) {
+      case move_type::TWO_THREE:
+        return propose_23_move(*D3_, *index_, N3_22_, &rng_, proposal);
+      case move_type::THREE_TWO:
+        return propose_32_move(*D3_, *index_, N3_22_, &rng_, proposal);
+      default:
+        return false;
+    }
+  }
+
+  /// @brief Proposes one move on a uniformly random (2,2) simplex of a slab
+  ///
+  /// Moves never leave the slab of their (2,2) simplex, so the proposal
+  /// ratio is that of **propose()** with the slab's N3_22 in place of the
+  /// total.
+  ///
+  /// @param[in]  move     The move type
+  /// @param[in]  slab     The slab
+  /// @param[out] proposal The evaluated move
+  /// @returns True if the move is possible
+  bool propose_in_slab(const move_type move,
+                       const unsigned slab,
+                       Move_proposal* const proposal) noexcept {
+    proposal->type = move;
+    proposal->cell = Cell_handle();
+    proposal->footprint.fill(Vertex_handle());
+    const auto& sites = index_->two_two[slab];
+    if (sites.size() == 0) return false;
+    const auto site = sites[rng_.uniform_index(sites.size())];
+    switch (move) {
+      case move_type::TWO_THREE:
+        return propose_23_move(*D3_, site, sites.size(), &rng_, proposal);
+      case move_type::THREE_TWO:
+        return propose_32_move(*D3_, site, sites.size(), &rng_, proposal);
+      default:
+        return false;
+    }
+  }
+
+  /// @brief Metropolis-Hastings acceptance probability of a Move_proposal
+  /// or Compact_proposal
+  template <typename Proposal>
+  double acceptance(const Proposal& proposal) const noexcept {
+    const auto mix = scheduler_.probability(inverse_move(proposal.type)) /
+                     scheduler_.probability(proposal.type);
+    return proposal.proposal_ratio * mix *
+           std::exp(-action_change(proposal.delta, coefficients_));
+  }
+
+  /// @brief Makes an accepted proposal and updates the counts
+  ///
+  /// @returns True if CGAL could make the move
+  bool commit(const Move_proposal& proposal) noexcept {
+    if (observer_) observer_(proposal);
+    if (!make_move(D3_, proposal, index_)) {
+      refused_++;
+      return false;
+    }
+    N1_TL_ += proposal.delta.N1_TL;
+    N3_31_ += proposal.delta.N3_31;
+    N3_22_ += proposal.delta.N3_22;
+    return true;
+  }
+
+  /// @brief Attempts one move
+  ///
+  /// @param[in] move The move type
+  /// @returns True if the move was accepted and made
+  bool attempt(const move_type move) noexcept {
+    Move_proposal proposal;
+    const auto possible = propose(move, &proposal);
+    return decide(proposal, possible);
+  }
+
+  /// @brief Attempts one move within a slab
+  ///
+  /// @param[in] move The move type
+  /// @param[in] slab The slab
+  /// @returns True if the move was accepted and made
+  bool attempt_in_slab(const move_type move, const unsigned slab) noexcept {
+    Move_proposal proposal;
+    const auto possible = propose_in_slab(move, slab, &proposal);
+    return decide(proposal, possible);
+  }
+
+  /// @brief Makes one attempt and records it with the Move_scheduler
+  ///
+  /// The attempt is only timed while the mix adapts. A frozen scheduler
+  /// never uses the time, so measurement sweeps skip the clock.
+  ///
+  /// @param[in] move         The move type
+  /// @param[in] attempt_move Makes the attempt, returning true if accepted
+  /// @returns True if the move was accepted and made
+  template <typename Attempt>
+  bool record_attempt(const move_type move, Attempt attempt_move) noexcept {
+    if (scheduler_.frozen()) {
+      const auto success = attempt_move();
+      scheduler_.record(move, success, 0.0);
+      return success;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto success = attempt_move();
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    scheduler_.record(move, success, elapsed.count());
+    return success;
+  }
+
+  /// @brief Attempts as many moves as there are simplices
+  ///
+  /// Each move type is chosen by the Move_scheduler, and its outcome and
+  /// cost recorded. Unless the scheduler is frozen, the mix is adapted at
+  /// the end of the sweep. With a batch size above 1, moves are proposed
+  /// and evaluated in batches by **batched_sweep()**. With
+  /// move_store::COMPACT they are made by **compact_sweep()**.
+  ///
+  /// @returns The number of accepted moves
+  std::uint64_t sweep() noexcept {
+    if (store_ == move_store::COMPACT) return compact_sweep();
+    if (batch_size_ > 1) return batched_sweep();
+    if (site_order_ == site_order::SEQUENTIAL) return sequential_sweep();
+    const auto attempts = number_of_simplices();
+    auto accepted = static_cast<std::uint64_t>(0);
+    for (auto n = static_cast<std::uint64_t>(0); n < attempts; ++n) {
+      const auto move = scheduler_.choose(&rng_);
+      if (record_attempt(move, [this, move] { return attempt(move); })) {
+        accepted++;
+      }
+    }
+    scheduler_.adapt();
+    return accepted;
+  }
+
+  /// @brief Attempts as many moves as there are simplices, in batches
+  ///
+  /// Every random number of a batch is drawn by **generate_batch()**, which
+  /// evaluates each proposal against the triangulation as it stood when the
+  /// batch began, and **evaluate_batch()** computes their weights together.
+  /// **apply_batch()** then decides them in order, each against the
+  /// triangulation as it stands, so the sweep is the same Markov chain as
+  /// uniform sequential attempts fed the same random numbers; the batch
+  /// start is only a guess, used wherever it is still right. While the mix
+  /// adapts, batch time is split evenly across its moves for the
+  /// Move_scheduler.
+  ///
+  /// @returns The number of accepted moves
+  std::uint64_t batched_sweep() noexcept {
+    const auto attempts = number_of_simplices();
+    auto accepted = static_cast<std::uint64_t>(0);
+    auto done = static_cast<std::uint64_t>(0);
+    const auto timed = !scheduler_.frozen();
+    while (done < attempts) {
+      const auto n = static_cast<std::size_t>(
+          std::min<std::uint64_t>(batch_size_, attempts - done));
+      const auto start = timed ? std::chrono::steady_clock::now()
+                               : std::chrono::steady_clock::time_point();
+      generate_batch(n);
+      evaluate_batch(coefficients_, &batch_);
+      accepted += apply_batch();
+      const std::chrono::duration<double> elapsed =
+          timed ? std::chrono::steady_clock::now() - start
+                : std::chrono::steady_clock::duration::zero();
+      for (auto k = static_cast<std::size_t>(0); k < n; ++k) {
+        scheduler_.record(batch_.proposals[k].type, batch_.accepted[k] != 0,
+                          elapsed.count() / n);
+      }
+      done += n;
+    }
+    scheduler_.adapt();
+    return accepted;
+  }
+
+  /// @brief Attempts as many moves as there are simplices, one slab at a
+  /// time
+  ///
+  /// The slabs are visited in turn, starting from a uniformly random slab in
+  /// a uniformly random direction, and each gets an equal share of the
+  /// attempts. Each attempt picks a uniformly random (2,2) simplex of the
+  /// current slab, so only that slab's cells are in the working set.
+  ///
+  /// Every attempt is a Metropolis-Hastings step within one slab: its site
+  /// is drawn from the (2,2) simplices of the slab as they stand, and
+  /// **propose_in_slab()** computes the proposal ratio from the slab's
+  /// counts, so the step satisfies detailed balance on its own. The sweep
+  /// is a composition of such steps in an order which does not depend on
+  /// the triangulation, so it leaves the same distribution invariant as
+  /// **sweep()** with uniform sites.
+  ///
+  /// @returns The number of accepted moves
+  std::uint64_t sequential_sweep() noexcept {
+    const auto slabs = static_cast<unsigned>(index_->two_two.size());
+    if (slabs == 0) return 0;
+    const auto first = static_cast<unsigned>(rng_.uniform_index(slabs));
+    const auto forward = rng_.uniform_index(2) == 0;
+    const auto attempts = number_of_simplices();
+    auto accepted = static_cast<std::uint64_t>(0);
+    auto done = static_cast<std::uint64_t>(0);
+    for (auto s = 0u; s < slabs; ++s) {
+      const auto slab = forward ? (first + s) % slabs
+                                : (first + slabs - s) % slabs;
+      for (const auto end = attempts * (s + 1) / slabs; done < end; ++done) {
+        const auto move = scheduler_.choose(&rng_);
+        if (record_attempt(move, [this, move, slab] {
+              return attempt_in_slab(move, slab);
+            })) {
+          accepted++;
+        }
+      }
+    }
+    scheduler_.adapt();
+    return accepted;
+  }
+
+  /// @brief Attempts as many moves as there are simplices on the
+  /// Compact_triangulation
+  ///
+  /// Sites are picked uniformly and moves proposed, accepted, and recorded
+  /// as by **sweep()**, but on 32-bit indices. The Delaunay triangulation
+  /// is then rebuilt from the compact one, and its Timeslice_index with it,
+  /// so they are current between sweeps. Observers and tracers are not
+  /// called, as the cells moves make have no Cell_handle.
+  ///
+  /// @returns The number of accepted moves
+  std::uint64_t compact_sweep() noexcept {
+    const auto attempts = number_of_simplices();
+    auto accepted = static_cast<std::uint64_t>(0);
+    for (auto n = static_cast<std::uint64_t>(0); n < attempts; ++n) {
+      const auto move = scheduler_.choose(&rng_);
+      if (record_attempt(move, [this, move] {
+            return attempt_compact(move);
+          })) {
+        accepted++;
+      }
+    }
+    scheduler_.adapt();
+    const auto timeslices = static_cast<unsigned>(
+        std::max<std::size_t>(index_->vertices.size(), 1) - 1);
+    export_compact_triangulation(compact_, D3_);
+    make_timeslice_index(*D3_, timeslices, index_);
+    return accepted;
+  }
+
+  /// @brief Sets where **sweep()** makes its moves
+  ///
+  /// Switching to move_store::COMPACT copies the triangulation into a
+  /// Compact_triangulation, which **compact_sweep()** then evolves. The
+  /// batch size and site order only apply to move_store::CGAL.
+  ///
+  /// @returns False, keeping move_store::CGAL, if the triangulation is not
+  /// 3-dimensional
+  bool set_move_store(const move_store store) noexcept {
+    store_ = move_store::CGAL;
+    if (store == move_store::CGAL) return true;
+    if (!make_compact_triangulation(*D3_, &compact_)) return false;
+    compact_two_two_.clear();
+    compact_positions_.assign(compact_.cell_capacity(), COMPACT_NO_INDEX);
+    for (auto c = static_cast<std::uint32_t>(0);
+         c < compact_.cell_capacity(); ++c) {
+      compact_.classify(c);
+      add_compact_site(c);
+    }
+    store_ = store;
+    return true;
+  }
+  move_store store() const noexcept { return store_; }
+
+  /// @brief Sets how **sweep()** picks (2,2) simplices
+  void set_sweep_order(const site_order order) noexcept {
+    site_order_ = order;
+  }
+  site_order sweep_order() const noexcept { return site_order_; }
+
+  /// @brief Sets how many proposals **sweep()** generates at once
+  ///
+  /// @param[in] batch_size Proposals per batch; 1 is fully sequential
+  void set_batch_size(const std::size_t batch_size) noexcept {
+    batch_size_ = std::max(static_cast<std::size_t>(1), batch_size);
+  }
+  std::size_t batch_size() const noexcept { return batch_size_; }
+
+  /// @brief Calls **observer** with every accepted proposal, whichever
+  /// sweep makes it, while its cell is still alive
+  void set_move_observer(Move_observer observer) noexcept {
+    observer_ = std::move(observer);
+  }
+
+  /// @brief Calls **tracer** with every attempted proposal, whichever sweep
+  /// makes it
+  void set_move_tracer(Move_tracer tracer) noexcept {
+    tracer_ = std::move(tracer);
+  }
+
+  /// @returns Approximate heap memory used by proposal buffers and the
+  /// compact triangulation
+  std::size_t buffer_bytes() const noexcept {
+    const auto n = batch_.proposals.capacity();
+    return n * sizeof(Move_proposal) +
+           n * (2 * sizeof(char) + 4 * sizeof(int) + 4 * sizeof(double)) +
+           touched_.bucket_count() * sizeof(void*) +
+           touched_.size() * (sizeof(Vertex_handle) + 2 * sizeof(void*)) +
+           compact_.memory_bytes() +
+           (compact_two_two_.capacity() + compact_positions_.capacity()) *
+               sizeof(std::uint32_t);
+  }
+
+  /// @brief Thermalizes with an adaptive mix, then freezes it
+  ///
+  /// @param[in] passes The number of sweeps
+  void thermalize(const std::uint64_t passes) noexcept {
+    for (auto pass = static_cast<std::uint64_t>(0); pass < passes; ++pass) {
+      sweep();
+    }
+    scheduler_.freeze();
+  }
+
+  std::uint64_t number_of_simplices() const noexcept {
+    return N3_31_ + N3_22_;
+  }
+  std::uint64_t N1_TL() const noexcept { return N1_TL_; }
+  std::uint64_t N3_31() const noexcept { return N3_31_; }
+  std::uint64_t N3_22() const noexcept { return N3_22_; }
+  /// Accepted moves CGAL refused to make
+  std::uint64_t refused() const noexcept { return refused_; }
+
+  /// @returns The current bulk action
+  double action() const noexcept {
+    return coefficients_.N1_TL * N1_TL_ + coefficients_.N3_31 * N3_31_ +
+           coefficients_.N3_22 * N3_22_;
+  }
+
+  const Action_coefficients& coefficients() const noexcept {
+    return coefficients_;
+  }
+  /// @brief Changes the couplings, e.g. while annealing
+  void set_coefficients(const Action_coefficients& coefficients) noexcept {
+    coefficients_ = coefficients;
+  }
+  Move_scheduler& scheduler() noexcept { return scheduler_; }
+  Random_engine& rng() noexcept { return rng_; }
+  Delaunay& triangulation() noexcept { return *D3_; }
+  Timeslice_index& index() noexcept { return *index_; }
+
+ private:
+  /// @brief Accepts or rejects a proposal, and makes it if accepted
+  ///
+  /// @returns True if the move was accepted and made
+  bool decide(const Move_proposal& proposal, const bool possible) noexcept {
+    // Always draw, so the random stream doesn't depend on the outcome
+    const auto u = rng_.uniform_real();
+    const auto accept = possible && u < acceptance(proposal);
+    if (tracer_) trace(proposal, possible, accept, 0);
+    if (!accept) return false;
+    return commit(proposal);
+  }
+
+  /// @brief Passes a decided proposal, and its slot in its batch, to the
+  /// tracer
+  void trace(const Move_proposal& proposal,
+             const bool possible,
+             const bool accepted,
+             const std::size_t slot) const noexcept {
+    if (!possible) {
+      tracer_(proposal, move_outcome::IMPOSSIBLE, 0.0, slot);
+    } else {
+      tracer_(proposal,
+              accepted ? move_outcome::ACCEPTED : move_outcome::REJECTED,
+              action_change(proposal.delta, coefficients_), slot);
+    }
+  }
+
+  /// @brief Evaluates a move from its random numbers
+  ///
+  /// @param[in]  move     The move type
+  /// @param[in]  site     Uniform draw picking one of the N3_22 (2,2)
+  ///                      simplices present now
+  /// @param[in]  choice   The facet or edge of the (2,2) simplex
+  /// @param[out] proposal The evaluated move
+  /// @returns True if the move is possible
+  bool propose_at(const move_type move,
+                  const double site,
+                  const int choice,
+                  Move_proposal* const proposal) const noexcept {
+    proposal->type = move;
+    proposal->cell = Cell_handle();
+    proposal->footprint.fill(Vertex_handle());
+    if (N3_22_ == 0) return false;
+    const auto cell = nth_two_two(*index_, site_position(site));
+    switch (move) {
+      case move_type::TWO_THREE:
+        return evaluate_23_move(*D3_, cell, choice, N3_22_, proposal);
+      case move_type::THREE_TWO:
+        return evaluate_32_move(*D3_, cell, choice, N3_22_, proposal);
+      default:
+        return false;
+    }
+  }
+
+  /// @returns The position among the N3_22 (2,2) simplices **site** picks
+  std::size_t site_position(const double site) const noexcept {
+    const auto position = static_cast<std::size_t>(site * N3_22_);
+    return std::min(position, static_cast<std::size_t>(N3_22_ - 1));
+  }
+
+  /// @brief Draws every random number of **n** moves, and evaluates them
+  /// against the triangulation as it stands
+  void generate_batch(const std::size_t n) noexcept {
+    batch_.resize(n);
+    for (auto k = static_cast<std::size_t>(0); k < n; ++k) {
+      auto& proposal = batch_.proposals[k];
+      const auto move = scheduler_.choose(&rng_);
+      batch_.site[k] = rng_.uniform_real();
+      batch_.choice[k] = static_cast<int>(
+          rng_.uniform_index(move == move_type::TWO_THREE ? 4 : 6));
+      batch_.possible[k] = propose_at(move, batch_.site[k], batch_.choice[k],
+                                      &proposal);
+      batch_.accepted[k] = 0;
+      batch_.N1_TL[k] = proposal.delta.N1_TL;
+      batch_.N3_31[k] = proposal.delta.N3_31;
+      batch_.N3_22[k] = proposal.delta.N3_22;
+      batch_.ratio[k] = batch_.possible[k] ?
+          proposal.proposal_ratio * scheduler_.probability(inverse_move(move))
+          / scheduler_.probability(move) : 0.0;
+      batch_.u[k] = rng_.uniform_real();
+    }
+  }
+
+  /// @returns True if **proposal** reads a vertex touched earlier in the batch
+  bool is_stale(const Move_proposal& proposal) const noexcept {
+    for (const auto& v : proposal.footprint) {
+      if (v != Vertex_handle() && touched_.count(v) != 0) return true;
+    }
+    return false;
+  }
+
+  /// @brief Accepts or rejects each proposal in order
+  ///
+  /// Each proposal's site is picked again from the (2,2) simplices present
+  /// now. If that is the simplex it was evaluated on, and no move made in
+  /// the batch shares a vertex with its footprint, only N3_22 can have
+  /// changed, and the proposal ratio is rescaled for it. Otherwise the move
+  /// is evaluated again from its random numbers, and its action change and
+  /// move mix ratio recomputed, before it is decided.
+  ///
+  /// @returns The number of accepted moves
+  std::uint64_t apply_batch() noexcept {
+    touched_.clear();
+    const auto N3_22_start = static_cast<double>(N3_22_);
+    auto accepted = static_cast<std::uint64_t>(0);
+    for (auto k = static_cast<std::size_t>(0); k < batch_.size(); ++k) {
+      auto& proposal = batch_.proposals[k];
+      auto possible = batch_.possible[k] != 0;
+      auto weight = batch_.weight[k];
+      const auto site = (N3_22_ == 0) ? Cell_handle() :
+          nth_two_two(*index_, site_position(batch_.site[k]));
+      if (site != proposal.cell || is_stale(proposal)) {
+        possible = propose_at(proposal.type, batch_.site[k],
+                              batch_.choice[k], &proposal);
+        weight = possible ? acceptance(proposal) : 0.0;
+      } else if (possible) {
+        // Proposal ratios carry N3_22 / (N3_22 + delta) from the batch start
+        const auto delta = proposal.delta.N3_22;
+        const auto N3_22_now = static_cast<double>(N3_22_);
+        weight *= (N3_22_now / (N3_22_now + delta)) *
+                  ((N3_22_start + delta) / N3_22_start);
+      }
+      const auto accept = possible && batch_.u[k] < weight;
+      if (tracer_) trace(proposal, possible, accept, k);
+      if (!accept) continue;
+      if (!commit(proposal)) continue;
+      for (const auto& v : proposal.footprint) {
+        if (v != Vertex_handle()) touched_.insert(v);
+      }
+      batch_.accepted[k] = 1;
+      accepted++;
+    }
+    return accepted;
+  }
+
+  /// @brief Attempts one move on the Compact_triangulation
+  ///
+  /// @param[in] move The move type
+  /// @returns True if the move was accepted and made
+  bool attempt_compact(const move_type move) noexcept {
+    Compact_proposal proposal;
+    const auto sites = compact_two_two_.size();
+    auto possible = false;
+    if (sites > 0) {
+      const auto cell = compact_two_two_[rng_.uniform_index(sites)];
+      if (move == move_type::TWO_THREE) {
+        possible = evaluate_23_move(
+            compact_, cell, static_cast<int>(rng_.uniform_index(4)), sites,
+            &proposal);
+      } else if (move == move_type::THREE_TWO) {
+        possible = evaluate_32_move(
+            compact_, cell, static_cast<int>(rng_.uniform_index(6)), sites,
+            &proposal);
+      }
+    }
+    // Always draw, so the random stream doesn't depend on the outcome
+    const auto u = rng_.uniform_real();
+    if (!possible || u >= acceptance(proposal)) return false;
+
+    Compact_flip flip;
+    const auto made = (proposal.type == move_type::TWO_THREE) ?
+        compact_.flip_23(proposal.cell, proposal.i, &flip) :
+        compact_.flip_32(proposal.cell, proposal.i, proposal.j, &flip);
+    if (!made) {
+      refused_++;
+      return false;
+    }
+    for (auto k = static_cast<std::size_t>(0); k < flip.number_removed;
+         ++k) {
+      remove_compact_site(flip.removed[k]);
+    }
+    for (auto k = static_cast<std::size_t>(0); k < flip.number_created;
+         ++k) {
+      add_compact_site(flip.created[k]);
+    }
+    N1_TL_ += proposal.delta.N1_TL;
+    N3_31_ += proposal.delta.N3_31;
+    N3_22_ += proposal.delta.N3_22;
+    return true;
+  }
+
+  /// @brief Adds cell **c** of the Compact_triangulation to the sites if
+  /// it is a finite (2,2) simplex
+  void add_compact_site(const std::uint32_t c) noexcept {
+    if (!compact_.is_cell(c) || compact_.is_infinite(c) ||
+        cell_type(compact_, c) != 22) {
+      return;
+    }
+    if (c >= compact_positions_.size()) {
+      compact_positions_.resize(c + 1, COMPACT_NO_INDEX);
+    }
+    compact_positions_[c] =
+        static_cast<std::uint32_t>(compact_two_two_.size());
+    compact_two_two_.push_back(c);
+  }
+
+  /// @brief Removes cell **c** from the sites, if it is one
+  void remove_compact_site(const std::uint32_t c) noexcept {
+    if (c >= compact_positions_.size() ||
+        compact_positions_[c] == COMPACT_NO_INDEX) {
+      return;
+    }
+    const auto hole = compact_positions_[c];
+    const auto last = compact_two_two_.back();
+    compact_two_two_[hole] = last;
+    compact_positions_[last] = hole;
+    compact_two_two_.pop_back();
+    compact_positions_[c] = COMPACT_NO_INDEX;
+  }
+
+  Delaunay* D3_;
+  Timeslice_index* index_;
+  Action_coefficients coefficients_;
+  Random_engine rng_;
+  Move_scheduler scheduler_;
+  std::uint64_t N1_TL_;
+  std::uint64_t N3_31_;
+  std::uint64_t N3_22_;
+  std::uint64_t refused_;
+  std::size_t batch_size_;
+  site_order site_order_;
+  move_store store_;
+  Compact_triangulation compact_;
+  /// The (2,2) simplices of compact_, and each cell's position among them
+  std::vector<std::uint32_t> compact_two_two_;
+  std::vector<std::uint32_t> compact_positions_;
+  Proposal_batch batch_;
+  std::unordered_set<Vertex_handle, Handle_hash<Vertex_handle>> touched_;
+  Move_observer observer_;
+  Move_tracer tracer_;
+};
+
+/// @brief Prints per-move statistics and the final move mix
+///
+/// @param[in] scheduler The Move_scheduler
+inline void print_move_statistics(const Move_scheduler& scheduler) noexcept {
+  for (auto i = 0u; i < NUMBER_OF_MOVE_TYPES; ++i) {
+    const auto move = static_cast<move_type>(i);
+    const auto& stats = scheduler.statistics(move);
+    if (stats.attempted == 0) continue;
+    std::cout << move_name(move) << " moves: " << stats.accepted << " of "
+              << stats.attempted << " accepted, " << stats.seconds
+              << " seconds timed while adapting, proposed with probability "
+              << scheduler.probability(move) << std::endl;
+  }
+}  // print_move_statistics()
+
+#endif  // SRC_METROPOLIS_H_
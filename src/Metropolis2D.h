@@ -0,0 +1,382 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// A flat-array engine for 1+1 dimensional CDT
+///
+/// Two-dimensional CDT is exactly solvable, e.g. the cosmological constant
+/// is critical at \f$\lambda_c = \ln 2\f$, which makes it a cheap check of
+/// Monte Carlo machinery. The engine needs no CGAL: the triangulation of a
+/// torus, periodic in time, is a set of triangles in flat arrays. Each
+/// triangle is UP, with its spacelike edge on timeslice t and its apex on
+/// t + 1, or DOWN, the other way round, and stores its slab, its left and
+/// right neighbors across timelike edges, and its vertical neighbor across
+/// its spacelike edge. Removed triangles are filled by the last one, so the
+/// arrays stay dense. Every move is O(1):
+///
+/// - (2,2) swaps the timelike edge shared by an UP and a DOWN triangle
+/// - (2,4) adds a vertex on a spacelike edge, splitting its two triangles
+/// - (4,2) removes a vertex with one timelike edge up and one down
+///
+/// Vertices are implicit: each is the left end of the spacelike edge of
+/// exactly one UP triangle. With the action \f$S = \lambda N_2\f$ and moves
+/// chosen uniformly, (2,4) is accepted with probability
+/// \f$\min(1, e^{-2\lambda} N_0 / (N_0 + 1))\f$ and (4,2) with
+/// \f$\min(1, e^{2\lambda} N_0 / (N_0 - 1))\f$; (2,2) leaves the action
+/// unchanged and is always accepted. The usual volume-fixing term
+/// \f$\epsilon (N_2 - \bar{V})^2\f$ may be added to the action, which keeps
+/// the universe near \f$\bar{V}\f$ triangles at any \f$\lambda\f$.
+///
+/// A sweep is a fixed number of attempts, by default the initial number of
+/// triangles. Were it the current number, states would be sampled between
+/// sweeps with an extra weight \f$1/N_2\f$, which visibly shifts
+/// \f$\langle N_2 \rangle\f$ away from the transfer matrix result.
+///
+/// \done Flat triangle arrays
+/// \done (2,2), (2,4), and (4,2) moves
+/// \done Volume profile and measurement snapshots
+/// \done Volume fixing
+
+/// @file Metropolis2D.h
+/// @brief Array-based Metropolis engine for 1+1 dimensional CDT
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_METROPOLIS2D_H_
+#define SRC_METROPOLIS2D_H_
+
+// CDT headers
+#include "Random.h"
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/// Timeslices never shrink below this many vertices
+static constexpr std::uint32_t MINIMUM_SLICE_VOLUME = 3;
+
+/// The moves of 1+1 dimensional CDT
+enum class move_2d { TWO_TWO, TWO_FOUR, FOUR_TWO };
+
+/// Number of move_2d values
+static constexpr std::size_t NUMBER_OF_2D_MOVES = 3;
+
+/// @brief A triangulated torus as flat arrays, one entry per triangle
+struct Triangulation_2d {
+  /// True for UP triangles
+  std::vector<std::uint8_t> up;
+  /// The slab, i.e. the timeslice of the lower edge or vertex
+  std::vector<std::uint32_t> slab;
+  std::vector<std::uint32_t> left;
+  std::vector<std::uint32_t> right;
+  std::vector<std::uint32_t> vertical;
+  /// Vertices on each timeslice, i.e. UP triangles in each slab
+  std::vector<std::uint32_t> slice_volume;
+
+  std::size_t number_of_triangles() const noexcept { return up.size(); }
+  /// @returns \f$N_0\f$, which is also the number of spacelike edges
+  std::size_t number_of_vertices() const noexcept {
+    return up.size() / 2;
+  }
+};
+
+/// @brief Makes a torus of **timeslices** circles of **slice_volume**
+/// vertices, with UP and DOWN triangles alternating in every slab
+///
+/// @param[in]  timeslices   The number of timeslices, at least 2
+/// @param[in]  slice_volume Vertices per timeslice, at least
+///                          MINIMUM_SLICE_VOLUME
+/// @param[out] T2           The triangulation
+inline void make_2d_triangulation(const std::uint32_t timeslices,
+                                  const std::uint32_t slice_volume,
+                                  Triangulation_2d* const T2) noexcept {
+  const auto per_slab = 2 * slice_volume;
+  const auto triangles = static_cast<std::size_t>(timeslices) * per_slab;
+  T2->up.resize(triangles);
+  T2->slab.resize(triangles);
+  T2->left.resize(triangles);
+  T2->right.resize(triangles);
+  T2->vertical.resize(triangles);
+  T2->slice_volume.assign(timeslices, slice_volume);
+  // Slab t holds UP_k at 2k and DOWN_k at 2k + 1; UP_k has its base from
+  // vertex k to k + 1 on timeslice t, and DOWN_k from k + 1 to k + 2 on
+  // timeslice t + 1, so UP_k sits on DOWN_(k-1) of the slab below
+  for (auto t = 0u; t < timeslices; ++t) {
+    const auto below = (t + timeslices - 1) % timeslices;
+    const auto above = (t + 1) % timeslices;
+    for (auto i = 0u; i < per_slab; ++i) {
+      const auto triangle = t * per_slab + i;
+      const auto k = i / 2;
+      T2->up[triangle] = (i % 2 == 0);
+      T2->slab[triangle] = t;
+      T2->left[triangle] = t * per_slab + (i + per_slab - 1) % per_slab;
+      T2->right[triangle] = t * per_slab + (i + 1) % per_slab;
+      const auto previous = (k + slice_volume - 1) % slice_volume;
+      const auto next = (k + 1) % slice_volume;
+      T2->vertical[triangle] = T2->up[triangle] ?
+          below * per_slab + 2 * previous + 1 : above * per_slab + 2 * next;
+    }
+  }
+}  // make_2d_triangulation()
+
+/// @brief Checks every neighbor relation of a triangulation
+///
+/// @returns True if neighbors are mutual, left and right neighbors share
+/// the slab, vertical neighbors are of opposite type in adjacent slabs, and
+/// the slice volumes match the UP triangles
+inline bool is_valid_2d(const Triangulation_2d& T2) noexcept {
+  const auto n = static_cast<std::uint32_t>(T2.number_of_triangles());
+  const auto timeslices = static_cast<std::uint32_t>(T2.slice_volume.size());
+  std::vector<std::uint32_t> volumes(timeslices, 0);
+  for (auto i = 0u; i < n; ++i) {
+    const auto l = T2.left[i];
+    const auto r = T2.right[i];
+    const auto v = T2.vertical[i];
+    if (l >= n || r >= n || v >= n) return false;
+    if (T2.right[l] != i || T2.left[r] != i || T2.vertical[v] != i) {
+      return false;
+    }
+    if (T2.slab[l] != T2.slab[i] || T2.up[v] == T2.up[i]) return false;
+    const auto expected = T2.up[i] ?
+        (T2.slab[i] + timeslices - 1) % timeslices :
+        (T2.slab[i] + 1) % timeslices;
+    if (T2.slab[v] != expected) return false;
+    if (T2.up[i]) volumes[T2.slab[i]]++;
+  }
+  return volumes == T2.slice_volume;
+}  // is_valid_2d()
+
+/// @brief Metropolis-Hastings for 1+1 dimensional CDT
+class Metropolis_2d {
+ public:
+  /// @param[in,out] T2     The triangulation, which is evolved in place
+  /// @param[in]     lambda The cosmological constant
+  /// @param[in]     seed   Seed for the random numbers
+  Metropolis_2d(Triangulation_2d* const T2,
+                const double lambda,
+                const std::uint64_t seed) noexcept
+      : T2_(T2),
+        rng_(seed),
+        sweep_length_(T2->number_of_triangles()),
+        target_volume_(0),
+        epsilon_(0) {
+    set_lambda(lambda);
+    attempted_.fill(0);
+    accepted_.fill(0);
+  }
+
+  void set_lambda(const double lambda) noexcept {
+    lambda_ = lambda;
+    grow_ = std::exp(-2.0 * lambda);
+    shrink_ = std::exp(2.0 * lambda);
+  }
+
+  /// @brief Adds \f$\epsilon (N_2 - \bar{V})^2\f$ to the action
+  ///
+  /// @param[in] volume  The target number of triangles \f$\bar{V}\f$
+  /// @param[in] epsilon The strength \f$\epsilon\f$, or 0 for none
+  void set_volume_fixing(const double volume, const double epsilon) noexcept {
+    target_volume_ = volume;
+    epsilon_ = epsilon;
+  }
+
+  /// @brief Attempts one move of a random kind on a random triangle
+  ///
+  /// @returns True if the move was made
+  bool attempt() noexcept {
+    const auto move = static_cast<move_2d>(
+        rng_.uniform_index(NUMBER_OF_2D_MOVES));
+    const auto triangle = static_cast<std::uint32_t>(
+        rng_.uniform_index(T2_->number_of_triangles()));
+    attempted_[static_cast<std::size_t>(move)]++;
+    bool made = false;
+    switch (move) {
+      case move_2d::TWO_TWO:
+        made = flip(triangle);
+        break;
+      case move_2d::TWO_FOUR:
+        made = insert_vertex(triangle);
+        break;
+      case move_2d::FOUR_TWO:
+        made = remove_vertex(triangle);
+        break;
+    }
+    if (made) accepted_[static_cast<std::size_t>(move)]++;
+    return made;
+  }
+
+  /// @brief Attempts **sweep_length()** moves
+  ///
+  /// @returns The number of moves made
+  std::uint64_t sweep() noexcept {
+    auto made = static_cast<std::uint64_t>(0);
+    for (auto i = static_cast<std::size_t>(0); i < sweep_length_; ++i) {
+      if (attempt()) made++;
+    }
+    return made;
+  }
+
+  /// @returns \f$S = \lambda N_2 + \epsilon (N_2 - \bar{V})^2\f$
+  double action() const noexcept {
+    const auto N2 = static_cast<double>(T2_->number_of_triangles());
+    return lambda_ * N2 + epsilon_ * (N2 - target_volume_) *
+                          (N2 - target_volume_);
+  }
+
+  /// @brief Sets the number of attempts in a sweep, at least 1
+  void set_sweep_length(const std::size_t attempts) noexcept {
+    sweep_length_ = std::max(attempts, static_cast<std::size_t>(1));
+  }
+
+  double lambda() const noexcept { return lambda_; }
+  std::size_t sweep_length() const noexcept { return sweep_length_; }
+  double target_volume() const noexcept { return target_volume_; }
+  double epsilon() const noexcept { return epsilon_; }
+  std::uint64_t attempted(const move_2d move) const noexcept {
+    return attempted_[static_cast<std::size_t>(move)];
+  }
+  std::uint64_t accepted(const move_2d move) const noexcept {
+    return accepted_[static_cast<std::size_t>(move)];
+  }
+  Triangulation_2d& triangulation() noexcept { return *T2_; }
+  const Triangulation_2d& triangulation() const noexcept { return *T2_; }
+  Random_engine& rng() noexcept { return rng_; }
+
+ private:
+  /// @brief (2,2): moves the timelike edge between **i** and its right
+  /// neighbor, if they are of opposite type
+  bool flip(const std::uint32_t i) noexcept {
+    auto& T2 = *T2_;
+    const auto j = T2.right[i];
+    if (T2.up[i] == T2.up[j]) return false;
+    // The triangles trade types, and with them their spacelike edges
+    std::swap(T2.up[i], T2.up[j]);
+    std::swap(T2.vertical[i], T2.vertical[j]);
+    T2.vertical[T2.vertical[i]] = i;
+    T2.vertical[T2.vertical[j]] = j;
+    return true;
+  }
+
+  /// @brief (2,4): adds a vertex in the middle of the spacelike edge of the
+  /// UP triangle **i**, or of the UP triangle below or above it
+  bool insert_vertex(std::uint32_t i) noexcept {
+    auto& T2 = *T2_;
+    if (!T2.up[i]) i = T2.vertical[i];
+    const auto N0 = static_cast<double>(T2.number_of_vertices());
+    if (!accept(grow_ * volume_fixing(2) * N0 / (N0 + 1.0))) return false;
+
+    const auto k = T2.vertical[i];
+    const auto n1 = add_triangle(1, T2.slab[i]);
+    const auto n2 = add_triangle(0, T2.slab[k]);
+    // i keeps the left half of the edge, n1 the right half, and likewise
+    // for k and n2 below it
+    link(n1, T2.right[i]);
+    link(i, n1);
+    link(n2, T2.right[k]);
+    link(k, n2);
+    T2.vertical[n1] = n2;
+    T2.vertical[n2] = n1;
+    T2.slice_volume[T2.slab[i]]++;
+    return true;
+  }
+
+  /// @brief (4,2): removes the left vertex of the spacelike edge of the UP
+  /// triangle **i**, or of the UP triangle below or above it
+  bool remove_vertex(std::uint32_t i) noexcept {
+    auto& T2 = *T2_;
+    if (!T2.up[i]) i = T2.vertical[i];
+    const auto t = T2.slab[i];
+    if (T2.slice_volume[t] <= MINIMUM_SLICE_VOLUME) return false;
+    // One timelike edge up and one down: UP triangles either side above,
+    // DOWN triangles either side below
+    const auto left_above = T2.left[i];
+    const auto below = T2.vertical[i];
+    const auto left_below = T2.left[below];
+    if (!T2.up[left_above] || T2.up[left_below]) return false;
+    const auto N0 = static_cast<double>(T2.number_of_vertices());
+    if (!accept(shrink_ * volume_fixing(-2) * N0 / (N0 - 1.0))) {
+      return false;
+    }
+
+    link(left_above, T2.right[i]);
+    link(left_below, T2.right[below]);
+    T2.slice_volume[t]--;
+    // Remove the higher index first, so the lower one is not moved
+    remove_triangle(std::max(i, below));
+    remove_triangle(std::min(i, below));
+    return true;
+  }
+
+  /// @returns \f$e^{-\Delta S}\f$ of the volume-fixing term when a move
+  /// changes \f$N_2\f$ by **change**
+  double volume_fixing(const int change) const noexcept {
+    if (epsilon_ == 0) return 1.0;
+    const auto before = static_cast<double>(T2_->number_of_triangles()) -
+                        target_volume_;
+    const auto after = before + change;
+    return std::exp(-epsilon_ * (after * after - before * before));
+  }
+
+  bool accept(const double ratio) noexcept {
+    return ratio >= 1.0 || rng_.uniform_real() < ratio;
+  }
+
+  /// @brief Makes **a** the left neighbor of **b**
+  void link(const std::uint32_t a, const std::uint32_t b) noexcept {
+    T2_->right[a] = b;
+    T2_->left[b] = a;
+  }
+
+  /// @returns The index of a new, unlinked triangle
+  std::uint32_t add_triangle(const std::uint8_t up,
+                             const std::uint32_t slab) noexcept {
+    auto& T2 = *T2_;
+    const auto index = static_cast<std::uint32_t>(T2.up.size());
+    T2.up.push_back(up);
+    T2.slab.push_back(slab);
+    T2.left.push_back(index);
+    T2.right.push_back(index);
+    T2.vertical.push_back(index);
+    return index;
+  }
+
+  /// @brief Fills triangle **i**, already unlinked, with the last triangle
+  void remove_triangle(const std::uint32_t i) noexcept {
+    auto& T2 = *T2_;
+    const auto last = static_cast<std::uint32_t>(T2.up.size() - 1);
+    if (i != last) {
+      T2.up[i] = T2.up[last];
+      T2.slab[i] = T2.slab[last];
+      T2.left[i] = T2.left[last];
+      T2.right[i] = T2.right[last];
+      T2.vertical[i] = T2.vertical[last];
+      T2.right[T2.left[i]] = i;
+      T2.left[T2.right[i]] = i;
+      T2.vertical[T2.vertical[i]] = i;
+    }
+    T2.up.pop_back();
+    T2.slab.pop_back();
+    T2.left.pop_back();
+    T2.right.pop_back();
+    T2.vertical.pop_back();
+  }
+
+  Triangulation_2d* T2_;
+  Random_engine rng_;
+  std::size_t sweep_length_;
+  double lambda_;
+  /// Acceptance factors \f$e^{\mp 2\lambda}\f$
+  double grow_;
+  double shrink_;
+  double target_volume_;
+  double epsilon_;
+  std::array<std::uint64_t, NUMBER_OF_2D_MOVES> attempted_;
+  std::array<std::uint64_t, NUMBER_OF_2D_MOVES> accepted_;
+};
+
+#endif  // SRC_METROPOLIS2D_H_
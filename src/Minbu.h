@@ -0,0 +1,364 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Minimal-neck baby universes of the spatial slices
+///
+/// Each timeslice is a triangulated 2-sphere made of the spacelike
+/// triangles on it. A minimal neck is a cycle of three edges which is not a
+/// triangle: cutting along it splits the sphere in two, and the smaller
+/// part is a baby universe. Minimal necks never cross, so the baby
+/// universes of a slice nest into a tree whose root is the whole slice.
+///
+/// For each slice, in parallel over slices:
+///
+/// - 3-cycles are listed by orienting every edge towards the vertex of
+///   higher degree, which takes O(E) on a planar graph
+/// - each 3-cycle which is not a triangle is measured by breadth-first
+///   searches of the dual graph, one on each side of the neck, taking turns
+///   until one runs out, so a neck costs the size of its baby universe
+/// - necks are taken from smallest to largest, and each becomes the parent
+///   of the largest baby universes already inside it
+///
+/// The total cost is the sum of the baby universe sizes, which is
+/// \f$O(N \log N)\f$ for the trees of branched polymers CDT is compared to.
+///
+/// \done Minimal necks of every spatial slice
+/// \done Baby universe sizes and tree
+/// \done Parallel over slices
+
+/// @file Minbu.h
+/// @brief Minimal-neck baby universe trees
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_MINBU_H_
+#define SRC_MINBU_H_
+
+// CDT headers
+#include "TriangulationArrays.h"
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// Parent of a baby universe growing straight out of its slice
+static constexpr std::int32_t MOTHER_UNIVERSE = -1;
+
+/// @brief The part of a slice cut off by a minimal neck
+struct Baby_universe {
+  std::uint32_t timeslice;
+  /// The vertices of the neck, in increasing order
+  std::array<std::uint32_t, 3> neck;
+  /// Spacelike triangles in the baby universe
+  std::uint32_t volume;
+  /// The baby universe it grows out of, or MOTHER_UNIVERSE
+  std::int32_t parent;
+};
+
+/// @brief The baby universes of every slice
+struct Minbu_tree {
+  /// Ordered by timeslice, then by increasing volume; parents are indices
+  /// into this vector
+  std::vector<Baby_universe> babies;
+  /// Spacelike triangles on each timeslice
+  std::vector<std::uint32_t> slice_volume;
+};
+
+/// @brief Finds the baby universes of one slice
+///
+/// @param[in]  timeslice The slice
+/// @param[in]  triangles Its triangles, each with sorted vertices
+/// @param[out] babies    Its baby universes, with parents counted from 0
+inline void find_slice_minbus(
+    const std::uint32_t timeslice,
+    std::vector<std::array<std::uint32_t, 3>>* const triangles,
+    std::vector<Baby_universe>* const babies) noexcept {
+  babies->clear();
+  auto& F = *triangles;
+  std::sort(F.begin(), F.end());
+  F.erase(std::unique(F.begin(), F.end()), F.end());
+  const auto faces = static_cast<std::uint32_t>(F.size());
+
+  // Edges as (u, v, triangle) with u < v, grouped by sorting
+  std::vector<std::array<std::uint32_t, 3>> incidences;
+  incidences.reserve(3 * faces);
+  for (auto f = static_cast<std::uint32_t>(0); f < faces; ++f) {
+    incidences.push_back({{F[f][0], F[f][1], f}});
+    incidences.push_back({{F[f][1], F[f][2], f}});
+    incidences.push_back({{F[f][0], F[f][2], f}});
+  }
+  std::sort(incidences.begin(), incidences.end());
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+  std::vector<std::uint32_t> dual(3 * faces, faces);
+  std::vector<std::uint8_t> sides(faces, 0);
+  for (auto i = static_cast<std::size_t>(0); i < incidences.size();) {
+    const auto& a = incidences[i];
+    auto j = i + 1;
+    while (j < incidences.size() && incidences[j][0] == a[0] &&
+           incidences[j][1] == a[1]) {
+      ++j;
+    }
+    edges.emplace_back(a[0], a[1]);
+    // Each edge of a closed surface is on exactly two triangles
+    if (j == i + 2) {
+      const auto b = incidences[i + 1][2];
+      dual[3 * a[2] + sides[a[2]]++] = b;
+      dual[3 * b + sides[b]++] = a[2];
+    }
+    i = j;
+  }
+  auto edge_index = [&edges](std::uint32_t u, std::uint32_t v) {
+    if (u > v) std::swap(u, v);
+    return static_cast<std::uint32_t>(
+        std::lower_bound(edges.begin(), edges.end(), std::make_pair(u, v)) -
+        edges.begin());
+  };
+  // The dual edge from f to its k-th neighbor crosses this edge
+  std::vector<std::uint32_t> crossing(3 * faces);
+  for (auto f = static_cast<std::uint32_t>(0); f < faces; ++f) {
+    for (auto k = 0; k < 3; ++k) {
+      const auto g = dual[3 * f + k];
+      if (g == faces) continue;
+      // The shared edge is made of the two vertices common to f and g
+      std::array<std::uint32_t, 2> shared;
+      auto s = 0;
+      for (const auto v : F[f]) {
+        if (s < 2 && std::binary_search(F[g].begin(), F[g].end(), v)) {
+          shared[s++] = v;
+        }
+      }
+      crossing[3 * f + k] = edge_index(shared[0], shared[1]);
+    }
+  }
+
+  // Vertices, renumbered, and their degrees
+  std::vector<std::uint32_t> vertices;
+  for (const auto& e : edges) {
+    vertices.push_back(e.first);
+    vertices.push_back(e.second);
+  }
+  std::sort(vertices.begin(), vertices.end());
+  vertices.erase(std::unique(vertices.begin(), vertices.end()),
+                 vertices.end());
+  auto vertex_index = [&vertices](const std::uint32_t v) {
+    return static_cast<std::uint32_t>(
+        std::lower_bound(vertices.begin(), vertices.end(), v) -
+        vertices.begin());
+  };
+  const auto n = vertices.size();
+  std::vector<std::uint32_t> degree(n, 0);
+  for (const auto& e : edges) {
+    degree[vertex_index(e.first)]++;
+    degree[vertex_index(e.second)]++;
+  }
+  // Each edge points from its lower to its higher ranked end
+  auto ranks_below = [&degree](const std::uint32_t a, const std::uint32_t b) {
+    return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+  };
+  std::vector<std::uint32_t> out_start(n + 1, 0);
+  for (const auto& e : edges) {
+    const auto a = vertex_index(e.first);
+    const auto b = vertex_index(e.second);
+    out_start[(ranks_below(a, b) ? a : b) + 1]++;
+  }
+  for (auto v = static_cast<std::size_t>(0); v < n; ++v) {
+    out_start[v + 1] += out_start[v];
+  }
+  std::vector<std::uint32_t> out(edges.size());
+  std::vector<std::uint32_t> filled(out_start.begin(), out_start.end() - 1);
+  for (const auto& e : edges) {
+    const auto a = vertex_index(e.first);
+    const auto b = vertex_index(e.second);
+    if (ranks_below(a, b)) {
+      out[filled[a]++] = b;
+    } else {
+      out[filled[b]++] = a;
+    }
+  }
+
+  // 3-cycles which are not triangles are necks
+  std::vector<std::array<std::uint32_t, 3>> necks;
+  std::vector<std::uint32_t> marked(n, static_cast<std::uint32_t>(n));
+  for (auto u = static_cast<std::uint32_t>(0); u < n; ++u) {
+    for (auto i = out_start[u]; i < out_start[u + 1]; ++i) marked[out[i]] = u;
+    for (auto i = out_start[u]; i < out_start[u + 1]; ++i) {
+      const auto v = out[i];
+      for (auto j = out_start[v]; j < out_start[v + 1]; ++j) {
+        const auto w = out[j];
+        if (marked[w] != u) continue;
+        std::array<std::uint32_t, 3> cycle{{vertices[u], vertices[v],
+                                            vertices[w]}};
+        std::sort(cycle.begin(), cycle.end());
+        if (!std::binary_search(F.begin(), F.end(), cycle)) {
+          necks.push_back(cycle);
+        }
+      }
+    }
+  }
+
+  // Measure each neck from the two triangles across one of its edges
+  std::vector<std::uint32_t> stamp(faces, 0);
+  std::vector<std::vector<std::uint32_t>> inside;
+  auto visit = 0u;
+  for (const auto& neck : necks) {
+    const std::array<std::uint32_t, 3> cut{{edge_index(neck[0], neck[1]),
+                                            edge_index(neck[1], neck[2]),
+                                            edge_index(neck[0], neck[2])}};
+    // The two triangles on the neck's first edge
+    const std::array<std::uint32_t, 3> first{{neck[0], neck[1], 0}};
+    const auto on_edge = std::lower_bound(incidences.begin(),
+                                          incidences.end(), first);
+    std::array<std::uint32_t, 2> start{{faces, faces}};
+    auto found = 0;
+    for (auto i = on_edge; i != incidences.end() && found < 2 &&
+                           (*i)[0] == neck[0] && (*i)[1] == neck[1]; ++i) {
+      start[found++] = (*i)[2];
+    }
+    if (found < 2) continue;
+    std::array<std::vector<std::uint32_t>, 2> side;
+    std::array<std::size_t, 2> next{{0, 0}};
+    std::array<std::uint32_t, 2> mark{{visit + 1, visit + 2}};
+    visit += 2;
+    for (auto s = 0; s < 2; ++s) {
+      side[s].push_back(start[s]);
+      stamp[start[s]] = mark[s];
+    }
+    // Take turns until one side runs out, or they meet
+    auto smaller = -1;
+    auto separating = true;
+    while (smaller < 0 && separating) {
+      for (auto s = 0; s < 2 && smaller < 0 && separating; ++s) {
+        if (next[s] == side[s].size()) {
+          smaller = s;
+          break;
+        }
+        const auto f = side[s][next[s]++];
+        for (auto k = 0; k < 3; ++k) {
+          const auto g = dual[3 * f + k];
+          if (g == faces || std::find(cut.begin(), cut.end(),
+                                      crossing[3 * f + k]) != cut.end()) {
+            continue;
+          }
+          if (stamp[g] == mark[1 - s]) {
+            separating = false;
+            break;
+          }
+          if (stamp[g] != mark[s]) {
+            stamp[g] = mark[s];
+            side[s].push_back(g);
+          }
+        }
+      }
+    }
+    if (!separating) continue;
+    babies->push_back(Baby_universe{
+        timeslice, neck, static_cast<std::uint32_t>(side[smaller].size()),
+        MOTHER_UNIVERSE});
+    inside.push_back(std::move(side[smaller]));
+  }
+
+  // From the smallest up, each baby adopts the largest babies inside it
+  std::vector<std::uint32_t> order(babies->size());
+  for (auto i = static_cast<std::uint32_t>(0); i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [babies](const std::uint32_t a, const std::uint32_t b) {
+                     return (*babies)[a].volume < (*babies)[b].volume;
+                   });
+  std::vector<std::int32_t> label(faces, MOTHER_UNIVERSE);
+  for (const auto b : order) {
+    for (const auto f : inside[b]) {
+      const auto child = label[f];
+      if (child != MOTHER_UNIVERSE && child != static_cast<std::int32_t>(b) &&
+          (*babies)[child].parent == MOTHER_UNIVERSE) {
+        (*babies)[child].parent = static_cast<std::int32_t>(b);
+      }
+      label[f] = static_cast<std::int32_t>(b);
+    }
+  }
+
+  // Renumber by increasing volume
+  std::vector<std::int32_t> position(babies->size());
+  for (auto i = static_cast<std::size_t>(0); i < order.size(); ++i) {
+    position[order[i]] = static_cast<std::int32_t>(i);
+  }
+  std::vector<Baby_universe> sorted;
+  sorted.reserve(babies->size());
+  for (const auto b : order) {
+    sorted.push_back((*babies)[b]);
+    if (sorted.back().parent != MOTHER_UNIVERSE) {
+      sorted.back().parent = position[sorted.back().parent];
+    }
+  }
+  babies->swap(sorted);
+}  // find_slice_minbus()
+
+/// @brief Finds the baby universes of every spatial slice
+///
+/// @param[in]  arrays  The triangulation
+/// @param[in]  threads The number of threads working on slices
+/// @param[out] tree    The baby universes
+inline void find_minbus(const Triangulation_arrays& arrays,
+                        const unsigned threads,
+                        Minbu_tree* const tree) noexcept {
+  const auto cells = arrays.cell_type.size();
+  auto timeslices = static_cast<std::uint32_t>(0);
+  for (const auto t : arrays.timeslice) {
+    timeslices = std::max(timeslices, t + 1);
+  }
+
+  // Spacelike facets, i.e. those of (3,1) and (1,3) simplices with all
+  // three vertices on one slice
+  std::vector<std::vector<std::array<std::uint32_t, 3>>> slices(timeslices);
+  for (auto c = static_cast<std::size_t>(0); c < cells; ++c) {
+    if (arrays.cell_type[c] != 31 && arrays.cell_type[c] != 13) continue;
+    for (auto k = 0u; k < 4; ++k) {
+      std::array<std::uint32_t, 3> facet;
+      auto f = 0;
+      for (auto m = 0u; m < 4; ++m) {
+        if (m != k) facet[f++] = arrays.cell_vertices[m * cells + c];
+      }
+      const auto t = arrays.timeslice[facet[0]];
+      if (arrays.timeslice[facet[1]] != t || arrays.timeslice[facet[2]] != t) {
+        continue;
+      }
+      std::sort(facet.begin(), facet.end());
+      slices[t].push_back(facet);
+    }
+  }
+
+  std::vector<std::vector<Baby_universe>> babies(timeslices);
+  tree->slice_volume.assign(timeslices, 0);
+  std::atomic<std::uint32_t> next{0};
+  auto work = [&]() {
+    for (auto t = next++; t < timeslices; t = next++) {
+      find_slice_minbus(t, &slices[t], &babies[t]);
+      tree->slice_volume[t] = static_cast<std::uint32_t>(slices[t].size());
+    }
+  };
+  std::vector<std::thread> workers;
+  for (auto i = 1u; i < std::min(std::max(threads, 1u), timeslices); ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) worker.join();
+
+  tree->babies.clear();
+  for (const auto& slice : babies) {
+    const auto offset = static_cast<std::int32_t>(tree->babies.size());
+    for (auto baby : slice) {
+      if (baby.parent != MOTHER_UNIVERSE) baby.parent += offset;
+      tree->babies.push_back(baby);
+    }
+  }
+}  // find_minbus()
+
+#endif  // SRC_MINBU_H_
@@ -0,0 +1,237 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Chooses which ergodic move to attempt next, and adapts the mix
+///
+/// Each move type has a proposal probability. The scheduler records, per
+/// move type, how many moves were attempted and accepted and how long they
+/// took. During thermalization **adapt()** shifts probability between
+/// inverse pairs, (2,3) with (3,2) and (2,6) with (6,2), toward the pair
+/// which yields the most accepted moves per CPU-second, and within each pair
+/// toward the move more often accepted. The driver only enables (2,3) and
+/// (3,2), so the split within a pair is what changes in practice. Unequal
+/// probabilities for a move and its inverse are allowed for by the mix ratio
+/// in the Metropolis-Hastings acceptance. Adapting during measurement would
+/// make the chain depend on its own history, so the mix is frozen before
+/// measurements begin.
+///
+/// \done Per-move acceptance and cost statistics
+/// \done Adaptive proposal probabilities
+/// \done Adaptive split within inverse pairs
+/// \done Freeze for measurement
+
+/// @file MoveScheduler.h
+/// @brief Adaptive proposal probabilities for ergodic moves
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_MOVESCHEDULER_H_
+#define SRC_MOVESCHEDULER_H_
+
+// CDT headers
+#include "Random.h"
+
+// C++ headers
+#include <array>
+#include <cstdint>
+#include <string>
+
+enum class move_type { TWO_THREE, THREE_TWO, TWO_SIX, SIX_TWO };
+
+static constexpr std::size_t NUMBER_OF_MOVE_TYPES = 4;
+
+/// @returns A printable name for the move type
+inline std::string move_name(const move_type move) noexcept {
+  switch (move) {
+    case move_type::TWO_THREE:
+      return "(2,3)";
+    case move_type::THREE_TWO:
+      return "(3,2)";
+    case move_type::TWO_SIX:
+      return "(2,6)";
+    default:
+      return "(6,2)";
+  }
+}  // move_name()
+
+/// @returns The move which undoes **move**
+inline move_type inverse_move(const move_type move) noexcept {
+  switch (move) {
+    case move_type::TWO_THREE:
+      return move_type::THREE_TWO;
+    case move_type::THREE_TWO:
+      return move_type::TWO_THREE;
+    case move_type::TWO_SIX:
+      return move_type::SIX_TWO;
+    default:
+      return move_type::TWO_SIX;
+  }
+}  // inverse_move()
+
+/// Attempts, acceptances, and time spent on one move type. Moves are only
+/// timed while the mix adapts.
+struct Move_statistics {
+  std::uint64_t attempted{0};
+  std::uint64_t accepted{0};
+  double seconds{0.0};
+};
+
+/// @brief Proposal probabilities for each move type
+class Move_scheduler {
+ public:
+  /// No enabled pair of moves gets less than this share of proposals
+  static constexpr double MIN_PAIR_PROBABILITY = 0.1;
+  /// No move of a pair with both enabled gets less than this fraction of
+  /// the pair's share
+  static constexpr double MIN_MOVE_FRACTION = 0.2;
+  /// Weight of the previous mix when adapting
+  static constexpr double SMOOTHING = 0.5;
+
+  /// @param[in] weights Relative initial weight of each move type, in the
+  ///                    order of **move_type**. A weight of 0 disables a move.
+  explicit Move_scheduler(
+      const std::array<double, NUMBER_OF_MOVE_TYPES>& weights) noexcept
+      : frozen_(false) {
+    for (auto i = 0u; i < NUMBER_OF_MOVE_TYPES; ++i) {
+      enabled_[i] = weights[i] > 0.0;
+      probability_[i] = enabled_[i] ? weights[i] : 0.0;
+    }
+    normalize();
+  }
+
+  /// @brief Picks a move type according to the current mix
+  ///
+  /// @param[in,out] rng The random number generator; one draw is consumed
+  /// @returns The move type to attempt
+  move_type choose(Random_engine* const rng) const noexcept {
+    const auto u = rng->uniform_real();
+    auto cumulative = 0.0;
+    auto last = 0u;
+    for (auto i = 0u; i < NUMBER_OF_MOVE_TYPES; ++i) {
+      if (!enabled_[i]) continue;
+      cumulative += probability_[i];
+      last = i;
+      if (u < cumulative) return static_cast<move_type>(i);
+    }
+    return static_cast<move_type>(last);
+  }
+
+  /// @returns The probability of proposing **move**
+  double probability(const move_type move) const noexcept {
+    return probability_[static_cast<std::size_t>(move)];
+  }
+
+  /// @brief Records the outcome of one attempted move
+  ///
+  /// @param[in] move     The move type attempted
+  /// @param[in] accepted Whether the move was accepted and made
+  /// @param[in] seconds  Time spent proposing, evaluating, and making it,
+  ///                     or 0 if not timed
+  void record(const move_type move,
+              const bool accepted,
+              const double seconds) noexcept {
+    const auto i = static_cast<std::size_t>(move);
+    for (auto* stats : {&total_[i], &window_[i]}) {
+      stats->attempted++;
+      if (accepted) stats->accepted++;
+      stats->seconds += seconds;
+    }
+  }
+
+  /// @brief Shifts the mix toward moves with more acceptances per second
+  ///
+  /// Within each pair with both moves enabled, each move gets a fraction of
+  /// the pair's share proportional to its acceptance rate since the last
+  /// call, floored at **MIN_MOVE_FRACTION**. If more than one pair is
+  /// enabled, each pair gets a share proportional to the accepted moves per
+  /// second it achieved, floored at **MIN_PAIR_PROBABILITY**. Both targets
+  /// are blended with the previous mix by **SMOOTHING**, and moves or pairs
+  /// without data since the last call keep their current probability. Does
+  /// nothing once frozen.
+  void adapt() noexcept {
+    if (frozen_) return;
+
+    std::array<double, NUMBER_OF_MOVE_TYPES> rate{};
+    auto total_rate = 0.0;
+    auto enabled_pairs = 0u;
+    for (auto i = 0u; i < NUMBER_OF_MOVE_TYPES; i += 2) {
+      if (!enabled_[i] && !enabled_[i + 1]) continue;
+      enabled_pairs++;
+      balance_pair(i);
+      const auto accepted = window_[i].accepted + window_[i + 1].accepted;
+      const auto seconds = window_[i].seconds + window_[i + 1].seconds;
+      // Pairs without timing data keep their current share
+      rate[i] = (seconds > 0.0) ? accepted / seconds : -1.0;
+      if (rate[i] > 0.0) total_rate += rate[i];
+    }
+    if (total_rate <= 0.0 || enabled_pairs < 2) {
+      normalize();
+      window_ = {};
+      return;
+    }
+
+    const auto free_share = 1.0 - MIN_PAIR_PROBABILITY * enabled_pairs;
+    for (auto i = 0u; i < NUMBER_OF_MOVE_TYPES; i += 2) {
+      if (!enabled_[i] && !enabled_[i + 1]) continue;
+      const auto current = probability_[i] + probability_[i + 1];
+      if (current <= 0.0) continue;
+      const auto target = (rate[i] < 0.0) ? current :
+          MIN_PAIR_PROBABILITY + free_share * rate[i] / total_rate;
+      const auto share = SMOOTHING * current + (1.0 - SMOOTHING) * target;
+      probability_[i] *= share / current;
+      probability_[i + 1] *= share / current;
+    }
+    normalize();
+    window_ = {};
+  }
+
+  /// @brief Stops adaptation so the mix is fixed for measurement
+  void freeze() noexcept { frozen_ = true; }
+
+  bool frozen() const noexcept { return frozen_; }
+
+  /// @returns Statistics for **move** since the scheduler was created
+  const Move_statistics& statistics(const move_type move) const noexcept {
+    return total_[static_cast<std::size_t>(move)];
+  }
+
+ private:
+  /// @brief Splits the share of the pair starting at **i** between its
+  /// moves by acceptance rate
+  void balance_pair(const std::size_t i) noexcept {
+    if (!enabled_[i] || !enabled_[i + 1]) return;
+    const auto& forward = window_[i];
+    const auto& reverse = window_[i + 1];
+    if (forward.attempted == 0 || reverse.attempted == 0) return;
+    const auto forward_rate = static_cast<double>(forward.accepted) /
+                              forward.attempted;
+    const auto reverse_rate = static_cast<double>(reverse.accepted) /
+                              reverse.attempted;
+    if (forward_rate + reverse_rate <= 0.0) return;
+
+    const auto share = probability_[i] + probability_[i + 1];
+    const auto current = probability_[i] / share;
+    const auto target = MIN_MOVE_FRACTION + (1.0 - 2.0 * MIN_MOVE_FRACTION) *
+                        forward_rate / (forward_rate + reverse_rate);
+    const auto fraction = SMOOTHING * current + (1.0 - SMOOTHING) * target;
+    probability_[i] = share * fraction;
+    probability_[i + 1] = share * (1.0 - fraction);
+  }
+
+  void normalize() noexcept {
+    auto sum = 0.0;
+    for (const auto p : probability_) sum += p;
+    if (sum <= 0.0) return;
+    for (auto& p : probability_) p /= sum;
+  }
+
+  std::array<double, NUMBER_OF_MOVE_TYPES> probability_;
+  std::array<bool, NUMBER_OF_MOVE_TYPES> enabled_;
+  std::array<Move_statistics, NUMBER_OF_MOVE_TYPES> total_;
+  std::array<Move_statistics, NUMBER_OF_MOVE_TYPES> window_;
+  bool frozen_;
+};
+
+#endif  // SRC_MOVESCHEDULER_H_
@@ -0,0 +1,488 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Move traces for deterministic replay
+///
+/// A Move_trace keeps the last attempted moves of a Metropolis run in a
+/// fixed ring of Move_records: the move type, the (2,2) simplex and its
+/// facet or edge, the change in action, the outcome, how many random draws
+/// had been made, and its slot in its batch. Recording a move is a copy
+/// into the ring, with no allocation.
+///
+/// Cell handles do not survive a save and load, so simplices are recorded
+/// by their vertices. Vertices are numbered in lexicographic order of their
+/// points, which the (2,3) and (3,2) moves never change, so a universe
+/// loaded from a checkpoint numbers them the same way.
+///
+/// Checkpoints are taken between sweeps, and between annealing passes, once
+/// half the ring has filled since the last one: a Snapshot_writer saves the
+/// universe next to the trace on its own thread, and the checkpoint takes
+/// effect between later sweeps, once it is written. A ring holding at least
+/// two sweeps of attempts therefore always reaches back to a checkpoint, and
+/// reaches_checkpoint() reports when it does not. The trace is written on
+/// request, at the end of the run, or from a signal handler if the run
+/// crashes. Replay loads the checkpoint and remakes the accepted moves in
+/// order, without drawing random numbers or evaluating acceptance, and
+/// checks the triangulation_hash() of the universe it starts and ends with
+/// against those the run recorded.
+///
+/// \done Ring buffer of attempted moves
+/// \done Checkpoints the ring reaches back to, saved asynchronously
+/// \done Written on request, at exit, and on crashes
+/// \done Replay from the checkpoint to the same triangulation
+
+/// @file MoveTrace.h
+/// @brief Move traces and their replay
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_MOVETRACE_H_
+#define SRC_MOVETRACE_H_
+
+// CDT headers
+#include "Differential.h"
+#include "Metropolis.h"
+#include "SeedCache.h"
+#include "TimesliceIndex.h"
+
+// C headers
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// Format version of move trace files
+static constexpr std::uint32_t MOVE_TRACE_FORMAT = 3;
+
+/// Vertex number of a move with no simplex
+static constexpr std::uint32_t NO_TRACE_VERTEX = 0xFFFFFFFF;
+
+/// @brief One attempted move
+struct Move_record {
+  /// Random draws made by the end of the move's decision. A batched sweep
+  /// draws every uniform of a batch before deciding any of its moves, so
+  /// this is the same for the whole batch and identifies it.
+  std::uint64_t draws;
+  double delta_action;
+  /// Passes completed before the move
+  std::uint32_t pass;
+  /// Position of the move in its batch, or 0 outside batched sweeps
+  std::uint32_t slot;
+  /// Vertex numbers of the (2,2) simplex, in its vertex order
+  std::array<std::uint32_t, 4> vertices;
+  /// A move_type
+  std::uint8_t type;
+  /// A move_outcome
+  std::uint8_t outcome;
+  /// The facet (i) or edge (i, j) of the (2,2) simplex
+  std::int8_t i;
+  std::int8_t j;
+};
+
+/// @brief Fixed-size header of a move trace file, followed by its records
+struct Move_trace_header {
+  char magic[8];
+  std::uint32_t format;
+  std::uint32_t record_size;
+  /// The Universe_key the checkpoint was saved with
+  Universe_key key;
+  /// Number of moves recorded before the checkpoint
+  std::uint64_t checkpoint;
+  std::uint64_t checkpoint_pass;
+  std::uint64_t checkpoint_draws;
+  /// Number of moves recorded before the first record in the file
+  std::uint64_t first;
+  /// Records in the file
+  std::uint64_t count;
+  /// N1_TL, N3_31, and N3_22 at the checkpoint
+  std::array<std::uint64_t, 3> checkpoint_counts;
+  /// N1_TL, N3_31, and N3_22 when the trace was written
+  std::array<std::uint64_t, 3> final_counts;
+  /// triangulation_hash() of the checkpoint
+  std::uint64_t checkpoint_hash;
+  /// triangulation_hash() when the trace was written, or 0 if it was
+  /// written by the crash handler
+  std::uint64_t final_hash;
+};
+
+/// @brief Numbers finite vertices in lexicographic order of their points
+///
+/// @param[in]  D3       The Delaunay triangulation
+/// @param[out] vertices The vertices in number order
+inline void number_trace_vertices(
+    const Delaunay& D3,
+    std::vector<Vertex_handle>* const vertices) noexcept {
+  vertices->clear();
+  vertices->reserve(D3.number_of_vertices());
+  Delaunay::Finite_vertices_iterator vit;
+  for (vit = D3.finite_vertices_begin(); vit != D3.finite_vertices_end();
+       ++vit) {
+    vertices->push_back(vit);
+  }
+  std::sort(vertices->begin(), vertices->end(),
+            [](const Vertex_handle& a, const Vertex_handle& b) {
+              return a->point() < b->point();
+            });
+}  // number_trace_vertices()
+
+/// @brief Ring buffer of the last attempted moves of a run
+class Move_trace {
+ public:
+  /// @param[in] D3       The triangulation being evolved
+  /// @param[in] key      The Universe_key checkpoints are saved with
+  /// @param[in] capacity Moves held
+  /// @param[in] path     The trace file; checkpoints are saved to
+  ///                     **path**.cdt
+  Move_trace(const Delaunay& D3,
+             const Universe_key& key,
+             const std::size_t capacity,
+             const std::string& path) noexcept
+      : D3_(&D3),
+        ring_(std::max(capacity, static_cast<std::size_t>(2))),
+        path_(path),
+        checkpoint_path_(path + ".cdt"),
+        pending_path_(path + ".cdt.pending"),
+        recorded_(0),
+        pass_(0),
+        metropolis_(nullptr),
+        writer_(nullptr),
+        pending_saved_(0) {
+    std::memset(&header_, 0, sizeof(header_));
+    std::memcpy(header_.magic, "CDTTRACE", 8);
+    header_.format = MOVE_TRACE_FORMAT;
+    header_.record_size = sizeof(Move_record);
+    header_.key = key;
+    pending_ = header_;
+    std::vector<Vertex_handle> vertices;
+    number_trace_vertices(D3, &vertices);
+    numbers_.reserve(vertices.size());
+    for (auto v = static_cast<std::uint32_t>(0); v < vertices.size(); ++v) {
+      numbers_.emplace(vertices[v], v);
+    }
+  }
+
+  /// @brief Records an attempted move
+  ///
+  /// @param[in] proposal     The proposal
+  /// @param[in] outcome      What became of it
+  /// @param[in] delta_action Its change in action, or 0 if impossible
+  /// @param[in] draws        Random draws made so far
+  /// @param[in] slot         Its position in its batch
+  void record(const Move_proposal& proposal,
+              const move_outcome outcome,
+              const double delta_action,
+              const std::uint64_t draws,
+              const std::size_t slot) noexcept {
+    auto& entry = ring_[recorded_ % ring_.size()];
+    entry.draws = draws;
+    entry.delta_action = delta_action;
+    entry.pass = static_cast<std::uint32_t>(pass_);
+    entry.slot = static_cast<std::uint32_t>(slot);
+    entry.type = static_cast<std::uint8_t>(proposal.type);
+    entry.outcome = static_cast<std::uint8_t>(outcome);
+    entry.i = static_cast<std::int8_t>(proposal.i);
+    entry.j = static_cast<std::int8_t>(proposal.j);
+    for (auto k = 0; k < 4; ++k) {
+      entry.vertices[k] = NO_TRACE_VERTEX;
+      if (proposal.cell == Cell_handle()) continue;
+      const auto found = numbers_.find(proposal.cell->vertex(k));
+      if (found != numbers_.end()) entry.vertices[k] = found->second;
+    }
+    ++recorded_;
+  }
+
+  /// @brief Sets the number of passes completed, stamped on later records
+  void set_pass(const std::uint64_t pass) noexcept { pass_ = pass; }
+
+  /// @brief Records the counts and random draws of **metropolis** when
+  /// the trace is written
+  void set_metropolis(Metropolis* const metropolis) noexcept {
+    metropolis_ = metropolis;
+  }
+
+  /// @returns True if half the ring has filled since the last checkpoint,
+  /// and no checkpoint is being written
+  bool needs_checkpoint() const noexcept {
+    return writer_ == nullptr &&
+           recorded_ - header_.checkpoint >= ring_.size() / 2;
+  }
+
+  /// @returns True if no move since the last checkpoint has been
+  /// overwritten, so the trace can be replayed
+  bool reaches_checkpoint() const noexcept {
+    return recorded_ - header_.checkpoint <= ring_.size();
+  }
+
+  /// @brief Saves the universe to **checkpoint_path()**, from which
+  /// replay starts
+  ///
+  /// @returns True if the checkpoint was saved
+  bool checkpoint() noexcept {
+    if (!save_universe(checkpoint_path_, header_.key, *D3_)) return false;
+    mark_checkpoint(&header_);
+    return true;
+  }
+
+  /// @brief Starts saving the universe on **writer**'s thread
+  ///
+  /// The checkpoint takes effect at the first **finish_checkpoint()** after
+  /// **writer** is done; until then the previous one stays in
+  /// **checkpoint_path()**.
+  ///
+  /// @param[in,out] writer The Snapshot_writer, not running while this
+  ///                       checkpoint is pending
+  /// @returns False if **writer** is busy, so the checkpoint should be
+  /// retried later
+  bool checkpoint(Snapshot_writer* const writer) noexcept {
+    if (writer_ != nullptr) return false;
+    pending_saved_ = writer->saved();
+    if (!writer->start(pending_path_, header_.key, *D3_)) return false;
+    writer_ = writer;
+    mark_checkpoint(&pending_);
+    return true;
+  }
+
+  /// @brief Puts a checkpoint started by **checkpoint(writer)** into
+  /// effect, if it has been written
+  ///
+  /// @returns False if it could not be written
+  bool finish_checkpoint() noexcept {
+    if (writer_ == nullptr || writer_->busy()) return true;
+    const auto saved = writer_->saved() > pending_saved_;
+    writer_ = nullptr;
+    if (!saved ||
+        rename(pending_path_.c_str(), checkpoint_path_.c_str()) != 0) {
+      return false;
+    }
+    header_ = pending_;
+    return true;
+  }
+
+  /// @brief Writes the moves since the checkpoint to **path()**
+  ///
+  /// Without **final_hash**, only open(), write(), and close() are called,
+  /// so this is safe in a signal handler.
+  ///
+  /// @param[in] final_hash Records the triangulation_hash() of the universe
+  /// @returns True if the file was written completely
+  bool write(const bool final_hash = true) const noexcept {
+    const auto fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    auto header = header_;
+    header.first = std::max(header.checkpoint,
+                            recorded_ > ring_.size() ?
+                            recorded_ - ring_.size() : 0);
+    header.count = recorded_ - header.first;
+    if (metropolis_ != nullptr) {
+      header.final_counts = {{metropolis_->N1_TL(), metropolis_->N3_31(),
+                              metropolis_->N3_22()}};
+    }
+    header.final_hash = final_hash ? triangulation_hash(*D3_) : 0;
+    auto written = write_all(fd, &header, sizeof(header));
+    // The records wrap around the end of the ring at most once
+    const auto start = header.first % ring_.size();
+    const auto first_part = std::min<std::uint64_t>(header.count,
+                                                    ring_.size() - start);
+    written = written &&
+              write_all(fd, &ring_[start], first_part * sizeof(Move_record)) &&
+              write_all(fd, ring_.data(),
+                        (header.count - first_part) * sizeof(Move_record));
+    return (::close(fd) == 0) && written;
+  }
+
+  std::uint64_t recorded() const noexcept { return recorded_; }
+  std::size_t capacity() const noexcept { return ring_.size(); }
+  const std::string& path() const noexcept { return path_; }
+  const std::string& checkpoint_path() const noexcept {
+    return checkpoint_path_;
+  }
+  std::size_t buffer_bytes() const noexcept {
+    return ring_.size() * sizeof(Move_record);
+  }
+
+ private:
+  /// @brief Records the current move, pass, draws, counts, and hash as
+  /// those of the checkpoint in **header**
+  void mark_checkpoint(Move_trace_header* const header) const noexcept {
+    header->checkpoint = recorded_;
+    header->checkpoint_pass = pass_;
+    header->checkpoint_hash = triangulation_hash(*D3_);
+    if (metropolis_ != nullptr) {
+      header->checkpoint_draws = metropolis_->rng().draws();
+      header->checkpoint_counts = {{metropolis_->N1_TL(),
+                                    metropolis_->N3_31(),
+                                    metropolis_->N3_22()}};
+    }
+  }
+
+  static bool write_all(const int fd,
+                        const void* const data,
+                        std::size_t bytes) noexcept {
+    auto p = static_cast<const char*>(data);
+    while (bytes > 0) {
+      const auto n = ::write(fd, p, bytes);
+      if (n <= 0) return false;
+      p += n;
+      bytes -= static_cast<std::size_t>(n);
+    }
+    return true;
+  }
+
+  const Delaunay* D3_;
+  std::vector<Move_record> ring_;
+  std::string path_;
+  std::string checkpoint_path_;
+  std::string pending_path_;
+  std::uint64_t recorded_;
+  std::uint64_t pass_;
+  Metropolis* metropolis_;
+  Move_trace_header header_;
+  /// The header once the checkpoint being written takes effect
+  Move_trace_header pending_;
+  /// The writer of the pending checkpoint, or nullptr
+  Snapshot_writer* writer_;
+  std::uint64_t pending_saved_;
+  std::unordered_map<Vertex_handle, std::uint32_t, Handle_hash<Vertex_handle>>
+      numbers_;
+};
+
+/// @brief Records every move **metropolis** attempts in **trace**
+inline void attach_move_trace(Metropolis* const metropolis,
+                              Move_trace* const trace) noexcept {
+  trace->set_metropolis(metropolis);
+  metropolis->set_move_tracer(
+      [metropolis, trace](const Move_proposal& proposal,
+                          const move_outcome outcome,
+                          const double delta_action,
+                          const std::size_t slot) {
+        trace->record(proposal, outcome, delta_action,
+                      metropolis->rng().draws(), slot);
+      });
+}  // attach_move_trace()
+
+/// @returns The trace written if the run crashes
+inline Move_trace*& crash_move_trace() noexcept {
+  static Move_trace* trace = nullptr;
+  return trace;
+}  // crash_move_trace()
+
+/// @brief Writes the crash trace, then lets the signal take its course
+inline void move_trace_crash_handler(const int signal) noexcept {
+  const auto* trace = crash_move_trace();
+  if (trace != nullptr) trace->write(false);
+  std::signal(signal, SIG_DFL);
+  std::raise(signal);
+}  // move_trace_crash_handler()
+
+/// @brief Writes **trace** if the run is killed by SIGSEGV, SIGBUS, SIGFPE,
+/// SIGILL, or SIGABRT, e.g. from a failed assertion
+inline void write_move_trace_on_crash(Move_trace* const trace) noexcept {
+  crash_move_trace() = trace;
+  for (const auto signal : {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT}) {
+    std::signal(signal, move_trace_crash_handler);
+  }
+}  // write_move_trace_on_crash()
+
+/// @brief A move trace read back from its file
+struct Move_trace_file {
+  Move_trace_header header;
+  std::vector<Move_record> records;
+};
+
+/// @brief Reads a move trace written by **Move_trace::write()**
+///
+/// @param[in]  path  The trace file
+/// @param[out] trace The trace
+/// @returns True if the file is a complete trace of this format
+inline bool read_move_trace(const std::string& path,
+                            Move_trace_file* const trace) noexcept {
+  std::ifstream is(path, std::ios::in | std::ios::binary);
+  if (!is || !read_binary(is, &trace->header) ||
+      std::memcmp(trace->header.magic, "CDTTRACE", 8) != 0 ||
+      trace->header.format != MOVE_TRACE_FORMAT ||
+      trace->header.record_size != sizeof(Move_record)) {
+    return false;
+  }
+  trace->records.resize(trace->header.count);
+  is.read(reinterpret_cast<char*>(trace->records.data()),
+          static_cast<std::streamsize>(trace->header.count *
+                                       sizeof(Move_record)));
+  return static_cast<bool>(is);
+}  // read_move_trace()
+
+/// @brief What a replay did
+struct Replay_result {
+  /// Accepted moves made again
+  std::uint64_t replayed;
+  /// Accepted moves CGAL could not make, in the run as in the replay
+  std::uint64_t failed;
+  /// Accepted moves whose simplex was not found
+  std::uint64_t missing;
+};
+
+/// @brief Remakes the accepted moves of a trace
+///
+/// **D3** must be the trace's checkpoint. No random numbers are drawn and
+/// no acceptance is evaluated: every recorded ACCEPTED move is made again
+/// on the simplex with the recorded vertices.
+///
+/// @param[in]     trace  The trace
+/// @param[in,out] D3     The Delaunay triangulation
+/// @param[in,out] index  A Timeslice_index of **D3**
+/// @param[out]    result What was replayed
+/// @returns False if the trace does not start at its checkpoint
+inline bool replay_move_trace(const Move_trace_file& trace,
+                              Delaunay* const D3,
+                              Timeslice_index* const index,
+                              Replay_result* const result) noexcept {
+  *result = Replay_result{0, 0, 0};
+  if (trace.header.first != trace.header.checkpoint) return false;
+  std::vector<Vertex_handle> vertices;
+  number_trace_vertices(*D3, &vertices);
+
+  for (const auto& record : trace.records) {
+    if (record.outcome != static_cast<std::uint8_t>(move_outcome::ACCEPTED)) {
+      continue;
+    }
+    std::array<Vertex_handle, 4> v;
+    auto known = true;
+    for (auto k = 0; k < 4; ++k) {
+      known = known && record.vertices[k] < vertices.size();
+      if (known) v[k] = vertices[record.vertices[k]];
+    }
+    Cell_handle cell;
+    std::array<int, 4> position;
+    if (!known || !D3->is_cell(v[0], v[1], v[2], v[3], cell, position[0],
+                               position[1], position[2], position[3])) {
+      result->missing++;
+      continue;
+    }
+    Move_proposal proposal;
+    proposal.type = static_cast<move_type>(record.type);
+    proposal.cell = cell;
+    proposal.i = position[record.i & 3];
+    proposal.j = position[record.j & 3];
+    if (make_move(D3, proposal, index)) {
+      result->replayed++;
+    } else {
+      result->failed++;
+    }
+  }
+  return true;
+}  // replay_move_trace()
+
+#endif  // SRC_MOVETRACE_H_
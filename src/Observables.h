@@ -0,0 +1,461 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Observables measured on worker threads between sweeps
+///
+/// An Observable is registered with a name, how many sweeps apart it is
+/// measured, which view of the universe it needs, and a function computing
+/// its values from a Measurement_snapshot. After each sweep the Monte Carlo
+/// thread calls **Measurement_scheduler::after_sweep()**, which builds one
+/// snapshot holding only the views the observables due that pass need, and
+/// queues them for the worker threads. The snapshot is immutable and shared
+/// by the measurements made from it, so they see the same configuration
+/// while the sweeps carry on. The Monte Carlo thread never waits for a
+/// measurement: if the workers fall too far behind, due measurements are
+/// skipped and counted instead.
+///
+/// For the ARRAYS view the Monte Carlo thread only copies values and
+/// handles out of the triangulation. One worker numbers the handles into
+/// Triangulation_arrays, and only then are the observables needing them
+/// queued. Measurements are kept until read, or written to a sink as they
+/// finish, so a long run need not hold them all.
+///
+/// \done Registration of observables with an interval and a data view
+/// \done Worker threads measuring a consistent snapshot
+/// \done Built-in action, volume profile, and vertex profile observables
+/// \done Volume-volume correlator fed by an observable
+/// \done Snapshots of the 1+1 dimensional engine
+/// \done Minimal-neck baby universe trees
+/// \done Arrays numbered on a worker thread
+/// \done Measurements streamed to a sink
+
+/// @file Observables.h
+/// @brief Observable plugins and their measurement scheduler
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_OBSERVABLES_H_
+#define SRC_OBSERVABLES_H_
+
+// CDT headers
+#include "Metropolis.h"
+#include "Metropolis2D.h"
+#include "Minbu.h"
+#include "Thermalization.h"
+#include "TimesliceIndex.h"
+#include "TriangulationArrays.h"
+#include "VolumeCorrelator.h"
+
+// C++ headers
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/// What an observable needs, from cheapest to most expensive to snapshot
+enum class observable_data {
+  /// N1_TL, N3_31, N3_22, and the action
+  COUNTS,
+  /// The spatial volume of every timeslice
+  VOLUME_PROFILE,
+  /// The whole triangulation as Triangulation_arrays
+  ARRAYS
+};
+
+/// @brief The universe after one pass, as observables see it
+///
+/// Only the views some observable due that pass needs are filled in.
+struct Measurement_snapshot {
+  std::uint64_t pass;
+  /// \f$N_3\f$, or \f$N_2\f$ in 1+1 dimensions
+  std::uint64_t volume;
+  std::uint64_t N1_TL;
+  std::uint64_t N3_31;
+  std::uint64_t N3_22;
+  double action;
+  /// \f$N_2(t)\f$ for every timeslice, if VOLUME_PROFILE is needed
+  std::vector<double> volume_profile;
+  /// The triangulation, if ARRAYS is needed; in 1+1 dimensions only the
+  /// vertex timeslices
+  Triangulation_arrays arrays;
+  /// The handles **arrays** still has to be numbered from, if any
+  Triangulation_keys keys;
+};
+
+/// @brief Fills in a snapshot of a 3+1 dimensional universe
+///
+/// The ARRAYS view is only captured, leaving its cell vertices and
+/// neighbors to be numbered from **snapshot->keys**.
+///
+/// @param[in]  metropolis The Metropolis engine, between sweeps
+/// @param[in]  data       The most expensive view needed
+/// @param[out] snapshot   The snapshot
+inline void fill_measurement_snapshot(
+    Metropolis* const metropolis,
+    const observable_data data,
+    Measurement_snapshot* const snapshot) noexcept {
+  snapshot->N1_TL = metropolis->N1_TL();
+  snapshot->N3_31 = metropolis->N3_31();
+  snapshot->N3_22 = metropolis->N3_22();
+  snapshot->volume = metropolis->number_of_simplices();
+  snapshot->action = metropolis->action();
+  if (data >= observable_data::VOLUME_PROFILE) {
+    volume_profile(metropolis->index(), &snapshot->volume_profile);
+  }
+  if (data == observable_data::ARRAYS) {
+    capture_triangulation_arrays(metropolis->triangulation(),
+                                 &snapshot->arrays, &snapshot->keys);
+  }
+}  // fill_measurement_snapshot()
+
+/// @brief Fills in a snapshot of a 1+1 dimensional universe
+///
+/// Every triangle has two timelike edges, each shared by two triangles, so
+/// \f$N_1^{TL} = N_2\f$.
+inline void fill_measurement_snapshot(
+    Metropolis_2d* const metropolis,
+    const observable_data data,
+    Measurement_snapshot* const snapshot) noexcept {
+  const auto& T2 = metropolis->triangulation();
+  snapshot->N1_TL = T2.number_of_triangles();
+  snapshot->N3_31 = 0;
+  snapshot->N3_22 = 0;
+  snapshot->volume = T2.number_of_triangles();
+  snapshot->action = metropolis->action();
+  if (data >= observable_data::VOLUME_PROFILE) {
+    snapshot->volume_profile.assign(T2.slice_volume.begin(),
+                                    T2.slice_volume.end());
+  }
+  if (data == observable_data::ARRAYS) {
+    for (auto i = static_cast<std::size_t>(0); i < T2.number_of_triangles();
+         ++i) {
+      if (T2.up[i]) snapshot->arrays.timeslice.push_back(T2.slab[i]);
+    }
+  }
+}  // fill_measurement_snapshot()
+
+/// @brief A measurement plugin
+struct Observable {
+  std::string name;
+  /// Measured after passes which are multiples of this
+  std::uint64_t interval;
+  observable_data data;
+  /// Computes the observable's values; called on a worker thread
+  std::function<std::vector<double>(const Measurement_snapshot&)> measure;
+};
+
+/// @brief The values of an observable after one pass
+struct Measurement {
+  std::uint64_t pass;
+  std::vector<double> values;
+};
+
+/// @brief Writes one measurement as a line: name, pass, then values
+inline void write_measurement(const std::string& name,
+                              const Measurement& measurement,
+                              std::ostream& os) noexcept {
+  os << name << " " << measurement.pass;
+  for (const auto value : measurement.values) os << " " << value;
+  os << "\n";
+}  // write_measurement()
+
+/// @brief Measures registered observables on worker threads
+class Measurement_scheduler {
+ public:
+  /// @param[in] threads     Worker threads, at least 1
+  /// @param[in] max_pending Queued measurements beyond which due ones are
+  ///                        skipped rather than queued
+  explicit Measurement_scheduler(const unsigned threads,
+                                 const std::size_t max_pending = 64) noexcept
+      : max_pending_(max_pending),
+        running_(0),
+        skipped_(0),
+        stop_(false),
+        sink_(nullptr) {
+    for (auto i = 0u; i < std::max(threads, 1u); ++i) {
+      workers_.emplace_back([this]() { work(); });
+    }
+  }
+
+  ~Measurement_scheduler() {
+    wait();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    queued_.notify_all();
+    for (auto& worker : workers_) worker.join();
+  }
+
+  Measurement_scheduler(const Measurement_scheduler&) = delete;
+  Measurement_scheduler& operator=(const Measurement_scheduler&) = delete;
+
+  /// @brief Registers an observable
+  ///
+  /// @returns False if the name is taken or the observable is incomplete
+  bool add(const Observable& observable) noexcept {
+    if (observable.interval == 0 || !observable.measure) return false;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (series_.count(observable.name) != 0) return false;
+    observables_.push_back(observable);
+    series_[observable.name];
+    return true;
+  }
+
+  /// @brief Writes each measurement to **sink** as it finishes, instead of
+  /// keeping it for **series()**
+  ///
+  /// @param[in] sink The stream, or nullptr to keep measurements again
+  void stream_to(std::ostream* const sink) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sink_ = sink;
+  }
+
+  /// @brief Snapshots the universe and queues the observables due
+  ///
+  /// If the snapshot's arrays still have to be numbered, a worker does that
+  /// first and then queues the observables which need them.
+  ///
+  /// @param[in] pass       Passes completed
+  /// @param[in] metropolis The Metropolis or Metropolis_2d engine, between
+  ///                       sweeps
+  template <typename Engine>
+  void after_sweep(const std::uint64_t pass,
+                   Engine* const metropolis) noexcept {
+    std::vector<const Observable*> due;
+    auto data = observable_data::COUNTS;
+    for (const auto& observable : observables_) {
+      if (pass % observable.interval != 0) continue;
+      due.push_back(&observable);
+      if (observable.data > data) data = observable.data;
+    }
+    if (due.empty()) return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (jobs_.size() + running_ + due.size() > max_pending_) {
+        skipped_ += due.size();
+        return;
+      }
+    }
+
+    std::shared_ptr<Measurement_snapshot> snapshot(new Measurement_snapshot);
+    snapshot->pass = pass;
+    fill_measurement_snapshot(metropolis, data, snapshot.get());
+
+    Job numbering{nullptr, snapshot, {}};
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto* observable : due) {
+        if (observable->data == observable_data::ARRAYS &&
+            !snapshot->keys.cells.empty()) {
+          numbering.waiting.push_back(observable);
+        } else {
+          jobs_.push_back(Job{observable, snapshot, {}});
+        }
+      }
+      if (!numbering.waiting.empty()) jobs_.push_back(std::move(numbering));
+    }
+    queued_.notify_all();
+  }
+
+  /// @brief Waits until every queued measurement is done
+  void wait() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this]() { return jobs_.empty() && running_ == 0; });
+  }
+
+  /// @returns The measurements of **name** kept so far, in pass order
+  std::vector<Measurement> series(const std::string& name) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto measurements = series_[name];
+    std::sort(measurements.begin(), measurements.end(),
+              [](const Measurement& a, const Measurement& b) {
+                return a.pass < b.pass;
+              });
+    return measurements;
+  }
+
+  /// @returns The names of the registered observables, in order
+  std::vector<std::string> names() const noexcept {
+    std::vector<std::string> names;
+    for (const auto& observable : observables_) {
+      names.push_back(observable.name);
+    }
+    return names;
+  }
+
+  /// @returns Measurements skipped because the workers were behind
+  std::uint64_t skipped() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return skipped_;
+  }
+
+ private:
+  /// @brief A measurement to make, or with no observable, a snapshot whose
+  /// arrays are to be numbered before the **waiting** observables are
+  /// queued
+  struct Job {
+    const Observable* observable;
+    std::shared_ptr<Measurement_snapshot> snapshot;
+    std::vector<const Observable*> waiting;
+  };
+
+  void work() noexcept {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      queued_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+      if (jobs_.empty()) return;
+      auto job = std::move(jobs_.front());
+      jobs_.pop_front();
+      running_++;
+      lock.unlock();
+      if (job.observable == nullptr) {
+        // Observables reading the arrays are only queued once they are
+        // numbered; the others do not touch them
+        auto* const snapshot = job.snapshot.get();
+        number_triangulation_arrays(snapshot->keys, &snapshot->arrays);
+        snapshot->keys = Triangulation_keys();
+        lock.lock();
+        for (const auto* observable : job.waiting) {
+          jobs_.push_back(Job{observable, job.snapshot, {}});
+        }
+        queued_.notify_all();
+      } else {
+        const auto& snapshot = *job.snapshot;
+        Measurement measurement{snapshot.pass,
+                                job.observable->measure(snapshot)};
+        lock.lock();
+        if (sink_ != nullptr) {
+          write_measurement(job.observable->name, measurement, *sink_);
+        } else {
+          series_[job.observable->name].push_back(std::move(measurement));
+        }
+      }
+      running_--;
+      if (jobs_.empty() && running_ == 0) idle_.notify_all();
+    }
+  }
+
+  // std::deque never moves elements, so jobs may point into observables_;
+  // registration happens before the first sweep
+  std::deque<Observable> observables_;
+  std::size_t max_pending_;
+  std::deque<Job> jobs_;
+  std::size_t running_;
+  std::uint64_t skipped_;
+  bool stop_;
+  std::map<std::string, std::vector<Measurement>> series_;
+  std::ostream* sink_;
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable idle_;
+  std::vector<std::thread> workers_;
+};
+
+/// @returns An observable of the action, every **interval** passes
+inline Observable action_observable(const std::uint64_t interval) noexcept {
+  return Observable{"action", interval, observable_data::COUNTS,
+                    [](const Measurement_snapshot& snapshot) {
+                      return std::vector<double>{
+                          snapshot.action,
+                          static_cast<double>(snapshot.volume)};
+                    }};
+}  // action_observable()
+
+/// @returns An observable of \f$N_2(t)\f$, every **interval** passes
+inline Observable volume_profile_observable(
+    const std::uint64_t interval) noexcept {
+  return Observable{"volume_profile", interval,
+                    observable_data::VOLUME_PROFILE,
+                    [](const Measurement_snapshot& snapshot) {
+                      return snapshot.volume_profile;
+                    }};
+}  // volume_profile_observable()
+
+/// @returns An observable of the number of vertices on each timeslice,
+/// every **interval** passes
+inline Observable vertex_profile_observable(
+    const std::uint64_t interval) noexcept {
+  return Observable{"vertex_profile", interval, observable_data::ARRAYS,
+                    [](const Measurement_snapshot& snapshot) {
+                      std::vector<double> profile;
+                      for (const auto t : snapshot.arrays.timeslice) {
+                        if (t >= profile.size()) profile.resize(t + 1, 0.0);
+                        profile[t] += 1.0;
+                      }
+                      return profile;
+                    }};
+}  // vertex_profile_observable()
+
+/// @brief Measures the minimal-neck baby universes of every slice, every
+/// **interval** passes
+///
+/// The values are three per baby universe, as in Minbu_tree: its timeslice,
+/// its volume in spacelike triangles, and the index of its parent, or -1.
+///
+/// @param[in] interval Passes between measurements
+/// @param[in] threads  Threads working on slices in each measurement
+inline Observable minbu_observable(const std::uint64_t interval,
+                                   const unsigned threads) noexcept {
+  return Observable{"minbu", interval, observable_data::ARRAYS,
+                    [threads](const Measurement_snapshot& snapshot) {
+                      Minbu_tree tree;
+                      find_minbus(snapshot.arrays, threads, &tree);
+                      std::vector<double> values;
+                      values.reserve(3 * tree.babies.size());
+                      for (const auto& baby : tree.babies) {
+                        values.push_back(baby.timeslice);
+                        values.push_back(baby.volume);
+                        values.push_back(baby.parent);
+                      }
+                      return values;
+                    }};
+}  // minbu_observable()
+
+/// @brief Feeds the volume profile to a Volume_correlator every **interval**
+/// passes
+///
+/// Measurements may finish out of order, which the correlator's averages
+/// do not depend on. The observable's value is the center of volume.
+///
+/// @param[in] interval   Passes between measurements
+/// @param[in] correlator The correlator, sized for the profile
+/// @param[in] lock       Guards **correlator** against other workers
+inline Observable volume_correlator_observable(
+    const std::uint64_t interval,
+    Volume_correlator* const correlator,
+    std::mutex* const lock) noexcept {
+  return Observable{"volume_correlator", interval,
+                    observable_data::VOLUME_PROFILE,
+                    [correlator, lock](const Measurement_snapshot& snapshot) {
+                      std::lock_guard<std::mutex> guard(*lock);
+                      correlator->add(snapshot.volume_profile);
+                      return std::vector<double>{
+                          center_of_volume(snapshot.volume_profile)};
+                    }};
+}  // volume_correlator_observable()
+
+/// @brief Writes every measurement kept, one per line: name, pass, then
+/// values
+inline void write_measurements(Measurement_scheduler* const scheduler,
+                               std::ostream& os) noexcept {
+  for (const auto& name : scheduler->names()) {
+    for (const auto& measurement : scheduler->series(name)) {
+      write_measurement(name, measurement, os);
+    }
+  }
+  os << std::flush;
+}  // write_measurements()
+
+#endif  // SRC_OBSERVABLES_H_
@@ -0,0 +1,227 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Linux hardware performance counters
+///
+/// A thin wrapper around the perf_event_open(2) system call. Counters count
+/// the calling thread and, because they are inherited, any threads it
+/// starts afterwards. Counters are optional: where the kernel, permissions
+/// (see /proc/sys/kernel/perf_event_paranoid), or a virtual machine don't
+/// provide them, **available()** is false and readings are -1.
+///
+/// Perf_counters opens one counter per event in Perf_event rather than a
+/// single group, so events the hardware lacks don't disable the others.
+/// **measure_phase()** brackets one phase of work with wall time and
+/// counters.
+///
+/// \done Cache misses
+/// \done Cycles, instructions, branch misses, and page faults
+/// \done Per-phase measurements
+
+/// @file PerfCounters.h
+/// @brief Linux perf_event hardware counters
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_PERFCOUNTERS_H_
+#define SRC_PERFCOUNTERS_H_
+
+// C headers
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// C++ headers
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+/// @brief One hardware or software event counter
+class Perf_counter {
+ public:
+  /// @param[in] type   The perf event type, e.g. PERF_TYPE_HARDWARE
+  /// @param[in] config The event, e.g. PERF_COUNT_HW_CACHE_MISSES
+  Perf_counter(const std::uint32_t type, const std::uint64_t config) noexcept
+      : fd_(-1) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1,
+                                   0));
+  }
+
+  ~Perf_counter() noexcept {
+    if (fd_ >= 0) close(fd_);
+  }
+
+  Perf_counter(const Perf_counter&) = delete;
+  Perf_counter& operator=(const Perf_counter&) = delete;
+
+  bool available() const noexcept { return fd_ >= 0; }
+
+  /// @brief Zeroes and starts the counter
+  void start() noexcept {
+    if (fd_ < 0) return;
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  /// @brief Stops the counter
+  void stop() noexcept {
+    if (fd_ >= 0) ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+  }
+
+  /// @returns The count since **start()**, or -1 if unavailable
+  std::int64_t value() const noexcept {
+    if (fd_ < 0) return -1;
+    auto count = static_cast<std::uint64_t>(0);
+    if (read(fd_, &count, sizeof(count)) != sizeof(count)) return -1;
+    return static_cast<std::int64_t>(count);
+  }
+
+ private:
+  int fd_;
+};
+
+enum class perf_event {
+  CYCLES, INSTRUCTIONS, LLC_MISSES, BRANCH_MISSES, PAGE_FAULTS
+};
+
+static constexpr std::size_t NUMBER_OF_PERF_EVENTS = 5;
+
+/// @returns A name for the event, usable as a report field
+inline const char* perf_event_name(const perf_event event) noexcept {
+  switch (event) {
+    case perf_event::CYCLES:
+      return "cycles";
+    case perf_event::INSTRUCTIONS:
+      return "instructions";
+    case perf_event::LLC_MISSES:
+      return "llc_misses";
+    case perf_event::BRANCH_MISSES:
+      return "branch_misses";
+    default:
+      return "page_faults";
+  }
+}  // perf_event_name()
+
+/// Counts of each perf_event; -1 where unavailable
+using Perf_reading = std::array<std::int64_t, NUMBER_OF_PERF_EVENTS>;
+
+/// @brief Counters for every perf_event
+class Perf_counters {
+ public:
+  /// @param[in] enabled If false, no counters are opened and every reading
+  ///                    is -1
+  explicit Perf_counters(const bool enabled) noexcept {
+    if (!enabled) return;
+    counters_[0].reset(new Perf_counter(PERF_TYPE_HARDWARE,
+                                        PERF_COUNT_HW_CPU_CYCLES));
+    counters_[1].reset(new Perf_counter(PERF_TYPE_HARDWARE,
+                                        PERF_COUNT_HW_INSTRUCTIONS));
+    // Generic cache misses are last level cache misses on most CPUs
+    counters_[2].reset(new Perf_counter(PERF_TYPE_HARDWARE,
+                                        PERF_COUNT_HW_CACHE_MISSES));
+    counters_[3].reset(new Perf_counter(PERF_TYPE_HARDWARE,
+                                        PERF_COUNT_HW_BRANCH_MISSES));
+    counters_[4].reset(new Perf_counter(PERF_TYPE_SOFTWARE,
+                                        PERF_COUNT_SW_PAGE_FAULTS));
+  }
+
+  /// @returns True if any event can be counted
+  bool available() const noexcept {
+    for (const auto& counter : counters_) {
+      if (counter && counter->available()) return true;
+    }
+    return false;
+  }
+
+  /// @brief Zeroes and starts every counter
+  void start() noexcept {
+    for (auto& counter : counters_) {
+      if (counter) counter->start();
+    }
+  }
+
+  /// @brief Stops every counter
+  ///
+  /// @returns The counts since **start()**
+  Perf_reading stop() noexcept {
+    Perf_reading reading;
+    for (auto i = 0u; i < NUMBER_OF_PERF_EVENTS; ++i) {
+      if (counters_[i]) counters_[i]->stop();
+      reading[i] = counters_[i] ? counters_[i]->value() : -1;
+    }
+    return reading;
+  }
+
+ private:
+  std::array<std::unique_ptr<Perf_counter>, NUMBER_OF_PERF_EVENTS> counters_;
+};
+
+/// @brief Wall time and counters of one phase of work
+struct Phase_measurement {
+  double seconds;
+  Perf_reading counters;
+};
+
+/// @returns A Phase_measurement of nothing, to combine others into
+inline Phase_measurement zero_phase() noexcept {
+  Phase_measurement measurement;
+  measurement.seconds = 0.0;
+  measurement.counters.fill(0);
+  return measurement;
+}  // zero_phase()
+
+/// @brief Runs one phase of work and measures it
+///
+/// @param[in,out] counters The Perf_counters, which are restarted
+/// @param[in]     phase    The work
+/// @returns Its wall time and counts
+template <typename Phase>
+inline Phase_measurement measure_phase(Perf_counters* const counters,
+                                       Phase&& phase) noexcept {
+  Phase_measurement measurement;
+  counters->start();
+  const auto start = std::chrono::steady_clock::now();
+  phase();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  measurement.counters = counters->stop();
+  measurement.seconds = elapsed.count();
+  return measurement;
+}  // measure_phase()
+
+/// @brief Combines measurements of the same phase run in parallel
+///
+/// Counts add up, wall time is that of the slowest, and a count unavailable
+/// in either is unavailable in the total.
+///
+/// @param[in,out] total       The running total
+/// @param[in]     measurement One more measurement
+inline void combine_phase(Phase_measurement* const total,
+                          const Phase_measurement& measurement) noexcept {
+  if (measurement.seconds > total->seconds) {
+    total->seconds = measurement.seconds;
+  }
+  for (auto i = 0u; i < NUMBER_OF_PERF_EVENTS; ++i) {
+    if (total->counters[i] < 0 || measurement.counters[i] < 0) {
+      total->counters[i] = -1;
+    } else {
+      total->counters[i] += measurement.counters[i];
+    }
+  }
+}  // combine_phase()
+
+#endif  // SRC_PERFCOUNTERS_H_
@@ -50,11 +50,11 @@ static const unsigned PRECISION = 256;
 /// @returns \f$S^{(3)}(\alpha=-1)\f$ as a
 /// <a href="http://doc.cgal.org/latest/Number_types/Gmpzf_8h.html">Gmpzf</a>
 ///                   value
-auto S3_bulk_action_alpha_minus_one(const unsigned N1_TL,
-                                     const unsigned N3_31,
-                                     const unsigned N3_22,
-                                     const long double K,
-                                     const long double Lambda) noexcept {
+inline auto S3_bulk_action_alpha_minus_one(const unsigned N1_TL,
+                                            const unsigned N3_31,
+                                            const unsigned N3_22,
+                                            const long double K,
+                                            const long double Lambda) noexcept {
   // Set precision for initialization and assignment functions
   mpfr_set_default_prec(PRECISION);
   // Initialize for MPFR
@@ -126,11 +126,11 @@ auto S3_bulk_action_alpha_minus_one(const unsigned N1_TL,
 /// @returns \f$S^{(3)}(\alpha=1)\f$ as a
 /// <a href="http://doc.cgal.org/latest/Number_types/Gmpzf_8h.html">Gmpzf</a>
 ///                   value
-auto S3_bulk_action_alpha_one(const unsigned N1_TL,
-                               const unsigned N3_31,
-                               const unsigned N3_22,
-                               const long double K,
-                               const long double Lambda) noexcept {
+inline auto S3_bulk_action_alpha_one(const unsigned N1_TL,
+                                      const unsigned N3_31,
+                                      const unsigned N3_22,
+                                      const long double K,
+                                      const long double Lambda) noexcept {
   // Set precision for initialization and assignment functions
   mpfr_set_default_prec(PRECISION);
   // Initialize for MPFR
@@ -218,12 +218,12 @@ S^{(3)} &=& 2\pi k\sqrt{\alpha}N_1^{TL} \\
 /// @returns \f$S^{(3)}(\alpha)\f$ as a
 /// <a href="http://doc.cgal.org/latest/Number_types/Gmpzf_8h.html">Gmpzf</a>
 ///                   value
-auto S3_bulk_action(const unsigned N1_TL,
-                     const unsigned N3_31,
-                     const unsigned N3_22,
-                     const long double Alpha,
-                     const long double K,
-                     const long double Lambda) noexcept {
+inline auto S3_bulk_action(const unsigned N1_TL,
+                            const unsigned N3_31,
+                            const unsigned N3_22,
+                            const long double Alpha,
+                            const long double K,
+                            const long double Lambda) noexcept {
   // Set precision for initialization and assignment functions
   mpfr_set_default_prec(PRECISION);
   // Initialize for MPFR
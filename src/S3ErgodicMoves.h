@@ -9,6 +9,8 @@
 /// \done <a href="http://www.cprogramming.com/tutorial/const_correctness.html">
 /// Const Correctness</a>
 /// \done Complete function documentation
+/// \done Keep a Timeslice_index current across moves
+/// \done Point location for the (2,6) move starts on the chosen timeslice
 /// \todo (2,6) move
 /// \todo (6,2) move
 /// \todo (4,4) move
@@ -25,8 +27,12 @@
 
 // CDT headers
 #include "S3Triangulation.h"
+#include "TimesliceIndex.h"
 
 // C++ headers
+#include <algorithm>
+#include <cmath>
+#include <iterator>
 #include <random>
 #include <vector>
 
@@ -41,8 +47,8 @@
 /// @param[in] min_value  The minimum value in the range
 /// @param[in] max_value  The maximum value in the range
 /// @returns A random unsigned value between min_value and max_value, inclusive
-unsigned generate_random_unsigned(const unsigned min_value,
-                                  const unsigned max_value) noexcept {
+inline unsigned generate_random_unsigned(const unsigned min_value,
+                                         const unsigned max_value) noexcept {
   // Non-deterministic random number generator
   std::random_device generator;
   std::uniform_int_distribution<int> distribution(min_value, max_value);
@@ -63,10 +69,110 @@ unsigned generate_random_unsigned(const unsigned min_value,
 ///
 /// @param[in] max_timeslice  The maximum timeslice
 /// @returns A random timeslice from 1 to max_timeslice
-unsigned generate_random_timeslice(unsigned const max_timeslice) noexcept {
+inline unsigned generate_random_timeslice(unsigned const max_timeslice)
+    noexcept {
   return generate_random_unsigned(1, max_timeslice);
 }  // generate_random_timeslice()
 
+/// @brief Flip a facet into its dual edge
+///
+/// This function performs a (2,3) flip on the facet between **cell** and
+/// its i-th neighbor. If **index** is not null, the two cells destroyed are
+/// removed from it beforehand and the three cells created are added to it
+/// afterwards.
+///
+/// @param[in,out] D3     The Delaunay triangulation
+/// @param[in]     cell   A cell containing the facet
+/// @param[in]     i      The index of the vertex opposite the facet
+/// @param[in,out] index  The Timeslice_index, or nullptr
+/// @returns True if the facet was flippable
+inline bool flip_facet(Delaunay* const D3,
+                       const Cell_handle& cell,
+                       const int i,
+                       Timeslice_index* const index) noexcept {
+  if (index == nullptr) return D3->flip(cell, i);
+
+  const auto neighbor = cell->neighbor(i);
+  const auto top = cell->vertex(i);
+  const auto bottom = D3->mirror_vertex(cell, i);
+
+  remove_cell_from_index(*D3, cell, index);
+  remove_cell_from_index(*D3, neighbor, index);
+  if (!D3->flip(cell, i)) {
+    add_cell_to_index(*D3, cell, index);
+    add_cell_to_index(*D3, neighbor, index);
+    return false;
+  }
+
+  // The three new cells share the new edge from top to bottom
+  Cell_handle edge_cell;
+  int v1, v2;
+  D3->is_edge(top, bottom, edge_cell, v1, v2);
+  Delaunay::Cell_circulator circulator = D3->incident_cells(edge_cell, v1, v2);
+  Delaunay::Cell_circulator done = circulator;
+  do {
+    add_cell_to_index(*D3, circulator, index);
+  } while (++circulator != done);
+  return true;
+}  // flip_facet()
+
+/// @brief Flip an edge into its dual facet
+///
+/// This function performs a (3,2) flip on the edge between the i-th and
+/// j-th vertices of **cell**. If **index** is not null, the three cells
+/// destroyed are removed from it beforehand and the two cells created are
+/// added to it afterwards.
+///
+/// @param[in,out] D3     The Delaunay triangulation
+/// @param[in]     cell   A cell containing the edge
+/// @param[in]     i      The index of the first vertex of the edge
+/// @param[in]     j      The index of the second vertex of the edge
+/// @param[in,out] index  The Timeslice_index, or nullptr
+/// @returns True if the edge was flippable
+inline bool flip_edge(Delaunay* const D3,
+                      const Cell_handle& cell,
+                      const int i,
+                      const int j,
+                      Timeslice_index* const index) noexcept {
+  if (index == nullptr) return D3->flip(cell, i, j);
+
+  // Only edges of degree 3 can be flipped
+  std::vector<Cell_handle> incident;
+  Delaunay::Cell_circulator circulator = D3->incident_cells(cell, i, j);
+  Delaunay::Cell_circulator done = circulator;
+  do {
+    incident.push_back(circulator);
+  } while (++circulator != done && incident.size() <= 3);
+  if (incident.size() != 3) return false;
+
+  // The vertices around the edge become the new facet
+  const auto u = cell->vertex(i);
+  const auto v = cell->vertex(j);
+  std::vector<Vertex_handle> ring;
+  for (const auto& c : incident) {
+    for (auto k = 0; k < 4; ++k) {
+      const auto w = c->vertex(k);
+      if (w != u && w != v &&
+          std::find(ring.begin(), ring.end(), w) == ring.end()) {
+        ring.push_back(w);
+      }
+    }
+  }
+
+  for (const auto& c : incident) remove_cell_from_index(*D3, c, index);
+  if (!D3->flip(cell, i, j)) {
+    for (const auto& c : incident) add_cell_to_index(*D3, c, index);
+    return false;
+  }
+
+  Cell_handle facet_cell;
+  int f1, f2, f3;
+  D3->is_facet(ring[0], ring[1], ring[2], facet_cell, f1, f2, f3);
+  add_cell_to_index(*D3, facet_cell, index);
+  add_cell_to_index(*D3, facet_cell->neighbor(6 - f1 - f2 - f3), index);
+  return true;
+}  // flip_edge()
+
 /// @brief Make a (2,3) move
 ///
 /// This function performs the (2,3) move by converting a facet
@@ -76,8 +182,10 @@ unsigned generate_random_timeslice(unsigned const max_timeslice) noexcept {
 ///
 /// @param[in,out] D3 The Delaunay triangulation
 /// @param[in,out] two_two A vector of (2,2) simplices
-void make_23_move(Delaunay* const D3,
-                  std::vector<Cell_handle>* const two_two) noexcept {
+/// @param[in,out] index The Timeslice_index kept current, or nullptr
+inline void make_23_move(Delaunay* const D3,
+                         std::vector<Cell_handle>* const two_two,
+                         Timeslice_index* const index) noexcept {
   bool not_flipped = true;
   while (not_flipped) {
     // Pick a random (2,2) out of the two_two vector, which ranges
@@ -86,7 +194,7 @@ void make_23_move(Delaunay* const D3,
     std::cout << "We're picking (2,2) simplex " << choice << std::endl;
     Cell_handle to_be_moved = (*two_two)[choice];
     for (size_t i = 0; i < 4; i++) {
-      if (D3->flip(to_be_moved, i)) {
+      if (flip_facet(D3, to_be_moved, i, index)) {
         std::cout << "Facet " << i << " was flippable." << std::endl;
         // Erase the flipped (2,2) simplex from the vector two_two
         two_two->erase(two_two->begin() + choice);
@@ -102,6 +210,15 @@ void make_23_move(Delaunay* const D3,
   }
 }  // make_23_move()
 
+/// @brief Make a (2,3) move
+///
+/// @param[in,out] D3 The Delaunay triangulation
+/// @param[in,out] two_two A vector of (2,2) simplices
+inline void make_23_move(Delaunay* const D3,
+                         std::vector<Cell_handle>* const two_two) noexcept {
+  make_23_move(D3, two_two, nullptr);
+}  // make_23_move()
+
 /// @brief Make a (3,2) move
 ///
 /// This function performs the (3,2) move by converting a timelike
@@ -109,16 +226,18 @@ void make_23_move(Delaunay* const D3,
 ///
 /// @param[in,out] D3 The Delaunay triangulation
 /// @param[in,out] timelike_edges Timelike edges to pick to attempt move
-void make_32_move(Delaunay* const D3,
-                  std::vector<Edge_tuple>* const timelike_edges) noexcept {
+/// @param[in,out] index The Timeslice_index kept current, or nullptr
+inline void make_32_move(Delaunay* const D3,
+                         std::vector<Edge_tuple>* const timelike_edges,
+                         Timeslice_index* const index) noexcept {
   bool not_flipped = true;
   while (not_flipped) {
     // Pick a random timelike edge out of the timelike_edges vector
     // which ranges from 0 to size()-1
     unsigned choice = generate_random_unsigned(0, timelike_edges->size()-1);
     Edge_tuple to_be_moved = (*timelike_edges)[choice];
-    if (D3->flip(std::get<0>(to_be_moved), std::get<1>(to_be_moved),
-               std::get<2>(to_be_moved))) {
+    if (flip_edge(D3, std::get<0>(to_be_moved), std::get<1>(to_be_moved),
+                  std::get<2>(to_be_moved), index)) {
       std::cout << "Edge " << choice << " was flippable." << std::endl;
       // Erase the flipped edge from timelike_edges
       timelike_edges->erase(timelike_edges->begin() + choice);
@@ -132,6 +251,16 @@ void make_32_move(Delaunay* const D3,
   }
 }  // make_32_move()
 
+/// @brief Make a (3,2) move
+///
+/// @param[in,out] D3 The Delaunay triangulation
+/// @param[in,out] timelike_edges Timelike edges to pick to attempt move
+inline void make_32_move(Delaunay* const D3,
+                         std::vector<Edge_tuple>* const timelike_edges)
+                         noexcept {
+  make_32_move(D3, timelike_edges, nullptr);
+}  // make_32_move()
+
 /// @brief Make a (6,2) move
 ///
 /// This function performs the (6,2) move by removing a vertex
@@ -139,8 +268,8 @@ void make_32_move(Delaunay* const D3,
 ///
 /// @param[in,out]  D3        The Delaunay triangulation
 /// @param[in]      vertices  Vertices to pick to attempt move
-void make_62_move(Delaunay* const D3,
-                  std::vector<Vertex_handle>* const vertices) noexcept {
+inline void make_62_move(Delaunay* const D3,
+                         std::vector<Vertex_handle>* const vertices) noexcept {
   bool no_move = true;
   while (no_move) {
     // Pick a random vertex
@@ -156,12 +285,103 @@ void make_62_move(Delaunay* const D3,
   }
 }  // make_62_move()
 
+/// @brief A cell to start locating a point on a timeslice from
+///
+/// Point location walks cell by cell from where it starts, so starting
+/// from an arbitrary cell costs a walk across the triangulation. This
+/// samples about \f$n^{1/3}\f$ of the n vertices on the point's
+/// timeslice, evenly spread through the Timeslice_index, and starts from a
+/// cell of the nearest one, so that the sampling and the remaining walk
+/// cost about the same and both grow very slowly with n.
+///
+/// @param[in] index     The Timeslice_index
+/// @param[in] timeslice The timeslice of the point
+/// @param[in] point     The point to locate
+/// @returns A cell incident to a nearby vertex, or a default Cell_handle if
+/// the timeslice has no vertices, to start from anywhere
+inline Cell_handle timeslice_hint(const Timeslice_index& index,
+                                  const unsigned timeslice,
+                                  const Point& point) noexcept {
+  if (timeslice >= index.vertices.size() ||
+      index.vertices[timeslice].empty()) {
+    return Cell_handle();
+  }
+  const auto& vertices = index.vertices[timeslice];
+  const auto n = vertices.size();
+  const auto cube_root = std::ceil(std::cbrt(static_cast<double>(n)));
+  const auto samples = std::min(n, static_cast<std::size_t>(cube_root));
+  auto nearest = vertices[0];
+  auto nearest_distance = CGAL::squared_distance(nearest->point(), point);
+  for (auto i = static_cast<std::size_t>(1); i < samples; ++i) {
+    const auto& candidate = vertices[i * n / samples];
+    const auto distance = CGAL::squared_distance(candidate->point(), point);
+    if (distance < nearest_distance) {
+      nearest = candidate;
+      nearest_distance = distance;
+    }
+  }
+  return nearest->cell();
+}  // timeslice_hint()
+
+/// @brief A cell to start locating a point from without a Timeslice_index
+///
+/// Without an index there is no list of a timeslice's vertices to sample,
+/// so this starts from the vertices of the first finite cell and walks the
+/// Delaunay graph greedily, moving to whichever adjacent vertex is nearer
+/// the point until none is. On a Delaunay triangulation the greedy walk
+/// ends at the vertex nearest the point, and it starts from a cell of that
+/// vertex.
+///
+/// @param[in] D3    The Delaunay triangulation
+/// @param[in] point The point to locate
+/// @returns A cell incident to the nearest vertex, or a default Cell_handle
+/// if **D3** has no finite cells, to start from anywhere
+inline Cell_handle nearest_vertex_hint(const Delaunay& D3,
+                                       const Point& point) noexcept {
+  if (D3.number_of_finite_cells() == 0) return Cell_handle();
+  Cell_handle start = D3.finite_cells_begin();
+  Vertex_handle nearest = start->vertex(0);
+  auto nearest_distance = CGAL::squared_distance(nearest->point(), point);
+  for (auto i = 1; i < 4; ++i) {
+    const auto distance =
+        CGAL::squared_distance(start->vertex(i)->point(), point);
+    if (distance < nearest_distance) {
+      nearest = start->vertex(i);
+      nearest_distance = distance;
+    }
+  }
+  std::vector<Vertex_handle> adjacent;
+  for (auto moved = true; moved;) {
+    moved = false;
+    adjacent.clear();
+    D3.finite_adjacent_vertices(nearest, std::back_inserter(adjacent));
+    for (const auto& candidate : adjacent) {
+      const auto distance = CGAL::squared_distance(candidate->point(), point);
+      if (distance < nearest_distance) {
+        nearest = candidate;
+        nearest_distance = distance;
+        moved = true;
+      }
+    }
+  }
+  return nearest->cell();
+}  // nearest_vertex_hint()
+
 /// @brief Make a (2,6) move
 ///
+/// This function inserts a random point on a random timeslice. If
+/// **index** is not null, the cells in conflict with the point are removed
+/// from it before insertion, and the new vertex and its incident cells are
+/// added to it afterwards, and the point is located starting from
+/// **timeslice_hint()**. Otherwise it is located starting from
+/// **nearest_vertex_hint()**.
+///
 /// @param[in,out]  D3                    The Delaunay triangulation
 /// @param[in]      number_of_timeslices  The maximum timeslice
-void make_26_move(Delaunay* const D3,
-                  const unsigned number_of_timeslices) noexcept {
+/// @param[in,out]  index                 The Timeslice_index, or nullptr
+inline void make_26_move(Delaunay* const D3,
+                         const unsigned number_of_timeslices,
+                         Timeslice_index* const index) noexcept {
   const unsigned points = 1;
   const bool output = true;
   // Allot vector to hold point and timevalue
@@ -175,8 +395,46 @@ void make_26_move(Delaunay* const D3,
   // Generate a point
   make_2_sphere(points, radius, output, &vertices, &timevalue);
 
-  // Insert into D3
-  insert_into_S3(vertices, timevalue, D3);
+  Locate_type lt;
+  int li, lj;
+  Cell_handle located =
+      D3->locate(vertices.front(), lt, li, lj,
+                 index == nullptr
+                     ? nearest_vertex_hint(*D3, vertices.front())
+                     : timeslice_hint(*index, timevalue.front(),
+                                      vertices.front()));
+  // Nothing changes if the point is already a vertex
+  if (lt == Delaunay::VERTEX) return;
+
+  if (index == nullptr) {
+    Vertex_handle v = D3->insert(vertices.front(), lt, located, li, lj);
+    v->info() = timevalue.front();
+    return;
+  }
+
+  std::vector<Delaunay::Facet> boundary;
+  std::vector<Cell_handle> conflicts;
+  D3->find_conflicts(vertices.front(), located,
+                     std::back_inserter(boundary),
+                     std::back_inserter(conflicts));
+  for (const auto& c : conflicts) remove_cell_from_index(*D3, c, index);
+
+  Vertex_handle v = D3->insert(vertices.front(), lt, located, li, lj);
+  v->info() = timevalue.front();
+
+  add_vertex_to_index(*D3, v, index);
+  std::vector<Cell_handle> incident;
+  D3->incident_cells(v, std::back_inserter(incident));
+  for (const auto& c : incident) add_cell_to_index(*D3, c, index);
+}  // make_26_move()
+
+/// @brief Make a (2,6) move
+///
+/// @param[in,out]  D3                    The Delaunay triangulation
+/// @param[in]      number_of_timeslices  The maximum timeslice
+inline void make_26_move(Delaunay* const D3,
+                         const unsigned number_of_timeslices) noexcept {
+  make_26_move(D3, number_of_timeslices, nullptr);
 }  // make_26_move()
 
 #endif  // SRC_S3ERGODICMOVES_H_
@@ -28,6 +28,8 @@
 /// \done <a href="http://www.cprogramming.com/tutorial/const_correctness.html">
 /// Const Correctness</a>
 /// \done Function documentation
+/// \done Reproducible universes from a seed
+/// \done Streaming construction in bounded batches
 /// \todo Multi-threaded operations using Intel TBB
 
 /// @file S3Triangulation.h
@@ -45,6 +47,7 @@
 #include <CGAL/Triangulation_vertex_base_with_info_3.h>
 #include <CGAL/Triangulation_cell_base_with_info_3.h>
 #include <CGAL/point_generators_3.h>
+#include <CGAL/Random.h>
 
 
 // C headers
@@ -53,8 +56,9 @@
 
 // C++ headers
 #include <boost/iterator/zip_iterator.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <vector>
-#include <list>
 #include <tuple>
 
 using K = CGAL::Exact_predicates_inexact_constructions_kernel;
@@ -177,10 +181,40 @@ inline void classify_edges(const Delaunay& D3,
   std::cout << "N1_TL = " << *N1_TL << std::endl;
 }  // classify_edges()
 
+/// @brief Classify a simplex as (3,1), (2,2), or (1,3)
+///
+/// This function counts how many vertices of the cell lie on its highest
+/// timeslice. Three gives a (1,3) simplex, two gives a (2,2) simplex, and
+/// anything else gives a (3,1) simplex. The result is also stored in
+/// **cell->info()**.
+///
+/// @param[in,out] cell The cell to classify
+/// @returns The simplex type as 13, 22, or 31
+inline unsigned classify_3_simplex(const Cell_handle& cell) noexcept {
+  auto max_time = cell->vertex(0)->info();
+  for (auto i = 1; i < 4; ++i) {
+    if (cell->vertex(i)->info() > max_time) max_time = cell->vertex(i)->info();
+  }
+
+  auto max_values = 0;
+  for (auto i = 0; i < 4; ++i) {
+    if (cell->vertex(i)->info() == max_time) max_values++;
+  }
+
+  if (max_values == 3) {
+    cell->info() = 13;
+  } else if (max_values == 2) {
+    cell->info() = 22;
+  } else {
+    cell->info() = 31;
+  }
+  return cell->info();
+}  // classify_3_simplex()
+
 /// @brief Classify simplices as (3,1), (2,2), or (1,3)
 ///
 /// This function iterates over all cells in the triangulation
-/// and classifies them as:
+/// and classifies them using **classify_3_simplex()** as:
 /**
 \f{eqnarray*}{
      31 &=& (3, 1) \\
@@ -204,38 +238,15 @@ inline void classify_3_simplices(const Delaunay* const D3,
   Delaunay::Finite_cells_iterator cit;
 
   for (cit = D3->finite_cells_begin(); cit != D3->finite_cells_end(); ++cit) {
-    std::list<unsigned> timevalues;
-    auto max_time = 0;
-    auto current_time = 0;
-    auto max_values = 0;
-    auto min_values = 0;
-    // Push every time value into a list
-    for (auto i = 0; i < 4; ++i) {
-      timevalues.push_back(cit->vertex(i)->info());
-    }
-    // Now sort the list
-    timevalues.sort();
-    // The maximum timevalue is at the end of the list
-    max_time = timevalues.back();
-    timevalues.pop_back();
-    // std::cout << "The maximum time value is " << max_time << std::endl;
-    max_values++;
-
-    while (!timevalues.empty()) {
-      current_time = timevalues.back();
-      timevalues.pop_back();
-      (current_time == max_time) ? max_values++ : min_values++;
-    }
-
-    if (max_values == 3) {
-      cit->info() = 13;
-      one_three->push_back(cit);
-    } else if (max_values == 2) {
-      cit->info() = 22;
-      two_two->push_back(cit);
-    } else {
-      cit->info() = 31;
-      three_one->push_back(cit);
+    switch (classify_3_simplex(cit)) {
+      case 13:
+        one_three->push_back(cit);
+        break;
+      case 22:
+        two_two->push_back(cit);
+        break;
+      default:
+        three_one->push_back(cit);
     }
   }
 }  // classify_3_simplices()
@@ -427,6 +438,85 @@ inline void make_2_sphere(const unsigned number_of_points,
   }
 }  // make_2_sphere()
 
+/// @brief Make 2-spheres of varying radii from a given random generator
+///
+/// @param[in] number_of_points Number of vertices at a given radius
+/// @param[in] radius Radius of sphere
+/// @param[in] output Prints detailed output
+/// @param[in,out] rng The random number generator for the points
+/// @param[out]  vertices  The vertices to insert into D3
+/// @param[out]  timevalue The timevalues placed into vertex.info()
+inline void make_2_sphere(const unsigned number_of_points,
+                          const double radius,
+                          const bool output,
+                          CGAL::Random* const rng,
+                          std::vector<Point>* const vertices,
+                          std::vector<unsigned>* const timevalue) noexcept {
+  CGAL::Random_points_on_sphere_3<Point> gen(radius, *rng);
+
+  for (auto j = 0u; j < number_of_points; ++j) {
+    vertices->push_back(*gen++);
+    timevalue->push_back(static_cast<unsigned int>(radius));
+  }
+
+  if (output) {
+    std::cout << "Generating " << number_of_points << " random points on "
+    << "the surface of a sphere in 3D of center 0 and radius "
+    << radius << "." << std::endl;
+  }
+}  // make_2_sphere()
+
+/// @brief Generate and insert nested spheres of points in bounded batches
+///
+/// Each sphere's points come from one generator, exactly as in
+/// make_2_sphere(), so their Delaunay triangulation is the same as when
+/// they are inserted all at once. Only **batch** points are held at a time,
+/// and each batch is spatially sorted as it is inserted.
+///
+/// @param[in] number_of_points Number of vertices on each sphere
+/// @param[in] number_of_timeslices The number of spheres
+/// @param[in] batch Points generated and inserted together
+/// @param[in] output Prints detailed output
+/// @param[in,out] rng The random number generator for the points, or
+/// nullptr to use CGAL's default generator
+/// @param[out] D3 The Delaunay triangulation
+inline void stream_into_S3(const unsigned number_of_points,
+                           const unsigned number_of_timeslices,
+                           const unsigned batch,
+                           const bool output,
+                           CGAL::Random* const rng,
+                           Delaunay* const D3) noexcept {
+  using Generator = CGAL::Random_points_on_sphere_3<Point>;
+  std::vector<Point> vertices;
+  std::vector<unsigned> timevalue;
+  vertices.reserve(std::min(batch, number_of_points));
+  timevalue.reserve(std::min(batch, number_of_points));
+
+  for (auto i = 0u; i < number_of_timeslices; ++i) {
+    const auto radius = 1.0 + static_cast<double>(i);
+    auto gen = (rng != nullptr) ? Generator(radius, *rng) : Generator(radius);
+    for (auto j = 0u; j < number_of_points; ++j) {
+      vertices.push_back(*gen++);
+      timevalue.push_back(static_cast<unsigned int>(radius));
+      if (vertices.size() == batch || j + 1 == number_of_points) {
+        insert_into_S3(vertices, timevalue, D3);
+        vertices.clear();
+        timevalue.clear();
+      }
+    }
+    if (output) {
+      std::cout << "Inserted " << number_of_points << " random points on "
+      << "the surface of a sphere in 3D of center 0 and radius "
+      << radius << " in batches of " << batch << "." << std::endl;
+    }
+  }
+}  // stream_into_S3()
+
+/// Version of the universe generator. Bump this whenever a change makes
+/// make_S3_triangulation() produce a different universe from the same seed,
+/// so that cached universes are regenerated.
+static constexpr unsigned UNIVERSE_GENERATOR_VERSION = 1;
+
 /// @brief Make a foliated 2-sphere
 ///
 /// This function creates a valid 2+1 foliation from a Delaunay triangulation.
@@ -450,18 +540,24 @@ inline void make_2_sphere(const unsigned number_of_points,
 /// @param[in] number_of_simplices The number of simplices in the triangulation
 /// @param[in] number_of_timeslices The number of foliated timeslices
 /// @param[in] output Prints detailed output
+/// @param[in] batch Points generated and inserted together by
+/// stream_into_S3(), or 0 to generate them all before inserting them
+/// @param[in,out] rng The random number generator for the points, or
+/// nullptr to use CGAL's default generator
 /// @param[out] D3 The Delaunay triangulation
 /// @param[out] three_one Cell handles of all (3,1) simplices
 /// @param[out] two_two Cell handles of all (2,2) simplices
 /// @param[out] one_three Cell handles of all (1,3) simplices
-inline void make_S3_triangulation(const unsigned number_of_simplices,
-                                  const unsigned number_of_timeslices,
-                                  const bool output,
-                                  Delaunay* const D3,
-                                  std::vector<Cell_handle>* const three_one,
-                                  std::vector<Cell_handle>* const two_two,
-                                  std::vector<Cell_handle>* const one_three)
-                                  noexcept {
+inline void generate_S3_triangulation(
+    const unsigned number_of_simplices,
+    const unsigned number_of_timeslices,
+    const bool output,
+    const unsigned batch,
+    CGAL::Random* const rng,
+    Delaunay* const D3,
+    std::vector<Cell_handle>* const three_one,
+    std::vector<Cell_handle>* const two_two,
+    std::vector<Cell_handle>* const one_three) noexcept {
   std::cout << "Generating universe ..." << std::endl;
   const auto simplices_per_timeslice = number_of_simplices /
                                        number_of_timeslices;
@@ -471,27 +567,35 @@ inline void make_S3_triangulation(const unsigned number_of_simplices,
 
   const auto points = simplices_per_timeslice * 4;
   const auto total_points = points * number_of_timeslices;
-  auto radius = 1.0;
-
-  std::vector<Point> vertices;
-  std::vector<unsigned> timevalue;
-
-  // We know how many points we have in advance, so reserve memory
-  vertices.reserve(total_points);
-  timevalue.reserve(total_points);
+  if (batch > 0) {
+    stream_into_S3(points, number_of_timeslices, batch, output, rng, D3);
+  } else {
+    auto radius = 1.0;
+
+    std::vector<Point> vertices;
+    std::vector<unsigned> timevalue;
+
+    // We know how many points we have in advance, so reserve memory
+    vertices.reserve(total_points);
+    timevalue.reserve(total_points);
+
+    for (auto i = 0; i < number_of_timeslices; ++i) {
+      // std::cout << "Loop " << i << std::endl;
+      radius = 1.0 + static_cast<double>(i);
+      if (rng != nullptr) {
+        make_2_sphere(points, radius, output, rng, &vertices, &timevalue);
+      } else {
+        make_2_sphere(points, radius, output, &vertices, &timevalue);
+      }
+    }
 
-  for (auto i = 0; i < number_of_timeslices; ++i) {
-    // std::cout << "Loop " << i << std::endl;
-    radius = 1.0 + static_cast<double>(i);
-    make_2_sphere(points, radius, output, &vertices, &timevalue);
+    // Insert vertices and timeslices
+    // It's more complicated than
+    // D3->insert(vertices.begin(), vertices.end());
+    // due to the timevalues
+    insert_into_S3(vertices, timevalue, D3);
   }
 
-  // Insert vertices and timeslices
-  // It's more complicated than
-  // D3->insert(vertices.begin(), vertices.end());
-  // due to the timevalues
-  insert_into_S3(vertices, timevalue, D3);
-
   // Remove cells that have invalid foliations
   auto pass = 0;
   while (!check_timeslices(D3, output)) {
@@ -522,5 +626,88 @@ inline void make_S3_triangulation(const unsigned number_of_simplices,
     }
   }
   assert(D3->is_valid());
+}  // generate_S3_triangulation()
+
+/// @brief Make a foliated 2-sphere
+///
+/// See generate_S3_triangulation(). Points come from CGAL's default random
+/// generator, so every run makes a different universe.
+///
+/// @param[in] number_of_simplices The number of simplices in the triangulation
+/// @param[in] number_of_timeslices The number of foliated timeslices
+/// @param[in] output Prints detailed output
+/// @param[out] D3 The Delaunay triangulation
+/// @param[out] three_one Cell handles of all (3,1) simplices
+/// @param[out] two_two Cell handles of all (2,2) simplices
+/// @param[out] one_three Cell handles of all (1,3) simplices
+inline void make_S3_triangulation(const unsigned number_of_simplices,
+                                  const unsigned number_of_timeslices,
+                                  const bool output,
+                                  Delaunay* const D3,
+                                  std::vector<Cell_handle>* const three_one,
+                                  std::vector<Cell_handle>* const two_two,
+                                  std::vector<Cell_handle>* const one_three)
+                                  noexcept {
+  generate_S3_triangulation(number_of_simplices, number_of_timeslices, output,
+                            0, nullptr, D3, three_one, two_two, one_three);
 }  // make_S3_triangulation()
+
+/// @brief Make a foliated 2-sphere reproducibly from a seed
+///
+/// See generate_S3_triangulation(). The same seed, size, and
+/// UNIVERSE_GENERATOR_VERSION always give the same universe.
+///
+/// @param[in] number_of_simplices The number of simplices in the triangulation
+/// @param[in] number_of_timeslices The number of foliated timeslices
+/// @param[in] seed Seed for the random points
+/// @param[in] output Prints detailed output
+/// @param[out] D3 The Delaunay triangulation
+/// @param[out] three_one Cell handles of all (3,1) simplices
+/// @param[out] two_two Cell handles of all (2,2) simplices
+/// @param[out] one_three Cell handles of all (1,3) simplices
+inline void make_S3_triangulation(const unsigned number_of_simplices,
+                                  const unsigned number_of_timeslices,
+                                  const std::uint64_t seed,
+                                  const bool output,
+                                  Delaunay* const D3,
+                                  std::vector<Cell_handle>* const three_one,
+                                  std::vector<Cell_handle>* const two_two,
+                                  std::vector<Cell_handle>* const one_three)
+                                  noexcept {
+  // CGAL::Random takes an unsigned seed, so fold in the high bits
+  CGAL::Random rng(static_cast<unsigned>(seed ^ (seed >> 32)));
+  generate_S3_triangulation(number_of_simplices, number_of_timeslices, output,
+                            0, &rng, D3, three_one, two_two, one_three);
+}  // make_S3_triangulation()
+
+/// @brief Make a foliated 2-sphere without holding all its points at once
+///
+/// See generate_S3_triangulation() and stream_into_S3(). The points are the
+/// same as make_S3_triangulation() makes from the same generator, but peak
+/// memory stays close to that of the triangulation itself.
+///
+/// @param[in] number_of_simplices The number of simplices in the triangulation
+/// @param[in] number_of_timeslices The number of foliated timeslices
+/// @param[in] batch Points generated and inserted together
+/// @param[in] output Prints detailed output
+/// @param[in,out] rng The random number generator for the points, or
+/// nullptr to use CGAL's default generator
+/// @param[out] D3 The Delaunay triangulation
+/// @param[out] three_one Cell handles of all (3,1) simplices
+/// @param[out] two_two Cell handles of all (2,2) simplices
+/// @param[out] one_three Cell handles of all (1,3) simplices
+inline void make_streamed_S3_triangulation(
+    const unsigned number_of_simplices,
+    const unsigned number_of_timeslices,
+    const unsigned batch,
+    const bool output,
+    CGAL::Random* const rng,
+    Delaunay* const D3,
+    std::vector<Cell_handle>* const three_one,
+    std::vector<Cell_handle>* const two_two,
+    std::vector<Cell_handle>* const one_three) noexcept {
+  assert(batch > 0);
+  generate_S3_triangulation(number_of_simplices, number_of_timeslices, output,
+                            batch, rng, D3, three_one, two_two, one_three);
+}  // make_streamed_S3_triangulation()
 #endif  // SRC_S3TRIANGULATION_H_
@@ -0,0 +1,309 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// On-disk cache of seed universes
+///
+/// Generating a universe with **make_S3_triangulation()** pays for Delaunay
+/// insertion plus several foliation repair passes. Universes generated from
+/// a seed are reproducible, so they are saved to a cache directory keyed by
+/// topology, number of simplices, timeslices, seed, and
+/// UNIVERSE_GENERATOR_VERSION, and loaded from there on later runs.
+///
+/// Files hold a fixed header, the triangulation in CGAL's binary format, and
+/// then the timeslice of every finite vertex in iteration order. CGAL reads
+/// vertices back in the order they were written, so the timeslices line up.
+/// Cell types are reclassified on load. Files are written to a temporary
+/// name and renamed into place, so concurrent runs never see partial files.
+///
+/// \done Binary save and load of foliated triangulations
+/// \done Cache keyed by size, timeslices, topology, seed, and version
+/// \done Snapshots written in the background
+/// \todo Toroidal universes
+
+/// @file SeedCache.h
+/// @brief On-disk cache of seed universes
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_SEEDCACHE_H_
+#define SRC_SEEDCACHE_H_
+
+// CGAL headers
+#include <CGAL/IO/io.h>
+
+// CDT headers
+#include "S3Triangulation.h"
+
+// C headers
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C++ headers
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Format version of cached universe files
+static constexpr std::uint32_t SEED_CACHE_FORMAT = 1;
+
+/// @brief Identifies a cached universe
+struct Universe_key {
+  /// 3 for S3; toroidal universes are not generated yet
+  std::uint32_t topology;
+  std::uint64_t number_of_simplices;
+  std::uint64_t number_of_timeslices;
+  std::uint64_t seed;
+  std::uint32_t generator_version;
+};
+
+/// @returns A Universe_key for an S3 universe from the current generator
+inline Universe_key make_universe_key(const unsigned number_of_simplices,
+                                      const unsigned number_of_timeslices,
+                                      const std::uint64_t seed) noexcept {
+  return Universe_key{3, number_of_simplices, number_of_timeslices, seed,
+                      UNIVERSE_GENERATOR_VERSION};
+}  // make_universe_key()
+
+/// @returns The file name of a cached universe in **directory**
+inline std::string cached_universe_path(const std::string& directory,
+                                        const Universe_key& key) noexcept {
+  return directory + "/S" + std::to_string(key.topology) + "-" +
+         std::to_string(key.number_of_simplices) + "-" +
+         std::to_string(key.number_of_timeslices) + "-seed" +
+         std::to_string(key.seed) + "-v" +
+         std::to_string(key.generator_version) + ".cdt";
+}  // cached_universe_path()
+
+/// @brief Writes a fixed-size value in native byte order
+template <typename T>
+inline void write_binary(std::ostream& os, const T& value) noexcept {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/// @brief Reads a fixed-size value in native byte order
+template <typename T>
+inline bool read_binary(std::istream& is, T* const value) noexcept {
+  is.read(reinterpret_cast<char*>(value), sizeof(*value));
+  return static_cast<bool>(is);
+}
+
+/// @brief Saves a foliated triangulation
+///
+/// @param[in] path The file to write
+/// @param[in] key  The Universe_key recorded in the header
+/// @param[in] D3   The Delaunay triangulation
+/// @returns True if the file was written completely
+inline bool save_universe(const std::string& path,
+                          const Universe_key& key,
+                          const Delaunay& D3) noexcept {
+  const auto temporary = path + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream os(temporary, std::ios::out | std::ios::binary);
+    if (!os) return false;
+    os.write("CDT3", 4);
+    write_binary(os, SEED_CACHE_FORMAT);
+    write_binary(os, key.topology);
+    write_binary(os, key.number_of_simplices);
+    write_binary(os, key.number_of_timeslices);
+    write_binary(os, key.seed);
+    write_binary(os, key.generator_version);
+
+    CGAL::set_binary_mode(os);
+    os << D3;
+
+    const auto vertices = static_cast<std::uint64_t>(D3.number_of_vertices());
+    write_binary(os, vertices);
+    Delaunay::Finite_vertices_iterator vit;
+    for (vit = D3.finite_vertices_begin(); vit != D3.finite_vertices_end();
+         ++vit) {
+      write_binary(os, vit->info());
+    }
+    if (!os) {
+      unlink(temporary.c_str());
+      return false;
+    }
+  }
+  return rename(temporary.c_str(), path.c_str()) == 0;
+}  // save_universe()
+
+/// @brief Loads a foliated triangulation saved by **save_universe()**
+///
+/// @param[in]  path      The file to read
+/// @param[in]  key       The Universe_key the file must match
+/// @param[out] D3        The Delaunay triangulation
+/// @param[out] three_one Cell handles of all (3,1) simplices
+/// @param[out] two_two   Cell handles of all (2,2) simplices
+/// @param[out] one_three Cell handles of all (1,3) simplices
+/// @returns True if the file exists, matches **key**, and was read
+/// completely; otherwise **D3** is cleared
+inline bool load_universe(const std::string& path,
+                          const Universe_key& key,
+                          Delaunay* const D3,
+                          std::vector<Cell_handle>* const three_one,
+                          std::vector<Cell_handle>* const two_two,
+                          std::vector<Cell_handle>* const one_three) noexcept {
+  std::ifstream is(path, std::ios::in | std::ios::binary);
+  if (!is) return false;
+
+  char magic[4];
+  is.read(magic, 4);
+  Universe_key found;
+  auto format = static_cast<std::uint32_t>(0);
+  if (!is || std::memcmp(magic, "CDT3", 4) != 0 ||
+      !read_binary(is, &format) || format != SEED_CACHE_FORMAT ||
+      !read_binary(is, &found.topology) ||
+      !read_binary(is, &found.number_of_simplices) ||
+      !read_binary(is, &found.number_of_timeslices) ||
+      !read_binary(is, &found.seed) ||
+      !read_binary(is, &found.generator_version) ||
+      found.topology != key.topology ||
+      found.number_of_simplices != key.number_of_simplices ||
+      found.number_of_timeslices != key.number_of_timeslices ||
+      found.seed != key.seed ||
+      found.generator_version != key.generator_version) {
+    return false;
+  }
+
+  D3->clear();
+  CGAL::set_binary_mode(is);
+  is >> *D3;
+
+  auto vertices = static_cast<std::uint64_t>(0);
+  if (!is || !read_binary(is, &vertices) ||
+      vertices != D3->number_of_vertices()) {
+    D3->clear();
+    return false;
+  }
+  Delaunay::Finite_vertices_iterator vit;
+  for (vit = D3->finite_vertices_begin(); vit != D3->finite_vertices_end();
+       ++vit) {
+    if (!read_binary(is, &vit->info())) {
+      D3->clear();
+      return false;
+    }
+  }
+
+  three_one->clear();
+  two_two->clear();
+  one_three->clear();
+  classify_3_simplices(D3, three_one, two_two, one_three);
+  return true;
+}  // load_universe()
+
+/// @brief Makes a seeded S3 universe, loading it from a cache if possible
+///
+/// On a cache miss the universe is generated by **make_S3_triangulation()**
+/// and saved for next time. An empty **directory** disables the cache.
+///
+/// @param[in]  directory            The cache directory, created if missing
+/// @param[in]  number_of_simplices  The number of simplices
+/// @param[in]  number_of_timeslices The number of foliated timeslices
+/// @param[in]  seed                 Seed for the random points
+/// @param[in]  output               Prints detailed output
+/// @param[out] D3                   The Delaunay triangulation
+/// @param[out] three_one            Cell handles of all (3,1) simplices
+/// @param[out] two_two              Cell handles of all (2,2) simplices
+/// @param[out] one_three            Cell handles of all (1,3) simplices
+/// @returns True if the universe came from the cache
+inline bool make_cached_S3_triangulation(
+    const std::string& directory,
+    const unsigned number_of_simplices,
+    const unsigned number_of_timeslices,
+    const std::uint64_t seed,
+    const bool output,
+    Delaunay* const D3,
+    std::vector<Cell_handle>* const three_one,
+    std::vector<Cell_handle>* const two_two,
+    std::vector<Cell_handle>* const one_three) noexcept {
+  const auto key = make_universe_key(number_of_simplices,
+                                     number_of_timeslices, seed);
+  const auto path = cached_universe_path(directory, key);
+  if (!directory.empty() &&
+      load_universe(path, key, D3, three_one, two_two, one_three)) {
+    std::cout << "Loaded universe from " << path << std::endl;
+    return true;
+  }
+
+  make_S3_triangulation(number_of_simplices, number_of_timeslices, seed,
+                        output, D3, three_one, two_two, one_three);
+
+  if (!directory.empty()) {
+    if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST) {
+      std::cout << "Cannot create cache directory " << directory
+                << std::endl;
+    } else if (save_universe(path, key, *D3)) {
+      std::cout << "Saved universe to " << path << std::endl;
+    }
+  }
+  return false;
+}  // make_cached_S3_triangulation()
+
+/// @brief Saves snapshots of a running triangulation in the background
+///
+/// The triangulation is copied on the caller's thread, which takes far
+/// less time than writing it out, and the copy is saved by
+/// **save_universe()** on a background thread while the caller carries on.
+/// One snapshot is written at a time.
+class Snapshot_writer {
+ public:
+  Snapshot_writer() noexcept : busy_(false), saved_(0) {}
+
+  ~Snapshot_writer() { wait(); }
+
+  Snapshot_writer(const Snapshot_writer&) = delete;
+  Snapshot_writer& operator=(const Snapshot_writer&) = delete;
+
+  /// @brief Starts saving a snapshot
+  ///
+  /// @param[in] path The file to write
+  /// @param[in] key  The Universe_key recorded in the header
+  /// @param[in] D3   The Delaunay triangulation, copied before returning
+  /// @returns False if the previous snapshot is still being written
+  bool start(const std::string& path,
+             const Universe_key& key,
+             const Delaunay& D3) noexcept {
+    if (busy_) return false;
+    wait();
+    copy_.reset(new Delaunay(D3));
+    busy_ = true;
+    writer_ = std::thread([this, path, key]() {
+      if (save_universe(path, key, *copy_)) {
+        saved_++;
+      } else {
+        std::cout << "Could not write snapshot " << path << std::endl;
+      }
+      busy_ = false;
+    });
+    return true;
+  }
+
+  /// @returns True while a snapshot is being written
+  bool busy() const noexcept { return busy_; }
+
+  /// @returns The number of snapshots written successfully
+  std::uint64_t saved() const noexcept { return saved_; }
+
+  /// @brief Waits for the snapshot being written, if any
+  void wait() noexcept {
+    if (writer_.joinable()) writer_.join();
+    copy_.reset();
+  }
+
+ private:
+  std::atomic<bool> busy_;
+  std::atomic<std::uint64_t> saved_;
+  std::unique_ptr<Delaunay> copy_;
+  std::thread writer_;
+};
+
+#endif  // SRC_SEEDCACHE_H_
@@ -0,0 +1,462 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Zero-copy snapshots of the triangulation in POSIX shared memory
+///
+/// A running simulation publishes its triangulation as structure-of-arrays
+/// snapshots in a shared memory segment named cdtsnap-<pid>, so analysis
+/// processes can map it and read the latest configuration in place, with
+/// no file written or parsed.
+///
+/// The segment starts with a Shared_snapshot_header, followed by two
+/// buffers. Snapshot g is written to buffer g % 2, so the previous snapshot
+/// stays intact while the next is written. Each buffer starts with a
+/// Shared_snapshot_buffer whose sequence number is odd while it is being
+/// written, followed by 64-byte aligned arrays, at the offsets it records:
+///
+/// - x, y, z: double[number_of_vertices], the vertex coordinates
+/// - timeslice: uint32[number_of_vertices]
+/// - cell_vertices: uint32[4][number_of_cells], i.e. four arrays of vertex
+///   indices, one per corner
+/// - cell_type: uint32[number_of_cells], 31, 22, or 13
+///
+/// A reader takes the buffer of **generation** from the header, notes its
+/// sequence number, reads the arrays in place, and afterwards checks that
+/// the sequence number is unchanged; if not, the writer lapped it and the
+/// read is retried. If the triangulation outgrows the segment, the writer
+/// marks it retired and replaces it with a larger one under the same name,
+/// which readers detect and reattach to.
+///
+/// \done Versioned header
+/// \done Double-buffered structure-of-arrays snapshots
+/// \done Readers that validate in-place reads
+
+/// @file SharedSnapshot.h
+/// @brief Zero-copy triangulation snapshots in shared memory
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_SHAREDSNAPSHOT_H_
+#define SRC_SHAREDSNAPSHOT_H_
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "TimesliceIndex.h"
+
+// C headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C++ headers
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <unordered_map>
+
+/// Identifies a snapshot segment, "CDTS"
+static constexpr std::uint32_t SHARED_SNAPSHOT_MAGIC = 0x53544443;
+
+/// Bumped whenever the segment layout changes
+static constexpr std::uint32_t SHARED_SNAPSHOT_VERSION = 1;
+
+/// Shared memory names of snapshot segments start with this
+static constexpr const char* SHARED_SNAPSHOT_PREFIX = "cdtsnap-";
+
+/// Arrays start on cache line boundaries
+static constexpr std::uint64_t SHARED_SNAPSHOT_ALIGNMENT = 64;
+
+/// Room for growth when a segment is sized
+static constexpr double SHARED_SNAPSHOT_HEADROOM = 1.5;
+
+/// @brief The start of a snapshot segment
+struct Shared_snapshot_header {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::uint64_t segment_bytes;
+  std::uint64_t vertex_capacity;
+  std::uint64_t cell_capacity;
+  /// Offsets of the two buffers from the start of the segment
+  std::uint64_t buffer_offset[2];
+  /// Set once a larger segment has replaced this one
+  std::atomic<std::uint32_t> retired;
+  /// The latest complete snapshot, in buffer generation % 2; 0 if none
+  std::atomic<std::uint64_t> generation;
+};
+
+/// @brief The start of one snapshot buffer
+///
+/// Array offsets are from the start of this buffer.
+struct Shared_snapshot_buffer {
+  /// Odd while the buffer is being written
+  std::atomic<std::uint64_t> sequence;
+  std::uint64_t generation;
+  std::uint64_t pass;
+  std::uint64_t number_of_vertices;
+  std::uint64_t number_of_cells;
+  std::uint64_t number_of_timeslices;
+  std::uint64_t N1_TL;
+  std::uint64_t N3_31;
+  std::uint64_t N3_22;
+  std::uint64_t x_offset;
+  std::uint64_t y_offset;
+  std::uint64_t z_offset;
+  std::uint64_t timeslice_offset;
+  std::uint64_t cell_vertices_offset[4];
+  std::uint64_t cell_type_offset;
+};
+
+/// @returns **bytes** rounded up to SHARED_SNAPSHOT_ALIGNMENT
+inline std::uint64_t align_snapshot(const std::uint64_t bytes) noexcept {
+  return (bytes + SHARED_SNAPSHOT_ALIGNMENT - 1) /
+         SHARED_SNAPSHOT_ALIGNMENT * SHARED_SNAPSHOT_ALIGNMENT;
+}  // align_snapshot()
+
+/// @brief Lays out one buffer's arrays
+///
+/// @param[in]  vertex_capacity Vertices the buffer can hold
+/// @param[in]  cell_capacity   Cells the buffer can hold
+/// @param[out] buffer          Receives the array offsets
+/// @returns The size of the buffer in bytes
+inline std::uint64_t layout_snapshot_buffer(
+    const std::uint64_t vertex_capacity,
+    const std::uint64_t cell_capacity,
+    Shared_snapshot_buffer* const buffer) noexcept {
+  auto offset = align_snapshot(sizeof(Shared_snapshot_buffer));
+  for (auto* array : {&buffer->x_offset, &buffer->y_offset,
+                      &buffer->z_offset}) {
+    *array = offset;
+    offset = align_snapshot(offset + vertex_capacity * sizeof(double));
+  }
+  buffer->timeslice_offset = offset;
+  offset = align_snapshot(offset + vertex_capacity * sizeof(std::uint32_t));
+  for (auto& array : buffer->cell_vertices_offset) {
+    array = offset;
+    offset = align_snapshot(offset + cell_capacity * sizeof(std::uint32_t));
+  }
+  buffer->cell_type_offset = offset;
+  return align_snapshot(offset + cell_capacity * sizeof(std::uint32_t));
+}  // layout_snapshot_buffer()
+
+/// @returns The shared memory object name for a snapshot segment
+inline std::string shared_snapshot_path(const std::string& name) noexcept {
+  return "/" + name;
+}  // shared_snapshot_path()
+
+/// @returns The default snapshot segment name of this process
+inline std::string default_shared_snapshot_name() noexcept {
+  return SHARED_SNAPSHOT_PREFIX + std::to_string(getpid());
+}  // default_shared_snapshot_name()
+
+/// @brief Publishes snapshots, and removes the segment when destroyed
+class Snapshot_publisher {
+ public:
+  /// @param[in] name The segment name, e.g. **default_shared_snapshot_name()**
+  explicit Snapshot_publisher(const std::string& name) noexcept
+      : name_(name), segment_(nullptr), generation_(0) {}
+
+  ~Snapshot_publisher() {
+    if (segment_ == nullptr) return;
+    munmap(segment_, header()->segment_bytes);
+    shm_unlink(shared_snapshot_path(name_).c_str());
+  }
+
+  Snapshot_publisher(const Snapshot_publisher&) = delete;
+  Snapshot_publisher& operator=(const Snapshot_publisher&) = delete;
+
+  const std::string& name() const noexcept { return name_; }
+
+  /// @returns The number of snapshots published
+  std::uint64_t generation() const noexcept { return generation_; }
+
+  /// @brief Writes the triangulation into the buffer readers aren't using
+  ///
+  /// @param[in] D3         The Delaunay triangulation
+  /// @param[in] timeslices The number of timeslices
+  /// @param[in] pass       The pass the snapshot was taken after
+  /// @param[in] N1_TL      The number of timelike edges
+  /// @param[in] N3_31      The number of (3,1) and (1,3) simplices
+  /// @param[in] N3_22      The number of (2,2) simplices
+  /// @returns True if the snapshot was published
+  bool publish(const Delaunay& D3,
+               const std::uint64_t timeslices,
+               const std::uint64_t pass,
+               const std::uint64_t N1_TL,
+               const std::uint64_t N3_31,
+               const std::uint64_t N3_22) noexcept {
+    const auto vertices = static_cast<std::uint64_t>(D3.number_of_vertices());
+    const auto cells = static_cast<std::uint64_t>(
+        D3.number_of_finite_cells());
+    if (!reserve(vertices, cells)) return false;
+
+    const auto generation = generation_ + 1;
+    auto* buffer = buffer_for(generation);
+    const auto sequence = buffer->sequence.load(std::memory_order_relaxed);
+    buffer->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto* base = reinterpret_cast<char*>(buffer);
+    auto* x = reinterpret_cast<double*>(base + buffer->x_offset);
+    auto* y = reinterpret_cast<double*>(base + buffer->y_offset);
+    auto* z = reinterpret_cast<double*>(base + buffer->z_offset);
+    auto* timeslice =
+        reinterpret_cast<std::uint32_t*>(base + buffer->timeslice_offset);
+    positions_.clear();
+    auto v = static_cast<std::uint32_t>(0);
+    Delaunay::Finite_vertices_iterator vit;
+    for (vit = D3.finite_vertices_begin(); vit != D3.finite_vertices_end();
+         ++vit, ++v) {
+      positions_.emplace(vit, v);
+      x[v] = vit->point().x();
+      y[v] = vit->point().y();
+      z[v] = vit->point().z();
+      timeslice[v] = vit->info();
+    }
+
+    std::uint32_t* corner[4];
+    for (auto k = 0; k < 4; ++k) {
+      corner[k] = reinterpret_cast<std::uint32_t*>(
+          base + buffer->cell_vertices_offset[k]);
+    }
+    auto* type =
+        reinterpret_cast<std::uint32_t*>(base + buffer->cell_type_offset);
+    auto c = static_cast<std::uint64_t>(0);
+    Delaunay::Finite_cells_iterator cit;
+    for (cit = D3.finite_cells_begin(); cit != D3.finite_cells_end();
+         ++cit, ++c) {
+      for (auto k = 0; k < 4; ++k) corner[k][c] = positions_[cit->vertex(k)];
+      type[c] = cit->info();
+    }
+
+    buffer->generation = generation;
+    buffer->pass = pass;
+    buffer->number_of_vertices = vertices;
+    buffer->number_of_cells = cells;
+    buffer->number_of_timeslices = timeslices;
+    buffer->N1_TL = N1_TL;
+    buffer->N3_31 = N3_31;
+    buffer->N3_22 = N3_22;
+    buffer->sequence.store(sequence + 2, std::memory_order_release);
+    header()->generation.store(generation, std::memory_order_release);
+    generation_ = generation;
+    return true;
+  }
+
+ private:
+  Shared_snapshot_header* header() const noexcept {
+    return static_cast<Shared_snapshot_header*>(segment_);
+  }
+
+  Shared_snapshot_buffer* buffer_for(const std::uint64_t generation) const
+      noexcept {
+    return reinterpret_cast<Shared_snapshot_buffer*>(
+        static_cast<char*>(segment_) +
+        header()->buffer_offset[generation % 2]);
+  }
+
+  /// @brief Ensures the segment holds **vertices** and **cells**, replacing
+  /// it with a larger one if need be
+  bool reserve(const std::uint64_t vertices,
+               const std::uint64_t cells) noexcept {
+    if (segment_ != nullptr && vertices <= header()->vertex_capacity &&
+        cells <= header()->cell_capacity) {
+      return true;
+    }
+    const auto vertex_capacity =
+        static_cast<std::uint64_t>(vertices * SHARED_SNAPSHOT_HEADROOM) + 1;
+    const auto cell_capacity =
+        static_cast<std::uint64_t>(cells * SHARED_SNAPSHOT_HEADROOM) + 1;
+    Shared_snapshot_buffer layout;
+    const auto buffer_bytes =
+        layout_snapshot_buffer(vertex_capacity, cell_capacity, &layout);
+    const auto header_bytes = align_snapshot(sizeof(Shared_snapshot_header));
+    const auto segment_bytes = header_bytes + 2 * buffer_bytes;
+
+    // Readers keep the old mapping until they notice it is retired
+    if (segment_ != nullptr) {
+      header()->retired.store(1, std::memory_order_release);
+      munmap(segment_, header()->segment_bytes);
+      segment_ = nullptr;
+    }
+    const auto path = shared_snapshot_path(name_);
+    shm_unlink(path.c_str());
+    const auto fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return false;
+    void* memory = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(segment_bytes)) == 0) {
+      memory = mmap(nullptr, segment_bytes, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (memory == MAP_FAILED) {
+      shm_unlink(path.c_str());
+      return false;
+    }
+
+    segment_ = memory;
+    auto* head = new (segment_) Shared_snapshot_header;
+    head->segment_bytes = segment_bytes;
+    head->vertex_capacity = vertex_capacity;
+    head->cell_capacity = cell_capacity;
+    head->buffer_offset[0] = header_bytes;
+    head->buffer_offset[1] = header_bytes + buffer_bytes;
+    head->retired.store(0, std::memory_order_relaxed);
+    head->generation.store(0, std::memory_order_relaxed);
+    for (auto b = 0; b < 2; ++b) {
+      auto* buffer = new (static_cast<char*>(segment_) +
+                          head->buffer_offset[b]) Shared_snapshot_buffer;
+      layout_snapshot_buffer(vertex_capacity, cell_capacity, buffer);
+      buffer->sequence.store(0, std::memory_order_relaxed);
+      buffer->generation = 0;
+    }
+    head->version = SHARED_SNAPSHOT_VERSION;
+    // Readers ignore the segment until the magic number appears
+    std::atomic_thread_fence(std::memory_order_release);
+    head->magic = SHARED_SNAPSHOT_MAGIC;
+    return true;
+  }
+
+  std::string name_;
+  void* segment_;
+  std::uint64_t generation_;
+  std::unordered_map<Vertex_handle, std::uint32_t, Handle_hash<Vertex_handle>>
+      positions_;
+};
+
+/// @brief Pointers into one snapshot, valid while **Snapshot_reader::
+/// current()** returns true for it
+struct Snapshot_view {
+  std::uint64_t generation;
+  std::uint64_t sequence;
+  std::uint64_t pass;
+  std::uint64_t number_of_vertices;
+  std::uint64_t number_of_cells;
+  std::uint64_t number_of_timeslices;
+  std::uint64_t N1_TL;
+  std::uint64_t N3_31;
+  std::uint64_t N3_22;
+  const double* x;
+  const double* y;
+  const double* z;
+  const std::uint32_t* timeslice;
+  const std::uint32_t* cell_vertices[4];
+  const std::uint32_t* cell_type;
+  /// The buffer, to check it hasn't been overwritten
+  const Shared_snapshot_buffer* buffer;
+};
+
+/// @brief Maps a snapshot segment read-only
+class Snapshot_reader {
+ public:
+  /// @param[in] name The segment name
+  explicit Snapshot_reader(const std::string& name) noexcept
+      : name_(name), segment_(nullptr), bytes_(0) {}
+
+  ~Snapshot_reader() { detach(); }
+
+  Snapshot_reader(const Snapshot_reader&) = delete;
+  Snapshot_reader& operator=(const Snapshot_reader&) = delete;
+
+  /// @brief Finds the latest snapshot
+  ///
+  /// @param[out] view Pointers into the snapshot's arrays
+  /// @returns True if a complete snapshot was found
+  bool latest(Snapshot_view* const view) noexcept {
+    if (!attached() && !attach()) return false;
+    if (header()->retired.load(std::memory_order_acquire) != 0) {
+      detach();
+      if (!attach()) return false;
+    }
+    const auto generation =
+        header()->generation.load(std::memory_order_acquire);
+    if (generation == 0) return false;
+
+    const auto* buffer = reinterpret_cast<const Shared_snapshot_buffer*>(
+        static_cast<const char*>(segment_) +
+        header()->buffer_offset[generation % 2]);
+    const auto sequence = buffer->sequence.load(std::memory_order_acquire);
+    if (sequence % 2 != 0 || buffer->generation != generation) return false;
+
+    const auto* base = reinterpret_cast<const char*>(buffer);
+    view->generation = generation;
+    view->sequence = sequence;
+    view->pass = buffer->pass;
+    view->number_of_vertices = buffer->number_of_vertices;
+    view->number_of_cells = buffer->number_of_cells;
+    view->number_of_timeslices = buffer->number_of_timeslices;
+    view->N1_TL = buffer->N1_TL;
+    view->N3_31 = buffer->N3_31;
+    view->N3_22 = buffer->N3_22;
+    view->x = reinterpret_cast<const double*>(base + buffer->x_offset);
+    view->y = reinterpret_cast<const double*>(base + buffer->y_offset);
+    view->z = reinterpret_cast<const double*>(base + buffer->z_offset);
+    view->timeslice =
+        reinterpret_cast<const std::uint32_t*>(base + buffer->timeslice_offset);
+    for (auto k = 0; k < 4; ++k) {
+      view->cell_vertices[k] = reinterpret_cast<const std::uint32_t*>(
+          base + buffer->cell_vertices_offset[k]);
+    }
+    view->cell_type =
+        reinterpret_cast<const std::uint32_t*>(base + buffer->cell_type_offset);
+    view->buffer = buffer;
+    return current(*view);
+  }
+
+  /// @returns True if nothing read through **view** so far can have been
+  /// overwritten; call after reading
+  bool current(const Snapshot_view& view) const noexcept {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return view.buffer->sequence.load(std::memory_order_relaxed) ==
+           view.sequence;
+  }
+
+ private:
+  const Shared_snapshot_header* header() const noexcept {
+    return static_cast<const Shared_snapshot_header*>(segment_);
+  }
+
+  bool attached() const noexcept { return segment_ != nullptr; }
+
+  bool attach() noexcept {
+    const auto fd = shm_open(shared_snapshot_path(name_).c_str(), O_RDONLY,
+                             0);
+    if (fd < 0) return false;
+    struct stat status;
+    void* memory = MAP_FAILED;
+    if (fstat(fd, &status) == 0 &&
+        static_cast<std::uint64_t>(status.st_size) >=
+            sizeof(Shared_snapshot_header)) {
+      memory = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (memory == MAP_FAILED) return false;
+    segment_ = memory;
+    bytes_ = status.st_size;
+    if (header()->magic != SHARED_SNAPSHOT_MAGIC ||
+        header()->version != SHARED_SNAPSHOT_VERSION ||
+        header()->segment_bytes != bytes_) {
+      detach();
+      return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return true;
+  }
+
+  void detach() noexcept {
+    if (segment_ == nullptr) return;
+    munmap(segment_, bytes_);
+    segment_ = nullptr;
+    bytes_ = 0;
+  }
+
+  std::string name_;
+  void* segment_;
+  std::uint64_t bytes_;
+};
+
+#endif  // SRC_SHAREDSNAPSHOT_H_
@@ -0,0 +1,292 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Slab-parallel construction of a foliated 3-sphere
+///
+/// make_S3_triangulation() triangulates every sphere at once, which makes
+/// cells spanning several timeslices that fix_timeslices() then has to
+/// remove. Here each slab, i.e. the spheres of radii t and t+1, is
+/// triangulated on its own, so slabs are built in parallel.
+///
+/// In the Delaunay triangulation of two concentric spheres of points,
+/// every cell with all four vertices on the outer sphere has that sphere as
+/// its circumsphere, which holds the inner points, so there are none.
+/// Every facet of the inner sphere's convex hull has an empty sphere
+/// through it just beyond the inner sphere, so the cells with all vertices
+/// on the inner sphere fill its hull exactly. The remaining cells are
+/// (3,1), (2,2), and (1,3) simplices which tile the shell between the two
+/// hulls. Adjacent slabs meet on the convex hull of their shared sphere,
+/// which is unique, so their cells stitch together facet for facet.
+///
+/// make_S3_triangulation() ends up with at most three vertices on the
+/// innermost timeslice, since fix_timeslices() removes its vertices until
+/// no cell lies wholly on it. Here only three of its points are kept, so
+/// the innermost slab is cones from them and needs no closing, and the
+/// universe has the same timeslices as one made serially from the same
+/// generator: the points of every other timeslice are identical. The
+/// outermost hull is coned to the infinite vertex. Cells are stitched in a
+/// Compact_triangulation and exported to the Delaunay type. The result is a
+/// valid triangulation with no badly foliated cells, though not a Delaunay
+/// triangulation of all its points, just as after any move.
+///
+/// \done Slabs triangulated in parallel
+/// \done Stitching on shared hull facets
+/// \done Innermost timeslice as in make_S3_triangulation()
+/// \done Cones closing the outermost sphere
+
+/// @file SlabTriangulation.h
+/// @brief Slab-parallel construction of foliated triangulations
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_SLABTRIANGULATION_H_
+#define SRC_SLABTRIANGULATION_H_
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "CompactTriangulation.h"
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// A cell as four vertex numbers, positively oriented
+using Slab_cell = std::array<std::uint32_t, 4>;
+
+/// Points kept on the innermost sphere; four or more would bound cells
+/// lying wholly on the innermost timeslice
+static constexpr std::size_t SLAB_INNERMOST_POINTS = 3;
+
+/// @brief Hashes a facet given as three sorted vertex numbers
+struct Facet_key_hash {
+  std::size_t operator()(const std::array<std::uint32_t, 3>& facet) const
+      noexcept {
+    auto seed = std::hash<std::uint32_t>()(facet[0]);
+    for (auto k = 1; k < 3; ++k) {
+      seed ^= std::hash<std::uint32_t>()(facet[k]) + 0x9e3779b9 +
+              (seed << 6) + (seed >> 2);
+    }
+    return seed;
+  }
+};
+
+/// @returns The sorted vertex numbers of the facet of **cell** opposite
+/// corner **k**
+inline std::array<std::uint32_t, 3> facet_key(const Slab_cell& cell,
+                                              const int k) noexcept {
+  std::array<std::uint32_t, 3> facet;
+  auto f = 0;
+  for (auto m = 0; m < 4; ++m) {
+    if (m != k) facet[f++] = cell[m];
+  }
+  std::sort(facet.begin(), facet.end());
+  return facet;
+}  // facet_key()
+
+/// @brief Triangulates the slab between two spheres of points
+///
+/// @param[in]  inner  Points on the inner sphere
+/// @param[in]  outer  Points on the outer sphere
+/// @param[in]  first  The number of the first inner point; the outer
+///                    points follow the inner ones
+/// @param[out] cells  The cells with vertices on both spheres
+inline void triangulate_slab(const std::vector<Point>& inner,
+                             const std::vector<Point>& outer,
+                             const std::uint32_t first,
+                             std::vector<Slab_cell>* const cells) noexcept {
+  std::vector<Point> points(inner);
+  points.insert(points.end(), outer.begin(), outer.end());
+  std::vector<unsigned> numbers(points.size());
+  for (auto i = static_cast<std::size_t>(0); i < numbers.size(); ++i) {
+    numbers[i] = first + static_cast<unsigned>(i);
+  }
+  Delaunay slab;
+  insert_into_S3(points, numbers, &slab);
+
+  const auto boundary = first + static_cast<std::uint32_t>(inner.size());
+  cells->clear();
+  Delaunay::Finite_cells_iterator cit;
+  for (cit = slab.finite_cells_begin(); cit != slab.finite_cells_end();
+       ++cit) {
+    Slab_cell cell;
+    auto on_inner = 0;
+    for (auto k = 0; k < 4; ++k) {
+      cell[k] = cit->vertex(k)->info();
+      if (cell[k] < boundary) on_inner++;
+    }
+    if (on_inner > 0 && on_inner < 4) cells->push_back(cell);
+  }
+}  // triangulate_slab()
+
+/// @brief Make a foliated 3-sphere slab by slab
+///
+/// Points are made as in generate_S3_triangulation(), one sphere of radius
+/// t per timeslice t, from 1 to **number_of_timeslices**, and all but
+/// SLAB_INNERMOST_POINTS of the innermost sphere are dropped. The slabs
+/// between them are triangulated by **threads** threads and stitched
+/// together.
+///
+/// @param[in] number_of_simplices The number of simplices in the triangulation
+/// @param[in] number_of_timeslices The number of foliated timeslices
+/// @param[in] threads The number of threads triangulating slabs
+/// @param[in,out] rng The random number generator for the points, or
+/// nullptr to use CGAL's default generator
+/// @param[out] D3 The triangulation
+/// @param[out] three_one Cell handles of all (3,1) simplices
+/// @param[out] two_two Cell handles of all (2,2) simplices
+/// @param[out] one_three Cell handles of all (1,3) simplices
+/// @returns False if there are fewer than two timeslices, or if the slabs
+/// did not meet facet for facet, e.g. because four points on a sphere
+/// were coplanar
+inline bool make_slab_S3_triangulation(
+    const unsigned number_of_simplices,
+    const unsigned number_of_timeslices,
+    const unsigned threads,
+    CGAL::Random* const rng,
+    Delaunay* const D3,
+    std::vector<Cell_handle>* const three_one,
+    std::vector<Cell_handle>* const two_two,
+    std::vector<Cell_handle>* const one_three) noexcept {
+  std::cout << "Generating universe slab by slab ..." << std::endl;
+  if (number_of_timeslices < 2) return false;
+  const auto simplices_per_timeslice = number_of_simplices /
+                                       number_of_timeslices;
+  assert(simplices_per_timeslice >= 1);
+  const auto points = simplices_per_timeslice * 4;
+
+  std::vector<std::vector<Point>> spheres(number_of_timeslices);
+  std::vector<unsigned> timevalue;
+  for (auto i = 0u; i < number_of_timeslices; ++i) {
+    const auto radius = 1.0 + static_cast<double>(i);
+    if (rng != nullptr) {
+      make_2_sphere(points, radius, false, rng, &spheres[i], &timevalue);
+    } else {
+      make_2_sphere(points, radius, false, &spheres[i], &timevalue);
+    }
+  }
+
+  // Every point is drawn, so the other spheres match the serial ones
+  spheres[0].resize(std::min(spheres[0].size(), SLAB_INNERMOST_POINTS));
+
+  // Sphere i's points are numbered from first[i], after the infinite vertex
+  std::vector<std::uint32_t> first(number_of_timeslices + 1, 1);
+  for (auto i = 0u; i < number_of_timeslices; ++i) {
+    first[i + 1] = first[i] + static_cast<std::uint32_t>(spheres[i].size());
+  }
+  const auto slabs = number_of_timeslices - 1;
+  std::vector<std::vector<Slab_cell>> slab_cells(slabs);
+  std::atomic<unsigned> next{0};
+  auto triangulate = [&]() {
+    for (auto s = next++; s < slabs; s = next++) {
+      triangulate_slab(spheres[s], spheres[s + 1], first[s],
+                       &slab_cells[s]);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (auto i = 1u; i < std::min(std::max(threads, 1u), slabs); ++i) {
+    workers.emplace_back(triangulate);
+  }
+  triangulate();
+  for (auto& worker : workers) worker.join();
+
+  std::vector<Slab_cell> cells;
+  for (auto& slab : slab_cells) {
+    cells.insert(cells.end(), slab.begin(), slab.end());
+    std::vector<Slab_cell>().swap(slab);
+  }
+  auto timeslice = [&first](const std::uint32_t v) {
+    return static_cast<unsigned>(
+        std::upper_bound(first.begin(), first.end(), v) - first.begin());
+  };
+
+  // Facets on only one slab cell are on the outermost hull; each is coned
+  // off, swapping two vertices to keep the orientation
+  std::unordered_map<std::array<std::uint32_t, 3>, std::size_t,
+                     Facet_key_hash> unmatched;
+  for (auto c = static_cast<std::size_t>(0); c < cells.size(); ++c) {
+    for (auto k = 0; k < 4; ++k) {
+      const auto key = facet_key(cells[c], k);
+      const auto found = unmatched.find(key);
+      if (found == unmatched.end()) {
+        unmatched.emplace(key, 4 * c + k);
+      } else {
+        unmatched.erase(found);
+      }
+    }
+  }
+  const auto slab_cell_count = cells.size();
+  for (const auto& facet : unmatched) {
+    const auto t = timeslice(facet.first[0]);
+    if (timeslice(facet.first[1]) != t || timeslice(facet.first[2]) != t) {
+      return false;
+    }
+    if (t != number_of_timeslices) {
+      std::cout << "Slabs do not meet on timeslice " << t << "." << std::endl;
+      return false;
+    }
+    auto cone = cells[facet.second / 4];
+    const auto k = static_cast<int>(facet.second % 4);
+    cone[k] = COMPACT_INFINITE_VERTEX;
+    std::swap(cone[(k + 1) % 4], cone[(k + 2) % 4]);
+    cells.push_back(cone);
+  }
+  unmatched.clear();
+
+  // Stitch every cell to its neighbors
+  Compact_triangulation compact;
+  compact.reserve(first.back() - 1, cells.size());
+  for (auto i = 0u; i < number_of_timeslices; ++i) {
+    for (const auto& point : spheres[i]) compact.add_vertex(point, i + 1);
+  }
+  std::unordered_map<std::array<std::uint32_t, 3>,
+                     std::pair<std::uint32_t, int>, Facet_key_hash> open;
+  open.reserve(cells.size());
+  for (const auto& cell : cells) {
+    const auto c = compact.create_cell(cell[0], cell[1], cell[2], cell[3]);
+    for (auto k = 0; k < 4; ++k) {
+      const auto key = facet_key(cell, k);
+      const auto found = open.find(key);
+      if (found == open.end()) {
+        open.emplace(key, std::make_pair(c, k));
+      } else {
+        compact.set_neighbor(c, k, found->second.first);
+        compact.set_neighbor(found->second.first, found->second.second, c);
+        open.erase(found);
+      }
+    }
+  }
+  if (!open.empty() || !compact.is_valid()) {
+    std::cout << "Slabs could not be stitched." << std::endl;
+    return false;
+  }
+
+  std::uint64_t N3_31, N3_22, N3_13;
+  compact.classify_cells(&N3_31, &N3_22, &N3_13);
+  export_compact_triangulation(compact, D3);
+  three_one->clear();
+  two_two->clear();
+  one_three->clear();
+  classify_3_simplices(D3, three_one, two_two, one_three);
+
+  std::cout << "Stitched " << slabs << " slabs of " << slab_cell_count
+            << " cells on " << std::min(std::max(threads, 1u), slabs)
+            << " threads." << std::endl;
+  std::cout << "Triangulation has " << D3->number_of_finite_cells();
+  std::cout << " cells." << std::endl;
+  std::cout << "There are " << three_one->size() << " (3,1) simplices" <<
+               " and " << two_two->size() << " (2,2) simplices and " <<
+               one_three->size() << " (1,3) simplices." << std::endl;
+  return true;
+}  // make_slab_S3_triangulation()
+
+#endif  // SRC_SLABTRIANGULATION_H_
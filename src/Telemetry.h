@@ -0,0 +1,284 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Live telemetry of a run through a shared-memory stats page
+///
+/// A running simulation publishes a small page in POSIX shared memory,
+/// named cdt-<pid>, which it rewrites after every sweep with its counts,
+/// action, acceptance, throughput, and estimated time remaining. Publishing
+/// only writes to memory: there are no system calls, I/O, or locks on the
+/// simulation thread. Readers such as cdt-top map the page read-only and
+/// copy it under a sequence lock, i.e. the writer makes the sequence number
+/// odd while it writes and even when it is done, and a reader retries until
+/// it sees the same even number before and after its copy.
+///
+/// The page of a run which finished is left behind when it exits, so
+/// readers can still show that it finished. cdt-top removes such pages
+/// once it has shown them, and each new run removes the pages of runs which
+/// are no longer running, so they do not pile up.
+///
+/// \done Shared-memory stats page
+/// \done Lock-free reads with a sequence lock
+/// \done Discovery of pages in /dev/shm
+/// \done Finished pages outlive their runs until read
+
+/// @file Telemetry.h
+/// @brief Shared-memory stats page for live monitoring
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_TELEMETRY_H_
+#define SRC_TELEMETRY_H_
+
+// C headers
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+/// Identifies a telemetry page, "CDTP"
+static constexpr std::uint32_t TELEMETRY_MAGIC = 0x50544443;
+
+/// Bumped whenever Telemetry_page changes layout
+static constexpr std::uint32_t TELEMETRY_VERSION = 1;
+
+/// Shared memory names of telemetry pages start with this
+static constexpr const char* TELEMETRY_PREFIX = "cdt-";
+
+/// Times a reader retries a copy torn by the writer
+static constexpr int TELEMETRY_READ_ATTEMPTS = 1 << 20;
+
+/// Which part of the run is in progress
+enum class run_phase : std::uint32_t {
+  STARTING,
+  THERMALIZING,
+  SWEEPING,
+  FINISHED
+};
+
+/// @returns A printable name for the run phase
+inline std::string run_phase_name(const run_phase phase) noexcept {
+  switch (phase) {
+    case run_phase::STARTING:
+      return "starting";
+    case run_phase::THERMALIZING:
+      return "thermalizing";
+    case run_phase::SWEEPING:
+      return "sweeping";
+    default:
+      return "finished";
+  }
+}  // run_phase_name()
+
+/// @brief The state of a run after its latest sweep
+///
+/// Per-move counts are indexed like **move_type**.
+struct Telemetry_sample {
+  run_phase phase;
+  std::uint64_t pass;
+  std::uint64_t passes;
+  std::uint64_t N1_TL;
+  std::uint64_t N3_31;
+  std::uint64_t N3_22;
+  double action;
+  std::array<std::uint64_t, 4> attempted;
+  std::array<std::uint64_t, 4> accepted;
+  double moves_per_second;
+  double elapsed_seconds;
+  /// Negative if unknown
+  double eta_seconds;
+};
+
+/// @brief The layout of the shared-memory page
+struct Telemetry_page {
+  std::uint32_t magic;
+  std::uint32_t version;
+  std::int64_t pid;
+  std::uint64_t seed;
+  std::uint64_t timeslices;
+  /// Odd while the sample is being written
+  std::atomic<std::uint64_t> sequence;
+  Telemetry_sample sample;
+};
+
+/// @brief A consistent copy of a telemetry page
+struct Telemetry_snapshot {
+  std::int64_t pid;
+  std::uint64_t seed;
+  std::uint64_t timeslices;
+  Telemetry_sample sample;
+};
+
+/// @returns The shared memory object name for a telemetry page
+inline std::string telemetry_path(const std::string& name) noexcept {
+  return "/" + name;
+}  // telemetry_path()
+
+/// @returns The default telemetry page name of this process
+inline std::string default_telemetry_name() noexcept {
+  return TELEMETRY_PREFIX + std::to_string(getpid());
+}  // default_telemetry_name()
+
+inline std::vector<std::string> list_telemetry() noexcept;
+inline void remove_stale_telemetry() noexcept;
+
+/// @brief Writes a telemetry page, and removes it when destroyed unless a
+/// FINISHED sample was published
+class Telemetry_publisher {
+ public:
+  /// @param[in] name       The page name, e.g. **default_telemetry_name()**
+  /// @param[in] seed       The run's random seed
+  /// @param[in] timeslices The number of timeslices
+  Telemetry_publisher(const std::string& name,
+                      const std::uint64_t seed,
+                      const std::uint64_t timeslices) noexcept
+      : name_(name), page_(nullptr), finished_(false) {
+    remove_stale_telemetry();
+    const auto fd = shm_open(telemetry_path(name_).c_str(),
+                             O_CREAT | O_RDWR | O_TRUNC, 0644);
+    if (fd < 0) return;
+    if (ftruncate(fd, sizeof(Telemetry_page)) == 0) {
+      auto* memory = mmap(nullptr, sizeof(Telemetry_page),
+                          PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (memory != MAP_FAILED) page_ = new (memory) Telemetry_page;
+    }
+    close(fd);
+    if (page_ == nullptr) {
+      shm_unlink(telemetry_path(name_).c_str());
+      return;
+    }
+    page_->pid = getpid();
+    page_->seed = seed;
+    page_->timeslices = timeslices;
+    page_->sequence.store(0, std::memory_order_relaxed);
+    std::memset(&page_->sample, 0, sizeof(page_->sample));
+    page_->sample.eta_seconds = -1.0;
+    page_->version = TELEMETRY_VERSION;
+    // Readers ignore the page until the magic number appears
+    std::atomic_thread_fence(std::memory_order_release);
+    page_->magic = TELEMETRY_MAGIC;
+  }
+
+  ~Telemetry_publisher() {
+    if (page_ == nullptr) return;
+    munmap(page_, sizeof(Telemetry_page));
+    // Readers remove finished pages once they have shown them
+    if (!finished_) shm_unlink(telemetry_path(name_).c_str());
+  }
+
+  Telemetry_publisher(const Telemetry_publisher&) = delete;
+  Telemetry_publisher& operator=(const Telemetry_publisher&) = delete;
+
+  /// @returns True if the page was created
+  bool available() const noexcept { return page_ != nullptr; }
+
+  const std::string& name() const noexcept { return name_; }
+
+  /// @brief Replaces the sample readers see
+  void publish(const Telemetry_sample& sample) noexcept {
+    if (page_ == nullptr) return;
+    const auto sequence = page_->sequence.load(std::memory_order_relaxed);
+    page_->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    page_->sample = sample;
+    page_->sequence.store(sequence + 2, std::memory_order_release);
+    finished_ = sample.phase == run_phase::FINISHED;
+  }
+
+ private:
+  std::string name_;
+  Telemetry_page* page_;
+  bool finished_;
+};
+
+/// @brief Reads a consistent copy of a telemetry page
+///
+/// @param[in]  name     The page name
+/// @param[out] snapshot The copy
+/// @returns True if the page exists and is a current telemetry page
+inline bool read_telemetry(const std::string& name,
+                           Telemetry_snapshot* const snapshot) noexcept {
+  const auto fd = shm_open(telemetry_path(name).c_str(), O_RDONLY, 0);
+  if (fd < 0) return false;
+  auto* memory = mmap(nullptr, sizeof(Telemetry_page), PROT_READ, MAP_SHARED,
+                      fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) return false;
+  const auto* page = static_cast<const Telemetry_page*>(memory);
+
+  auto valid = page->magic == TELEMETRY_MAGIC;
+  std::atomic_thread_fence(std::memory_order_acquire);
+  valid = valid && page->version == TELEMETRY_VERSION;
+  if (valid) {
+    snapshot->pid = page->pid;
+    snapshot->seed = page->seed;
+    snapshot->timeslices = page->timeslices;
+    // The writer only holds the page for a few stores, but may have died
+    // holding it, so give up eventually
+    valid = false;
+    for (auto attempt = 0; attempt < TELEMETRY_READ_ATTEMPTS && !valid;
+         ++attempt) {
+      const auto before = page->sequence.load(std::memory_order_acquire);
+      if (before % 2 != 0) continue;
+      std::memcpy(&snapshot->sample, &page->sample, sizeof(Telemetry_sample));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      valid = page->sequence.load(std::memory_order_relaxed) == before;
+    }
+  }
+  munmap(memory, sizeof(Telemetry_page));
+  return valid;
+}  // read_telemetry()
+
+/// @returns The names of the telemetry pages in /dev/shm, sorted
+inline std::vector<std::string> list_telemetry() noexcept {
+  std::vector<std::string> names;
+  auto* directory = opendir("/dev/shm");
+  if (directory == nullptr) return names;
+  const std::string prefix(TELEMETRY_PREFIX);
+  while (const auto* entry = readdir(directory)) {
+    const std::string name(entry->d_name);
+    if (name.compare(0, prefix.size(), prefix) == 0) names.push_back(name);
+  }
+  closedir(directory);
+  std::sort(names.begin(), names.end());
+  return names;
+}  // list_telemetry()
+
+/// @returns True if the process which published **snapshot** is running
+inline bool publisher_alive(const Telemetry_snapshot& snapshot) noexcept {
+  return snapshot.pid > 0 &&
+         (kill(static_cast<pid_t>(snapshot.pid), 0) == 0 || errno == EPERM);
+}  // publisher_alive()
+
+/// @brief Removes a telemetry page
+///
+/// @returns True if the page existed
+inline bool remove_telemetry(const std::string& name) noexcept {
+  return shm_unlink(telemetry_path(name).c_str()) == 0;
+}  // remove_telemetry()
+
+/// @brief Removes the pages of runs which are no longer running
+inline void remove_stale_telemetry() noexcept {
+  for (const auto& name : list_telemetry()) {
+    Telemetry_snapshot snapshot;
+    if (read_telemetry(name, &snapshot) && !publisher_alive(snapshot)) {
+      remove_telemetry(name);
+    }
+  }
+}  // remove_stale_telemetry()
+
+#endif  // SRC_TELEMETRY_H_
@@ -0,0 +1,245 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Fast thermalization by annealing the couplings
+///
+/// The seed universe from **make_S3_triangulation()** is far from the
+/// equilibrium of the production couplings. Rather than thermalizing with
+/// production settings from the start, K is ramped linearly from a weaker
+/// starting value up to its production value, which lets the geometry
+/// reorganize quickly while the move mix adapts toward the moves most
+/// often accepted. Once at production couplings, successive windows of
+/// sweeps are compared, and thermalization stops as soon as the mean
+/// \f$N_3\f$ and the mean spatial volume profile agree within a tolerance.
+/// The move mix is then frozen for measurement.
+///
+/// \done Linear ramp of K
+/// \done Convergence of N3 and the volume profile
+/// \todo Ramp Lambda to control the volume
+
+/// @file Thermalization.h
+/// @brief Annealed thermalization with convergence detection
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_THERMALIZATION_H_
+#define SRC_THERMALIZATION_H_
+
+// CDT headers
+#include "Metropolis.h"
+#include "TimesliceIndex.h"
+
+// C++ headers
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/// Starting K as a fraction of the production K
+static constexpr long double ANNEAL_K_FRACTION = 0.5;
+/// Relative change between windows below which thermalization has converged
+static constexpr double CONVERGENCE_TOLERANCE = 0.01;
+
+/// @brief How to anneal the couplings and detect convergence
+struct Anneal_schedule {
+  /// Production couplings
+  long double Alpha;
+  long double K;
+  long double Lambda;
+  /// K at the first pass
+  long double K_start;
+  /// Passes spent ramping K from **K_start** to **K**
+  std::uint64_t anneal_passes;
+  /// Passes averaged in each convergence window
+  std::uint64_t window;
+  /// Largest relative change between windows counted as converged
+  double tolerance;
+  /// Thermalization stops after this many passes even if not converged
+  std::uint64_t max_passes;
+};
+
+/// @brief Makes the default Anneal_schedule for at most **max_passes**
+///
+/// A quarter of the passes ramp K, and convergence windows are a twentieth
+/// of the passes, but at least two.
+///
+/// @param[in] Alpha      \f$\alpha\f$ is the timelike edge length
+/// @param[in] K          \f$k=\frac{1}{8\pi G_{Newton}}\f$
+/// @param[in] Lambda     \f$\lambda=k*\Lambda\f$
+/// @param[in] max_passes The most thermalization passes allowed
+/// @returns The Anneal_schedule
+inline Anneal_schedule make_anneal_schedule(const long double Alpha,
+                                            const long double K,
+                                            const long double Lambda,
+                                            const std::uint64_t max_passes)
+                                            noexcept {
+  Anneal_schedule schedule;
+  schedule.Alpha = Alpha;
+  schedule.K = K;
+  schedule.Lambda = Lambda;
+  schedule.K_start = ANNEAL_K_FRACTION * K;
+  schedule.anneal_passes = max_passes / 4;
+  schedule.window = std::max(static_cast<std::uint64_t>(2), max_passes / 20);
+  schedule.tolerance = CONVERGENCE_TOLERANCE;
+  schedule.max_passes = max_passes;
+  return schedule;
+}  // make_anneal_schedule()
+
+/// @returns K for **pass** of the annealing ramp
+inline long double annealed_K(const Anneal_schedule& schedule,
+                              const std::uint64_t pass) noexcept {
+  if (pass >= schedule.anneal_passes) return schedule.K;
+  const auto fraction = static_cast<long double>(pass) /
+                        schedule.anneal_passes;
+  return schedule.K_start + fraction * (schedule.K - schedule.K_start);
+}  // annealed_K()
+
+/// @brief Detects when N3 and the volume profile stop drifting
+///
+/// Observations are averaged over windows of a fixed number of passes. Each
+/// completed window is compared with the one before it.
+class Convergence_monitor {
+ public:
+  /// @param[in] window    Passes per window
+  /// @param[in] tolerance Largest relative change counted as converged
+  Convergence_monitor(const std::uint64_t window,
+                      const double tolerance) noexcept
+      : window_(std::max(static_cast<std::uint64_t>(1), window)),
+        tolerance_(tolerance),
+        count_(0),
+        N3_sum_(0.0),
+        previous_N3_(-1.0),
+        N3_change_(-1.0),
+        profile_change_(-1.0),
+        converged_(false) {}
+
+  /// @brief Records one pass
+  ///
+  /// @param[in] N3      The number of simplices
+  /// @param[in] profile The spatial volume of each timeslice
+  /// @returns True if this pass completed a window which converged
+  bool observe(const double N3, const std::vector<double>& profile) noexcept {
+    if (profile_sum_.size() < profile.size()) {
+      profile_sum_.resize(profile.size(), 0.0);
+    }
+    N3_sum_ += N3;
+    for (auto t = 0u; t < profile.size(); ++t) profile_sum_[t] += profile[t];
+    if (++count_ < window_) return false;
+
+    const auto N3_mean = N3_sum_ / count_;
+    for (auto& v : profile_sum_) v /= count_;
+
+    if (previous_N3_ > 0.0) {
+      N3_change_ = std::abs(N3_mean - previous_N3_) / previous_N3_;
+      auto difference = 0.0;
+      auto total = 0.0;
+      for (auto t = 0u; t < profile_sum_.size(); ++t) {
+        const auto before = (t < previous_profile_.size()) ?
+                            previous_profile_[t] : 0.0;
+        difference += std::abs(profile_sum_[t] - before);
+        total += before;
+      }
+      profile_change_ = (total > 0.0) ? difference / total : 1.0;
+      converged_ = N3_change_ < tolerance_ && profile_change_ < tolerance_;
+    }
+
+    previous_N3_ = N3_mean;
+    previous_profile_.swap(profile_sum_);
+    profile_sum_.assign(previous_profile_.size(), 0.0);
+    N3_sum_ = 0.0;
+    count_ = 0;
+    return converged_;
+  }
+
+  /// @brief Forgets all windows, e.g. after the couplings change
+  void reset() noexcept {
+    count_ = 0;
+    N3_sum_ = 0.0;
+    profile_sum_.clear();
+    previous_N3_ = -1.0;
+    previous_profile_.clear();
+    N3_change_ = -1.0;
+    profile_change_ = -1.0;
+    converged_ = false;
+  }
+
+  bool converged() const noexcept { return converged_; }
+  /// Relative change in mean N3 between the last two windows, or -1
+  double N3_change() const noexcept { return N3_change_; }
+  /// Relative L1 change in the mean volume profile, or -1
+  double profile_change() const noexcept { return profile_change_; }
+
+ private:
+  std::uint64_t window_;
+  double tolerance_;
+  std::uint64_t count_;
+  double N3_sum_;
+  std::vector<double> profile_sum_;
+  double previous_N3_;
+  std::vector<double> previous_profile_;
+  double N3_change_;
+  double profile_change_;
+  bool converged_;
+};
+
+/// @brief The spatial volume of every timeslice
+///
+/// @param[in]  index   The Timeslice_index
+/// @param[out] profile \f$N_2(t)\f$ for each timeslice t
+inline void volume_profile(const Timeslice_index& index,
+                           std::vector<double>* const profile) noexcept {
+  profile->resize(index.vertices.size());
+  for (auto t = 0u; t < index.vertices.size(); ++t) {
+    (*profile)[t] = static_cast<double>(spatial_volume(index, t));
+  }
+}  // volume_profile()
+
+/// @brief Thermalizes with annealed couplings until converged
+///
+/// Ramps K over **schedule.anneal_passes** while the move mix adapts, then
+/// sweeps at production couplings until the Convergence_monitor reports
+/// convergence or **schedule.max_passes** is reached. The production
+/// couplings are always in place, and the move mix frozen, on return.
+///
+/// @param[in,out] metropolis The Metropolis-Hastings driver
+/// @param[in]     schedule   The Anneal_schedule
+/// @param[out]    passes     The number of passes made
+/// @param[in]     after_pass Called with the passes completed after each
+///                           sweep, or empty
+/// @returns True if N3 and the volume profile converged
+inline bool thermalize_annealed(
+    Metropolis* const metropolis,
+    const Anneal_schedule& schedule,
+    std::uint64_t* const passes,
+    const std::function<void(std::uint64_t)>& after_pass = nullptr)
+    noexcept {
+  Convergence_monitor monitor(schedule.window, schedule.tolerance);
+  std::vector<double> profile;
+  auto converged = false;
+  auto pass = static_cast<std::uint64_t>(0);
+
+  for (; pass < schedule.max_passes && !converged; ++pass) {
+    if (pass <= schedule.anneal_passes) {
+      metropolis->set_coefficients(make_action_coefficients(
+          schedule.Alpha, annealed_K(schedule, pass), schedule.Lambda));
+    }
+    metropolis->sweep();
+    if (after_pass) after_pass(pass + 1);
+    // Only windows at production couplings count toward convergence
+    if (pass < schedule.anneal_passes) continue;
+    volume_profile(metropolis->index(), &profile);
+    converged = monitor.observe(
+        static_cast<double>(metropolis->number_of_simplices()), profile);
+  }
+
+  metropolis->set_coefficients(make_action_coefficients(
+      schedule.Alpha, schedule.K, schedule.Lambda));
+  metropolis->scheduler().freeze();
+  *passes = pass;
+  return converged;
+}  // thermalize_annealed()
+
+#endif  // SRC_THERMALIZATION_H_
@@ -0,0 +1,320 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Per-timeslice indices of vertices and cells
+///
+/// Every vertex is filed under its timeslice, and every correctly foliated
+/// cell is filed under the slab it spans, i.e. the slab between timeslices
+/// t and t+1 is stored at index t, and split into (3,1), (2,2), and (1,3)
+/// simplices. Insertion and removal are O(1), so ergodic moves keep the
+/// index current as they go, and slice-local proposals and per-slice
+/// observables never have to scan the whole triangulation.
+///
+/// \done Per-timeslice vertex sets
+/// \done Per-slab (3,1), (2,2), and (1,3) cell sets
+/// \done Spatial volume of a timeslice
+/// \todo Per-timeslice spacelike edges
+
+/// @file TimesliceIndex.h
+/// @brief Per-timeslice indices of vertices and cells
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_TIMESLICEINDEX_H_
+#define SRC_TIMESLICEINDEX_H_
+
+// CDT headers
+#include "S3Triangulation.h"
+
+// C++ headers
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Hashes CGAL handles by the address they refer to
+///
+/// CGAL handles are iterators into the triangulation's containers, so two
+/// handles are equal exactly when they point to the same object.
+template <typename Handle>
+struct Handle_hash {
+  std::size_t operator()(const Handle& handle) const noexcept {
+    return std::hash<const void*>()(static_cast<const void*>(&*handle));
+  }
+};
+
+/// @brief A set with O(1) insertion, removal, and random access
+///
+/// Items are kept contiguously in a vector so that a uniformly random member
+/// can be drawn by position. A hash map remembers each item's position, so
+/// removal swaps the item with the last one and pops it.
+template <typename T, typename Hash = std::hash<T>>
+class Indexed_set {
+ public:
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  /// @returns True if the item was not already present
+  bool insert(const T& item) noexcept {
+    if (position_.find(item) != position_.end()) return false;
+    position_.emplace(item, items_.size());
+    items_.push_back(item);
+    return true;
+  }
+
+  /// @returns True if the item was present
+  bool erase(const T& item) noexcept {
+    auto found = position_.find(item);
+    if (found == position_.end()) return false;
+    const auto hole = found->second;
+    position_.erase(found);
+    if (hole != items_.size() - 1) {
+      items_[hole] = items_.back();
+      position_[items_[hole]] = hole;
+    }
+    items_.pop_back();
+    return true;
+  }
+
+  bool contains(const T& item) const noexcept {
+    return position_.find(item) != position_.end();
+  }
+
+  const T& operator[](const std::size_t i) const noexcept {
+    return items_[i];
+  }
+
+  std::size_t size() const noexcept { return items_.size(); }
+  bool empty() const noexcept { return items_.empty(); }
+  const_iterator begin() const noexcept { return items_.begin(); }
+  const_iterator end() const noexcept { return items_.end(); }
+
+  void clear() noexcept {
+    items_.clear();
+    position_.clear();
+  }
+
+  void reserve(const std::size_t n) noexcept {
+    items_.reserve(n);
+    position_.reserve(n);
+  }
+
+  /// @brief Approximate heap memory used
+  ///
+  /// Counts the vector's capacity, the hash map's buckets, and one node per
+  /// item holding the key, position, next pointer, and cached hash.
+  std::size_t memory_bytes() const noexcept {
+    return items_.capacity() * sizeof(T) +
+           position_.bucket_count() * sizeof(void*) +
+           position_.size() * (sizeof(T) + 2 * sizeof(std::size_t) +
+                               sizeof(void*));
+  }
+
+ private:
+  std::vector<T> items_;
+  std::unordered_map<T, std::size_t, Hash> position_;
+};
+
+using Vertex_set = Indexed_set<Vertex_handle, Handle_hash<Vertex_handle>>;
+using Cell_set = Indexed_set<Cell_handle, Handle_hash<Cell_handle>>;
+
+/// @brief Vertices by timeslice and cells by slab and simplex type
+///
+/// **vertices[t]** holds the vertices on timeslice t. **three_one[t]**,
+/// **two_two[t]**, and **one_three[t]** hold the simplices of that type
+/// which span timeslices t and t+1.
+struct Timeslice_index {
+  std::vector<Vertex_set> vertices;
+  std::vector<Cell_set> three_one;
+  std::vector<Cell_set> two_two;
+  std::vector<Cell_set> one_three;
+};
+
+/// @brief Finds the slab spanned by a cell
+///
+/// @param[in]  cell The cell
+/// @param[out] slab The lower timeslice of the cell
+/// @returns True if the cell spans exactly one slab
+inline bool get_slab(const Cell_handle& cell, unsigned* const slab) noexcept {
+  auto min_time = cell->vertex(0)->info();
+  auto max_time = min_time;
+  for (auto i = 1; i < 4; ++i) {
+    min_time = std::min(min_time, cell->vertex(i)->info());
+    max_time = std::max(max_time, cell->vertex(i)->info());
+  }
+  *slab = min_time;
+  return max_time - min_time == 1;
+}  // get_slab()
+
+/// @brief Grows the index so that timeslice **timeslice** fits
+///
+/// @param[in]  timeslice The largest timeslice to be stored
+/// @param[out] index     The Timeslice_index
+inline void reserve_timeslices(const unsigned timeslice,
+                               Timeslice_index* const index) noexcept {
+  if (index->vertices.size() > timeslice) return;
+  index->vertices.resize(timeslice + 1);
+  index->three_one.resize(timeslice + 1);
+  index->two_two.resize(timeslice + 1);
+  index->one_three.resize(timeslice + 1);
+}  // reserve_timeslices()
+
+/// @brief Adds a vertex to its timeslice
+///
+/// @param[in]  D3     The Delaunay triangulation
+/// @param[in]  vertex The vertex to add
+/// @param[out] index  The Timeslice_index
+inline void add_vertex_to_index(const Delaunay& D3,
+                                const Vertex_handle& vertex,
+                                Timeslice_index* const index) noexcept {
+  if (D3.is_infinite(vertex)) return;
+  reserve_timeslices(vertex->info(), index);
+  index->vertices[vertex->info()].insert(vertex);
+}  // add_vertex_to_index()
+
+/// @brief Removes a vertex from its timeslice
+///
+/// @param[in]  D3     The Delaunay triangulation
+/// @param[in]  vertex The vertex to remove
+/// @param[out] index  The Timeslice_index
+inline void remove_vertex_from_index(const Delaunay& D3,
+                                     const Vertex_handle& vertex,
+                                     Timeslice_index* const index) noexcept {
+  if (D3.is_infinite(vertex)) return;
+  if (vertex->info() >= index->vertices.size()) return;
+  index->vertices[vertex->info()].erase(vertex);
+}  // remove_vertex_from_index()
+
+/// @brief Classifies a cell and adds it to its slab
+///
+/// Infinite cells and cells which do not span exactly one slab are not
+/// indexed.
+///
+/// @param[in]     D3    The Delaunay triangulation
+/// @param[in,out] cell  The cell to add; **cell->info()** is set by
+///                      **classify_3_simplex()**
+/// @param[out]    index The Timeslice_index
+inline void add_cell_to_index(const Delaunay& D3,
+                              const Cell_handle& cell,
+                              Timeslice_index* const index) noexcept {
+  if (D3.is_infinite(cell)) return;
+  auto slab = static_cast<unsigned>(0);
+  if (!get_slab(cell, &slab)) return;
+  reserve_timeslices(slab + 1, index);
+
+  switch (classify_3_simplex(cell)) {
+    case 13:
+      index->one_three[slab].insert(cell);
+      break;
+    case 22:
+      index->two_two[slab].insert(cell);
+      break;
+    default:
+      index->three_one[slab].insert(cell);
+  }
+}  // add_cell_to_index()
+
+/// @brief Removes a cell from its slab
+///
+/// This must be called while the cell still exists, i.e. before the move
+/// which destroys it.
+///
+/// @param[in]  D3    The Delaunay triangulation
+/// @param[in]  cell  The cell to remove
+/// @param[out] index The Timeslice_index
+inline void remove_cell_from_index(const Delaunay& D3,
+                                   const Cell_handle& cell,
+                                   Timeslice_index* const index) noexcept {
+  if (D3.is_infinite(cell)) return;
+  auto slab = static_cast<unsigned>(0);
+  if (!get_slab(cell, &slab)) return;
+  if (slab >= index->two_two.size()) return;
+
+  switch (cell->info()) {
+    case 13:
+      index->one_three[slab].erase(cell);
+      break;
+    case 22:
+      index->two_two[slab].erase(cell);
+      break;
+    default:
+      index->three_one[slab].erase(cell);
+  }
+}  // remove_cell_from_index()
+
+/// @brief Builds a Timeslice_index from scratch
+///
+/// @param[in]  D3                   The Delaunay triangulation
+/// @param[in]  number_of_timeslices The number of foliated timeslices
+/// @param[out] index                The Timeslice_index
+inline void make_timeslice_index(const Delaunay& D3,
+                                 const unsigned number_of_timeslices,
+                                 Timeslice_index* const index) noexcept {
+  index->vertices.clear();
+  index->three_one.clear();
+  index->two_two.clear();
+  index->one_three.clear();
+  reserve_timeslices(number_of_timeslices, index);
+
+  Delaunay::Finite_vertices_iterator vit;
+  for (vit = D3.finite_vertices_begin(); vit != D3.finite_vertices_end();
+       ++vit) {
+    add_vertex_to_index(D3, vit, index);
+  }
+
+  Delaunay::Finite_cells_iterator cit;
+  for (cit = D3.finite_cells_begin(); cit != D3.finite_cells_end(); ++cit) {
+    add_cell_to_index(D3, cit, index);
+  }
+}  // make_timeslice_index()
+
+/// @brief Counts the cells in the slab between timeslices t and t+1
+///
+/// @param[in] index The Timeslice_index
+/// @param[in] slab  The lower timeslice of the slab
+/// @returns The number of (3,1), (2,2), and (1,3) simplices in the slab
+inline std::size_t number_of_cells_in_slab(const Timeslice_index& index,
+                                           const unsigned slab) noexcept {
+  if (slab >= index.two_two.size()) return 0;
+  return index.three_one[slab].size() + index.two_two[slab].size() +
+         index.one_three[slab].size();
+}  // number_of_cells_in_slab()
+
+/// @brief Spatial volume of a timeslice
+///
+/// Every spacelike triangle on timeslice t is the base of a (3,1) simplex
+/// in the slab above it and of a (1,3) simplex in the slab below it. The
+/// outermost and innermost timeslices only have one of these.
+///
+/// @param[in] index     The Timeslice_index
+/// @param[in] timeslice The timeslice
+/// @returns \f$N_2(t)\f$, the number of spacelike triangles on timeslice t
+inline std::size_t spatial_volume(const Timeslice_index& index,
+                                  const unsigned timeslice) noexcept {
+  auto above = static_cast<std::size_t>(0);
+  auto below = static_cast<std::size_t>(0);
+  if (timeslice < index.three_one.size()) {
+    above = index.three_one[timeslice].size();
+  }
+  if (timeslice > 0 && timeslice - 1 < index.one_three.size()) {
+    below = index.one_three[timeslice - 1].size();
+  }
+  return std::max(above, below);
+}  // spatial_volume()
+
+/// @brief Approximate heap memory used by a Timeslice_index
+///
+/// @param[in] index The Timeslice_index
+/// @returns Bytes used by all of its sets
+inline std::size_t timeslice_index_bytes(
+    const Timeslice_index& index) noexcept {
+  auto bytes = static_cast<std::size_t>(0);
+  for (const auto& set : index.vertices) bytes += set.memory_bytes();
+  for (const auto& set : index.three_one) bytes += set.memory_bytes();
+  for (const auto& set : index.two_two) bytes += set.memory_bytes();
+  for (const auto& set : index.one_three) bytes += set.memory_bytes();
+  return bytes;
+}  // timeslice_index_bytes()
+
+#endif  // SRC_TIMESLICEINDEX_H_
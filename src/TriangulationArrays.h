@@ -0,0 +1,177 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Flat arrays of a triangulation for analysis outside CGAL
+///
+/// CGAL keeps vertices and cells as linked objects, which other languages
+/// cannot read. **make_triangulation_arrays()** numbers the finite vertices
+/// and cells in iteration order and writes them out as structure-of-arrays:
+/// coordinates and timeslices per vertex, and for each cell its type and,
+/// corner by corner, its vertices and the neighbors opposite them. The
+/// arrays can be handed to NumPy without copying.
+///
+/// The work is split in two, so that a thread which must not hold up the
+/// triangulation only copies from it: **capture_triangulation_arrays()**
+/// copies the per-vertex and per-cell values in one pass, and records
+/// handles as opaque keys in Triangulation_keys. Another thread can then
+/// number them with **number_triangulation_arrays()**, which is where the
+/// hashing is, while the triangulation changes.
+///
+/// \done Vertex coordinates and timeslices
+/// \done Cell vertices, neighbors, and types
+/// \done Capture and numbering on separate threads
+
+/// @file TriangulationArrays.h
+/// @brief Structure-of-arrays export of a triangulation
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_TRIANGULATIONARRAYS_H_
+#define SRC_TRIANGULATIONARRAYS_H_
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "TimesliceIndex.h"
+
+// C++ headers
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/// Neighbor index of an infinite cell
+static constexpr std::int32_t NO_NEIGHBOR = -1;
+
+/// @brief A triangulation as flat arrays
+///
+/// Vertices and cells are numbered from 0 in iteration order. The cell
+/// arrays hold all cells' first corners, then all their second corners, and
+/// so on, so corner k of cell c is **cell_vertices[k * cells + c]**, and the
+/// cell sharing the facet opposite it is **cell_neighbors[k * cells + c]**,
+/// or NO_NEIGHBOR.
+struct Triangulation_arrays {
+  std::vector<double> x;
+  std::vector<double> y;
+  std::vector<double> z;
+  std::vector<std::uint32_t> timeslice;
+  std::vector<std::uint32_t> cell_vertices;
+  std::vector<std::int32_t> cell_neighbors;
+  /// 31, 22, 13, or 0 for cells which are not properly foliated
+  std::vector<std::uint32_t> cell_type;
+};
+
+/// @brief The handles of a captured triangulation, as keys which are only
+/// compared, never followed
+///
+/// The per-cell keys are laid out corner by corner as in
+/// Triangulation_arrays.
+struct Triangulation_keys {
+  std::vector<const void*> vertices;
+  std::vector<const void*> cells;
+  std::vector<const void*> cell_vertices;
+  std::vector<const void*> cell_neighbors;
+};
+
+/// @returns The key of a CGAL handle
+template <typename Handle>
+inline const void* handle_key(const Handle& handle) noexcept {
+  return static_cast<const void*>(&*handle);
+}  // handle_key()
+
+/// @brief Copies a triangulation's coordinates, timeslices, and cell types
+/// into flat arrays, and its handles into keys
+///
+/// Nothing is looked up, so the copy is one pass over the vertices and one
+/// over the cells. The cell vertices and neighbors are filled in from the
+/// keys by **number_triangulation_arrays()**.
+///
+/// @param[in]  D3     The Delaunay triangulation
+/// @param[out] arrays The arrays, resized to fit
+/// @param[out] keys   The handles of the vertices and cells
+inline void capture_triangulation_arrays(
+    const Delaunay& D3,
+    Triangulation_arrays* const arrays,
+    Triangulation_keys* const keys) noexcept {
+  const auto vertices = D3.number_of_vertices();
+  const auto cells = D3.number_of_finite_cells();
+  arrays->x.resize(vertices);
+  arrays->y.resize(vertices);
+  arrays->z.resize(vertices);
+  arrays->timeslice.resize(vertices);
+  arrays->cell_type.resize(cells);
+  keys->vertices.resize(vertices);
+  keys->cells.resize(cells);
+  keys->cell_vertices.resize(4 * cells);
+  keys->cell_neighbors.resize(4 * cells);
+
+  auto v = static_cast<std::size_t>(0);
+  Delaunay::Finite_vertices_iterator vit;
+  for (vit = D3.finite_vertices_begin(); vit != D3.finite_vertices_end();
+       ++vit, ++v) {
+    keys->vertices[v] = handle_key(vit);
+    arrays->x[v] = vit->point().x();
+    arrays->y[v] = vit->point().y();
+    arrays->z[v] = vit->point().z();
+    arrays->timeslice[v] = vit->info();
+  }
+
+  auto c = static_cast<std::size_t>(0);
+  Delaunay::Finite_cells_iterator cit;
+  for (cit = D3.finite_cells_begin(); cit != D3.finite_cells_end();
+       ++cit, ++c) {
+    keys->cells[c] = handle_key(cit);
+    for (auto k = 0u; k < 4; ++k) {
+      keys->cell_vertices[k * cells + c] = handle_key(cit->vertex(k));
+      keys->cell_neighbors[k * cells + c] = handle_key(cit->neighbor(k));
+    }
+    arrays->cell_type[c] = cit->info();
+  }
+}  // capture_triangulation_arrays()
+
+/// @brief Fills in the cell vertices and neighbors of captured arrays by
+/// numbering their keys
+///
+/// Only reads **keys**, so it may run while the triangulation they were
+/// captured from changes.
+///
+/// @param[in]     keys   The keys from **capture_triangulation_arrays()**
+/// @param[in,out] arrays The arrays captured with them
+inline void number_triangulation_arrays(
+    const Triangulation_keys& keys,
+    Triangulation_arrays* const arrays) noexcept {
+  const auto vertices = keys.vertices.size();
+  const auto cells = keys.cells.size();
+  arrays->cell_vertices.resize(4 * cells);
+  arrays->cell_neighbors.resize(4 * cells);
+
+  std::unordered_map<const void*, std::uint32_t> vertex_numbers(vertices);
+  for (auto v = static_cast<std::size_t>(0); v < vertices; ++v) {
+    vertex_numbers.emplace(keys.vertices[v], static_cast<std::uint32_t>(v));
+  }
+  std::unordered_map<const void*, std::int32_t> cell_numbers(cells);
+  for (auto c = static_cast<std::size_t>(0); c < cells; ++c) {
+    cell_numbers.emplace(keys.cells[c], static_cast<std::int32_t>(c));
+  }
+
+  for (auto i = static_cast<std::size_t>(0); i < 4 * cells; ++i) {
+    arrays->cell_vertices[i] = vertex_numbers[keys.cell_vertices[i]];
+    const auto neighbor = cell_numbers.find(keys.cell_neighbors[i]);
+    arrays->cell_neighbors[i] =
+        (neighbor == cell_numbers.end()) ? NO_NEIGHBOR : neighbor->second;
+  }
+}  // number_triangulation_arrays()
+
+/// @brief Writes out a triangulation as flat arrays
+///
+/// @param[in]  D3     The Delaunay triangulation
+/// @param[out] arrays The arrays, resized to fit
+inline void make_triangulation_arrays(
+    const Delaunay& D3,
+    Triangulation_arrays* const arrays) noexcept {
+  Triangulation_keys keys;
+  capture_triangulation_arrays(D3, arrays, &keys);
+  number_triangulation_arrays(keys, arrays);
+}  // make_triangulation_arrays()
+
+#endif  // SRC_TRIANGULATIONARRAYS_H_
@@ -0,0 +1,256 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Volume-volume correlations of the spatial volume profile
+///
+/// The volume profile \f$n(t) = N_2(t)\f$ of each measurement is first
+/// centered, i.e. rotated so that its center of volume, taken from the phase
+/// of its lowest Fourier mode, falls on timeslice T/2. Otherwise the blob
+/// wanders in time between measurements and averages out. The accumulator
+/// then updates, with Welford's streaming updates, so no profiles are
+/// stored:
+///
+/// - the mean and variance of n(t), in O(T)
+/// - the translation-averaged correlator
+///   \f$G(\Delta) = \frac{1}{T}\sum_t n(t)\,n(t+\Delta)\f$, from
+///   \f$|\tilde{n}(k)|^2\f$ in O(T log T)
+/// - optionally, the full covariance matrix
+///   \f$\langle n(t)n(t')\rangle - \langle n(t)\rangle\langle n(t')\rangle\f$,
+///   which is O(T^2) by nature
+///
+/// Time is taken to be periodic with period T. The FFTs are radix-2 on
+/// a profile zero-padded to at least 2T, so any T works.
+///
+/// \done Centering on the center of volume
+/// \done Streaming mean, variance, and covariance matrix
+/// \done FFT-based connected time correlator
+
+/// @file VolumeCorrelator.h
+/// @brief Online volume-volume correlator
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef SRC_VOLUMECORRELATOR_H_
+#define SRC_VOLUMECORRELATOR_H_
+
+// C++ headers
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+/// @brief In-place radix-2 FFT
+///
+/// @param[in,out] data    The sequence, whose length is a power of 2
+/// @param[in]     inverse Computes the unnormalized inverse transform
+inline void fft(std::vector<std::complex<double>>* const data,
+                const bool inverse) noexcept {
+  auto& a = *data;
+  const auto n = a.size();
+  for (auto i = static_cast<std::size_t>(1), j = static_cast<std::size_t>(0);
+       i < n; ++i) {
+    auto bit = n >> 1;
+    for (; j & bit; bit >>= 1) j ^= bit;
+    j ^= bit;
+    if (i < j) std::swap(a[i], a[j]);
+  }
+  for (auto length = static_cast<std::size_t>(2); length <= n; length <<= 1) {
+    const auto angle = (inverse ? 2.0 : -2.0) * M_PI / length;
+    const std::complex<double> step(std::cos(angle), std::sin(angle));
+    for (auto start = static_cast<std::size_t>(0); start < n;
+         start += length) {
+      std::complex<double> w(1.0, 0.0);
+      for (auto k = static_cast<std::size_t>(0); k < length / 2; ++k) {
+        const auto u = a[start + k];
+        const auto v = a[start + k + length / 2] * w;
+        a[start + k] = u + v;
+        a[start + k + length / 2] = u - v;
+        w *= step;
+      }
+    }
+  }
+}  // fft()
+
+/// @brief The timeslice of a profile's center of volume
+///
+/// @param[in] profile \f$n(t)\f$, taken to be periodic
+/// @returns The center, in [0, T), or 0 for an empty profile
+inline double center_of_volume(const std::vector<double>& profile) noexcept {
+  const auto T = profile.size();
+  std::complex<double> mode(0.0, 0.0);
+  for (auto t = static_cast<std::size_t>(0); t < T; ++t) {
+    mode += profile[t] * std::polar(1.0, 2.0 * M_PI * t / T);
+  }
+  if (std::abs(mode) == 0.0) return 0.0;
+  auto center = std::arg(mode) * T / (2.0 * M_PI);
+  if (center < 0.0) center += T;
+  return center;
+}  // center_of_volume()
+
+/// @brief Rotates a profile so its center of volume is on timeslice T/2
+///
+/// @param[in]  profile  \f$n(t)\f$
+/// @param[out] centered The rotated profile
+inline void center_profile(const std::vector<double>& profile,
+                           std::vector<double>* const centered) noexcept {
+  const auto T = profile.size();
+  centered->resize(T);
+  if (T == 0) return;
+  const auto center =
+      static_cast<std::size_t>(std::lround(center_of_volume(profile))) % T;
+  const auto shift = (T / 2 + T - center) % T;
+  for (auto t = static_cast<std::size_t>(0); t < T; ++t) {
+    (*centered)[(t + shift) % T] = profile[t];
+  }
+}  // center_profile()
+
+/// @brief Accumulates volume-volume correlations measurement by measurement
+class Volume_correlator {
+ public:
+  /// @param[in] timeslices The length of every profile
+  /// @param[in] matrix     Also accumulate the full covariance matrix
+  Volume_correlator(const std::size_t timeslices, const bool matrix) noexcept
+      : T_(timeslices),
+        matrix_(matrix),
+        measurements_(0),
+        mean_(timeslices, 0.0),
+        M2_(matrix ? timeslices * timeslices : timeslices, 0.0),
+        G_(timeslices, 0.0) {
+    padded_ = 1;
+    while (padded_ < 2 * T_) padded_ <<= 1;
+    buffer_.resize(padded_);
+  }
+
+  /// @brief Adds one measurement
+  ///
+  /// @param[in] profile \f$n(t)\f$, of length **timeslices()**
+  void add(const std::vector<double>& profile) noexcept {
+    center_profile(profile, &centered_);
+    measurements_++;
+    const auto n = static_cast<double>(measurements_);
+
+    // Welford: delta before and after the mean moves
+    delta_.resize(T_);
+    for (auto t = static_cast<std::size_t>(0); t < T_; ++t) {
+      delta_[t] = centered_[t] - mean_[t];
+      mean_[t] += delta_[t] / n;
+    }
+    if (matrix_) {
+      for (auto t = static_cast<std::size_t>(0); t < T_; ++t) {
+        const auto after = centered_[t] - mean_[t];
+        for (auto u = static_cast<std::size_t>(0); u < T_; ++u) {
+          M2_[t * T_ + u] += delta_[u] * after;
+        }
+      }
+    } else {
+      for (auto t = static_cast<std::size_t>(0); t < T_; ++t) {
+        M2_[t] += delta_[t] * (centered_[t] - mean_[t]);
+      }
+    }
+
+    const auto correlation = periodic_correlation(centered_);
+    for (auto d = static_cast<std::size_t>(0); d < T_; ++d) {
+      G_[d] += (correlation[d] - G_[d]) / n;
+    }
+  }
+
+  std::size_t timeslices() const noexcept { return T_; }
+  std::uint64_t measurements() const noexcept { return measurements_; }
+
+  /// @returns \f$\langle n(t)\rangle\f$ of the centered profiles
+  const std::vector<double>& mean_profile() const noexcept { return mean_; }
+
+  /// @returns The variance of n(t) of the centered profiles
+  std::vector<double> variance_profile() const noexcept {
+    std::vector<double> variance(T_, 0.0);
+    if (measurements_ < 2) return variance;
+    for (auto t = static_cast<std::size_t>(0); t < T_; ++t) {
+      variance[t] = M2_[matrix_ ? t * T_ + t : t] / (measurements_ - 1);
+    }
+    return variance;
+  }
+
+  /// @returns The covariance matrix, row-major, or an empty vector if it
+  /// is not accumulated
+  std::vector<double> covariance() const noexcept {
+    std::vector<double> covariance;
+    if (!matrix_) return covariance;
+    covariance.resize(T_ * T_, 0.0);
+    if (measurements_ < 2) return covariance;
+    for (auto i = static_cast<std::size_t>(0); i < T_ * T_; ++i) {
+      covariance[i] = M2_[i] / (measurements_ - 1);
+    }
+    return covariance;
+  }
+
+  /// @returns The connected correlator
+  /// \f$\frac{1}{T}\sum_t \langle n(t)n(t+\Delta)\rangle -
+  /// \langle n(t)\rangle\langle n(t+\Delta)\rangle\f$ for
+  /// \f$\Delta = 0 .. T-1\f$
+  std::vector<double> correlator() noexcept {
+    std::vector<double> connected(T_, 0.0);
+    if (measurements_ == 0) return connected;
+    const auto disconnected = periodic_correlation(mean_);
+    for (auto d = static_cast<std::size_t>(0); d < T_; ++d) {
+      connected[d] = G_[d] - disconnected[d];
+    }
+    return connected;
+  }
+
+ private:
+  /// @returns \f$\frac{1}{T}\sum_t n(t)\,n((t+\Delta) \bmod T)\f$
+  std::vector<double> periodic_correlation(const std::vector<double>& n)
+      noexcept {
+    for (auto i = static_cast<std::size_t>(0); i < padded_; ++i) {
+      buffer_[i] = (i < T_) ? n[i] : 0.0;
+    }
+    fft(&buffer_, false);
+    for (auto& x : buffer_) x = std::norm(x);
+    fft(&buffer_, true);
+    // The zero padding gives the linear correlation L(k) at k and at
+    // padded_ - k for negative k; the periodic one is L(d) + L(d - T)
+    std::vector<double> correlation(T_, 0.0);
+    for (auto d = static_cast<std::size_t>(0); d < T_; ++d) {
+      auto sum = buffer_[d].real();
+      if (d > 0) sum += buffer_[padded_ - (T_ - d)].real();
+      correlation[d] = sum / padded_ / T_;
+    }
+    return correlation;
+  }
+
+  std::size_t T_;
+  bool matrix_;
+  std::uint64_t measurements_;
+  std::vector<double> mean_;
+  /// Sums of products of deviations: the matrix, or just its diagonal
+  std::vector<double> M2_;
+  std::vector<double> G_;
+  std::size_t padded_;
+  std::vector<std::complex<double>> buffer_;
+  std::vector<double> centered_;
+  std::vector<double> delta_;
+};
+
+/// @brief Writes the mean, variance, and connected correlator, one line per
+/// timeslice or lag
+inline void write_volume_correlator(Volume_correlator* const correlator,
+                                    std::ostream& os) noexcept {
+  const auto& mean = correlator->mean_profile();
+  const auto variance = correlator->variance_profile();
+  const auto connected = correlator->correlator();
+  for (auto t = static_cast<std::size_t>(0); t < mean.size(); ++t) {
+    os << "volume_mean " << t << " " << mean[t] << " " << variance[t]
+       << "\n";
+  }
+  for (auto d = static_cast<std::size_t>(0); d < connected.size(); ++d) {
+    os << "volume_correlator " << d << " " << connected[d] << "\n";
+  }
+  os << std::flush;
+}  // write_volume_correlator()
+
+#endif  // SRC_VOLUMECORRELATOR_H_
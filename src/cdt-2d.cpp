@@ -0,0 +1,172 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// A program that evolves 1+1 dimensional spacetimes
+///
+/// Runs the flat-array Metropolis_2d engine on a torus, and measures it with
+/// the same observables as cdt. The cosmological constant is critical at
+/// ln 2: above it the universe shrinks to the minimum size, below it it
+/// grows without bound.
+///
+/// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
+/// for a beautiful command line interface.
+
+/// @file cdt-2d.cpp
+/// @brief 1+1 dimensional CDT
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+// C++ headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+// Docopt
+#include "docopt/docopt.h"
+
+// CDT headers
+#include "Metropolis2D.h"
+#include "Observables.h"
+#include "Benchmark.h"
+
+/// Help message parsed by docopt into options
+static const char USAGE[] {
+R"(Causal Dynamical Triangulations in C++ using CGAL.
+
+Copyright (c) 2015 Adam Getchell
+
+A program that evolves 1+1 dimensional triangulated spacetimes, periodic
+in space and time, with the (2,2), (2,4), and (4,2) moves.
+
+Usage:./cdt-2d -t TIMESLICES -v VOLUME --lambda LAMBDA [-p PASSES] [--thermalize THERMAL] [--seed SEED] [--target-volume N2 [--epsilon EPSILON]] [--check] [--measure FILE [--measure-every PASSES]]
+
+Examples:
+./cdt-2d -t 64 -v 64 --lambda 0.7 --passes 1000
+./cdt-2d -t64 -v64 -l0.7 -p1000 --measure volumes.txt
+./cdt-2d -t64 -v64 -l0.7 -p1000 --target-volume 16384 --epsilon 0.0001
+
+Options:
+  -h --help             Show this message
+  --version             Show program version
+  -t TIMESLICES         Number of timeslices
+  -v VOLUME             Vertices on each timeslice to start with
+  -l --lambda LAMBDA    Cosmological constant, critical at ln 2
+  -p --passes PASSES    Number of passes [default: 100]
+  --thermalize THERMAL  Passes before measurement [default: 0]
+  --seed SEED           Seed for the moves
+  --target-volume N2    Add the volume-fixing term epsilon (N2 - target)^2
+                        to the action, and sweep N2 moves at a time
+  --epsilon EPSILON     Strength of the volume-fixing term [default: 0.0001]
+  --check               Check the triangulation after every pass
+  --measure FILE        Measure the action, volume profile, and volume-volume
+                        correlator on worker threads, and write them to FILE
+  --measure-every PASSES  Passes between measurements [default: 1]
+)"
+};
+
+/// @brief The main path of the cdt-2d program
+///
+/// @param[in,out]  argc  Argument count = 1 + number of arguments
+/// @param[in,out]  argv  Argument vector (array) to be passed to docopt
+/// @returns        Integer value 0 if successful, 1 on failure
+int main(int argc, char* const argv[]) {
+  // docopt option parser
+  std::map<std::string, docopt::value> args
+    = docopt::docopt(USAGE,
+                     { argv + 1, argv + argc},
+                     true,           // print help message automatically
+                     "cdt-2d 1.0");  // Version
+
+  // Parse docopt::values in args map
+  auto timeslices = std::stoul(args["-t"].asString());
+  auto volume = std::stoul(args["-v"].asString());
+  auto lambda = std::stod(args["--lambda"].asString());
+  auto passes = std::stoull(args["--passes"].asString());
+  auto thermalization = std::stoull(args["--thermalize"].asString());
+  std::random_device random_seed;
+  auto seed = args["--seed"] ? std::stoull(args["--seed"].asString())
+                             : static_cast<unsigned long long>(random_seed());
+  auto check = args["--check"].asBool();
+
+  if (timeslices < 2 || volume < MINIMUM_SLICE_VOLUME) {
+    std::cout << "Need at least 2 timeslices of " << MINIMUM_SLICE_VOLUME
+              << " vertices." << std::endl;
+    return 1;
+  }
+
+  Triangulation_2d universe;
+  make_2d_triangulation(timeslices, volume, &universe);
+  Metropolis_2d metropolis(&universe, lambda, seed);
+  if (args["--target-volume"]) {
+    const auto target = std::stoul(args["--target-volume"].asString());
+    metropolis.set_volume_fixing(target,
+                                 std::stod(args["--epsilon"].asString()));
+    metropolis.set_sweep_length(target);
+    std::cout << "Volume fixed near N2 = " << target << std::endl;
+  }
+  std::cout << "Random seed = " << seed << std::endl;
+
+  // Outlives the scheduler, whose workers write measurements to it
+  std::ofstream measurement_file;
+  std::unique_ptr<Measurement_scheduler> measurements;
+  Volume_correlator correlator(timeslices, true);
+  std::mutex correlator_lock;
+  if (args["--measure"]) {
+    const auto every = std::stoull(args["--measure-every"].asString());
+    measurement_file.open(args["--measure"].asString());
+    measurements.reset(new Measurement_scheduler(
+        std::max(std::thread::hardware_concurrency(), 2u) - 1));
+    measurements->stream_to(&measurement_file);
+    measurements->add(action_observable(every));
+    measurements->add(volume_profile_observable(every));
+    measurements->add(volume_correlator_observable(every, &correlator,
+                                                   &correlator_lock));
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto attempted = static_cast<std::uint64_t>(0);
+  for (auto pass = 1ull; pass <= thermalization + passes; ++pass) {
+    attempted += metropolis.sweep_length();
+    metropolis.sweep();
+    if (check && !is_valid_2d(universe)) {
+      std::cout << "Invalid triangulation after pass " << pass << std::endl;
+      return 1;
+    }
+    if (measurements && pass > thermalization) {
+      measurements->after_sweep(pass - thermalization, &metropolis);
+    }
+  }
+  const auto elapsed = seconds_since(start);
+
+  std::cout << "N2 = " << universe.number_of_triangles() << " N0 = "
+            << universe.number_of_vertices() << " action = "
+            << metropolis.action() << std::endl;
+  std::cout << "Accepted (2,2) "
+            << metropolis.accepted(move_2d::TWO_TWO) << "/"
+            << metropolis.attempted(move_2d::TWO_TWO) << ", (2,4) "
+            << metropolis.accepted(move_2d::TWO_FOUR) << "/"
+            << metropolis.attempted(move_2d::TWO_FOUR) << ", (4,2) "
+            << metropolis.accepted(move_2d::FOUR_TWO) << "/"
+            << metropolis.attempted(move_2d::FOUR_TWO) << std::endl;
+  std::cout << attempted << " moves in " << elapsed << " seconds, "
+            << (elapsed > 0.0 ? attempted / elapsed : 0.0)
+            << " moves per second." << std::endl;
+
+  if (measurements) {
+    measurements->wait();
+    write_volume_correlator(&correlator, measurement_file);
+    std::cout << "Measurements written to " << args["--measure"].asString()
+              << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,313 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// A program that benchmarks the Metropolis-Hastings sweeps
+///
+/// Builds one universe, then evolves an identical copy of it with each way
+/// of picking sites, and with moves made on the compact triangulation,
+/// reporting moves per second and the integrated autocorrelation time of
+/// \f$N_3^{(2,2)}\f$ and the action. Faster sweeps are only worth having
+/// if they decorrelate the geometry as well as uniform selection does.
+///
+/// With --baseline the construction and sweep timings, in units of a
+/// calibration workload, are compared against those stored in a file, and
+/// the program fails if any is slower by more than the tolerance. A
+/// missing baseline is an error too, so the gate cannot pass by recording
+/// one. The timings are only recorded, and the file only written, with
+/// --update.
+///
+/// \done Uniform versus sequential site selection
+/// \done Moves per second
+/// \done Integrated autocorrelation times
+/// \done Hardware counters per phase
+/// \done Fail on regressions against a stored baseline
+/// \done Classification with CGAL's cells against the compact arrays
+/// \done Moves on CGAL's cells against the compact arrays
+/// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
+/// for a beautiful command line interface.
+
+/// @file cdt-bench.cpp
+/// @brief Benchmarks of Metropolis-Hastings sweeps
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+// C headers
+#include <sys/stat.h>
+
+// C++ headers
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Docopt
+#include "docopt/docopt.h"
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "CompactTriangulation.h"
+#include "Metropolis.h"
+#include "Autocorrelation.h"
+#include "PerfCounters.h"
+#include "Benchmark.h"
+
+/// Help message parsed by docopt into options
+static const char USAGE[] {
+R"(Causal Dynamical Triangulations in C++ using CGAL.
+
+Copyright (c) 2015 Adam Getchell
+
+A program that benchmarks Metropolis-Hastings sweeps on the same
+initial S3 universe with each way of picking sites for moves, and
+with moves made on CGAL's cells or on compact 32-bit arrays,
+optionally failing if it has become slower than a stored baseline.
+
+Usage:./cdt-bench -n SIMPLICES -t TIMESLICES -k K --alpha ALPHA --lambda LAMBDA [-p PASSES] [--seed SEED] [--counters] [--repeat N] [--baseline FILE [--tolerance TOL] [--update]]
+
+Example:
+./cdt-bench -n 64000 -t 64 --alpha 1.1 -k 2.2 --lambda 3.3 --passes 100
+./cdt-bench -n64000 -t64 -a1.1 -k2.2 -l3.3 -p100
+./cdt-bench -n6400 -t16 -a1.1 -k2.2 -l3.3 -p4 --baseline bench.baseline
+
+Options:
+  -h --help             Show this message
+  --version             Show program version
+  -n SIMPLICES          Approximate number of simplices
+  -t TIMESLICES         Number of timeslices
+  -a --alpha ALPHA      Negative squared geodesic length of 1-d timelike edges
+  -k K                  K = 1/(8*pi*G_newton)
+  -l --lambda LAMBDA    K * Cosmological constant
+  -p --passes PASSES    Number of passes [default: 100]
+  --seed SEED           Random seed for the universe and moves [default: 1]
+  --counters            Report hardware counters for each phase
+  --repeat N            Time each phase N times and keep the fastest
+                        [default: 1]
+  --baseline FILE       Compare timings against those stored in FILE
+  --tolerance TOL       Fractional slowdown allowed [default: 0.5]
+  --update              Record the timings in FILE instead of comparing
+)"
+};
+
+/// A way of making sweeps, and the name its timings are reported under
+struct Sweep_method {
+  std::string name;
+  site_order order;
+  move_store store;
+};
+
+/// @brief Prints the wall time and counters of a phase
+///
+/// @param[in] phase       The name of the phase
+/// @param[in] measurement Its Phase_measurement
+void print_phase(const std::string& phase,
+                 const Phase_measurement& measurement) noexcept {
+  std::cout << phase << " counters: seconds = " << measurement.seconds;
+  for (auto i = 0u; i < NUMBER_OF_PERF_EVENTS; ++i) {
+    std::cout << ", " << perf_event_name(static_cast<perf_event>(i))
+              << " = " << measurement.counters[i];
+  }
+  const auto cycles = measurement.counters[0];
+  const auto instructions = measurement.counters[1];
+  if (cycles > 0 && instructions >= 0) {
+    std::cout << ", IPC = " << static_cast<double>(instructions) / cycles;
+  }
+  std::cout << std::endl;
+}  // print_phase()
+
+/// @brief The main path of the cdt-bench program
+///
+/// @param[in,out]  argc  Argument count = 1 + number of arguments
+/// @param[in,out]  argv  Argument vector (array) to be passed to docopt
+/// @returns        Integer value 0 if successful, 1 on failure
+int main(int argc, char* const argv[]) {
+  // docopt option parser
+  std::map<std::string, docopt::value> args
+    = docopt::docopt(USAGE,
+                     { argv + 1, argv + argc},
+                     true,              // print help message automatically
+                     "cdt-bench 1.0");  // Version
+
+  // Parse docopt::values in args map
+  auto simplices = std::stoul(args["-n"].asString());
+  auto timeslices = std::stoul(args["-t"].asString());
+  auto alpha = std::stold(args["--alpha"].asString());
+  auto k = std::stold(args["-k"].asString());
+  auto lambda = std::stold(args["--lambda"].asString());
+  auto passes = std::stoul(args["--passes"].asString());
+  auto seed = std::stoull(args["--seed"].asString());
+  Perf_counters counters(args["--counters"].asBool());
+  auto repeat = std::max(1ul, std::stoul(args["--repeat"].asString()));
+  auto baseline_file =
+      args["--baseline"] ? args["--baseline"].asString() : std::string();
+  auto tolerance = std::stod(args["--tolerance"].asString());
+
+  // The workload is fixed by its parameters, so baselines record them
+  Baseline measured;
+  measured["workload.simplices"] = simplices;
+  measured["workload.timeslices"] = timeslices;
+  measured["workload.passes"] = passes;
+  measured["workload.seed"] = seed;
+  const auto calibration = calibration_seconds();
+
+  // Build the universe once, so every run starts from the same geometry
+  Delaunay universe;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  auto construction = zero_phase();
+  for (auto run = 0ul; run < repeat; ++run) {
+    universe.clear();
+    three_one.clear();
+    two_two.clear();
+    one_three.clear();
+    const auto measurement = measure_phase(&counters, [&]() {
+      make_S3_triangulation(simplices, timeslices, seed, false, &universe,
+                            &three_one, &two_two, &one_three);
+    });
+    if (run == 0 || measurement.seconds < construction.seconds) {
+      construction = measurement;
+    }
+  }
+  measured["construction"] = construction.seconds / calibration;
+  if (counters.available()) print_phase("construction", construction);
+  std::cout << "Universe has " << universe.number_of_finite_cells()
+            << " simplices on " << timeslices << " timeslices." << std::endl;
+
+  // Classifying every cell is dominated by following pointers, so it
+  // shows what the compact triangulation buys
+  Compact_triangulation compact;
+  make_compact_triangulation(universe, &compact);
+  const auto cgal_classify = measure_phase(&counters, [&]() {
+    Delaunay::Finite_cells_iterator cit;
+    for (cit = universe.finite_cells_begin();
+         cit != universe.finite_cells_end(); ++cit) {
+      classify_3_simplex(cit);
+    }
+  });
+  std::uint64_t N3_31, N3_22, N3_13;
+  const auto compact_classify = measure_phase(&counters, [&]() {
+    compact.classify_cells(&N3_31, &N3_22, &N3_13);
+  });
+  if (counters.available()) {
+    print_phase("cgal_classify", cgal_classify);
+    print_phase("compact_classify", compact_classify);
+  }
+  std::cout << "Classification: CGAL " << cgal_classify.seconds
+            << " seconds in "
+            << universe.tds().cells().capacity() * sizeof(Delaunay::Cell) +
+               universe.tds().vertices().capacity() *
+                   sizeof(Delaunay::Vertex)
+            << " bytes, compact " << compact_classify.seconds
+            << " seconds in " << compact.memory_bytes() << " bytes."
+            << std::endl;
+
+  const auto coefficients = make_action_coefficients(alpha, k, lambda);
+
+  const std::vector<Sweep_method> methods{
+      {"uniform", site_order::UNIFORM, move_store::CGAL},
+      {"sequential", site_order::SEQUENTIAL, move_store::CGAL},
+      {"compact", site_order::UNIFORM, move_store::COMPACT}};
+  std::map<std::string, double> moves_per_second;
+  for (const auto& method : methods) {
+    std::vector<double> N3_22;
+    std::vector<double> action;
+    auto accepted = static_cast<std::uint64_t>(0);
+    auto attempted = static_cast<std::uint64_t>(0);
+    auto sweeps = zero_phase();
+    // The seed fixes the chain, so every repetition makes the same moves
+    for (auto run = 0ul; run < repeat; ++run) {
+      Delaunay D3(universe);
+      Timeslice_index index;
+      make_timeslice_index(D3, timeslices, &index);
+      Metropolis metropolis(&D3, &index, coefficients, seed);
+      metropolis.set_sweep_order(method.order);
+      // The copy into the compact arrays is not timed; the copy back after
+      // each sweep is
+      metropolis.set_move_store(method.store);
+      // Keep the move mix fixed so every method samples the same chain
+      metropolis.scheduler().freeze();
+
+      N3_22.clear();
+      action.clear();
+      accepted = 0;
+      attempted = 0;
+      const auto measurement = measure_phase(&counters, [&]() {
+        for (auto pass = static_cast<decltype(passes)>(0); pass < passes;
+             ++pass) {
+          attempted += metropolis.number_of_simplices();
+          accepted += metropolis.sweep();
+          N3_22.push_back(static_cast<double>(metropolis.N3_22()));
+          action.push_back(metropolis.action());
+        }
+      });
+      if (run == 0 || measurement.seconds < sweeps.seconds) {
+        sweeps = measurement;
+      }
+    }
+    measured[method.name + "_sweeps"] = sweeps.seconds / calibration;
+    moves_per_second[method.name] = attempted / sweeps.seconds;
+
+    if (counters.available()) print_phase(method.name, sweeps);
+    std::cout << method.name << ": "
+              << attempted / sweeps.seconds << " moves/sec, "
+              << accepted / sweeps.seconds << " accepted/sec, "
+              << "tau_int(N3_22) = "
+              << integrated_autocorrelation_time(N3_22) << " sweeps, "
+              << "tau_int(S) = " << integrated_autocorrelation_time(action)
+              << " sweeps" << std::endl;
+  }
+  std::cout << "Moves on the compact triangulation are "
+            << moves_per_second["compact"] / moves_per_second["uniform"]
+            << " times as fast as on CGAL's cells." << std::endl;
+
+  if (baseline_file.empty()) return 0;
+
+  Baseline baseline;
+  if (args["--update"].asBool()) {
+    const auto slash = baseline_file.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+      mkdir(baseline_file.substr(0, slash).c_str(), 0755);
+    }
+    if (!write_baseline(baseline_file, measured)) {
+      std::cout << "Could not write baseline " << baseline_file << std::endl;
+      return 1;
+    }
+    std::cout << "Recorded baseline " << baseline_file << std::endl;
+    return 0;
+  }
+  if (!read_baseline(baseline_file, &baseline)) {
+    std::cout << "No baseline " << baseline_file << "; record one on the "
+              << "reference machine with --update." << std::endl;
+    return 1;
+  }
+  if (!same_workload(baseline, measured)) {
+    std::cout << "Baseline " << baseline_file << " was recorded for a "
+              << "different workload; rerun with --update." << std::endl;
+    return 1;
+  }
+
+  for (const auto& entry : measured) {
+    const auto found = baseline.find(entry.first);
+    if (entry.first.compare(0, 9, "workload.") == 0 ||
+        found == baseline.end()) {
+      continue;
+    }
+    std::cout << entry.first << ": " << entry.second
+              << " calibration units, baseline " << found->second << " ("
+              << 100.0 * (entry.second / found->second - 1.0) << "%)"
+              << std::endl;
+  }
+  const auto regressions = find_regressions(baseline, measured, tolerance);
+  for (const auto& regression : regressions) {
+    std::cout << "Performance regression: " << regression.name << " took "
+              << regression.measured / regression.baseline
+              << " times its baseline." << std::endl;
+  }
+  if (!regressions.empty()) return 1;
+  std::cout << "No performance regressions." << std::endl;
+  return 0;
+}
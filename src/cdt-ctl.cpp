@@ -0,0 +1,92 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// A program that sends control requests to a running simulation
+///
+/// Sends one request to the socket given to cdt --control. Replies, such as
+/// the status line, appear in the simulation's output.
+///
+/// \done Send snapshot, pause, resume, status, k, lambda, and trace requests
+/// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
+/// for a beautiful command line interface.
+
+/// @file cdt-ctl.cpp
+/// @brief Control requests for running simulations
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+// C++ headers
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Docopt
+#include "docopt/docopt.h"
+
+// CDT headers
+#include "Control.h"
+
+/// Help message parsed by docopt into options
+static const char USAGE[] {
+R"(Causal Dynamical Triangulations in C++ using CGAL.
+
+Copyright (c) 2015 Adam Getchell
+
+A program that sends a request to a simulation started with
+cdt --control SOCKET.
+
+Usage:./cdt-ctl SOCKET REQUEST...
+
+Requests:
+  snapshot [FILE]       Save the triangulation in the background
+  pause                 Stop between sweeps until resumed
+  resume                Carry on after a pause
+  status                Print the counts, action, and couplings
+  k VALUE               Change K
+  lambda VALUE          Change Lambda
+  trace                 Write the move trace of a run started with --trace
+
+Example:
+./cdt-ctl /tmp/cdt.sock snapshot thermalized.cdt
+./cdt-ctl /tmp/cdt.sock k 2.5
+
+Options:
+  -h --help             Show this message
+  --version             Show program version
+)"
+};
+
+/// @brief The main path of the cdt-ctl program
+///
+/// @param[in,out]  argc  Argument count = 1 + number of arguments
+/// @param[in,out]  argv  Argument vector (array) to be passed to docopt
+/// @returns        Integer value 0 if successful, 1 on failure
+int main(int argc, char* const argv[]) {
+  // docopt option parser
+  std::map<std::string, docopt::value> args
+    = docopt::docopt(USAGE,
+                     { argv + 1, argv + argc},
+                     true,            // print help message automatically
+                     "cdt-ctl 1.0");  // Version
+
+  auto socket = args["SOCKET"].asString();
+  std::string text;
+  for (const auto& word : args["REQUEST"].asStringList()) {
+    text += (text.empty() ? "" : " ") + word;
+  }
+
+  Control_request request;
+  if (!parse_control_request(text, &request)) {
+    std::cout << "Unknown request: " << text << std::endl;
+    return 1;
+  }
+  if (!send_control(socket, text)) {
+    std::cout << "Could not send to " << socket << std::endl;
+    return 1;
+  }
+  std::cout << "Sent " << text << std::endl;
+  return 0;
+}
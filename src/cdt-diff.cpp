@@ -0,0 +1,137 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// A program that checks the Metropolis engine against plain flips
+///
+/// Evolves one universe with Metropolis, mirroring every accepted move onto
+/// a reference copy with **Delaunay::flip()**, and compares the two with
+/// a Differential_tester after every few sweeps. Exits with 1 at the first
+/// difference, so optimizations of the move engine can be checked over
+/// millions of moves before they are merged.
+///
+/// \done Uniform, sequential, and batched sweeps
+/// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
+/// for a beautiful command line interface.
+
+/// @file cdt-diff.cpp
+/// @brief Differential test of the Metropolis engine
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+// C++ headers
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Docopt
+#include "docopt/docopt.h"
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "Metropolis.h"
+#include "Differential.h"
+#include "Benchmark.h"
+
+/// Help message parsed by docopt into options
+static const char USAGE[] {
+R"(Causal Dynamical Triangulations in C++ using CGAL.
+
+Copyright (c) 2015 Adam Getchell
+
+A program that evolves an S3 universe with the Metropolis engine while
+making the same moves on a copy with plain CGAL flips, and fails if the
+two ever differ in their counts or triangulation.
+
+Usage:./cdt-diff -n SIMPLICES -t TIMESLICES -k K --alpha ALPHA --lambda LAMBDA [-p PASSES] [--seed SEED] [--check PASSES] [--batch SIZE | --sequential]
+
+Example:
+./cdt-diff -n 64000 -t 64 --alpha 1.1 -k 2.2 --lambda 3.3 --passes 100
+./cdt-diff -n6400 -t16 -a1.1 -k2.2 -l3.3 -p10 --batch 64
+
+Options:
+  -h --help             Show this message
+  --version             Show program version
+  -n SIMPLICES          Approximate number of simplices
+  -t TIMESLICES         Number of timeslices
+  -a --alpha ALPHA      Negative squared geodesic length of 1-d timelike edges
+  -k K                  K = 1/(8*pi*G_newton)
+  -l --lambda LAMBDA    K * Cosmological constant
+  -p --passes PASSES    Number of passes [default: 10]
+  --seed SEED           Seed for the universe and moves [default: 1]
+  --check PASSES        Passes between comparisons [default: 1]
+  --batch SIZE          Moves proposed and evaluated together [default: 1]
+  --sequential          Attempt moves one slab at a time
+)"
+};
+
+/// @brief The main path of the cdt-diff program
+///
+/// @param[in,out]  argc  Argument count = 1 + number of arguments
+/// @param[in,out]  argv  Argument vector (array) to be passed to docopt
+/// @returns        Integer value 0 if successful, 1 on failure
+int main(int argc, char* const argv[]) {
+  // docopt option parser
+  std::map<std::string, docopt::value> args
+    = docopt::docopt(USAGE,
+                     { argv + 1, argv + argc},
+                     true,             // print help message automatically
+                     "cdt-diff 1.0");  // Version
+
+  // Parse docopt::values in args map
+  auto simplices = std::stoul(args["-n"].asString());
+  auto timeslices = std::stoul(args["-t"].asString());
+  auto alpha = std::stold(args["--alpha"].asString());
+  auto k = std::stold(args["-k"].asString());
+  auto lambda = std::stold(args["--lambda"].asString());
+  auto passes = std::stoul(args["--passes"].asString());
+  auto seed = std::stoull(args["--seed"].asString());
+  auto check = std::max(1ul, std::stoul(args["--check"].asString()));
+  auto batch = std::stoul(args["--batch"].asString());
+  auto sequential = args["--sequential"].asBool();
+
+  Delaunay universe;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  make_S3_triangulation(simplices, timeslices, seed, false, &universe,
+                        &three_one, &two_two, &one_three);
+
+  Differential_tester tester(universe, timeslices,
+                             make_action_coefficients(alpha, k, lambda),
+                             seed);
+  auto& metropolis = tester.optimized();
+  metropolis.set_batch_size(batch);
+  if (sequential) metropolis.set_sweep_order(site_order::SEQUENTIAL);
+
+  std::string difference;
+  if (!tester.check(&difference)) {
+    std::cout << "Copies differ before any moves: " << difference
+              << std::endl;
+    return 1;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto attempted = static_cast<std::uint64_t>(0);
+  for (auto pass = 1ul; pass <= passes; ++pass) {
+    attempted += metropolis.number_of_simplices();
+    metropolis.sweep();
+    if (pass % check != 0 && pass != passes) continue;
+    if (!tester.check(&difference)) {
+      std::cout << "Difference after pass " << pass << " and "
+                << tester.moves() << " accepted moves: " << difference
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << attempted << " moves attempted, " << tester.moves()
+            << " accepted and mirrored (" << tester.made() << " made) in "
+            << seconds_since(start) << " seconds." << std::endl;
+  std::cout << "No differences found." << std::endl;
+  return 0;
+}
@@ -9,6 +9,7 @@
 ///
 /// \done Load files generated by cdt.cpp
 /// \done Invoke Geomview
+/// \done Insert points in spatial order, each located from the last
 /// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
 /// for a beautiful command line interface.
 /// \todo Parse file and read in points only
@@ -31,6 +32,7 @@
 #include <fstream>
 #include <map>
 #include <string>
+#include <vector>
 
 // Docopt
 #include "docopt/docopt.h"
@@ -97,11 +99,15 @@ int main(int argc, char* const argv[]) {
   Delaunay D;
   std::ifstream iFile(file, std::ios::in);
   Point3 p;
+  std::vector<Point3> points;
 
-  // Insert points from file into Delaunay triangulation
+  // Insert points from file into Delaunay triangulation all at once, so
+  // CGAL sorts them spatially and starts locating each from the last,
+  // rather than walking from an arbitrary cell every time
   while (iFile >> p) {
-    D.insert(p);
+    points.push_back(p);
   }
+  D.insert(points.begin(), points.end());
 
   std::cout << "Drawing 3D Delaunay triangulation in wired mode." << std::endl;
   gv.set_wired(true);
@@ -0,0 +1,149 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// A program that replays a move trace
+///
+/// Loads the checkpoint a trace written by cdt --trace starts from, remakes
+/// its accepted moves in order without drawing random numbers or evaluating
+/// acceptance, and checks that the triangulation it ends with hashes as the
+/// run's did, and that the counts match those the run recorded. A
+/// crash or divergence hours into a run is reproduced in the time it takes
+/// to make the moves since the last checkpoint.
+///
+/// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
+/// for a beautiful command line interface.
+
+/// @file cdt-replay.cpp
+/// @brief Deterministic replay of move traces
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+// C++ headers
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Docopt
+#include "docopt/docopt.h"
+
+// CDT headers
+#include "MoveTrace.h"
+#include "Benchmark.h"
+
+/// Help message parsed by docopt into options
+static const char USAGE[] {
+R"(Causal Dynamical Triangulations in C++ using CGAL.
+
+Copyright (c) 2015 Adam Getchell
+
+A program that loads the checkpoint of a move trace written by cdt --trace,
+makes the accepted moves again in order, and fails if the counts differ
+from those the run recorded.
+
+Usage:./cdt-replay TRACE [--checkpoint FILE]
+
+Example:
+./cdt-replay run.trace
+./cdt-replay run.trace --checkpoint run.trace.cdt
+
+Options:
+  -h --help             Show this message
+  --version             Show program version
+  --checkpoint FILE     The checkpoint, if not TRACE.cdt
+)"
+};
+
+/// @brief The main path of the cdt-replay program
+///
+/// @param[in,out]  argc  Argument count = 1 + number of arguments
+/// @param[in,out]  argv  Argument vector (array) to be passed to docopt
+/// @returns        Integer value 0 if successful, 1 on failure
+int main(int argc, char* const argv[]) {
+  // docopt option parser
+  std::map<std::string, docopt::value> args
+    = docopt::docopt(USAGE,
+                     { argv + 1, argv + argc},
+                     true,               // print help message automatically
+                     "cdt-replay 1.0");  // Version
+
+  const auto path = args["TRACE"].asString();
+  const auto checkpoint = args["--checkpoint"] ?
+      args["--checkpoint"].asString() : path + ".cdt";
+
+  Move_trace_file trace;
+  if (!read_move_trace(path, &trace)) {
+    std::cout << "Cannot read move trace " << path << std::endl;
+    return 1;
+  }
+  const auto& header = trace.header;
+  if (header.first != header.checkpoint) {
+    std::cout << "The trace lost " << header.first - header.checkpoint
+              << " moves since its checkpoint." << std::endl;
+    return 1;
+  }
+
+  Delaunay universe;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  if (!load_universe(checkpoint, header.key, &universe, &three_one, &two_two,
+                     &one_three)) {
+    std::cout << "Cannot load checkpoint " << checkpoint << std::endl;
+    return 1;
+  }
+  Timeslice_index index;
+  make_timeslice_index(universe, header.key.number_of_timeslices, &index);
+
+  // Only used to count N1_TL, N3_31, and N3_22
+  Metropolis metropolis(&universe, &index, Action_coefficients{0, 0, 0},
+                        header.key.seed);
+  auto counts = [&metropolis]() {
+    return std::array<std::uint64_t, 3>{{metropolis.N1_TL(),
+                                         metropolis.N3_31(),
+                                         metropolis.N3_22()}};
+  };
+  if (triangulation_hash(universe) != header.checkpoint_hash ||
+      counts() != header.checkpoint_counts) {
+    std::cout << "Checkpoint " << checkpoint << " is not the one the trace "
+              << "starts from." << std::endl;
+    return 1;
+  }
+  std::cout << "Replaying " << header.count << " moves from pass "
+            << header.checkpoint_pass << ", random draw "
+            << header.checkpoint_draws << std::endl;
+  if (!trace.records.empty()) {
+    const auto& last = trace.records.back();
+    std::cout << "Last move in pass " << last.pass << ", random draw "
+              << last.draws << ", batch slot " << last.slot
+              << ", change in action " << last.delta_action << std::endl;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  Replay_result result;
+  replay_move_trace(trace, &universe, &index, &result);
+  const auto elapsed = seconds_since(start);
+  metropolis.recount();
+
+  std::cout << result.replayed << " moves replayed, " << result.failed
+            << " failed as in the run, and " << result.missing
+            << " not found, in " << elapsed << " seconds." << std::endl;
+  std::cout << "N1_TL = " << metropolis.N1_TL() << " N3_31 = "
+            << metropolis.N3_31() << " N3_22 = " << metropolis.N3_22()
+            << std::endl;
+  // A trace written by the crash handler records no final hash
+  const auto hash = triangulation_hash(universe);
+  std::cout << "Triangulation hash " << hash << std::endl;
+  if (result.missing > 0 || counts() != header.final_counts ||
+      (header.final_hash != 0 && hash != header.final_hash)) {
+    std::cout << "Replay diverged from the traced run." << std::endl;
+    return 1;
+  }
+  std::cout << "Replay matches the traced run." << std::endl;
+  return 0;
+}
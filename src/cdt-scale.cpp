@@ -0,0 +1,386 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// A program that measures how construction and evolution scale
+///
+/// For each size on a ladder and each thread count, a child process builds
+/// one universe per thread, classifies it, and runs sweeps of ergodic moves.
+/// The universes are independent, so thread counts measure aggregate
+/// throughput on a node. Each configuration runs in its own process, so its
+/// peak RSS is its own, and an out-of-memory kill only loses that row.
+///
+/// \done Wall time per phase
+/// \done Moves per second
+/// \done Peak RSS
+/// \done Bytes in the TDS, Timeslice_index, and candidate buffers
+/// \done Cache misses
+/// \done Hardware counters per phase
+/// \done CSV and JSON reports
+/// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
+/// for a beautiful command line interface.
+
+/// @file cdt-scale.cpp
+/// @brief Scaling harness for construction and evolution
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+// C headers
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// C++ headers
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Docopt
+#include "docopt/docopt.h"
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "Metropolis.h"
+#include "Benchmark.h"
+#include "PerfCounters.h"
+#include "MemoryReport.h"
+
+/// Help message parsed by docopt into options
+static const char USAGE[] {
+R"(Causal Dynamical Triangulations in C++ using CGAL.
+
+Copyright (c) 2015 Adam Getchell
+
+A program that measures how constructing, classifying, and evolving S3
+universes scales with size and thread count. Each thread evolves its own
+universe.
+
+Usage:./cdt-scale [--sizes SIZES] [--threads THREADS] [-t TIMESLICES] [-p PASSES] [-a ALPHA] [-k K] [-l LAMBDA] [--seed SEED] [--counters] [--format FORMAT] [--output FILE]
+
+Examples:
+./cdt-scale --sizes 1e3,1e4,1e5 --threads 1,2,4 --format json
+./cdt-scale --sizes 64000 -p10 --output scaling.csv
+
+Options:
+  -h --help             Show this message
+  --version             Show program version
+  --sizes SIZES         Comma-separated numbers of simplices
+                        [default: 1e3,1e4,1e5,1e6,1e7]
+  --threads THREADS     Comma-separated thread counts [default: 1,2,4]
+  -t TIMESLICES         Number of timeslices [default: 16]
+  -p --passes PASSES    Sweeps per universe [default: 1]
+  -a --alpha ALPHA      Negative squared geodesic length of 1-d timelike edges
+                        [default: 1.1]
+  -k K                  K = 1/(8*pi*G_newton) [default: 2.2]
+  -l --lambda LAMBDA    K * Cosmological constant [default: 3.3]
+  --seed SEED           Seed of the first universe [default: 1]
+  --counters            Report hardware counters for each phase
+  --format FORMAT       csv or json [default: csv]
+  --output FILE         Report file, or - for standard output [default: -]
+)"
+};
+
+/// @brief Measurements of one configuration, sent from child to parent
+struct Scaling_result {
+  /// Mean number of simplices per universe
+  std::uint64_t simplices;
+  /// Slowest thread's time and total counts over threads for each phase
+  Phase_measurement construction;
+  Phase_measurement classification;
+  Phase_measurement sweeps;
+  double wall_seconds;
+  /// Totals over all threads
+  std::uint64_t moves;
+  std::uint64_t accepted;
+  std::int64_t peak_rss_kilobytes;
+  /// Bytes held after the sweeps, summed over threads
+  std::uint64_t tds_bytes;
+  std::uint64_t index_bytes;
+  std::uint64_t buffer_bytes;
+};
+
+/// @brief Parameters shared by every configuration
+struct Scaling_parameters {
+  unsigned timeslices;
+  unsigned long passes;
+  long double alpha;
+  long double k;
+  long double lambda;
+  std::uint64_t seed;
+};
+
+/// @returns Comma-separated numbers, which may be written like 1e6
+std::vector<unsigned long> parse_list(const std::string& list) noexcept {
+  std::vector<unsigned long> values;
+  std::istringstream items(list);
+  std::string item;
+  while (std::getline(items, item, ',')) {
+    if (!item.empty()) {
+      values.push_back(static_cast<unsigned long>(std::stod(item)));
+    }
+  }
+  return values;
+}  // parse_list()
+
+/// @brief Builds, classifies, and evolves one universe per thread
+///
+/// @param[in] size       Number of simplices per universe
+/// @param[in] threads    Number of threads
+/// @param[in] parameters The Scaling_parameters
+/// @returns The Scaling_result
+Scaling_result run_configuration(const unsigned long size,
+                                 const unsigned long threads,
+                                 const Scaling_parameters& parameters)
+                                 noexcept {
+  struct Thread_result {
+    std::uint64_t simplices{0};
+    Phase_measurement construction;
+    Phase_measurement classification;
+    Phase_measurement sweeps;
+    std::uint64_t moves{0};
+    std::uint64_t accepted{0};
+    std::uint64_t tds_bytes{0};
+    std::uint64_t index_bytes{0};
+    std::uint64_t buffer_bytes{0};
+  };
+  std::vector<Thread_result> results(threads);
+  const auto coefficients = make_action_coefficients(
+      parameters.alpha, parameters.k, parameters.lambda);
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (auto i = 0ul; i < threads; ++i) {
+    workers.emplace_back([&, i]() {
+      auto& result = results[i];
+      // Counters opened here count this thread only
+      Perf_counters counters(true);
+      Delaunay D3;
+      std::vector<Cell_handle> three_one;
+      std::vector<Cell_handle> two_two;
+      std::vector<Cell_handle> one_three;
+
+      result.construction = measure_phase(&counters, [&]() {
+        make_S3_triangulation(size, parameters.timeslices,
+                              parameters.seed + i, false, &D3, &three_one,
+                              &two_two, &one_three);
+      });
+
+      Timeslice_index index;
+      std::unique_ptr<Metropolis> metropolis;
+      result.classification = measure_phase(&counters, [&]() {
+        three_one.clear();
+        two_two.clear();
+        one_three.clear();
+        classify_3_simplices(&D3, &three_one, &two_two, &one_three);
+        make_timeslice_index(D3, parameters.timeslices, &index);
+        metropolis.reset(new Metropolis(&D3, &index, coefficients,
+                                        parameters.seed + i));
+      });
+      metropolis->scheduler().freeze();
+      result.simplices = metropolis->number_of_simplices();
+
+      result.sweeps = measure_phase(&counters, [&]() {
+        for (auto pass = 0ul; pass < parameters.passes; ++pass) {
+          result.moves += metropolis->number_of_simplices();
+          result.accepted += metropolis->sweep();
+        }
+      });
+
+      result.tds_bytes =
+          D3.tds().cells().capacity() * sizeof(Delaunay::Cell) +
+          D3.tds().vertices().capacity() * sizeof(Delaunay::Vertex);
+      result.index_bytes = timeslice_index_bytes(index);
+      result.buffer_bytes = metropolis->buffer_bytes();
+    });
+  }
+  for (auto& worker : workers) worker.join();
+
+  Scaling_result scaling{};
+  scaling.wall_seconds = seconds_since(start);
+  scaling.construction = zero_phase();
+  scaling.classification = zero_phase();
+  scaling.sweeps = zero_phase();
+  for (const auto& result : results) {
+    scaling.simplices += result.simplices;
+    combine_phase(&scaling.construction, result.construction);
+    combine_phase(&scaling.classification, result.classification);
+    combine_phase(&scaling.sweeps, result.sweeps);
+    scaling.moves += result.moves;
+    scaling.accepted += result.accepted;
+    scaling.tds_bytes += result.tds_bytes;
+    scaling.index_bytes += result.index_bytes;
+    scaling.buffer_bytes += result.buffer_bytes;
+  }
+  scaling.simplices /= threads;
+  scaling.peak_rss_kilobytes = peak_rss_kilobytes();
+  return scaling;
+}  // run_configuration()
+
+/// @brief Runs one configuration in a child process
+///
+/// @param[in]  size       Number of simplices per universe
+/// @param[in]  threads    Number of threads
+/// @param[in]  parameters The Scaling_parameters
+/// @param[out] result     The Scaling_result
+/// @returns "ok", or how the child failed
+std::string run_in_child(const unsigned long size,
+                         const unsigned long threads,
+                         const Scaling_parameters& parameters,
+                         Scaling_result* const result) noexcept {
+  int channel[2];
+  if (pipe(channel) != 0) return "no pipe";
+  const auto child = fork();
+  if (child < 0) return "no fork";
+
+  if (child == 0) {
+    close(channel[0]);
+    // Keep progress messages out of the report
+    const auto null = open("/dev/null", O_WRONLY);
+    if (null >= 0) dup2(null, STDOUT_FILENO);
+    const auto scaling = run_configuration(size, threads, parameters);
+    const auto written = write(channel[1], &scaling, sizeof(scaling));
+    _exit(written == sizeof(scaling) ? 0 : 1);
+  }
+
+  close(channel[1]);
+  auto received = static_cast<std::size_t>(0);
+  auto* const buffer = reinterpret_cast<char*>(result);
+  while (received < sizeof(*result)) {
+    const auto n = read(channel[0], buffer + received,
+                        sizeof(*result) - received);
+    if (n <= 0) break;
+    received += static_cast<std::size_t>(n);
+  }
+  close(channel[0]);
+
+  auto status = 0;
+  waitpid(child, &status, 0);
+  if (WIFSIGNALED(status)) {
+    return "killed by signal " + std::to_string(WTERMSIG(status));
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+      received != sizeof(*result)) {
+    return "failed";
+  }
+  return "ok";
+}  // run_in_child()
+
+/// @returns **count** per second, or 0 if no time was measured
+double per_second(const double count, const double seconds) noexcept {
+  return (seconds > 0.0) ? count / seconds : 0.0;
+}
+
+/// @returns The sum of one counter over phases, or -1 if unavailable
+std::int64_t total_count(const Scaling_result& result,
+                         const perf_event event) noexcept {
+  const auto i = static_cast<std::size_t>(event);
+  const auto construction = result.construction.counters[i];
+  const auto classification = result.classification.counters[i];
+  const auto sweeps = result.sweeps.counters[i];
+  if (construction < 0 || classification < 0 || sweeps < 0) return -1;
+  return construction + classification + sweeps;
+}
+
+/// @brief Adds every counter of a phase to a row, prefixed by its name
+void add_counters(Report_row* const row, const std::string& phase,
+                  const Phase_measurement& measurement) noexcept {
+  for (auto i = 0u; i < NUMBER_OF_PERF_EVENTS; ++i) {
+    add_field(row, phase + "_" + perf_event_name(static_cast<perf_event>(i)),
+              measurement.counters[i]);
+  }
+}
+
+/// @brief The main path of the cdt-scale program
+///
+/// @param[in,out]  argc  Argument count = 1 + number of arguments
+/// @param[in,out]  argv  Argument vector (array) to be passed to docopt
+/// @returns        Integer value 0 if successful, 1 on failure
+int main(int argc, char* const argv[]) {
+  // docopt option parser
+  std::map<std::string, docopt::value> args
+    = docopt::docopt(USAGE,
+                     { argv + 1, argv + argc},
+                     true,              // print help message automatically
+                     "cdt-scale 1.0");  // Version
+
+  // Parse docopt::values in args map
+  const auto sizes = parse_list(args["--sizes"].asString());
+  const auto thread_counts = parse_list(args["--threads"].asString());
+  Scaling_parameters parameters;
+  parameters.timeslices = std::stoul(args["-t"].asString());
+  parameters.passes = std::stoul(args["--passes"].asString());
+  parameters.alpha = std::stold(args["--alpha"].asString());
+  parameters.k = std::stold(args["-k"].asString());
+  parameters.lambda = std::stold(args["--lambda"].asString());
+  parameters.seed = std::stoull(args["--seed"].asString());
+  const auto counters = args["--counters"].asBool();
+  const auto format = args["--format"].asString();
+  const auto output = args["--output"].asString();
+
+  if (format != "csv" && format != "json") {
+    std::cerr << "Format must be csv or json." << std::endl;
+    return 1;
+  }
+
+  std::vector<Report_row> rows;
+  for (const auto size : sizes) {
+    for (const auto threads : thread_counts) {
+      if (threads == 0) continue;
+      std::cerr << "Running " << size << " simplices on " << threads
+                << " threads ..." << std::endl;
+      Scaling_result result{};
+      const auto status = run_in_child(size, threads, parameters, &result);
+
+      Report_row row;
+      add_field(&row, "size", size);
+      add_field(&row, "threads", threads);
+      add_field(&row, "timeslices", parameters.timeslices);
+      add_field(&row, "passes", parameters.passes);
+      add_field(&row, "status", status);
+      add_field(&row, "simplices", result.simplices);
+      add_field(&row, "construction_seconds", result.construction.seconds);
+      add_field(&row, "classification_seconds",
+                result.classification.seconds);
+      add_field(&row, "sweep_seconds", result.sweeps.seconds);
+      add_field(&row, "wall_seconds", result.wall_seconds);
+      add_field(&row, "moves", result.moves);
+      add_field(&row, "moves_per_second",
+                per_second(result.moves, result.sweeps.seconds));
+      add_field(&row, "accepted_per_second",
+                per_second(result.accepted, result.sweeps.seconds));
+      add_field(&row, "peak_rss_kilobytes", result.peak_rss_kilobytes);
+      add_field(&row, "tds_bytes", result.tds_bytes);
+      add_field(&row, "index_bytes", result.index_bytes);
+      add_field(&row, "buffer_bytes", result.buffer_bytes);
+      add_field(&row, "cache_misses",
+                total_count(result, perf_event::LLC_MISSES));
+      if (counters) {
+        add_counters(&row, "construction", result.construction);
+        add_counters(&row, "classification", result.classification);
+        add_counters(&row, "sweeps", result.sweeps);
+      }
+      rows.push_back(row);
+    }
+  }
+
+  std::ofstream file;
+  if (output != "-") file.open(output);
+  std::ostream& report = (output != "-") ? file : std::cout;
+  if (format == "json") {
+    write_json(rows, report);
+  } else {
+    write_csv(rows, report);
+  }
+
+  return 0;
+}
@@ -0,0 +1,148 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// A program that monitors running simulations
+///
+/// Reads the telemetry pages published by cdt --telemetry and shows one line
+/// per run, refreshing periodically, much like top(1). Reading never blocks
+/// or slows the runs being watched. Runs which have exited are shown once
+/// more, as finished or dead, and their pages are then removed.
+///
+/// \done Discover runs on this node
+/// \done Counts, action, acceptance, throughput, and ETA
+/// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
+/// for a beautiful command line interface.
+
+/// @file cdt-top.cpp
+/// @brief Live monitor of running simulations
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+// C++ headers
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Docopt
+#include "docopt/docopt.h"
+
+// CDT headers
+#include "Telemetry.h"
+
+/// Help message parsed by docopt into options
+static const char USAGE[] {
+R"(Causal Dynamical Triangulations in C++ using CGAL.
+
+Copyright (c) 2015 Adam Getchell
+
+A program that shows the progress of simulations started with
+cdt --telemetry. Without names, every run on this node is shown.
+
+Usage:./cdt-top [--interval SECONDS] [--once] [NAME ...]
+
+Example:
+./cdt-top
+./cdt-top --once cdt-12345
+
+Options:
+  -h --help             Show this message
+  --version             Show program version
+  --interval SECONDS    Seconds between refreshes [default: 2]
+  --once                Print once and exit
+)"
+};
+
+/// @returns **seconds** as hours, minutes, and seconds, or - if unknown
+std::string format_duration(const double seconds) noexcept {
+  if (seconds < 0.0) return "-";
+  const auto total = static_cast<std::uint64_t>(seconds);
+  std::ostringstream formatted;
+  formatted << total / 3600 << ":" << std::setfill('0') << std::setw(2)
+            << total / 60 % 60 << ":" << std::setw(2) << total % 60;
+  return formatted.str();
+}  // format_duration()
+
+/// @returns **value** with **precision** digits after the point
+std::string format_fixed(const double value, const int precision) noexcept {
+  std::ostringstream formatted;
+  formatted << std::fixed << std::setprecision(precision) << value;
+  return formatted.str();
+}  // format_fixed()
+
+/// @brief Prints one line per telemetry page, and removes the pages of runs
+/// which have exited
+///
+/// @param[in] names The page names
+void print_runs(const std::vector<std::string>& names) noexcept {
+  std::cout << std::left << std::setw(14) << "NAME" << std::right
+            << std::setw(8) << "PID" << std::setw(14) << "PHASE"
+            << std::setw(14) << "PASS" << std::setw(10) << "N3"
+            << std::setw(10) << "N3_22" << std::setw(10) << "N1_TL"
+            << std::setw(14) << "ACTION" << std::setw(9) << "ACCEPT%"
+            << std::setw(12) << "MOVES/S" << std::setw(11) << "ELAPSED"
+            << std::setw(11) << "ETA" << std::endl;
+  for (const auto& name : names) {
+    Telemetry_snapshot snapshot;
+    if (!read_telemetry(name, &snapshot)) continue;
+    const auto& sample = snapshot.sample;
+    auto attempted = static_cast<std::uint64_t>(0);
+    auto accepted = static_cast<std::uint64_t>(0);
+    for (auto i = 0u; i < sample.attempted.size(); ++i) {
+      attempted += sample.attempted[i];
+      accepted += sample.accepted[i];
+    }
+    const auto alive = publisher_alive(snapshot);
+    const auto phase = (alive || sample.phase == run_phase::FINISHED) ?
+        run_phase_name(sample.phase) : std::string("dead");
+    std::cout << std::left << std::setw(14) << name << std::right
+              << std::setw(8) << snapshot.pid << std::setw(14) << phase
+              << std::setw(14)
+              << std::to_string(sample.pass) + "/" +
+                 std::to_string(sample.passes)
+              << std::setw(10) << sample.N3_31 + sample.N3_22
+              << std::setw(10) << sample.N3_22 << std::setw(10)
+              << sample.N1_TL << std::setw(14) << sample.action
+              << std::setw(9)
+              << format_fixed(attempted ? 100.0 * accepted / attempted : 0.0,
+                              2)
+              << std::setw(12) << format_fixed(sample.moves_per_second, 0)
+              << std::setw(11)
+              << format_duration(sample.elapsed_seconds) << std::setw(11)
+              << format_duration(sample.eta_seconds) << std::endl;
+    if (!alive) remove_telemetry(name);
+  }
+}  // print_runs()
+
+/// @brief The main path of the cdt-top program
+///
+/// @param[in,out]  argc  Argument count = 1 + number of arguments
+/// @param[in,out]  argv  Argument vector (array) to be passed to docopt
+/// @returns        Integer value 0 if successful, 1 on failure
+int main(int argc, char* const argv[]) {
+  // docopt option parser
+  std::map<std::string, docopt::value> args
+    = docopt::docopt(USAGE,
+                     { argv + 1, argv + argc},
+                     true,            // print help message automatically
+                     "cdt-top 1.0");  // Version
+
+  // Parse docopt::values in args map
+  auto interval = std::stod(args["--interval"].asString());
+  auto once = args["--once"].asBool();
+  auto named = args["NAME"].asStringList();
+
+  for (;;) {
+    if (!once) std::cout << "\033[H\033[2J";
+    print_runs(named.empty() ? list_telemetry() : named);
+    if (once) return 0;
+    std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+  }
+}
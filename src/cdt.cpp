@@ -7,7 +7,18 @@
 /// Inspired by https://github.com/ucdavis/CDT
 ///
 /// \todo Invoke complete set of ergodic (Pachner) moves
-/// \todo Use Metropolis-Hastings algorithm
+/// \done Use Metropolis-Hastings algorithm
+/// \done Adapt the move mix while thermalizing
+/// \done Anneal K while thermalizing, stopping once converged
+/// \done Reproducible runs from a seed, with cached seed universes
+/// \done Per-phase memory report
+/// \done Live telemetry in shared memory
+/// \done Snapshot, pause, and change couplings while running
+/// \done Zero-copy snapshots in shared memory for analysis processes
+/// \done Observables measured on worker threads
+/// \done Slab-parallel construction
+/// \done Move traces for deterministic replay
+/// \done Moves on the compact triangulation
 /// \todo Fix write_file() to include cell->info() and vertex->info()
 /// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
 /// for a beautiful command line interface.
@@ -22,10 +33,17 @@
 #include <CGAL/Timer.h>
 
 // C++ headers
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <cstdlib>
+#include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 // Docopt
@@ -34,6 +52,20 @@
 // CDT headers
 #include "./utilities.h"
 #include "S3Triangulation.h"
+#include "SlabTriangulation.h"
+#include "Metropolis.h"
+#include "Thermalization.h"
+#include "SeedCache.h"
+#include "MemoryReport.h"
+#include "Telemetry.h"
+#include "Benchmark.h"
+#include "Control.h"
+#include "SharedSnapshot.h"
+#include "Observables.h"
+#include "MoveTrace.h"
+
+// Heap use for --memory-report
+CDT_COUNT_ALLOCATIONS()
 
 /// Help message parsed by docopt into options
 static const char USAGE[] {
@@ -47,7 +79,7 @@ to the Metropolis algorithm. Specify the number of passes to control
 how much evolution is desired. Each pass attempts a number of ergodic
 moves equal to the number of simplices in the simulation.
 
-Usage:./cdt (--spherical | --toroidal) -n SIMPLICES -t TIMESLICES [-d DIM] -k K --alpha ALPHA --lambda LAMBDA [-p PASSES]
+Usage:./cdt (--spherical | --toroidal) -n SIMPLICES -t TIMESLICES [-d DIM] -k K --alpha ALPHA --lambda LAMBDA [-p PASSES] [--slabs | --stream POINTS] [--thermalize THERMAL [--anneal]] [--batch SIZE | --sequential | --compact] [--seed SEED [--cache DIR]] [--memory-report] [--telemetry] [--control SOCKET] [--share EVERY] [--measure FILE [--measure-every PASSES]] [--trace FILE [--trace-moves MOVES]]
 
 Examples:
 ./cdt --spherical -n 64000 -t 256 --alpha 1.1 -k 2.2 --lambda 3.3 --passes 1000
@@ -63,9 +95,204 @@ Options:
   -k K                  K = 1/(8*pi*G_newton)
   -l --lambda LAMBDA    K * Cosmological constant
   -p --passes PASSES    Number of passes [default: 10000]
+  --slabs               Triangulate the slabs between timeslices in parallel
+                        and stitch them together, with no cache
+  --stream POINTS       Generate and insert points in batches of POINTS, so
+                        startup needs little more memory than the universe
+  --thermalize THERMAL  Passes adapting the move mix before measurement
+                        [default: 0]
+  --anneal              Ramp K up while thermalizing, and stop early once
+                        N3 and the volume profile have converged
+  --batch SIZE          Moves proposed and evaluated together [default: 1]
+  --sequential          Attempt moves one slab at a time
+  --compact             Make moves on a compact 32-bit copy of the
+                        triangulation, copied back after every pass
+  --seed SEED           Seed for the universe and the moves
+  --cache DIR           Load seed universes from, and save them to, DIR
+  --memory-report       Print peak memory and container sizes by phase
+  --telemetry           Publish live statistics for cdt-top in shared memory
+  --control SOCKET      Accept snapshot, pause, resume, status, k, lambda, and
+                        trace requests on a Unix socket between sweeps;
+                        SIGUSR1 snapshots, SIGUSR2 pauses, and SIGCONT resumes
+  --share EVERY         Publish the triangulation in shared memory every
+                        EVERY passes for analysis processes to map
+  --measure FILE        Measure the action, volume profile, vertex profile,
+                        baby universes, and volume-volume correlator on
+                        worker threads, and write them to FILE
+  --measure-every PASSES  Passes between measurements; the vertex profile
+                        and baby universes are measured ten times less
+                        often [default: 1]
+  --trace FILE          Keep the last attempted moves in a ring buffer and
+                        write them to FILE on exit, crash, or a trace
+                        request, with checkpoints in FILE.cdt for cdt-replay
+  --trace-moves MOVES   Moves the ring buffer holds, at least two sweeps
+                        [default: 1048576]
 )"
 };
 
+/// @brief Publishes the state of the run after a sweep
+///
+/// @param[in]     phase      The run phase
+/// @param[in]     pass       Passes completed, thermalization included
+/// @param[in]     passes     Passes planned, thermalization included
+/// @param[in]     start      When the first pass began
+/// @param[in]     metropolis The Metropolis engine
+/// @param[in,out] telemetry  The publisher, or nullptr
+void publish_telemetry(const run_phase phase,
+                       const std::uint64_t pass,
+                       const std::uint64_t passes,
+                       const std::chrono::steady_clock::time_point start,
+                       Metropolis* const metropolis,
+                       Telemetry_publisher* const telemetry) noexcept {
+  if (telemetry == nullptr) return;
+  Telemetry_sample sample{};
+  sample.phase = phase;
+  sample.pass = pass;
+  sample.passes = passes;
+  sample.N1_TL = metropolis->N1_TL();
+  sample.N3_31 = metropolis->N3_31();
+  sample.N3_22 = metropolis->N3_22();
+  sample.action = metropolis->action();
+  auto attempted = static_cast<std::uint64_t>(0);
+  for (auto i = 0u; i < NUMBER_OF_MOVE_TYPES; ++i) {
+    const auto& statistics =
+        metropolis->scheduler().statistics(static_cast<move_type>(i));
+    sample.attempted[i] = statistics.attempted;
+    sample.accepted[i] = statistics.accepted;
+    attempted += statistics.attempted;
+  }
+  sample.elapsed_seconds = seconds_since(start);
+  sample.moves_per_second = (sample.elapsed_seconds > 0.0) ?
+      attempted / sample.elapsed_seconds : 0.0;
+  // Annealing may stop early, so this is an upper bound while thermalizing
+  sample.eta_seconds = (pass > 0) ?
+      sample.elapsed_seconds / pass * (passes - pass) : -1.0;
+  telemetry->publish(sample);
+}  // publish_telemetry()
+
+/// @brief Publishes a snapshot every **every** passes
+///
+/// @param[in]     pass       Passes completed, thermalization included
+/// @param[in]     every      Passes between snapshots
+/// @param[in]     timeslices The number of timeslices
+/// @param[in]     metropolis The Metropolis engine
+/// @param[in,out] shared     The Snapshot_publisher, or nullptr
+void share_snapshot(const std::uint64_t pass,
+                    const std::uint64_t every,
+                    const std::uint64_t timeslices,
+                    Metropolis* const metropolis,
+                    Snapshot_publisher* const shared) noexcept {
+  if (shared == nullptr || every == 0 || pass % every != 0) return;
+  shared->publish(metropolis->triangulation(), timeslices, pass,
+                  metropolis->N1_TL(), metropolis->N3_31(),
+                  metropolis->N3_22());
+}  // share_snapshot()
+
+/// @brief Stamps later moves with **pass**, and checkpoints the universe
+/// once half the trace's ring has filled since the last checkpoint
+///
+/// @param[in]     pass      Passes completed, thermalization included
+/// @param[in,out] snapshots The Snapshot_writer saving checkpoints; while
+///                          it is busy, checkpoints wait for a later pass
+/// @param[in,out] trace     The Move_trace, or nullptr
+void advance_move_trace(const std::uint64_t pass,
+                        Snapshot_writer* const snapshots,
+                        Move_trace* const trace) noexcept {
+  if (trace == nullptr) return;
+  trace->set_pass(pass);
+  if (!trace->finish_checkpoint()) {
+    std::cout << "Cannot save checkpoint " << trace->checkpoint_path()
+              << std::endl;
+  }
+  if (!trace->reaches_checkpoint()) {
+    std::cout << "Move trace lost moves since its checkpoint; "
+              << "raise --trace-moves" << std::endl;
+  }
+  if (trace->needs_checkpoint()) trace->checkpoint(snapshots);
+}  // advance_move_trace()
+
+/// @brief Carries out control requests between sweeps
+///
+/// While the run is paused this waits for requests instead of returning.
+/// Coupling changes take effect from the next sweep.
+///
+/// @param[in]     key        The Universe_key recorded in snapshots
+/// @param[in]     pass       Passes completed, thermalization included
+/// @param[in]     alpha      The current Alpha
+/// @param[in,out] k          The current K
+/// @param[in,out] lambda     The current Lambda
+/// @param[in,out] metropolis The Metropolis engine
+/// @param[in,out] snapshots  The Snapshot_writer
+/// @param[in]     trace      The Move_trace, or nullptr
+/// @param[in,out] control    The Control_channel, or nullptr
+void handle_control(const Universe_key& key,
+                    const std::uint64_t pass,
+                    const long double alpha,
+                    long double* const k,
+                    long double* const lambda,
+                    Metropolis* const metropolis,
+                    Snapshot_writer* const snapshots,
+                    const Move_trace* const trace,
+                    Control_channel* const control) noexcept {
+  if (control == nullptr) return;
+  static constexpr int PAUSED_POLL_MS = 200;
+  auto paused = false;
+  std::vector<Control_request> requests;
+  do {
+    control->poll(&requests, paused ? PAUSED_POLL_MS : 0);
+    for (const auto& request : requests) {
+      switch (request.command) {
+        case control_command::SNAPSHOT: {
+          const auto path = request.path.empty() ?
+              "snapshot-" + std::to_string(getpid()) + "-" +
+              std::to_string(pass) + ".cdt" : request.path;
+          std::cout << (snapshots->start(path, key,
+                                         metropolis->triangulation()) ?
+                        "Writing snapshot " : "Still writing, skipped ")
+                    << path << std::endl;
+          break;
+        }
+        case control_command::PAUSE:
+          if (!paused) std::cout << "Paused after pass " << pass << std::endl;
+          paused = true;
+          break;
+        case control_command::RESUME:
+          if (paused) std::cout << "Resumed" << std::endl;
+          paused = false;
+          break;
+        case control_command::STATUS:
+          std::cout << "Pass " << pass << ": N1_TL = " << metropolis->N1_TL()
+                    << " N3_31 = " << metropolis->N3_31() << " N3_22 = "
+                    << metropolis->N3_22() << " action = "
+                    << metropolis->action() << " K = " << *k
+                    << " Lambda = " << *lambda << std::endl;
+          break;
+        case control_command::SET_K:
+        case control_command::SET_LAMBDA:
+          if (request.command == control_command::SET_K) {
+            *k = request.value;
+          } else {
+            *lambda = request.value;
+          }
+          metropolis->set_coefficients(
+              make_action_coefficients(alpha, *k, *lambda));
+          std::cout << "Couplings now K = " << *k << " Lambda = " << *lambda
+                    << std::endl;
+          break;
+        case control_command::TRACE:
+          if (trace == nullptr) {
+            std::cout << "No move trace is being recorded" << std::endl;
+          } else {
+            std::cout << (trace->write() ? "Move trace written to "
+                                         : "Cannot write move trace ")
+                      << trace->path() << std::endl;
+          }
+          break;
+      }
+    }
+  } while (paused);
+}  // handle_control()
+
 /// @brief The main path of the CDT++ program
 ///
 /// @param[in,out]  argc  Argument count = 1 + number of arguments
@@ -96,6 +323,58 @@ int main(int argc, char* const argv[]) {
   auto k = std::stold(args["-k"].asString());
   auto lambda = std::stold(args["--lambda"].asString());
   auto passes = std::stoul(args["--passes"].asString());
+  auto thermalization = std::stoul(args["--thermalize"].asString());
+  auto anneal = args["--anneal"].asBool();
+  auto batch = std::stoul(args["--batch"].asString());
+  auto sequential = args["--sequential"].asBool();
+  auto compact = args["--compact"].asBool();
+  auto seeded = static_cast<bool>(args["--seed"]);
+  std::random_device random_seed;
+  auto seed = seeded ? std::stoull(args["--seed"].asString())
+                     : static_cast<unsigned long long>(random_seed());
+  auto cache = args["--cache"] ? args["--cache"].asString() : std::string();
+  auto slabs = args["--slabs"].asBool();
+  auto stream = args["--stream"] ? std::stoul(args["--stream"].asString())
+                                 : 0ul;
+  Memory_report memory(args["--memory-report"].asBool());
+  std::unique_ptr<Telemetry_publisher> telemetry;
+  if (args["--telemetry"].asBool()) {
+    telemetry.reset(new Telemetry_publisher(default_telemetry_name(), seed,
+                                            timeslices));
+    std::cout << (telemetry->available() ? "Publishing telemetry as "
+                                         : "Cannot publish telemetry as ")
+              << telemetry->name() << std::endl;
+  }
+  std::unique_ptr<Control_channel> control;
+  if (args["--control"]) {
+    control.reset(new Control_channel(args["--control"].asString()));
+    std::cout << (control->listening() ? "Listening for control requests on "
+                                       : "Cannot listen for control on ")
+              << control->path() << std::endl;
+  }
+  Snapshot_writer snapshots;
+  // Outlives the scheduler, whose workers write measurements to it
+  std::ofstream measurement_file;
+  std::unique_ptr<Measurement_scheduler> measurements;
+  if (args["--measure"]) {
+    const auto every = std::stoull(args["--measure-every"].asString());
+    measurement_file.open(args["--measure"].asString());
+    measurements.reset(new Measurement_scheduler(
+        std::max(std::thread::hardware_concurrency(), 2u) - 1));
+    measurements->stream_to(&measurement_file);
+    measurements->add(action_observable(every));
+    measurements->add(volume_profile_observable(every));
+    measurements->add(vertex_profile_observable(10 * every));
+    // The scheduler's workers already use the other cores
+    measurements->add(minbu_observable(10 * every, 1));
+  }
+  std::unique_ptr<Snapshot_publisher> shared;
+  const auto share_every = args["--share"] ?
+      std::stoull(args["--share"].asString()) : 0ull;
+  if (share_every > 0) {
+    shared.reset(new Snapshot_publisher(default_shared_snapshot_name()));
+    std::cout << "Sharing snapshots as " << shared->name() << std::endl;
+  }
 
   // Topology of simulation
   topology_type topology;
@@ -116,6 +395,14 @@ int main(int argc, char* const argv[]) {
   std::cout << "K = " << k << std::endl;
   std::cout << "Lambda = " << lambda << std::endl;
   std::cout << "Number of passes = " << passes << std::endl;
+  std::cout << "Thermalization passes = " << thermalization
+            << (anneal ? " (annealed)" : "") << std::endl;
+  std::cout << "Batch size = " << batch << std::endl;
+  std::cout << "Sites visited "
+            << (sequential ? "slab by slab" : "uniformly") << std::endl;
+  std::cout << "Moves made on "
+            << (compact ? "the compact triangulation" : "CGAL's cells")
+            << std::endl;
   std::cout << "User = " << getEnvVar("USER") << std::endl;
   std::cout << "Hostname = " << hostname() << std::endl;
 
@@ -135,11 +422,35 @@ int main(int argc, char* const argv[]) {
     return 1;
   }
 
+  memory.begin_phase("construction");
   switch (topology) {
     case topology_type::SPHERICAL:
       if (dimensions == 3) {
-        make_S3_triangulation(simplices, timeslices, false, &Sphere3,
-                              &three_one, &two_two, &one_three);
+        // CGAL::Random takes an unsigned seed, so fold in the high bits
+        const auto point_seed = static_cast<unsigned>(seed ^ (seed >> 32));
+        CGAL::Random slab_rng(point_seed);
+        // Other constructions draw from a fresh generator, so falling back
+        // from slabs gives the same universe as not asking for them
+        CGAL::Random rng(point_seed);
+        if (slabs && make_slab_S3_triangulation(
+                simplices, timeslices,
+                std::max(std::thread::hardware_concurrency(), 1u), &slab_rng,
+                &Sphere3, &three_one, &two_two, &one_three)) {
+          std::cout << "Universe built slab by slab." << std::endl;
+        } else if (stream > 0) {
+          make_streamed_S3_triangulation(simplices, timeslices, stream, false,
+                                         &rng, &Sphere3, &three_one,
+                                         &two_two, &one_three);
+          std::cout << "Universe streamed in batches of " << stream
+                    << " points." << std::endl;
+        } else if (seeded) {
+          make_cached_S3_triangulation(cache, simplices, timeslices, seed,
+                                       false, &Sphere3, &three_one,
+                                       &two_two, &one_three);
+        } else {
+          make_S3_triangulation(simplices, timeslices, false, &Sphere3,
+                                &three_one, &two_two, &one_three);
+        }
       } else {
         std::cout << "Currently, dimensions cannot be higher than 3.";
         std::cout << std::endl;
@@ -151,22 +462,135 @@ int main(int argc, char* const argv[]) {
       break;
   }
 
+  add_triangulation_usage(Sphere3, &memory);
+  add_simplex_vectors_usage(three_one, two_two, one_three, &memory);
+  memory.end_phase();
+
   std::cout << "Universe has been initialized ..." << std::endl;
   std::cout << "Now performing " << passes << " passes of ergodic moves."
             << std::endl;
 
-  // TODO(acgetchell): Ergodic moves using Metropolis algorithm
-  // Initialize data and data structures needed for ergodic moves
-  //
-  // make_23_move(&Sphere3, &two_two) does the (2,2) move
-  // These hold the timelike edges needed for a (3,2) move
-  std::vector<Edge_tuple> V2;
-  auto N1_SL = static_cast<unsigned>(0);
+  // Index vertices and cells by timeslice for the ergodic moves
+  memory.begin_phase("indexing");
+  Timeslice_index index;
+  make_timeslice_index(Sphere3, timeslices, &index);
+  add_index_usage(index, &memory);
+  memory.end_phase();
 
-  // Get timelike edges V2 that make_32_move(&Sphere3, &V2) can be called on
-  get_timelike_edges(Sphere3, &V2, &N1_SL);
+  // Correlations of the volume profile, with one entry per timeslice index
+  Volume_correlator correlator(index.vertices.size(), true);
+  std::mutex correlator_lock;
+  if (measurements) {
+    measurements->add(volume_correlator_observable(
+        std::stoull(args["--measure-every"].asString()), &correlator,
+        &correlator_lock));
+  }
 
-  // Metropolis algorithm to select moves goes here
+  // Metropolis-Hastings algorithm
+  Metropolis metropolis(&Sphere3, &index,
+                        make_action_coefficients(alpha, k, lambda), seed);
+  std::cout << "Random seed = " << metropolis.rng().seed() << std::endl;
+  metropolis.set_batch_size(batch);
+  if (sequential) metropolis.set_sweep_order(site_order::SEQUENTIAL);
+  if (compact && !metropolis.set_move_store(move_store::COMPACT)) {
+    std::cout << "Cannot copy the universe into the compact triangulation."
+              << std::endl;
+  }
+  const auto key = make_universe_key(simplices, timeslices, seed);
+  std::unique_ptr<Move_trace> trace;
+  if (args["--trace"] && compact) {
+    std::cout << "--trace needs the moves made on CGAL's cells, not "
+              << "--compact ... Exiting." << std::endl;
+    return 1;
+  }
+  if (args["--trace"]) {
+    // Checkpoints are only taken between sweeps
+    const auto minimum = 2 * metropolis.number_of_simplices();
+    if (std::stoull(args["--trace-moves"].asString()) < minimum) {
+      std::cout << "--trace-moves must hold two sweeps, at least " << minimum
+                << " moves ... Exiting." << std::endl;
+      return 1;
+    }
+    trace.reset(new Move_trace(Sphere3, key,
+                               std::stoull(args["--trace-moves"].asString()),
+                               args["--trace"].asString()));
+    attach_move_trace(&metropolis, trace.get());
+    write_move_trace_on_crash(trace.get());
+    std::cout << (trace->checkpoint() ? "Tracing moves from checkpoint "
+                                      : "Cannot save checkpoint ")
+              << trace->checkpoint_path() << std::endl;
+  }
+
+  memory.begin_phase("thermalization");
+  const auto start = std::chrono::steady_clock::now();
+  const auto total_passes = static_cast<std::uint64_t>(thermalization) +
+                            passes;
+  auto completed = static_cast<std::uint64_t>(0);
+  publish_telemetry(run_phase::THERMALIZING, completed, total_passes, start,
+                    &metropolis, telemetry.get());
+  if (anneal) {
+    // Control requests wait until the annealing schedule is done
+    auto thermalized = static_cast<std::uint64_t>(0);
+    const auto converged = thermalize_annealed(
+        &metropolis, make_anneal_schedule(alpha, k, lambda, thermalization),
+        &thermalized, [&snapshots, &trace](const std::uint64_t pass) {
+          advance_move_trace(pass, &snapshots, trace.get());
+        });
+    std::cout << (converged ? "Thermalized in " : "Not converged after ")
+              << thermalized << " passes." << std::endl;
+    completed = total_passes - passes;
+    advance_move_trace(completed, &snapshots, trace.get());
+  } else {
+    // As metropolis.thermalize(), publishing after every pass
+    for (; completed < thermalization; ++completed) {
+      metropolis.sweep();
+      publish_telemetry(run_phase::THERMALIZING, completed + 1,
+                        total_passes, start, &metropolis, telemetry.get());
+      share_snapshot(completed + 1, share_every, timeslices, &metropolis,
+                     shared.get());
+      advance_move_trace(completed + 1, &snapshots, trace.get());
+      handle_control(key, completed + 1, alpha, &k, &lambda, &metropolis,
+                     &snapshots, trace.get(), control.get());
+    }
+    metropolis.scheduler().freeze();
+  }
+  add_triangulation_usage(Sphere3, &memory);
+  add_metropolis_usage(metropolis, &memory);
+  memory.end_phase();
+
+  memory.begin_phase("sweeps");
+  for (auto pass = static_cast<decltype(passes)>(0); pass < passes; ++pass) {
+    metropolis.sweep();
+    publish_telemetry(run_phase::SWEEPING, ++completed, total_passes, start,
+                      &metropolis, telemetry.get());
+    share_snapshot(completed, share_every, timeslices, &metropolis,
+                   shared.get());
+    if (measurements) measurements->after_sweep(pass + 1, &metropolis);
+    advance_move_trace(completed, &snapshots, trace.get());
+    handle_control(key, completed, alpha, &k, &lambda, &metropolis,
+                   &snapshots, trace.get(), control.get());
+  }
+  snapshots.wait();
+  if (measurements) measurements->wait();
+  if (trace) {
+    if (!trace->finish_checkpoint()) {
+      std::cout << "Cannot save checkpoint " << trace->checkpoint_path()
+                << std::endl;
+    }
+    std::cout << (trace->write() ? "Move trace written to "
+                                 : "Cannot write move trace ")
+              << trace->path() << std::endl;
+    crash_move_trace() = nullptr;
+  }
+  add_triangulation_usage(Sphere3, &memory);
+  add_index_usage(index, &memory);
+  add_metropolis_usage(metropolis, &memory);
+  memory.end_phase();
+
+  print_move_statistics(metropolis.scheduler());
+  std::cout << "N1_TL = " << metropolis.N1_TL() << " N3_31 = "
+            << metropolis.N3_31() << " N3_22 = " << metropolis.N3_22()
+            << std::endl;
 
   // Output results
   t.stop();  // End running time counter
@@ -176,8 +600,22 @@ int main(int argc, char* const argv[]) {
   // Write results to file
   // TODO(acgetchell): Fixup so that cell->info() and vertex->info() values are
   //                   written
+  memory.begin_phase("output");
   write_file(Sphere3, topology, dimensions, Sphere3.number_of_finite_cells(),
              timeslices);
+  if (measurements) {
+    write_volume_correlator(&correlator, measurement_file);
+    std::cout << "Measurements written to " << args["--measure"].asString()
+              << (measurements->skipped() > 0 ?
+                  " (" + std::to_string(measurements->skipped()) +
+                  " skipped while workers were busy)" : "")
+              << std::endl;
+  }
+  memory.end_phase();
+
+  if (memory.enabled()) print_memory_report(memory, std::cout);
+  publish_telemetry(run_phase::FINISHED, completed, total_passes, start,
+                    &metropolis, telemetry.get());
 
   return 0;
 }
@@ -0,0 +1,311 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Python bindings
+///
+/// The pycdt module makes S3 universes, sweeps them with the Metropolis
+/// engine, saves snapshots, and exports them as NumPy arrays. Arrays are
+/// views of a Triangulation_arrays (or of a shared snapshot segment) which
+/// they keep alive, so nothing is copied between C++ and Python:
+///
+/// ~~~
+/// import pycdt
+/// universe = pycdt.Universe(64000, 16, alpha=1.1, k=2.2, lambda_=3.3,
+///                           seed=42)
+/// universe.sweep(100)
+/// arrays = universe.arrays()
+/// volume = numpy.bincount(arrays.timeslice)
+/// ~~~
+///
+/// Cell arrays have shape (cells, 4), strided over the per-corner arrays.
+/// Shared snapshots are read-only, and stay valid until **current()** is
+/// false.
+///
+/// \done Universes, sweeps, and snapshots
+/// \done Zero-copy NumPy arrays
+/// \done Zero-copy reads of shared snapshots
+
+/// @file pycdt.cpp
+/// @brief Python extension module
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+// pybind11
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+
+// C++ headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "Metropolis.h"
+#include "SeedCache.h"
+#include "SharedSnapshot.h"
+#include "TriangulationArrays.h"
+
+namespace py = pybind11;
+using namespace pybind11::literals;  // NOLINT
+
+/// @brief Stops NumPy writing through a view, since shared snapshots are
+/// mapped read-only and exported arrays are never read back
+template <typename T>
+py::array_t<T> read_only(py::array_t<T> array) {
+  array.attr("setflags")("write"_a = false);
+  return array;
+}  // read_only()
+
+/// @returns A 1-d array viewing **data**, kept alive by **owner**
+template <typename T>
+py::array_t<T> array_view(const T* const data,
+                          const std::uint64_t n,
+                          const py::object& owner) {
+  return read_only(py::array_t<T>({static_cast<py::ssize_t>(n)}, data,
+                                  owner));
+}  // array_view()
+
+/// @returns A (cells, 4) array viewing per-corner arrays **stride** bytes
+/// apart, kept alive by **owner**
+template <typename T>
+py::array_t<T> corner_view(const T* const data,
+                           const std::uint64_t cells,
+                           const std::ptrdiff_t stride,
+                           const py::object& owner) {
+  return read_only(py::array_t<T>(
+      {static_cast<py::ssize_t>(cells), static_cast<py::ssize_t>(4)},
+      {static_cast<py::ssize_t>(sizeof(T)), static_cast<py::ssize_t>(stride)},
+      data, owner));
+}  // corner_view()
+
+/// @brief Exported arrays and the pass they were taken after
+struct Python_arrays {
+  Triangulation_arrays arrays;
+  std::uint64_t pass;
+};
+
+/// @brief A universe evolved by Metropolis, as seen from Python
+class Universe {
+ public:
+  Universe(const unsigned simplices,
+           const unsigned timeslices,
+           const Action_coefficients& coefficients,
+           const std::uint64_t seed,
+           const std::string& cache)
+      : timeslices_(timeslices),
+        key_(make_universe_key(simplices, timeslices, seed)),
+        passes_(0) {
+    make_cached_S3_triangulation(cache, simplices, timeslices, seed, false,
+                                 &D3_, &three_one_, &two_two_, &one_three_);
+    make_timeslice_index(D3_, timeslices_, &index_);
+    metropolis_.reset(new Metropolis(&D3_, &index_, coefficients, seed));
+  }
+
+  void set_couplings(const double alpha, const double k,
+                     const double lambda) {
+    metropolis_->set_coefficients(make_action_coefficients(alpha, k, lambda));
+  }
+
+  /// @returns Moves accepted over **passes** sweeps
+  std::uint64_t sweep(const std::uint64_t passes) {
+    auto accepted = static_cast<std::uint64_t>(0);
+    for (auto pass = static_cast<std::uint64_t>(0); pass < passes; ++pass) {
+      accepted += metropolis_->sweep();
+      passes_++;
+    }
+    return accepted;
+  }
+
+  void thermalize(const std::uint64_t passes) {
+    metropolis_->thermalize(passes);
+    passes_ += passes;
+  }
+
+  void save(const std::string& path) const {
+    if (!save_universe(path, key_, D3_)) {
+      throw std::runtime_error("Could not write " + path);
+    }
+  }
+
+  std::unique_ptr<Python_arrays> arrays() const {
+    std::unique_ptr<Python_arrays> result(new Python_arrays);
+    make_triangulation_arrays(D3_, &result->arrays);
+    result->pass = passes_;
+    return result;
+  }
+
+  Metropolis& metropolis() noexcept { return *metropolis_; }
+  std::uint64_t passes() const noexcept { return passes_; }
+  std::size_t number_of_vertices() const noexcept {
+    return D3_.number_of_vertices();
+  }
+  std::size_t number_of_cells() const noexcept {
+    return D3_.number_of_finite_cells();
+  }
+
+ private:
+  unsigned timeslices_;
+  Universe_key key_;
+  std::uint64_t passes_;
+  Delaunay D3_;
+  std::vector<Cell_handle> three_one_;
+  std::vector<Cell_handle> two_two_;
+  std::vector<Cell_handle> one_three_;
+  Timeslice_index index_;
+  std::unique_ptr<Metropolis> metropolis_;
+};
+
+/// @brief The latest snapshot a running cdt --share publishes
+class Shared_snapshot {
+ public:
+  explicit Shared_snapshot(const std::string& name)
+      : reader_(new Snapshot_reader(name)) {
+    if (!reader_->latest(&view_)) {
+      throw std::runtime_error("No snapshot is shared as " + name);
+    }
+  }
+
+  const Snapshot_view& view() const noexcept { return view_; }
+
+  /// @returns False once the publisher has overwritten this snapshot
+  bool current() const noexcept { return reader_->current(view_); }
+
+ private:
+  std::unique_ptr<Snapshot_reader> reader_;
+  Snapshot_view view_;
+};
+
+PYBIND11_MODULE(pycdt, module) {
+  module.doc() = "Causal Dynamical Triangulations in C++ using CGAL";
+
+  py::class_<Python_arrays>(module, "Arrays",
+                            "A triangulation as NumPy arrays")
+      .def_readonly("passes", &Python_arrays::pass)
+      .def_property_readonly("x", [](py::object self) {
+        const auto& arrays = self.cast<const Python_arrays&>().arrays;
+        return array_view(arrays.x.data(), arrays.x.size(), self);
+      })
+      .def_property_readonly("y", [](py::object self) {
+        const auto& arrays = self.cast<const Python_arrays&>().arrays;
+        return array_view(arrays.y.data(), arrays.y.size(), self);
+      })
+      .def_property_readonly("z", [](py::object self) {
+        const auto& arrays = self.cast<const Python_arrays&>().arrays;
+        return array_view(arrays.z.data(), arrays.z.size(), self);
+      })
+      .def_property_readonly("timeslice", [](py::object self) {
+        const auto& arrays = self.cast<const Python_arrays&>().arrays;
+        return array_view(arrays.timeslice.data(), arrays.timeslice.size(),
+                          self);
+      })
+      .def_property_readonly("cell_type", [](py::object self) {
+        const auto& arrays = self.cast<const Python_arrays&>().arrays;
+        return array_view(arrays.cell_type.data(), arrays.cell_type.size(),
+                          self);
+      })
+      .def_property_readonly("cell_vertices", [](py::object self) {
+        const auto& arrays = self.cast<const Python_arrays&>().arrays;
+        const auto cells = arrays.cell_type.size();
+        return corner_view(arrays.cell_vertices.data(), cells,
+                           cells * sizeof(std::uint32_t), self);
+      })
+      .def_property_readonly("cell_neighbors", [](py::object self) {
+        const auto& arrays = self.cast<const Python_arrays&>().arrays;
+        const auto cells = arrays.cell_type.size();
+        return corner_view(arrays.cell_neighbors.data(), cells,
+                           cells * sizeof(std::int32_t), self);
+      });
+
+  py::class_<Universe>(module, "Universe",
+                       "An S3 universe evolved by the Metropolis algorithm")
+      .def(py::init([](const unsigned simplices, const unsigned timeslices,
+                       const double alpha, const double k,
+                       const double lambda, py::object seed,
+                       const std::string& cache) {
+             std::random_device random_seed;
+             return new Universe(simplices, timeslices,
+                                 make_action_coefficients(alpha, k, lambda),
+                                 seed.is_none() ?
+                                 static_cast<std::uint64_t>(random_seed()) :
+                                 seed.cast<std::uint64_t>(),
+                                 cache);
+           }),
+           py::arg("simplices"), py::arg("timeslices"), py::arg("alpha"),
+           py::arg("k"), py::arg("lambda_"), py::arg("seed") = py::none(),
+           py::arg("cache") = "",
+           "Makes a foliated S3 universe, as make_S3_triangulation()")
+      .def("set_couplings", &Universe::set_couplings, py::arg("alpha"),
+           py::arg("k"), py::arg("lambda_"))
+      .def("sweep", &Universe::sweep, py::arg("passes") = 1,
+           py::call_guard<py::gil_scoped_release>(),
+           "Sweeps the universe, returning the moves accepted")
+      .def("thermalize", &Universe::thermalize, py::arg("passes"),
+           py::call_guard<py::gil_scoped_release>(),
+           "Sweeps while adapting the move mix, then freezes it")
+      .def("save", &Universe::save, py::arg("path"),
+           "Saves a snapshot in the seed cache format")
+      .def("arrays", &Universe::arrays,
+           "Exports the triangulation as NumPy arrays")
+      .def_property_readonly("passes", &Universe::passes)
+      .def_property_readonly("number_of_vertices",
+                             &Universe::number_of_vertices)
+      .def_property_readonly("number_of_cells", &Universe::number_of_cells)
+      .def_property_readonly("N1_TL", [](Universe& universe) {
+        return universe.metropolis().N1_TL();
+      })
+      .def_property_readonly("N3_31", [](Universe& universe) {
+        return universe.metropolis().N3_31();
+      })
+      .def_property_readonly("N3_22", [](Universe& universe) {
+        return universe.metropolis().N3_22();
+      })
+      .def_property_readonly("action", [](Universe& universe) {
+        return universe.metropolis().action();
+      });
+
+  py::class_<Shared_snapshot>(module, "SharedSnapshot",
+                              "The latest snapshot of a cdt --share run, "
+                              "read in place")
+      .def(py::init<const std::string&>(), py::arg("name"))
+      .def("current", &Shared_snapshot::current,
+           "False once the run has overwritten this snapshot")
+      .def_property_readonly("passes", [](const Shared_snapshot& shared) {
+        return shared.view().pass;
+      })
+      .def_property_readonly("x", [](py::object self) {
+        const auto& view = self.cast<const Shared_snapshot&>().view();
+        return array_view(view.x, view.number_of_vertices, self);
+      })
+      .def_property_readonly("y", [](py::object self) {
+        const auto& view = self.cast<const Shared_snapshot&>().view();
+        return array_view(view.y, view.number_of_vertices, self);
+      })
+      .def_property_readonly("z", [](py::object self) {
+        const auto& view = self.cast<const Shared_snapshot&>().view();
+        return array_view(view.z, view.number_of_vertices, self);
+      })
+      .def_property_readonly("timeslice", [](py::object self) {
+        const auto& view = self.cast<const Shared_snapshot&>().view();
+        return array_view(view.timeslice, view.number_of_vertices, self);
+      })
+      .def_property_readonly("cell_type", [](py::object self) {
+        const auto& view = self.cast<const Shared_snapshot&>().view();
+        return array_view(view.cell_type, view.number_of_cells, self);
+      })
+      .def_property_readonly("cell_vertices", [](py::object self) {
+        const auto& view = self.cast<const Shared_snapshot&>().view();
+        // The corner arrays are a fixed distance apart in the segment
+        const auto stride =
+            reinterpret_cast<const char*>(view.cell_vertices[1]) -
+            reinterpret_cast<const char*>(view.cell_vertices[0]);
+        return corner_view(view.cell_vertices[0], view.number_of_cells,
+                           stride, self);
+      });
+}
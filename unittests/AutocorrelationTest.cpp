@@ -0,0 +1,50 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests integrated autocorrelation times against known series.
+
+/// @file AutocorrelationTest.cpp
+/// @brief Tests for autocorrelation of Monte Carlo observables
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "Autocorrelation.h"
+
+using namespace testing;  // NOLINT
+
+TEST(Autocorrelation, IsOneAtLagZero) {
+  const std::vector<double> series{1, 3, 2, 5, 4};
+  const auto rho = autocorrelation(series, 2);
+
+  EXPECT_THAT(rho.size(), Eq(3));
+  EXPECT_THAT(rho[0], DoubleEq(1.0));
+}
+
+TEST(Autocorrelation, ConstantSeriesIsUncorrelated) {
+  const std::vector<double> series(100, 42.0);
+
+  EXPECT_TRUE(autocorrelation(series, 10).empty());
+  EXPECT_THAT(integrated_autocorrelation_time(series), DoubleEq(0.5));
+}
+
+TEST(Autocorrelation, MatchesAnAutoregressiveSeries) {
+  // x(n+1) = phi x(n) + noise has tau_int = (1 + phi) / (2 (1 - phi))
+  const auto phi = 0.8;
+  std::mt19937_64 engine(1);
+  std::normal_distribution<double> noise;
+  std::vector<double> series(100000);
+  auto x = 0.0;
+  for (auto& value : series) {
+    x = phi * x + noise(engine);
+    value = x;
+  }
+
+  EXPECT_THAT(integrated_autocorrelation_time(series), DoubleNear(4.5, 0.5))
+    << "Integrated autocorrelation time is off.";
+}
@@ -0,0 +1,104 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests the measurements, reports, and performance baselines used by the
+/// benchmark programs.
+
+/// @file BenchmarkTest.cpp
+/// @brief Tests for benchmark measurements and reports
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "Benchmark.h"
+
+using namespace testing;  // NOLINT
+
+class BenchmarkReport : public Test {
+ protected:
+  virtual void SetUp() {
+    for (auto size : {1000, 10000}) {
+      Report_row row;
+      add_field(&row, "size", size);
+      add_field(&row, "status", std::string("ok"));
+      add_field(&row, "seconds", 0.5);
+      rows.push_back(row);
+    }
+  }
+
+  std::vector<Report_row> rows;
+};
+
+TEST_F(BenchmarkReport, WritesCsv) {
+  std::ostringstream csv;
+  write_csv(rows, csv);
+
+  EXPECT_THAT(csv.str(), Eq("size,status,seconds\n"
+                            "1000,ok,0.5\n"
+                            "10000,ok,0.5\n"));
+}
+
+TEST_F(BenchmarkReport, WritesJson) {
+  std::ostringstream json;
+  write_json(rows, json);
+
+  EXPECT_THAT(json.str(),
+              HasSubstr("{\"size\": 1000, \"status\": \"ok\", "
+                        "\"seconds\": 0.5}"))
+    << "Numbers should be unquoted and text quoted.";
+  EXPECT_THAT(json.str(), StartsWith("["));
+}
+
+TEST(Benchmark, MeasuresPeakRss) {
+  EXPECT_THAT(peak_rss_kilobytes(), Gt(0));
+}
+
+TEST(PerformanceBaseline, RoundTrips) {
+  const std::string path = "benchmark-test.baseline";
+  Baseline written{{"construction", 12.5}, {"workload.seed", 1},
+                   {"uniform_sweeps", 0.1 + 0.2}};
+
+  ASSERT_TRUE(write_baseline(path, written));
+  Baseline read;
+  ASSERT_TRUE(read_baseline(path, &read));
+  std::remove(path.c_str());
+
+  EXPECT_THAT(read, Eq(written))
+    << "Baselines should be read back exactly.";
+  EXPECT_FALSE(read_baseline("no-such.baseline", &read));
+}
+
+TEST(PerformanceBaseline, FindsRegressionsBeyondTolerance) {
+  Baseline baseline{{"construction", 10.0}, {"uniform_sweeps", 10.0},
+                    {"sequential_sweeps", 10.0}};
+  Baseline measured{{"construction", 14.0}, {"uniform_sweeps", 21.0},
+                    {"sequential_sweeps", 5.0}, {"new_metric", 100.0}};
+
+  const auto regressions = find_regressions(baseline, measured, 0.5);
+
+  ASSERT_THAT(regressions.size(), Eq(1))
+    << "Only costs more than 50% over their baseline should regress.";
+  EXPECT_THAT(regressions.front().name, Eq("uniform_sweeps"));
+  EXPECT_THAT(regressions.front().measured, DoubleEq(21.0));
+}
+
+TEST(PerformanceBaseline, ChecksTheWorkload) {
+  Baseline baseline{{"workload.simplices", 6400}, {"construction", 1.0}};
+  Baseline same{{"workload.simplices", 6400}, {"construction", 9.0}};
+  Baseline different{{"workload.simplices", 64000}, {"construction", 1.0}};
+
+  EXPECT_TRUE(same_workload(baseline, same));
+  EXPECT_FALSE(same_workload(baseline, different))
+    << "Timings of different workloads should not be compared.";
+}
+
+TEST(PerformanceBaseline, Calibrates) {
+  EXPECT_THAT(calibration_seconds(), Gt(0.0));
+}
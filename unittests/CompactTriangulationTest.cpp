@@ -0,0 +1,348 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that the compact triangulation keeps CGAL's combinatorics through
+/// import, moves, and export.
+
+/// @file CompactTriangulationTest.cpp
+/// @brief Tests for the index-based triangulation data structure
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "CompactTriangulation.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+class CompactTriangulationTest : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+    ASSERT_TRUE(make_compact_triangulation(T, &compact));
+  }
+
+  /// @brief Makes the first (2,3) move the compact triangulation accepts
+  ///
+  /// @param[out] top    The vertex opposite the flipped facet
+  /// @param[out] bottom The vertex on its other side
+  /// @returns True if some facet was flipped
+  bool flip_some_facet(std::uint32_t* const top, std::uint32_t* const bottom) {
+    for (auto c = 0u; c < compact.cell_capacity(); ++c) {
+      if (!compact.is_cell(c)) continue;
+      for (auto i = 0; i < 4; ++i) {
+        const auto n = compact.neighbor(c, i);
+        *top = compact.vertex(c, i);
+        *bottom = compact.vertex(n, compact.neighbor_index(n, c));
+        if (compact.flip_23(c, i)) return true;
+      }
+    }
+    return false;
+  }
+
+  /// @returns True if the edge from **top** to **bottom** was flipped back
+  bool flip_back(const std::uint32_t top, const std::uint32_t bottom) {
+    for (auto d = 0u; d < compact.cell_capacity(); ++d) {
+      if (!compact.is_cell(d)) continue;
+      const auto u = compact.index(d, top);
+      const auto v = compact.index(d, bottom);
+      if (u >= 0 && v >= 0) return compact.flip_32(d, u, v);
+    }
+    return false;
+  }
+
+  /// @returns True if **D3** is a valid triangulation with positively
+  /// oriented cells. Delaunay::is_valid() also checks the empty sphere
+  /// property, which no triangulation keeps once flipped.
+  bool is_valid_triangulation(const Delaunay& D3) {
+    return D3.Tr_Base::is_valid();
+  }
+
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  Compact_triangulation compact;
+};
+
+/// @brief The join of two circles, which is a 3-sphere of
+/// **outer** * **inner** cells, none of them infinite
+///
+/// Only its combinatorics are meaningful. A closed 3-sphere cannot be
+/// embedded in space with every cell positively oriented, so its points are
+/// degenerate and every flip on it is refused for orientation as well.
+class CompactJoinTest : public Test {
+ protected:
+  void make_join(const std::uint32_t outer, const std::uint32_t inner) {
+    compact.clear();
+    for (auto i = 0u; i < outer; ++i) compact.add_vertex(Point(i, 0, 0), 0);
+    for (auto j = 0u; j < inner; ++j) compact.add_vertex(Point(0, j, 1), 1);
+    std::vector<std::uint32_t> cells;
+    for (auto i = 0u; i < outer; ++i) {
+      for (auto j = 0u; j < inner; ++j) {
+        cells.push_back(compact.create_cell(1 + i, 1 + (i + 1) % outer,
+                                            1 + outer + j,
+                                            1 + outer + (j + 1) % inner));
+      }
+    }
+    // Glue every pair of cells sharing three vertices
+    for (const auto c : cells) {
+      for (const auto d : cells) {
+        auto shared = 0;
+        auto opposite = -1;
+        for (auto k = 0; k < 4; ++k) {
+          if (compact.index(d, compact.vertex(c, k)) >= 0) {
+            shared++;
+          } else {
+            opposite = k;
+          }
+        }
+        if (shared == 3) compact.set_neighbor(c, opposite, d);
+      }
+    }
+  }
+
+  Compact_triangulation compact;
+};
+
+TEST_F(CompactTriangulationTest, ImportKeepsCountsAndTypes) {
+  EXPECT_TRUE(compact.is_valid());
+  EXPECT_THAT(compact.number_of_vertices(), Eq(T.number_of_vertices()));
+  EXPECT_THAT(compact.number_of_cells(), Eq(T.number_of_cells()));
+  EXPECT_THAT(compact.number_of_finite_cells(),
+              Eq(T.number_of_finite_cells()));
+
+  std::uint64_t N3_31, N3_22, N3_13;
+  compact.classify_cells(&N3_31, &N3_22, &N3_13);
+  EXPECT_THAT(N3_31, Eq(three_one.size()));
+  EXPECT_THAT(N3_22, Eq(two_two.size()));
+  EXPECT_THAT(N3_13, Eq(one_three.size()))
+    << "Classification should agree with classify_3_simplices().";
+}
+
+TEST_F(CompactTriangulationTest, ExportRoundTrips) {
+  Delaunay exported;
+  export_compact_triangulation(compact, &exported);
+
+  EXPECT_TRUE(exported.tds().is_valid());
+  EXPECT_THAT(exported.number_of_vertices(), Eq(T.number_of_vertices()));
+  EXPECT_THAT(exported.number_of_finite_cells(),
+              Eq(T.number_of_finite_cells()));
+
+  Compact_triangulation again;
+  ASSERT_TRUE(make_compact_triangulation(exported, &again));
+  EXPECT_THAT(again.number_of_cells(), Eq(compact.number_of_cells()));
+}
+
+TEST_F(CompactTriangulationTest, UsesMuchLessMemory) {
+  const auto cgal_bytes =
+      T.tds().cells().capacity() * sizeof(Delaunay::Cell) +
+      T.tds().vertices().capacity() * sizeof(Delaunay::Vertex);
+
+  EXPECT_THAT(compact.memory_bytes(), Lt(cgal_bytes * 3 / 5));
+}
+
+TEST_F(CompactTriangulationTest, MovesExportAsValidTriangulations) {
+  auto flipped = false;
+  for (auto c = 0u; c < compact.cell_capacity() && !flipped; ++c) {
+    if (!compact.is_cell(c) || compact.info(c) != 22) continue;
+    for (auto i = 0; i < 4 && !flipped; ++i) {
+      flipped = compact.flip_23(c, i);
+    }
+  }
+  ASSERT_TRUE(flipped) << "Some (2,2) facet should be flippable.";
+  EXPECT_TRUE(compact.is_valid());
+  EXPECT_THAT(compact.number_of_finite_cells(),
+              Eq(T.number_of_finite_cells() + 1));
+
+  Delaunay exported;
+  export_compact_triangulation(compact, &exported);
+  EXPECT_TRUE(is_valid_triangulation(exported))
+    << "Exported triangulation has inverted or degenerate cells.";
+  EXPECT_THAT(exported.number_of_finite_cells(),
+              Eq(T.number_of_finite_cells() + 1));
+}
+
+TEST_F(CompactTriangulationTest, FlipsAgreeWithCGAL) {
+  // Compact vertices are numbered from 1 in CGAL's iteration order
+  std::vector<Vertex_handle> vertices{T.infinite_vertex()};
+  Delaunay::Finite_vertices_iterator vit;
+  for (vit = T.finite_vertices_begin(); vit != T.finite_vertices_end();
+       ++vit) {
+    vertices.push_back(vit);
+  }
+  std::mt19937 rng(42);
+  auto flipped = 0;
+  auto refused = 0;
+
+  for (auto step = 0; step < 4000; ++step) {
+    std::uint32_t c;
+    do {
+      c = static_cast<std::uint32_t>(rng() % compact.cell_capacity());
+    } while (!compact.is_cell(c) || compact.is_infinite(c));
+    Cell_handle cell;
+    std::array<int, 4> position;
+    ASSERT_TRUE(T.is_cell(vertices[compact.vertex(c, 0)],
+                          vertices[compact.vertex(c, 1)],
+                          vertices[compact.vertex(c, 2)],
+                          vertices[compact.vertex(c, 3)], cell, position[0],
+                          position[1], position[2], position[3]))
+      << "Cell " << c << " is not in the CGAL triangulation.";
+
+    const auto i = static_cast<int>(rng() % 4);
+    auto compact_flipped = false;
+    auto cgal_flipped = false;
+    if (step % 2 == 0) {
+      compact_flipped = compact.flip_23(c, i);
+      cgal_flipped = T.flip(cell, position[i]);
+    } else {
+      const auto j = static_cast<int>((i + 1 + rng() % 3) % 4);
+      compact_flipped = compact.flip_32(c, i, j);
+      cgal_flipped = T.flip(cell, position[i], position[j]);
+    }
+    ASSERT_THAT(compact_flipped, Eq(cgal_flipped))
+      << "Step " << step << " was decided differently from CGAL.";
+    if (cgal_flipped) {
+      flipped++;
+    } else {
+      refused++;
+    }
+  }
+
+  EXPECT_THAT(flipped, Gt(0)) << "No flips were made.";
+  EXPECT_THAT(refused, Gt(0)) << "No flips were refused.";
+  EXPECT_TRUE(compact.is_valid());
+  EXPECT_TRUE(is_valid_triangulation(T));
+  EXPECT_THAT(compact.number_of_finite_cells(),
+              Eq(T.number_of_finite_cells()));
+
+  std::uint64_t N3_31, N3_22, N3_13;
+  compact.classify_cells(&N3_31, &N3_22, &N3_13);
+  reclassify_3_simplices(&T, &three_one, &two_two, &one_three);
+  EXPECT_THAT(N3_31, Eq(three_one.size()));
+  EXPECT_THAT(N3_22, Eq(two_two.size()));
+  EXPECT_THAT(N3_13, Eq(one_three.size()))
+    << "Simplex counts differ from CGAL's after the same flips.";
+}
+
+TEST_F(CompactTriangulationTest, FlipsAreInverses) {
+  const auto cells = compact.number_of_cells();
+  std::uint32_t top, bottom;
+
+  ASSERT_TRUE(flip_some_facet(&top, &bottom));
+  EXPECT_TRUE(compact.is_valid()) << "Invalid after the (2,3) move.";
+  EXPECT_THAT(compact.number_of_cells(), Eq(cells + 1));
+  ASSERT_TRUE(compact.is_edge(top, bottom));
+
+  ASSERT_TRUE(flip_back(top, bottom));
+  EXPECT_TRUE(compact.is_valid()) << "Invalid after the (3,2) move.";
+  EXPECT_THAT(compact.number_of_cells(), Eq(cells));
+  EXPECT_FALSE(compact.is_edge(top, bottom));
+}
+
+TEST_F(CompactTriangulationTest, ReusesFreedCells) {
+  const auto cells = compact.number_of_cells();
+  const auto capacity = compact.cell_capacity();
+
+  for (auto round = 0; round < 10; ++round) {
+    std::uint32_t top, bottom;
+    ASSERT_TRUE(flip_some_facet(&top, &bottom));
+    ASSERT_TRUE(flip_back(top, bottom));
+    ASSERT_TRUE(compact.is_valid());
+  }
+
+  EXPECT_THAT(compact.number_of_cells(), Eq(cells));
+  EXPECT_THAT(compact.cell_capacity(), Le(capacity + 3))
+    << "Moves should reuse cells from the free list.";
+}
+
+TEST_F(CompactJoinTest, MakesAValidSphere) {
+  make_join(4, 5);
+
+  EXPECT_TRUE(compact.is_valid());
+  EXPECT_THAT(compact.number_of_cells(), Eq(20));
+  EXPECT_THAT(compact.number_of_finite_cells(), Eq(20));
+  std::uint64_t N3_31, N3_22, N3_13;
+  compact.classify_cells(&N3_31, &N3_22, &N3_13);
+  EXPECT_THAT(N3_22, Eq(20));
+}
+
+TEST_F(CompactJoinTest, RefusesToDuplicateEdges) {
+  // On a join of triangles every pair of vertices shares an edge
+  make_join(3, 3);
+
+  for (auto c = 0u; c < compact.cell_capacity(); ++c) {
+    for (auto i = 0; i < 4; ++i) {
+      EXPECT_FALSE(compact.flip_23(c, i));
+    }
+  }
+  EXPECT_TRUE(compact.is_valid());
+}
+
+TEST_F(CompactJoinTest, FindsEdgesAndFacetsInStars) {
+  make_join(3, 5);
+
+  const auto vertices = static_cast<std::uint32_t>(
+      compact.number_of_vertices());
+  for (auto u = 1u; u <= vertices; ++u) {
+    std::vector<std::uint32_t> star;
+    compact.incident_cells(u, &star);
+    auto in_star = 0u;
+    for (auto c = 0u; c < compact.cell_capacity(); ++c) {
+      if (compact.index(c, u) >= 0) in_star++;
+    }
+    EXPECT_THAT(star.size(), Eq(in_star))
+      << "The star of vertex " << u << " has repeated or missing cells.";
+
+    for (auto v = 1u; v <= vertices; ++v) {
+      if (v == u) continue;
+      auto edge = false;
+      for (const auto c : star) edge = edge || compact.index(c, v) >= 0;
+      EXPECT_THAT(compact.is_edge(u, v), Eq(edge))
+        << "Wrong answer for the edge " << u << "-" << v << ".";
+      for (auto w = v + 1; w <= vertices; ++w) {
+        if (w == u) continue;
+        auto facet = false;
+        for (const auto c : star) {
+          facet = facet || (compact.index(c, v) >= 0 &&
+                            compact.index(c, w) >= 0);
+        }
+        EXPECT_THAT(compact.is_facet(u, v, w), Eq(facet))
+          << "Wrong answer for the facet " << u << "-" << v << "-" << w
+          << ".";
+      }
+    }
+  }
+}
+
+TEST_F(CompactJoinTest, FindsCellsAroundEdgesOfDegreeThree) {
+  // Edges of the outer triangle are in 5 cells, of the inner pentagon in 3
+  make_join(3, 5);
+
+  std::array<std::uint32_t, 3> around;
+  for (auto c = 0u; c < compact.cell_capacity(); ++c) {
+    EXPECT_FALSE(compact.cells_around_edge(c, 0, 1, &around))
+      << "The outer edge of cell " << c << " is not of degree 3.";
+    ASSERT_TRUE(compact.cells_around_edge(c, 2, 3, &around))
+      << "The inner edge of cell " << c << " is of degree 3.";
+    EXPECT_THAT(around[0], Eq(c));
+    for (const auto d : around) {
+      EXPECT_THAT(compact.index(d, compact.vertex(c, 2)), Ge(0));
+      EXPECT_THAT(compact.index(d, compact.vertex(c, 3)), Ge(0))
+        << "Cell " << d << " does not contain the edge.";
+    }
+  }
+}
@@ -0,0 +1,90 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that control requests are parsed, and delivered by socket and by
+/// signal.
+
+/// @file ControlTest.cpp
+/// @brief Tests for the runtime control channel
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <csignal>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "Control.h"
+
+using namespace testing;  // NOLINT
+
+class ControlTest : public Test {
+ protected:
+  const std::string path{"control-test-" + std::to_string(getpid()) +
+                         ".sock"};
+  std::vector<Control_request> requests;
+};
+
+TEST(ControlRequest, Parses) {
+  Control_request request;
+
+  EXPECT_TRUE(parse_control_request("snapshot thermal.cdt", &request));
+  EXPECT_THAT(request.command, Eq(control_command::SNAPSHOT));
+  EXPECT_THAT(request.path, Eq("thermal.cdt"));
+
+  EXPECT_TRUE(parse_control_request("lambda 0.25", &request));
+  EXPECT_THAT(request.command, Eq(control_command::SET_LAMBDA));
+  EXPECT_THAT(static_cast<double>(request.value), DoubleEq(0.25));
+
+  EXPECT_TRUE(parse_control_request("pause\n", &request));
+  EXPECT_THAT(request.command, Eq(control_command::PAUSE));
+
+  EXPECT_TRUE(parse_control_request("trace", &request));
+  EXPECT_THAT(request.command, Eq(control_command::TRACE));
+
+  EXPECT_FALSE(parse_control_request("k", &request))
+    << "Coupling changes need a value.";
+  EXPECT_FALSE(parse_control_request("explode", &request));
+}
+
+TEST_F(ControlTest, ReceivesRequestsOnTheSocket) {
+  Control_channel control(path);
+  ASSERT_TRUE(control.listening());
+
+  control.poll(&requests, 0);
+  EXPECT_THAT(requests, IsEmpty())
+    << "Polling with nothing pending should return at once.";
+
+  EXPECT_TRUE(send_control(path, "k 2.5"));
+  EXPECT_TRUE(send_control(path, "not a request"));
+  EXPECT_TRUE(send_control(path, "resume"));
+  control.poll(&requests, 0);
+
+  ASSERT_THAT(requests.size(), Eq(2))
+    << "Invalid requests should be dropped.";
+  EXPECT_THAT(requests[0].command, Eq(control_command::SET_K));
+  EXPECT_THAT(static_cast<double>(requests[0].value), DoubleEq(2.5));
+  EXPECT_THAT(requests[1].command, Eq(control_command::RESUME));
+}
+
+TEST_F(ControlTest, ReceivesSignals) {
+  Control_channel control("");
+
+  std::raise(SIGUSR1);
+  std::raise(SIGUSR2);
+  control.poll(&requests, 0);
+
+  ASSERT_THAT(requests.size(), Eq(2));
+  EXPECT_THAT(requests[0].command, Eq(control_command::SNAPSHOT));
+  EXPECT_THAT(requests[1].command, Eq(control_command::PAUSE));
+}
+
+TEST_F(ControlTest, RemovesTheSocket) {
+  {
+    Control_channel control(path);
+  }
+
+  EXPECT_FALSE(send_control(path, "status"));
+}
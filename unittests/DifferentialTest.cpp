@@ -0,0 +1,93 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that the Metropolis engine makes the same triangulation and counts
+/// as plain flips, for every kind of sweep.
+
+/// @file DifferentialTest.cpp
+/// @brief Differential tests of the Metropolis engine
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "Differential.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+class DifferentialTest : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+  }
+
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  const std::uint64_t seed{42};
+  const Action_coefficients coefficients{
+      make_action_coefficients(1.1, 2.2, 3.3)};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+};
+
+TEST_F(DifferentialTest, HashIgnoresStorageOrder) {
+  Delaunay copy(T);
+
+  EXPECT_THAT(triangulation_hash(copy), Eq(triangulation_hash(T)))
+    << "A copy should hash the same as the original.";
+}
+
+TEST_F(DifferentialTest, HashSeesAFlip) {
+  Delaunay copy(T);
+  Timeslice_index index;
+  make_timeslice_index(copy, number_of_timeslices, &index);
+  Metropolis metropolis(&copy, &index, coefficients, seed);
+
+  auto accepted = static_cast<std::uint64_t>(0);
+  while (accepted == 0) accepted = metropolis.sweep();
+
+  EXPECT_THAT(triangulation_hash(copy), Ne(triangulation_hash(T)))
+    << "Accepted moves should change the hash.";
+}
+
+TEST_F(DifferentialTest, UniformSweepsMatchFlips) {
+  Differential_tester tester(T, number_of_timeslices, coefficients, seed);
+  std::string difference;
+
+  for (auto pass = 0; pass < 2; ++pass) tester.optimized().sweep();
+
+  EXPECT_THAT(tester.moves(), Gt(0));
+  EXPECT_TRUE(tester.check(&difference)) << difference;
+}
+
+TEST_F(DifferentialTest, SequentialSweepsMatchFlips) {
+  Differential_tester tester(T, number_of_timeslices, coefficients, seed);
+  tester.optimized().set_sweep_order(site_order::SEQUENTIAL);
+  std::string difference;
+
+  for (auto pass = 0; pass < 2; ++pass) tester.optimized().sweep();
+
+  EXPECT_TRUE(tester.check(&difference)) << difference;
+}
+
+TEST_F(DifferentialTest, BatchedSweepsMatchFlips) {
+  Differential_tester tester(T, number_of_timeslices, coefficients, seed);
+  tester.optimized().set_batch_size(64);
+  std::string difference;
+
+  for (auto pass = 0; pass < 2; ++pass) tester.optimized().sweep();
+
+  EXPECT_TRUE(tester.check(&difference)) << difference;
+}
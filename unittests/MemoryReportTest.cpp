@@ -0,0 +1,107 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests per-phase memory accounting. Resetting the high-water mark may not
+/// be permitted in containers, so tests accept cumulative peaks.
+
+/// @file MemoryReportTest.cpp
+/// @brief Tests for per-phase memory accounting
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "MemoryReport.h"
+
+using namespace testing;  // NOLINT
+
+TEST(MemoryReport, DisabledReportRecordsNothing) {
+  Memory_report report(false);
+
+  report.begin_phase("construction");
+  report.add_container("tds_cells", 1, 1);
+  report.end_phase();
+
+  EXPECT_THAT(report.phases(), IsEmpty());
+  EXPECT_THAT(memory_rows(report), IsEmpty());
+}
+
+TEST(MemoryReport, RecordsPeakPerPhase) {
+  Memory_report report(true);
+  std::vector<char> buffer;
+
+  report.begin_phase("allocate");
+  buffer.assign(64 << 20, 1);
+  report.add_container("buffer", buffer.size(), buffer.capacity());
+  report.end_phase();
+  std::vector<char>().swap(buffer);
+
+  report.begin_phase("idle");
+  report.end_phase();
+
+  ASSERT_THAT(report.phases().size(), Eq(2));
+  const auto& allocate = report.phases()[0];
+  const auto& idle = report.phases()[1];
+  EXPECT_THAT(allocate.peak_rss_kilobytes, Ge(64 * 1024))
+    << "Touching 64 MB should raise the peak by at least that much.";
+  EXPECT_THAT(allocate.containers.size(), Eq(1));
+  if (idle.isolated) {
+    EXPECT_THAT(idle.peak_rss_kilobytes, Lt(allocate.peak_rss_kilobytes))
+      << "A reset high-water mark should not include the earlier phase.";
+  }
+}
+
+TEST(MemoryReport, CountsAllocationsPerPhase) {
+  ASSERT_TRUE(counting_allocations())
+    << "unittests/main.cpp should count allocations.";
+  Memory_report report(true);
+
+  report.begin_phase("allocate");
+  {
+    std::vector<char> buffer(1 << 20, 1);
+    std::vector<int> small(16, 1);
+  }
+  report.end_phase();
+  report.begin_phase("idle");
+  report.end_phase();
+
+  const auto& allocate = report.phases()[0];
+  EXPECT_THAT(allocate.allocations, Ge(2))
+    << "Both vectors should have been counted.";
+  EXPECT_THAT(allocate.allocated_bytes, Ge((1 << 20) + 16 * sizeof(int)));
+  EXPECT_THAT(allocate.peak_heap_bytes, Ge(1 << 20))
+    << "The peak should include memory freed before the phase ended.";
+  EXPECT_THAT(report.phases()[1].peak_heap_bytes, Lt(1 << 20))
+    << "The peak should be reset at the start of each phase.";
+}
+
+TEST(MemoryReport, WritesOneRowPerContainer) {
+  Memory_report report(true);
+
+  report.begin_phase("construction");
+  report.add_container("tds_cells", 10, 1000);
+  report.add_container("tds_vertices", 4, 200);
+  report.end_phase();
+  report.begin_phase("output");
+  report.end_phase();
+
+  const auto rows = memory_rows(report);
+  ASSERT_THAT(rows.size(), Eq(3))
+    << "Phases without containers should still get a row.";
+  EXPECT_THAT(rows[1][4].value, Eq("tds_vertices"));
+  EXPECT_THAT(rows[1][6].value, Eq("200"));
+  EXPECT_THAT(rows[2][0].value, Eq("output"));
+}
+
+TEST(IndexedSet, CountsItsMemory) {
+  Indexed_set<int> set;
+  const auto empty = set.memory_bytes();
+
+  for (auto i = 0; i < 1000; ++i) set.insert(i);
+
+  EXPECT_THAT(set.memory_bytes(), Gt(empty + 1000 * sizeof(int)))
+    << "Memory should grow with the vector and the hash map.";
+}
@@ -0,0 +1,190 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that the 1+1 dimensional moves keep the triangulation a valid
+/// torus, that the cosmological constant is critical at ln 2, that the mean
+/// volume matches the transfer matrix, and that volume fixing holds the
+/// volume near its target.
+
+/// @file Metropolis2DTest.cpp
+/// @brief Tests for the 1+1 dimensional Metropolis engine
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <cmath>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "Autocorrelation.h"
+#include "Metropolis2D.h"
+
+using namespace testing;  // NOLINT
+
+class Metropolis2DTest : public Test {
+ protected:
+  virtual void SetUp() {
+    make_2d_triangulation(timeslices, slice_volume, &T2);
+  }
+
+  /// @brief A mean with its standard error
+  struct Estimate {
+    double mean;
+    double error;
+  };
+
+  /// @brief Mean N2 after each of **passes** sweeps, following
+  /// **thermal_passes**, with an error bar from its integrated
+  /// autocorrelation time
+  Estimate mean_volume(Metropolis_2d* const metropolis,
+                       const int thermal_passes,
+                       const int passes) {
+    for (auto pass = 0; pass < thermal_passes; ++pass) metropolis->sweep();
+    std::vector<double> series;
+    for (auto pass = 0; pass < passes; ++pass) {
+      metropolis->sweep();
+      series.push_back(static_cast<double>(T2.number_of_triangles()));
+    }
+    const auto mean = series_mean(series);
+    const auto variance = autocovariance(series, mean, 0);
+    const auto tau = integrated_autocorrelation_time(series);
+    return Estimate{mean, std::sqrt(2.0 * tau * variance / series.size())};
+  }
+
+  /// @brief Exact \f$\langle N_2 \rangle\f$ from the transfer matrix
+  ///
+  /// A slab between slices of l and l' vertices is a cyclic sequence of l
+  /// UP and l' DOWN triangles, so with the weight \f$e^{-\lambda N_2}\f$
+  /// and one over the symmetry factor that the moves sample,
+  /// \f$P(l_0, \ldots, l_{T-1}) \propto \prod_t M_{l_t l_{t+1}}\f$ with
+  /// \f$M_{l l'} = \binom{l + l' - 1}{l - 1} e^{-\lambda (l + l')}\f$,
+  /// for slices of at least MINIMUM_SLICE_VOLUME vertices. Above
+  /// \f$\lambda_c = \ln 2\f$ the entries fall off exponentially, so
+  /// slices longer than **cutoff** are left out.
+  double transfer_matrix_volume(const double lambda,
+                                const std::uint32_t cutoff) {
+    const auto first = MINIMUM_SLICE_VOLUME;
+    const auto n = static_cast<std::size_t>(cutoff - first + 1);
+    std::vector<double> M(n * n);
+    for (auto a = static_cast<std::size_t>(0); a < n; ++a) {
+      for (auto b = static_cast<std::size_t>(0); b < n; ++b) {
+        const auto l = static_cast<double>(first + a);
+        const auto l_next = static_cast<double>(first + b);
+        M[a * n + b] = std::exp(std::lgamma(l + l_next) - std::lgamma(l) -
+                                std::lgamma(l_next + 1.0) -
+                                lambda * (l + l_next));
+      }
+    }
+    auto power = M;
+    for (auto t = 1u; t < timeslices; ++t) {
+      std::vector<double> product(n * n, 0.0);
+      for (auto a = static_cast<std::size_t>(0); a < n; ++a) {
+        for (auto c = static_cast<std::size_t>(0); c < n; ++c) {
+          for (auto b = static_cast<std::size_t>(0); b < n; ++b) {
+            product[a * n + b] += power[a * n + c] * M[c * n + b];
+          }
+        }
+      }
+      power.swap(product);
+    }
+    auto weight = 0.0;
+    auto length = 0.0;
+    for (auto a = static_cast<std::size_t>(0); a < n; ++a) {
+      weight += power[a * n + a];
+      length += (first + a) * power[a * n + a];
+    }
+    // Each slice of l vertices has 2 l triangles in the slabs either side
+    return 2.0 * timeslices * length / weight;
+  }
+
+  const std::uint32_t timeslices{8};
+  const std::uint32_t slice_volume{16};
+  const std::uint64_t seed{42};
+  Triangulation_2d T2;
+};
+
+TEST_F(Metropolis2DTest, MakesAValidTorus) {
+  EXPECT_TRUE(is_valid_2d(T2))
+    << "The initial triangulation should be valid.";
+  EXPECT_THAT(T2.number_of_triangles(), Eq(2 * timeslices * slice_volume));
+  EXPECT_THAT(T2.number_of_vertices(), Eq(timeslices * slice_volume));
+  EXPECT_THAT(T2.slice_volume, Each(Eq(slice_volume)));
+}
+
+TEST_F(Metropolis2DTest, MovesKeepTheTorusValid) {
+  Metropolis_2d metropolis(&T2, std::log(2.0), seed);
+
+  for (auto pass = 0; pass < 100; ++pass) {
+    metropolis.sweep();
+    ASSERT_TRUE(is_valid_2d(T2)) << "Invalid after pass " << pass << ".";
+  }
+
+  EXPECT_THAT(metropolis.accepted(move_2d::TWO_TWO), Gt(0));
+  EXPECT_THAT(metropolis.accepted(move_2d::TWO_FOUR), Gt(0));
+  EXPECT_THAT(metropolis.accepted(move_2d::FOUR_TWO), Gt(0));
+  EXPECT_THAT(T2.slice_volume, Each(Ge(MINIMUM_SLICE_VOLUME)))
+    << "No timeslice should shrink below the minimum.";
+}
+
+TEST_F(Metropolis2DTest, GrowsBelowTheCriticalLambda) {
+  Metropolis_2d metropolis(&T2, 0.5, seed);
+  const auto N2 = T2.number_of_triangles();
+
+  for (auto pass = 0; pass < 20; ++pass) metropolis.sweep();
+
+  EXPECT_THAT(T2.number_of_triangles(), Gt(2 * N2));
+  EXPECT_TRUE(is_valid_2d(T2));
+}
+
+TEST_F(Metropolis2DTest, ShrinksAboveTheCriticalLambda) {
+  Metropolis_2d metropolis(&T2, 1.5, seed);
+
+  for (auto pass = 0; pass < 200; ++pass) metropolis.sweep();
+
+  EXPECT_THAT(T2.number_of_triangles(),
+              Le(4 * 2 * timeslices * MINIMUM_SLICE_VOLUME))
+    << "The universe should collapse to near the minimum size.";
+  EXPECT_TRUE(is_valid_2d(T2));
+}
+
+TEST_F(Metropolis2DTest, ActionIsLambdaTimesN2) {
+  Metropolis_2d metropolis(&T2, 0.7, seed);
+  metropolis.sweep();
+
+  EXPECT_THAT(metropolis.action(),
+              DoubleEq(0.7 * T2.number_of_triangles()));
+}
+
+TEST_F(Metropolis2DTest, MatchesTheTransferMatrix) {
+  const auto lambda = 0.8;
+  Metropolis_2d metropolis(&T2, lambda, seed);
+  const auto exact = transfer_matrix_volume(lambda, 400);
+
+  const auto measured = mean_volume(&metropolis, 2000, 100000);
+
+  EXPECT_THAT(measured.error, Gt(0.0))
+    << "The volume should fluctuate.";
+  EXPECT_THAT(std::abs(measured.mean - exact), Le(4.0 * measured.error))
+    << "<N2> = " << measured.mean << " +/- " << measured.error
+    << " against " << exact << " from the transfer matrix.";
+}
+
+TEST_F(Metropolis2DTest, VolumeFixingHoldsTheTarget) {
+  const auto target = 1000.0;
+  const auto epsilon = 0.01;
+  Metropolis_2d metropolis(&T2, std::log(2.0), seed);
+  metropolis.set_volume_fixing(target, epsilon);
+  const auto N2 = static_cast<double>(T2.number_of_triangles());
+
+  EXPECT_THAT(metropolis.action(),
+              DoubleEq(std::log(2.0) * N2 +
+                       epsilon * (N2 - target) * (N2 - target)));
+
+  const auto measured = mean_volume(&metropolis, 500, 5000);
+
+  // Fluctuations are about 1/sqrt(2 epsilon) = 7 triangles
+  EXPECT_THAT(measured.mean, DoubleNear(target, 0.05 * target))
+    << "Volume fixing should hold N2 near its target.";
+  EXPECT_TRUE(is_valid_2d(T2));
+}
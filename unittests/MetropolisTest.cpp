@@ -0,0 +1,313 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that Metropolis-Hastings sweeps keep the triangulation foliated
+/// and the incrementally tracked counts correct.
+
+/// @file MetropolisTest.cpp
+/// @brief Tests for the Metropolis-Hastings algorithm
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "Autocorrelation.h"
+#include "Metropolis.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+class MetropolisTest : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+    make_timeslice_index(T, number_of_timeslices, &index);
+  }
+
+  /// A sample mean and its statistical error
+  struct Estimate {
+    double mean;
+    double error;
+  };
+
+  /// @brief Mean fraction of (2,2) simplices in a copy of **T**, with an
+  /// error bar from its integrated autocorrelation time
+  ///
+  /// Thermalizes a copy for **thermal_passes** with the given batch size,
+  /// site order, and move store, then measures N3_22 / N3 after each of
+  /// **passes** further sweeps.
+  Estimate two_two_fraction(const std::size_t batch_size,
+                            const site_order order,
+                            const std::uint64_t thermal_passes,
+                            const std::uint64_t passes,
+                            const move_store store = move_store::CGAL) {
+    Delaunay copy(T);
+    Timeslice_index copy_index;
+    make_timeslice_index(copy, number_of_timeslices, &copy_index);
+    Metropolis metropolis(&copy, &copy_index,
+                          make_action_coefficients(1.1, 2.2, 3.3), seed);
+    metropolis.set_batch_size(batch_size);
+    metropolis.set_sweep_order(order);
+    EXPECT_TRUE(metropolis.set_move_store(store));
+    metropolis.thermalize(thermal_passes);
+    std::vector<double> series;
+    for (auto pass = static_cast<std::uint64_t>(0); pass < passes; ++pass) {
+      metropolis.sweep();
+      series.push_back(static_cast<double>(metropolis.N3_22()) /
+                       metropolis.number_of_simplices());
+    }
+    const auto mean = series_mean(series);
+    const auto variance = autocovariance(series, mean, 0);
+    const auto tau = integrated_autocorrelation_time(series);
+    return Estimate{mean, std::sqrt(2.0 * tau * variance / series.size())};
+  }
+
+  /// @brief Expects two estimates to agree within four standard errors
+  void expect_agree(const Estimate& a, const Estimate& b,
+                    const std::string& message) {
+    const auto error = std::sqrt(a.error * a.error + b.error * b.error);
+    EXPECT_THAT(error, Gt(0.0))
+      << "The series should fluctuate.";
+    EXPECT_THAT(std::abs(a.mean - b.mean), Le(4.0 * error))
+      << message << " " << a.mean << " +/- " << a.error << " against "
+      << b.mean << " +/- " << b.error << ".";
+  }
+
+  const bool no_output{false};
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  const std::uint64_t seed{42};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  Timeslice_index index;
+};
+
+TEST_F(MetropolisTest, ActionCoefficientsAreLinear) {
+  const auto coefficients = make_action_coefficients(1.1, 2.2, 3.3);
+  const Move_delta delta{2, 3, 5};
+
+  EXPECT_THAT(action_change(delta, coefficients),
+              DoubleNear(CGAL::to_double(S3_bulk_action(2, 3, 5, 1.1, 2.2,
+                                                        3.3)), 1e-6))
+    << "The bulk action should be linear in N1_TL, N3_31, and N3_22.";
+}
+
+TEST_F(MetropolisTest, SweepKeepsCountsCurrent) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  metropolis.sweep();
+
+  auto N1_TL = static_cast<unsigned>(0);
+  auto N1_SL = static_cast<unsigned>(0);
+  classify_edges(T, &N1_TL, &N1_SL);
+  reclassify_3_simplices(&T, &three_one, &two_two, &one_three);
+
+  EXPECT_TRUE(T.tds().is_valid())
+    << "Triangulation is invalid.";
+
+  EXPECT_THAT(metropolis.N1_TL(), Eq(N1_TL))
+    << "Timelike edges were not tracked correctly.";
+
+  EXPECT_THAT(metropolis.N3_22(), Eq(two_two.size()))
+    << "(2,2) simplices were not tracked correctly.";
+
+  EXPECT_THAT(metropolis.N3_31(), Eq(three_one.size() + one_three.size()))
+    << "(3,1) and (1,3) simplices were not tracked correctly.";
+}
+
+TEST_F(MetropolisTest, SameSeedGivesSameEvolution) {
+  Delaunay copy(T);
+  Timeslice_index copy_index;
+  make_timeslice_index(copy, number_of_timeslices, &copy_index);
+  const auto coefficients = make_action_coefficients(1.1, 2.2, 3.3);
+
+  Metropolis first(&T, &index, coefficients, seed);
+  Metropolis second(&copy, &copy_index, coefficients, seed);
+  first.scheduler().freeze();
+  second.scheduler().freeze();
+  first.sweep();
+  second.sweep();
+
+  EXPECT_THAT(first.N3_22(), Eq(second.N3_22()));
+  EXPECT_THAT(first.N1_TL(), Eq(second.N1_TL()));
+  EXPECT_THAT(first.rng().draws(), Eq(second.rng().draws()));
+}
+
+TEST_F(MetropolisTest, ThermalizationFreezesTheMix) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  metropolis.thermalize(1);
+
+  EXPECT_TRUE(metropolis.scheduler().frozen());
+  EXPECT_THAT(metropolis.scheduler().statistics(move_type::TWO_THREE)
+              .attempted, Gt(0));
+}
+
+TEST_F(MetropolisTest, FrozenSweepsAreNotTimed) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  metropolis.thermalize(1);
+  const auto before = metropolis.scheduler().statistics(move_type::TWO_THREE);
+  ASSERT_THAT(before.seconds, Gt(0.0));
+
+  metropolis.sweep();
+
+  const auto& after = metropolis.scheduler().statistics(move_type::TWO_THREE);
+  EXPECT_THAT(after.attempted, Gt(before.attempted))
+    << "Frozen sweeps should still count attempts.";
+  EXPECT_THAT(after.seconds, DoubleEq(before.seconds))
+    << "Frozen sweeps should not read the clock.";
+}
+
+TEST_F(MetropolisTest, SweepAdaptsTheMix) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  const auto& scheduler = metropolis.scheduler();
+  ASSERT_THAT(scheduler.probability(move_type::TWO_THREE), DoubleEq(0.5));
+
+  metropolis.sweep();
+
+  EXPECT_THAT(scheduler.probability(move_type::TWO_THREE),
+              Not(DoubleEq(0.5)))
+    << "The mix of (2,3) and (3,2) moves did not adapt.";
+
+  EXPECT_THAT(scheduler.probability(move_type::TWO_THREE) +
+              scheduler.probability(move_type::THREE_TWO), DoubleEq(1.0))
+    << "Disabled moves were given a share.";
+}
+
+TEST(ProposalBatch, EvaluatesEveryProposal) {
+  Proposal_batch batch;
+  batch.resize(3);
+  const Action_coefficients coefficients{1.0, 2.0, 3.0};
+  for (auto k = 0u; k < batch.size(); ++k) {
+    batch.N1_TL[k] = k;
+    batch.N3_31[k] = -1;
+    batch.N3_22[k] = 1;
+    batch.ratio[k] = 0.5;
+  }
+
+  evaluate_batch(coefficients, &batch);
+
+  for (auto k = 0u; k < batch.size(); ++k) {
+    const Move_delta delta{batch.N1_TL[k], batch.N3_31[k], batch.N3_22[k]};
+    EXPECT_THAT(batch.weight[k],
+                DoubleEq(0.5 * std::exp(-action_change(delta, coefficients))))
+      << "Batched weight differs from the sequential one.";
+  }
+}
+
+TEST_F(MetropolisTest, BatchedSweepKeepsCountsCurrent) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  metropolis.set_batch_size(64);
+  EXPECT_THAT(metropolis.sweep(), Gt(0))
+    << "No batched moves were accepted.";
+
+  auto N1_TL = static_cast<unsigned>(0);
+  auto N1_SL = static_cast<unsigned>(0);
+  classify_edges(T, &N1_TL, &N1_SL);
+  reclassify_3_simplices(&T, &three_one, &two_two, &one_three);
+
+  EXPECT_TRUE(T.tds().is_valid())
+    << "Triangulation is invalid.";
+
+  EXPECT_THAT(metropolis.N1_TL(), Eq(N1_TL))
+    << "Timelike edges were not tracked correctly.";
+
+  EXPECT_THAT(metropolis.N3_22(), Eq(two_two.size()))
+    << "(2,2) simplices were not tracked correctly.";
+
+  EXPECT_THAT(metropolis.N3_31(), Eq(three_one.size() + one_three.size()))
+    << "(3,1) and (1,3) simplices were not tracked correctly.";
+}
+
+TEST_F(MetropolisTest, BatchedSweepSamplesTheSameDistribution) {
+  const auto sequential = two_two_fraction(1, site_order::UNIFORM, 50, 400);
+  const auto batched = two_two_fraction(64, site_order::UNIFORM, 50, 400);
+
+  expect_agree(batched, sequential,
+               "Batched sweeps sample a different mean N3_22 / N3:");
+}
+
+TEST_F(MetropolisTest, SequentialSweepKeepsCountsCurrent) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  metropolis.set_sweep_order(site_order::SEQUENTIAL);
+  EXPECT_THAT(metropolis.sweep(), Gt(0))
+    << "No sequential moves were accepted.";
+
+  auto N1_TL = static_cast<unsigned>(0);
+  auto N1_SL = static_cast<unsigned>(0);
+  classify_edges(T, &N1_TL, &N1_SL);
+  reclassify_3_simplices(&T, &three_one, &two_two, &one_three);
+
+  EXPECT_TRUE(T.tds().is_valid())
+    << "Triangulation is invalid.";
+
+  EXPECT_THAT(metropolis.N1_TL(), Eq(N1_TL))
+    << "Timelike edges were not tracked correctly.";
+
+  EXPECT_THAT(metropolis.N3_22(), Eq(two_two.size()))
+    << "(2,2) simplices were not tracked correctly.";
+}
+
+TEST_F(MetropolisTest, SequentialSweepSamplesTheSameDistribution) {
+  const auto uniform = two_two_fraction(1, site_order::UNIFORM, 50, 400);
+  const auto sequential = two_two_fraction(1, site_order::SEQUENTIAL, 50,
+                                           400);
+
+  expect_agree(sequential, uniform,
+               "Sequential sweeps sample a different mean N3_22 / N3:");
+}
+
+TEST_F(MetropolisTest, CompactSweepKeepsCountsAndIndexCurrent) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  ASSERT_TRUE(metropolis.set_move_store(move_store::COMPACT));
+  EXPECT_THAT(metropolis.sweep(), Gt(0))
+    << "No compact moves were accepted.";
+
+  auto N1_TL = static_cast<unsigned>(0);
+  auto N1_SL = static_cast<unsigned>(0);
+  classify_edges(T, &N1_TL, &N1_SL);
+  reclassify_3_simplices(&T, &three_one, &two_two, &one_three);
+
+  EXPECT_TRUE(T.tds().is_valid())
+    << "The exported triangulation is invalid.";
+
+  EXPECT_THAT(metropolis.N1_TL(), Eq(N1_TL))
+    << "Timelike edges were not tracked correctly.";
+
+  EXPECT_THAT(metropolis.N3_22(), Eq(two_two.size()))
+    << "(2,2) simplices were not tracked correctly.";
+
+  EXPECT_THAT(metropolis.N3_31(), Eq(three_one.size() + one_three.size()))
+    << "(3,1) and (1,3) simplices were not tracked correctly.";
+
+  auto indexed = static_cast<std::size_t>(0);
+  for (const auto& slab : index.two_two) indexed += slab.size();
+  EXPECT_THAT(indexed, Eq(two_two.size()))
+    << "The Timeslice_index was not rebuilt after the sweep.";
+}
+
+TEST_F(MetropolisTest, CompactSweepSamplesTheSameDistribution) {
+  const auto cgal = two_two_fraction(1, site_order::UNIFORM, 50, 400);
+  const auto compact = two_two_fraction(1, site_order::UNIFORM, 50, 400,
+                                        move_store::COMPACT);
+
+  expect_agree(compact, cgal,
+               "Compact sweeps sample a different mean N3_22 / N3:");
+}
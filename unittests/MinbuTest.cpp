@@ -0,0 +1,163 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that minimal necks are found and their baby universes nested.
+
+/// @file MinbuTest.cpp
+/// @brief Tests for minimal-neck baby universe trees
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "Minbu.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+/// An octahedron on timeslice 1, with a cap glued on one face and a second
+/// cap glued on the first, each under a (3,1) simplex with apex on
+/// timeslice 2
+class MinbuCapTest : public Test {
+ protected:
+  void make_arrays(const std::vector<std::array<std::uint32_t, 3>>& slice) {
+    const auto cells = slice.size();
+    arrays.timeslice.assign(apex + 1, 1);
+    arrays.timeslice[apex] = 2;
+    arrays.cell_vertices.resize(4 * cells);
+    arrays.cell_type.assign(cells, 31);
+    for (auto c = static_cast<std::size_t>(0); c < cells; ++c) {
+      for (auto k = 0u; k < 3; ++k) {
+        arrays.cell_vertices[k * cells + c] = slice[c][k];
+      }
+      arrays.cell_vertices[3 * cells + c] = apex;
+    }
+  }
+
+  const std::uint32_t apex{8};
+  const std::vector<std::array<std::uint32_t, 3>> octahedron{
+      {{0, 1, 2}}, {{0, 2, 3}}, {{0, 3, 4}}, {{0, 4, 1}},
+      {{5, 1, 2}}, {{5, 2, 3}}, {{5, 3, 4}}, {{5, 4, 1}}};
+  // The octahedron with face 012 replaced by a cone to 6, then face 016 of
+  // that by a cone to 7
+  const std::vector<std::array<std::uint32_t, 3>> capped{
+      {{0, 2, 3}}, {{0, 3, 4}}, {{0, 4, 1}}, {{5, 1, 2}},
+      {{5, 2, 3}}, {{5, 3, 4}}, {{5, 4, 1}}, {{1, 2, 6}},
+      {{2, 0, 6}}, {{0, 1, 7}}, {{1, 6, 7}}, {{6, 0, 7}}};
+  Triangulation_arrays arrays;
+  Minbu_tree tree;
+};
+
+TEST_F(MinbuCapTest, SmoothSliceHasNoBabies) {
+  make_arrays(octahedron);
+  find_minbus(arrays, 1, &tree);
+
+  EXPECT_THAT(tree.babies, IsEmpty())
+    << "An octahedron has a minimal neck.";
+
+  EXPECT_THAT(tree.slice_volume[1], Eq(8))
+    << "Slice volume is not the octahedron's.";
+}
+
+TEST_F(MinbuCapTest, FindsNestedNecks) {
+  make_arrays(capped);
+  find_minbus(arrays, 1, &tree);
+
+  ASSERT_THAT(tree.babies.size(), Eq(2))
+    << "Both caps should be baby universes.";
+
+  EXPECT_THAT(tree.slice_volume[1], Eq(12))
+    << "Slice volume is wrong.";
+
+  const auto& inner = tree.babies[0];
+  const auto& outer = tree.babies[1];
+  EXPECT_THAT(inner.timeslice, Eq(1))
+    << "Baby universe is on the wrong timeslice.";
+
+  EXPECT_THAT(inner.neck, ElementsAre(0, 1, 6))
+    << "Inner cap's neck is wrong.";
+
+  EXPECT_THAT(inner.volume, Eq(3))
+    << "Inner cap's volume is wrong.";
+
+  EXPECT_THAT(outer.neck, ElementsAre(0, 1, 2))
+    << "Outer cap's neck is wrong.";
+
+  EXPECT_THAT(outer.volume, Eq(5))
+    << "Outer cap's volume is wrong.";
+
+  EXPECT_THAT(inner.parent, Eq(1))
+    << "Inner cap does not grow out of the outer cap.";
+
+  EXPECT_THAT(outer.parent, Eq(MOTHER_UNIVERSE))
+    << "Outer cap does not grow out of the slice.";
+}
+
+class MinbuTest : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+    make_triangulation_arrays(T, &arrays);
+  }
+
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  Triangulation_arrays arrays;
+};
+
+TEST_F(MinbuTest, BabiesAreTheSmallerSide) {
+  Minbu_tree tree;
+  find_minbus(arrays, 1, &tree);
+
+  for (const auto& baby : tree.babies) {
+    ASSERT_THAT(baby.timeslice, Lt(tree.slice_volume.size()))
+      << "Baby universe on a timeslice that does not exist.";
+
+    EXPECT_THAT(2 * baby.volume, Le(tree.slice_volume[baby.timeslice]))
+      << "Baby universe is more than half its slice.";
+
+    if (baby.parent != MOTHER_UNIVERSE) {
+      const auto& parent = tree.babies[baby.parent];
+      EXPECT_THAT(parent.timeslice, Eq(baby.timeslice))
+        << "Parent is on another timeslice.";
+
+      EXPECT_THAT(parent.volume, Gt(baby.volume))
+        << "Parent is no larger than its child.";
+    }
+  }
+}
+
+TEST_F(MinbuTest, ThreadsAgree) {
+  Minbu_tree serial;
+  Minbu_tree parallel;
+  find_minbus(arrays, 1, &serial);
+  find_minbus(arrays, 4, &parallel);
+
+  EXPECT_THAT(parallel.slice_volume, ContainerEq(serial.slice_volume))
+    << "Slice volumes depend on the number of threads.";
+
+  ASSERT_THAT(parallel.babies.size(), Eq(serial.babies.size()))
+    << "Number of baby universes depends on the number of threads.";
+
+  for (auto i = static_cast<std::size_t>(0); i < serial.babies.size(); ++i) {
+    EXPECT_THAT(parallel.babies[i].neck, ContainerEq(serial.babies[i].neck))
+      << "Necks depend on the number of threads.";
+
+    EXPECT_THAT(parallel.babies[i].parent, Eq(serial.babies[i].parent))
+      << "Tree depends on the number of threads.";
+  }
+}
@@ -0,0 +1,127 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that the move scheduler picks moves according to its mix, adapts
+/// the mix toward productive moves, and stops adapting when frozen.
+
+/// @file MoveSchedulerTest.cpp
+/// @brief Tests for the adaptive move scheduler
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <array>
+
+#include "gmock/gmock.h"
+#include "MoveScheduler.h"
+#include "Random.h"
+
+using namespace testing;  // NOLINT
+
+class MoveScheduler : public Test {
+ protected:
+  /// Records **n** attempts of **move** with the given outcome and cost
+  void record(const move_type move, const unsigned n, const bool accepted,
+              const double seconds) {
+    for (auto i = 0u; i < n; ++i) scheduler.record(move, accepted, seconds);
+  }
+
+  Move_scheduler scheduler{std::array<double, NUMBER_OF_MOVE_TYPES>{
+    {1, 1, 1, 1}}};
+};
+
+TEST(RandomEngine, IsReproducibleAndCounts) {
+  Random_engine first(42);
+  Random_engine second(42);
+
+  for (auto i = 0; i < 100; ++i) {
+    EXPECT_THAT(first.uniform_index(1000), Eq(second.uniform_index(1000)));
+  }
+  EXPECT_THAT(first.draws(), Eq(100))
+    << "Each helper should consume exactly one draw.";
+
+  second.discard(5);
+  first.uniform_real();
+  first.uniform_real();
+  first.uniform_real();
+  first.uniform_real();
+  first.uniform_real();
+  EXPECT_THAT(first(), Eq(second()))
+    << "discard() should skip ahead in the same stream.";
+}
+
+TEST_F(MoveScheduler, StartsWithNormalizedMix) {
+  auto sum = 0.0;
+  for (auto i = 0u; i < NUMBER_OF_MOVE_TYPES; ++i) {
+    sum += scheduler.probability(static_cast<move_type>(i));
+  }
+  EXPECT_THAT(sum, DoubleEq(1.0));
+  EXPECT_THAT(scheduler.probability(move_type::TWO_THREE), DoubleEq(0.25));
+}
+
+TEST_F(MoveScheduler, NeverChoosesDisabledMoves) {
+  Move_scheduler flips_only{std::array<double, NUMBER_OF_MOVE_TYPES>{
+    {1, 1, 0, 0}}};
+  Random_engine rng(1);
+  for (auto i = 0; i < 1000; ++i) {
+    EXPECT_THAT(flips_only.choose(&rng),
+                AnyOf(Eq(move_type::TWO_THREE), Eq(move_type::THREE_TWO)));
+  }
+}
+
+TEST_F(MoveScheduler, AdaptsTowardCheapAcceptedMoves) {
+  // (2,3)/(3,2) are cheap and usually accepted
+  record(move_type::TWO_THREE, 100, true, 1e-6);
+  record(move_type::THREE_TWO, 100, true, 1e-6);
+  // (2,6)/(6,2) are expensive and usually rejected
+  record(move_type::TWO_SIX, 100, false, 1e-4);
+  record(move_type::SIX_TWO, 10, true, 1e-4);
+
+  scheduler.adapt();
+
+  EXPECT_THAT(scheduler.probability(move_type::TWO_THREE),
+              Gt(scheduler.probability(move_type::TWO_SIX)));
+  EXPECT_THAT(scheduler.probability(move_type::TWO_THREE),
+              DoubleEq(scheduler.probability(move_type::THREE_TWO)))
+    << "Equally accepted inverse moves should be proposed equally often.";
+  EXPECT_THAT(scheduler.probability(move_type::TWO_SIX) +
+              scheduler.probability(move_type::SIX_TWO),
+              Ge(Move_scheduler::MIN_PAIR_PROBABILITY))
+    << "Every enabled move should stay in play.";
+}
+
+TEST_F(MoveScheduler, AdaptsWithinTheOnlyEnabledPair) {
+  // As Metropolis builds it, with (2,6) and (6,2) disabled
+  Move_scheduler flips_only{std::array<double, NUMBER_OF_MOVE_TYPES>{
+    {1, 1, 0, 0}}};
+  for (auto i = 0; i < 100; ++i) {
+    flips_only.record(move_type::TWO_THREE, i < 60, 1e-6);
+    flips_only.record(move_type::THREE_TWO, i < 20, 1e-6);
+  }
+
+  flips_only.adapt();
+
+  EXPECT_THAT(flips_only.probability(move_type::TWO_THREE),
+              Gt(flips_only.probability(move_type::THREE_TWO)))
+    << "The more often accepted move should be proposed more often.";
+  EXPECT_THAT(flips_only.probability(move_type::TWO_THREE) +
+              flips_only.probability(move_type::THREE_TWO), DoubleEq(1.0));
+  EXPECT_THAT(flips_only.probability(move_type::THREE_TWO),
+              Ge(Move_scheduler::MIN_MOVE_FRACTION))
+    << "Every enabled move should stay in play.";
+  EXPECT_THAT(flips_only.probability(move_type::TWO_SIX), Eq(0.0));
+}
+
+TEST_F(MoveScheduler, StopsAdaptingWhenFrozen) {
+  scheduler.freeze();
+  record(move_type::TWO_THREE, 100, true, 1e-6);
+  record(move_type::TWO_SIX, 100, false, 1e-4);
+
+  scheduler.adapt();
+
+  EXPECT_TRUE(scheduler.frozen());
+  EXPECT_THAT(scheduler.probability(move_type::TWO_THREE), DoubleEq(0.25));
+  EXPECT_THAT(scheduler.statistics(move_type::TWO_THREE).accepted, Eq(100))
+    << "Statistics should still be recorded when frozen.";
+}
@@ -0,0 +1,257 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that move traces record every attempt, and replay from their
+/// checkpoint to the same triangulation as the traced run.
+
+/// @file MoveTraceTest.cpp
+/// @brief Tests for move traces and their replay
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "MoveTrace.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+class MoveTraceTest : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+    make_timeslice_index(T, number_of_timeslices, &index);
+  }
+
+  virtual void TearDown() {
+    unlink(path.c_str());
+    unlink((path + ".cdt").c_str());
+    unlink((path + ".cdt.pending").c_str());
+  }
+
+  /// @brief Sweeps **passes** times with a trace, then replays it
+  void trace_and_replay(const std::size_t batch_size,
+                        const std::uint64_t passes) {
+    Metropolis metropolis(&T, &index,
+                          make_action_coefficients(1.1, 2.2, 3.3), seed);
+    metropolis.set_batch_size(batch_size);
+    Move_trace trace(T, key, capacity, path);
+    attach_move_trace(&metropolis, &trace);
+    ASSERT_TRUE(trace.checkpoint());
+    for (auto pass = static_cast<std::uint64_t>(0); pass < passes; ++pass) {
+      metropolis.sweep();
+    }
+    ASSERT_TRUE(trace.write());
+
+    Move_trace_file file;
+    ASSERT_TRUE(read_move_trace(path, &file));
+    Delaunay U;
+    std::vector<Cell_handle> U_three_one;
+    std::vector<Cell_handle> U_two_two;
+    std::vector<Cell_handle> U_one_three;
+    ASSERT_TRUE(load_universe(path + ".cdt", key, &U, &U_three_one,
+                              &U_two_two, &U_one_three));
+    Timeslice_index U_index;
+    make_timeslice_index(U, number_of_timeslices, &U_index);
+    Replay_result result;
+    ASSERT_TRUE(replay_move_trace(file, &U, &U_index, &result));
+
+    EXPECT_THAT(result.missing, Eq(0))
+      << "Replayed moves were not found.";
+
+    EXPECT_THAT(result.replayed, Gt(0))
+      << "No moves were replayed.";
+
+    Metropolis replayed(&U, &U_index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+    EXPECT_THAT(replayed.N1_TL(), Eq(metropolis.N1_TL()))
+      << "Replay ended with a different N1_TL.";
+
+    EXPECT_THAT(replayed.N3_31(), Eq(metropolis.N3_31()))
+      << "Replay ended with a different N3_31.";
+
+    EXPECT_THAT(replayed.N3_22(), Eq(metropolis.N3_22()))
+      << "Replay ended with a different N3_22.";
+
+    EXPECT_THAT(file.header.checkpoint_hash, Ne(file.header.final_hash))
+      << "The sweeps did not change the triangulation.";
+
+    EXPECT_THAT(triangulation_hash(U), Eq(file.header.final_hash))
+      << "Replay ended with a different triangulation.";
+
+    EXPECT_THAT(file.header.final_hash, Eq(triangulation_hash(T)))
+      << "Trace recorded the wrong final hash.";
+
+    EXPECT_THAT(file.header.final_counts,
+                ElementsAre(metropolis.N1_TL(), metropolis.N3_31(),
+                            metropolis.N3_22()))
+      << "Trace recorded the wrong final counts.";
+
+    EXPECT_TRUE(U.tds().is_valid())
+      << "Replayed triangulation is invalid.";
+  }
+
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  const std::uint64_t seed{42};
+  const std::size_t capacity{1 << 20};
+  const Universe_key key{make_universe_key(number_of_simplices,
+                                           number_of_timeslices, seed)};
+  const std::string path{"MoveTraceTest-" + std::to_string(getpid()) +
+                         ".trace"};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  Timeslice_index index;
+};
+
+TEST_F(MoveTraceTest, RecordsEveryAttempt) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  Move_trace trace(T, key, capacity, path);
+  attach_move_trace(&metropolis, &trace);
+  const auto attempts = metropolis.number_of_simplices();
+  const auto accepted = metropolis.sweep();
+
+  EXPECT_THAT(trace.recorded(), Eq(attempts))
+    << "Not every attempted move was recorded.";
+
+  ASSERT_TRUE(trace.write());
+  Move_trace_file file;
+  ASSERT_TRUE(read_move_trace(path, &file));
+  auto traced = static_cast<std::uint64_t>(0);
+  for (const auto& record : file.records) {
+    if (record.outcome == static_cast<std::uint8_t>(move_outcome::ACCEPTED)) {
+      traced++;
+    }
+  }
+  EXPECT_THAT(file.records.size(), Eq(attempts))
+    << "The trace does not hold every attempt.";
+
+  // Accepted moves CGAL refused to make are still traced as accepted
+  EXPECT_THAT(traced, Eq(accepted + metropolis.refused()))
+    << "The trace has the wrong number of accepted moves.";
+
+  EXPECT_THAT(file.records.back().draws, Eq(metropolis.rng().draws()))
+    << "The last record does not carry the random draw counter.";
+}
+
+TEST_F(MoveTraceTest, RecordsBatchSlots) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  const auto batch_size = static_cast<std::size_t>(64);
+  metropolis.set_batch_size(batch_size);
+  Move_trace trace(T, key, capacity, path);
+  attach_move_trace(&metropolis, &trace);
+  metropolis.sweep();
+
+  ASSERT_TRUE(trace.write());
+  Move_trace_file file;
+  ASSERT_TRUE(read_move_trace(path, &file));
+  ASSERT_THAT(file.records.size(), Gt(batch_size));
+  for (auto r = static_cast<std::size_t>(0); r < file.records.size(); ++r) {
+    EXPECT_THAT(file.records[r].slot, Eq(r % batch_size))
+      << "Record " << r << " has the wrong batch slot.";
+    if (r % batch_size == 0) continue;
+    EXPECT_THAT(file.records[r].draws, Eq(file.records[r - 1].draws))
+      << "Records in one batch have different draw counts.";
+  }
+  EXPECT_THAT(file.records[batch_size].draws, Gt(file.records[0].draws))
+    << "Consecutive batches have the same draw count.";
+}
+
+TEST_F(MoveTraceTest, ReplaysSweeps) {
+  trace_and_replay(1, 2);
+}
+
+TEST_F(MoveTraceTest, ReplaysBatchedSweeps) {
+  trace_and_replay(64, 2);
+}
+
+TEST_F(MoveTraceTest, CheckpointsBeforeTheRingWraps) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  Move_trace trace(T, key, 1000, path);
+  attach_move_trace(&metropolis, &trace);
+  ASSERT_TRUE(trace.checkpoint());
+  metropolis.sweep();
+
+  EXPECT_TRUE(trace.needs_checkpoint())
+    << "A full ring does not ask for a checkpoint.";
+
+  EXPECT_FALSE(trace.reaches_checkpoint())
+    << "A ring that wrapped since its checkpoint claims to reach it.";
+
+  ASSERT_TRUE(trace.write());
+  Move_trace_file file;
+  ASSERT_TRUE(read_move_trace(path, &file));
+  Replay_result result;
+  EXPECT_FALSE(replay_move_trace(file, &T, &index, &result))
+    << "A trace which lost moves since its checkpoint was replayed.";
+
+  ASSERT_TRUE(trace.checkpoint());
+  EXPECT_FALSE(trace.needs_checkpoint())
+    << "A fresh checkpoint still asks for another.";
+  EXPECT_TRUE(trace.reaches_checkpoint())
+    << "A fresh checkpoint is out of reach.";
+}
+
+TEST_F(MoveTraceTest, CheckpointsOnTheSnapshotWriter) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        seed);
+  Move_trace trace(T, key, capacity, path);
+  attach_move_trace(&metropolis, &trace);
+  ASSERT_TRUE(trace.checkpoint());
+  metropolis.sweep();
+  const auto hash = triangulation_hash(T);
+  const auto recorded = trace.recorded();
+  Snapshot_writer writer;
+  ASSERT_TRUE(trace.checkpoint(&writer));
+
+  EXPECT_FALSE(trace.needs_checkpoint())
+    << "A pending checkpoint asks for another.";
+
+  EXPECT_FALSE(trace.checkpoint(&writer))
+    << "A second checkpoint started while one is pending.";
+
+  metropolis.sweep();
+  writer.wait();
+  ASSERT_TRUE(trace.finish_checkpoint());
+  ASSERT_TRUE(trace.write());
+  Move_trace_file file;
+  ASSERT_TRUE(read_move_trace(path, &file));
+
+  EXPECT_THAT(file.header.checkpoint, Eq(recorded))
+    << "The checkpoint did not take effect once written.";
+
+  EXPECT_THAT(file.header.checkpoint_hash, Eq(hash))
+    << "The checkpoint recorded the wrong hash.";
+
+  Delaunay U;
+  std::vector<Cell_handle> U_three_one;
+  std::vector<Cell_handle> U_two_two;
+  std::vector<Cell_handle> U_one_three;
+  ASSERT_TRUE(load_universe(path + ".cdt", key, &U, &U_three_one,
+                            &U_two_two, &U_one_three));
+  EXPECT_THAT(triangulation_hash(U), Eq(hash))
+    << "The checkpoint file is not the universe when it was taken.";
+
+  Timeslice_index U_index;
+  make_timeslice_index(U, number_of_timeslices, &U_index);
+  Replay_result result;
+  ASSERT_TRUE(replay_move_trace(file, &U, &U_index, &result));
+  EXPECT_THAT(triangulation_hash(U), Eq(file.header.final_hash))
+    << "Replay from the written checkpoint ended elsewhere.";
+}
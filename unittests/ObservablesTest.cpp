@@ -0,0 +1,178 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that observables are measured on schedule, from snapshots taken
+/// between sweeps, without holding up the sweeps.
+
+/// @file ObservablesTest.cpp
+/// @brief Tests for observable plugins and the measurement scheduler
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "Observables.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+class ObservablesTest : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+    make_timeslice_index(T, number_of_timeslices, &index);
+    metropolis.reset(new Metropolis(&T, &index,
+                                    make_action_coefficients(1.1, 2.2, 3.3),
+                                    seed));
+  }
+
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  const std::uint64_t seed{42};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  Timeslice_index index;
+  std::unique_ptr<Metropolis> metropolis;
+};
+
+TEST_F(ObservablesTest, RejectsDuplicatesAndIncompleteObservables) {
+  Measurement_scheduler scheduler(1);
+
+  EXPECT_TRUE(scheduler.add(action_observable(1)));
+  EXPECT_FALSE(scheduler.add(action_observable(2)))
+    << "Names should be unique.";
+  EXPECT_FALSE(scheduler.add(Observable{"never", 0, observable_data::COUNTS,
+                                        action_observable(1).measure}))
+    << "An interval of 0 should be rejected.";
+}
+
+TEST_F(ObservablesTest, MeasuresOnSchedule) {
+  Measurement_scheduler scheduler(2);
+  scheduler.add(action_observable(1));
+  scheduler.add(volume_profile_observable(2));
+  scheduler.add(vertex_profile_observable(3));
+
+  for (auto pass = 1u; pass <= 6; ++pass) {
+    metropolis->sweep();
+    scheduler.after_sweep(pass, metropolis.get());
+  }
+  scheduler.wait();
+
+  EXPECT_THAT(scheduler.series("action"), SizeIs(6));
+  ASSERT_THAT(scheduler.series("volume_profile"), SizeIs(3));
+  ASSERT_THAT(scheduler.series("vertex_profile"), SizeIs(2));
+  EXPECT_THAT(scheduler.series("volume_profile")[0].pass, Eq(2));
+  EXPECT_THAT(scheduler.series("vertex_profile")[1].pass, Eq(6));
+  EXPECT_THAT(scheduler.skipped(), Eq(0));
+}
+
+TEST_F(ObservablesTest, SnapshotsMatchTheUniverseWhenTaken) {
+  Measurement_scheduler scheduler(1);
+  scheduler.add(action_observable(1));
+  scheduler.add(vertex_profile_observable(1));
+
+  metropolis->sweep();
+  const auto N3 = metropolis->N3_31() + metropolis->N3_22();
+  scheduler.after_sweep(1, metropolis.get());
+  // Later sweeps must not change what was measured
+  metropolis->sweep();
+  metropolis->sweep();
+  scheduler.wait();
+
+  const auto action = scheduler.series("action");
+  ASSERT_THAT(action, SizeIs(1));
+  EXPECT_THAT(action[0].values[1], Eq(static_cast<double>(N3)));
+  auto vertices = 0.0;
+  for (const auto count : scheduler.series("vertex_profile")[0].values) {
+    vertices += count;
+  }
+  EXPECT_THAT(vertices, Eq(static_cast<double>(T.number_of_vertices())))
+    << "Every vertex should be on some timeslice.";
+}
+
+TEST_F(ObservablesTest, SkipsRatherThanWaitsForBusyWorkers) {
+  std::atomic<bool> release{false};
+  Measurement_scheduler scheduler(1, 2);
+  scheduler.add(Observable{"slow", 1, observable_data::COUNTS,
+                           [&release](const Measurement_snapshot&) {
+                             while (!release) std::this_thread::yield();
+                             return std::vector<double>{1.0};
+                           }});
+
+  for (auto pass = 1u; pass <= 5; ++pass) {
+    scheduler.after_sweep(pass, metropolis.get());
+  }
+  release = true;
+  scheduler.wait();
+
+  EXPECT_THAT(scheduler.series("slow"), SizeIs(2));
+  EXPECT_THAT(scheduler.skipped(), Eq(3))
+    << "Measurements beyond max_pending should be skipped.";
+}
+
+TEST_F(ObservablesTest, WritesOneLinePerMeasurement) {
+  Measurement_scheduler scheduler(1);
+  scheduler.add(action_observable(1));
+  scheduler.after_sweep(1, metropolis.get());
+  scheduler.after_sweep(2, metropolis.get());
+  scheduler.wait();
+  std::ostringstream output;
+
+  write_measurements(&scheduler, output);
+
+  EXPECT_THAT(output.str(), StartsWith("action 1 "));
+  EXPECT_THAT(output.str(), HasSubstr("\naction 2 "));
+}
+
+TEST_F(ObservablesTest, StreamsMeasurementsToTheSink) {
+  Measurement_scheduler scheduler(1);
+  std::ostringstream output;
+  scheduler.stream_to(&output);
+  scheduler.add(action_observable(1));
+  scheduler.add(vertex_profile_observable(1));
+  scheduler.after_sweep(1, metropolis.get());
+  scheduler.after_sweep(2, metropolis.get());
+  scheduler.wait();
+
+  EXPECT_THAT(scheduler.series("action"), IsEmpty())
+    << "Streamed measurements should not be kept.";
+  EXPECT_THAT(output.str(), HasSubstr("action 1 "));
+  EXPECT_THAT(output.str(), HasSubstr("action 2 "));
+  EXPECT_THAT(output.str(), HasSubstr("vertex_profile 2 "))
+    << "Observables reading the arrays should run once they are numbered.";
+}
+
+TEST_F(ObservablesTest, MeasuresThe2dEngine) {
+  Triangulation_2d T2;
+  make_2d_triangulation(number_of_timeslices, 8, &T2);
+  Metropolis_2d metropolis_2d(&T2, 0.7, seed);
+  Measurement_scheduler scheduler(1);
+  scheduler.add(action_observable(1));
+  scheduler.add(volume_profile_observable(1));
+
+  metropolis_2d.sweep();
+  scheduler.after_sweep(1, &metropolis_2d);
+  scheduler.wait();
+
+  ASSERT_THAT(scheduler.series("action"), SizeIs(1));
+  EXPECT_THAT(scheduler.series("action")[0].values[1],
+              Eq(static_cast<double>(T2.number_of_triangles())));
+  const auto profile = scheduler.series("volume_profile")[0].values;
+  ASSERT_THAT(profile, SizeIs(number_of_timeslices));
+  for (auto t = 0u; t < number_of_timeslices; ++t) {
+    EXPECT_THAT(profile[t], Eq(static_cast<double>(T2.slice_volume[t])));
+  }
+}
@@ -0,0 +1,60 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests per-phase measurements with Linux perf_event counters. Counters
+/// may be unavailable in containers and virtual machines, so tests accept
+/// -1 readings.
+
+/// @file PerfCountersTest.cpp
+/// @brief Tests for hardware performance counters
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "PerfCounters.h"
+
+using namespace testing;  // NOLINT
+
+TEST(PerfCounters, DisabledCountersReadUnavailable) {
+  Perf_counters counters(false);
+
+  EXPECT_FALSE(counters.available());
+  const auto measurement = measure_phase(&counters, []() {});
+  EXPECT_THAT(measurement.counters, Each(Eq(-1)));
+}
+
+TEST(PerfCounters, MeasuresAPhase) {
+  Perf_counters counters(true);
+  std::vector<int> touched;
+
+  const auto measurement = measure_phase(&counters, [&touched]() {
+    touched.assign(1 << 20, 1);
+  });
+
+  EXPECT_THAT(measurement.seconds, Ge(0.0));
+  EXPECT_THAT(measurement.counters, Each(Ge(-1)));
+  const auto page_faults =
+      measurement.counters[static_cast<std::size_t>(perf_event::PAGE_FAULTS)];
+  if (page_faults >= 0) {
+    EXPECT_THAT(page_faults, Gt(0))
+      << "Touching 4 MB of fresh memory should fault in pages.";
+  }
+}
+
+TEST(PerfCounters, CombinesParallelPhases) {
+  auto total = zero_phase();
+  Phase_measurement first{1.0, {{10, 20, 30, 40, 50}}};
+  Phase_measurement second{2.0, {{1, 2, -1, 4, 5}}};
+
+  combine_phase(&total, first);
+  combine_phase(&total, second);
+
+  EXPECT_THAT(total.seconds, DoubleEq(2.0))
+    << "Wall time should be that of the slowest.";
+  EXPECT_THAT(total.counters, ElementsAre(11, 22, -1, 44, 55))
+    << "Counts should add up, and unavailable counts stay unavailable.";
+}
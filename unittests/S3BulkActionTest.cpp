@@ -17,19 +17,19 @@
 #include "gmock/gmock.h"
 #include "S3Triangulation.h"
 #include "S3Action.h"
+#include "SharedUniverse.h"
 
 using namespace testing;  // NOLINT
 
 class S3BulkAction : public Test {
  protected:
   virtual void SetUp() {
-    make_S3_triangulation(number_of_simplices,
-                          number_of_timeslices,
-                          no_output,
-                          &T,
-                          &three_one,
-                          &two_two,
-                          &one_three);
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
   }
 
   const bool output = true;
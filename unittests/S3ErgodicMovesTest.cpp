@@ -15,19 +15,19 @@
 
 #include "gmock/gmock.h"
 #include "S3ErgodicMoves.h"
+#include "SharedUniverse.h"
 
 using namespace testing;  // NOLINT
 
 class S3ErgodicMoves : public Test {
  protected:
   virtual void SetUp() {
-    make_S3_triangulation(number_of_simplices,
-                          number_of_timeslices,
-                          no_output,
-                          &T,
-                          &three_one,
-                          &two_two,
-                          &one_three);
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
   }
 
   const bool output{true};
@@ -212,6 +212,57 @@ TEST_F(S3ErgodicMoves, DISABLED_MakeA62Move) {
     << "(1,3) simplices did not decrease by 2.";
 }
 
+TEST_F(S3ErgodicMoves, TimesliceHintStartsNearThePoint) {
+  Timeslice_index index;
+  make_timeslice_index(T, number_of_timeslices, &index);
+  const auto timeslice = number_of_timeslices / 2;
+  ASSERT_FALSE(index.vertices[timeslice].empty());
+  const auto vertex = index.vertices[timeslice][0];
+
+  const auto hint = timeslice_hint(index, timeslice, vertex->point());
+
+  ASSERT_TRUE(hint != Cell_handle());
+  EXPECT_TRUE(hint->has_vertex(vertex))
+    << "A point on a sampled vertex should start from that vertex.";
+  EXPECT_TRUE(timeslice_hint(index, 10 * number_of_timeslices,
+                             vertex->point()) == Cell_handle())
+    << "An empty timeslice should give no hint.";
+}
+
+TEST_F(S3ErgodicMoves, TimesliceHintLocatesTheSameCell) {
+  Timeslice_index index;
+  make_timeslice_index(T, number_of_timeslices, &index);
+  std::vector<Point> points;
+  std::vector<unsigned> timevalue;
+  make_2_sphere(10, number_of_timeslices / 2, no_output, &points,
+                &timevalue);
+
+  for (auto i = 0u; i < points.size(); ++i) {
+    Locate_type lt, hinted_lt;
+    int li, lj, hinted_li, hinted_lj;
+    const auto located = T.locate(points[i], lt, li, lj);
+    const auto hinted = T.locate(points[i], hinted_lt, hinted_li, hinted_lj,
+                                 timeslice_hint(index, timevalue[i],
+                                                points[i]));
+    EXPECT_TRUE(located == hinted) << "Point " << i << " was mislocated.";
+    EXPECT_THAT(hinted_lt, Eq(lt));
+  }
+}
+
+TEST_F(S3ErgodicMoves, NearestVertexHintStartsFromTheNearestVertex) {
+  std::vector<Point> points;
+  std::vector<unsigned> timevalue;
+  make_2_sphere(10, number_of_timeslices / 2, no_output, &points,
+                &timevalue);
+
+  for (auto i = 0u; i < points.size(); ++i) {
+    const auto hint = nearest_vertex_hint(T, points[i]);
+    ASSERT_TRUE(hint != Cell_handle());
+    EXPECT_TRUE(hint->has_vertex(T.nearest_vertex(points[i])))
+      << "Point " << i << " should start from its nearest vertex.";
+  }
+}
+
 TEST_F(S3ErgodicMoves, DISABLED_MakeA26Move) {
   auto number_of_vertices_before = T.number_of_vertices();
   auto N3_31_before = three_one.size();
@@ -0,0 +1,129 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that seeded universes are reproducible, and survive a round trip
+/// through the seed universe cache.
+
+/// @file SeedCacheTest.cpp
+/// @brief Tests for the seed universe cache
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "SeedCache.h"
+
+using namespace testing;  // NOLINT
+
+class SeedCache : public Test {
+ protected:
+  virtual void SetUp() {
+    make_S3_triangulation(number_of_simplices,
+                          number_of_timeslices,
+                          seed,
+                          no_output,
+                          &T,
+                          &three_one,
+                          &two_two,
+                          &one_three);
+  }
+
+  virtual void TearDown() {
+    unlink(path.c_str());
+  }
+
+  const bool no_output{false};
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  const std::uint64_t seed{7};
+  const Universe_key key{make_universe_key(number_of_simplices,
+                                           number_of_timeslices, seed)};
+  const std::string path{"SeedCacheTest-" + std::to_string(getpid()) +
+                         ".cdt"};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+};
+
+TEST_F(SeedCache, SeededUniversesAreReproducible) {
+  Delaunay U;
+  std::vector<Cell_handle> U_three_one;
+  std::vector<Cell_handle> U_two_two;
+  std::vector<Cell_handle> U_one_three;
+  make_S3_triangulation(number_of_simplices, number_of_timeslices, seed,
+                        no_output, &U, &U_three_one, &U_two_two,
+                        &U_one_three);
+
+  EXPECT_THAT(U.number_of_vertices(), Eq(T.number_of_vertices()));
+  EXPECT_THAT(U.number_of_finite_cells(), Eq(T.number_of_finite_cells()));
+  EXPECT_THAT(U_two_two.size(), Eq(two_two.size()))
+    << "The same seed should give the same universe.";
+}
+
+TEST_F(SeedCache, SavesAndLoads) {
+  ASSERT_TRUE(save_universe(path, key, T));
+
+  Delaunay U;
+  std::vector<Cell_handle> U_three_one;
+  std::vector<Cell_handle> U_two_two;
+  std::vector<Cell_handle> U_one_three;
+  ASSERT_TRUE(load_universe(path, key, &U, &U_three_one, &U_two_two,
+                            &U_one_three));
+
+  EXPECT_TRUE(U.is_valid());
+  EXPECT_THAT(U.number_of_vertices(), Eq(T.number_of_vertices()));
+  EXPECT_THAT(U.number_of_finite_cells(), Eq(T.number_of_finite_cells()));
+  EXPECT_THAT(U_three_one.size(), Eq(three_one.size()));
+  EXPECT_THAT(U_two_two.size(), Eq(two_two.size()));
+  EXPECT_THAT(U_one_three.size(), Eq(one_three.size()));
+
+  auto original = T.finite_vertices_begin();
+  auto loaded = U.finite_vertices_begin();
+  for (; original != T.finite_vertices_end(); ++original, ++loaded) {
+    EXPECT_THAT(loaded->point(), Eq(original->point()));
+    EXPECT_THAT(loaded->info(), Eq(original->info()))
+      << "Timeslices were not restored in order.";
+  }
+}
+
+TEST_F(SeedCache, RejectsADifferentKey) {
+  ASSERT_TRUE(save_universe(path, key, T));
+
+  auto other = key;
+  other.seed++;
+  Delaunay U;
+  std::vector<Cell_handle> U_three_one;
+  std::vector<Cell_handle> U_two_two;
+  std::vector<Cell_handle> U_one_three;
+
+  EXPECT_FALSE(load_universe(path, other, &U, &U_three_one, &U_two_two,
+                             &U_one_three))
+    << "A universe for a different seed was loaded.";
+}
+
+TEST_F(SeedCache, WritesSnapshotsInTheBackground) {
+  Snapshot_writer snapshots;
+
+  ASSERT_TRUE(snapshots.start(path, key, T));
+  // Changing the original must not affect the snapshot being written
+  T.clear();
+  snapshots.wait();
+
+  EXPECT_FALSE(snapshots.busy());
+  EXPECT_THAT(snapshots.saved(), Eq(1));
+  Delaunay U;
+  std::vector<Cell_handle> U_three_one;
+  std::vector<Cell_handle> U_two_two;
+  std::vector<Cell_handle> U_one_three;
+  ASSERT_TRUE(load_universe(path, key, &U, &U_three_one, &U_two_two,
+                            &U_one_three));
+  EXPECT_THAT(U_two_two.size(), Eq(two_two.size()))
+    << "The snapshot should hold the universe as it was when started.";
+}
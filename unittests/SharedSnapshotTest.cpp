@@ -0,0 +1,142 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that shared snapshots read back in place, alternate buffers, and
+/// survive the segment being replaced.
+
+/// @file SharedSnapshotTest.cpp
+/// @brief Tests for zero-copy shared-memory snapshots
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "SharedSnapshot.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+class SharedSnapshotTest : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+  }
+
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  const std::string name{default_shared_snapshot_name() + "-test"};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+};
+
+TEST_F(SharedSnapshotTest, NothingBeforeTheFirstSnapshot) {
+  Snapshot_reader reader(name);
+  Snapshot_view view;
+
+  EXPECT_FALSE(reader.latest(&view))
+    << "There should be no segment to attach to.";
+}
+
+TEST_F(SharedSnapshotTest, ReadsTheTriangulationInPlace) {
+  Snapshot_publisher publisher(name);
+  ASSERT_TRUE(publisher.publish(T, number_of_timeslices, 5, 1, 2, 3));
+
+  Snapshot_reader reader(name);
+  Snapshot_view view;
+  ASSERT_TRUE(reader.latest(&view));
+
+  EXPECT_THAT(view.generation, Eq(1))
+    << "The first snapshot should be generation 1.";
+  EXPECT_THAT(view.pass, Eq(5));
+  EXPECT_THAT(view.N3_22, Eq(3));
+  EXPECT_THAT(view.number_of_vertices, Eq(T.number_of_vertices()));
+  EXPECT_THAT(view.number_of_cells, Eq(T.number_of_finite_cells()));
+
+  auto v = 0u;
+  Delaunay::Finite_vertices_iterator vit;
+  for (vit = T.finite_vertices_begin(); vit != T.finite_vertices_end();
+       ++vit, ++v) {
+    ASSERT_THAT(view.x[v], Eq(vit->point().x()));
+    ASSERT_THAT(view.z[v], Eq(vit->point().z()));
+    ASSERT_THAT(view.timeslice[v], Eq(vit->info()));
+  }
+
+  auto typed = 0u;
+  for (auto c = 0u; c < view.number_of_cells; ++c) {
+    for (auto k = 0; k < 4; ++k) {
+      ASSERT_THAT(view.cell_vertices[k][c], Lt(view.number_of_vertices))
+        << "Cells should refer to vertices by index.";
+    }
+    if (view.cell_type[c] == 31 || view.cell_type[c] == 22 ||
+        view.cell_type[c] == 13) {
+      typed++;
+    }
+  }
+  EXPECT_THAT(typed, Eq(three_one.size() + two_two.size() +
+                        one_three.size()))
+    << "Cell types should match the classified simplices.";
+  EXPECT_TRUE(reader.current(view));
+}
+
+TEST_F(SharedSnapshotTest, TheLatestSnapshotSurvivesOneMore) {
+  Snapshot_publisher publisher(name);
+  Snapshot_reader reader(name);
+  Snapshot_view first;
+  ASSERT_TRUE(publisher.publish(T, number_of_timeslices, 1, 0, 0, 0));
+  ASSERT_TRUE(reader.latest(&first));
+
+  ASSERT_TRUE(publisher.publish(T, number_of_timeslices, 2, 0, 0, 0));
+  EXPECT_TRUE(reader.current(first))
+    << "The next snapshot should go to the other buffer.";
+  Snapshot_view second;
+  ASSERT_TRUE(reader.latest(&second));
+  EXPECT_THAT(second.pass, Eq(2));
+
+  ASSERT_TRUE(publisher.publish(T, number_of_timeslices, 3, 0, 0, 0));
+  EXPECT_FALSE(reader.current(first))
+    << "A reader lapped by the writer should know it.";
+  EXPECT_TRUE(reader.current(second));
+}
+
+TEST_F(SharedSnapshotTest, ReattachesWhenTheSegmentGrows) {
+  Delaunay small;
+  small.insert(Point(0, 0, 0));
+  small.insert(Point(1, 0, 0));
+  small.insert(Point(0, 1, 0));
+  small.insert(Point(0, 0, 1));
+  Snapshot_publisher publisher(name);
+  Snapshot_reader reader(name);
+  Snapshot_view view;
+  ASSERT_TRUE(publisher.publish(small, 1, 1, 0, 0, 0));
+  ASSERT_TRUE(reader.latest(&view));
+  EXPECT_THAT(view.number_of_vertices, Eq(4));
+
+  ASSERT_TRUE(publisher.publish(T, number_of_timeslices, 2, 0, 0, 0));
+  ASSERT_TRUE(reader.latest(&view));
+
+  EXPECT_THAT(view.pass, Eq(2));
+  EXPECT_THAT(view.number_of_vertices, Eq(T.number_of_vertices()))
+    << "The reader should follow the publisher to the larger segment.";
+}
+
+TEST_F(SharedSnapshotTest, RemovesTheSegmentWhenDone) {
+  {
+    Snapshot_publisher publisher(name);
+    publisher.publish(T, number_of_timeslices, 1, 0, 0, 0);
+  }
+  Snapshot_reader reader(name);
+  Snapshot_view view;
+
+  EXPECT_FALSE(reader.latest(&view));
+}
@@ -0,0 +1,92 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Seed universes shared by the test fixtures
+///
+/// Each fixture used to call make_S3_triangulation() in SetUp(), so the
+/// same size of universe was rebuilt for every test. Instead, each
+/// (simplices, timeslices) universe is generated once per process from a
+/// fixed seed, and fixtures get a copy, which is far cheaper than insertion
+/// plus foliation repair. If the CDT_CACHE_DIR environment variable is set,
+/// the universes also come from the seed universe cache, so later runs
+/// skip generating them entirely.
+
+/// @file SharedUniverse.h
+/// @brief Once-per-process seed universes for test fixtures
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#ifndef UNITTESTS_SHAREDUNIVERSE_H_
+#define UNITTESTS_SHAREDUNIVERSE_H_
+
+// CDT headers
+#include "S3Triangulation.h"
+#include "SeedCache.h"
+
+// C++ headers
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/// Seed of every shared universe
+static constexpr std::uint64_t SHARED_UNIVERSE_SEED = 1;
+
+/// @brief The shared universe of a given size, built on first use
+///
+/// @param[in] number_of_simplices  The number of simplices
+/// @param[in] number_of_timeslices The number of foliated timeslices
+/// @returns The universe, which must not be modified
+inline const Delaunay& shared_universe(const unsigned number_of_simplices,
+                                       const unsigned number_of_timeslices)
+                                       noexcept {
+  static std::mutex mutex;
+  static std::map<std::pair<unsigned, unsigned>, std::unique_ptr<Delaunay>>
+      universes;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& universe = universes[std::make_pair(number_of_simplices,
+                                            number_of_timeslices)];
+  if (!universe) {
+    universe.reset(new Delaunay);
+    const auto directory = std::getenv("CDT_CACHE_DIR");
+    std::vector<Cell_handle> three_one;
+    std::vector<Cell_handle> two_two;
+    std::vector<Cell_handle> one_three;
+    make_cached_S3_triangulation(directory ? directory : "",
+                                 number_of_simplices, number_of_timeslices,
+                                 SHARED_UNIVERSE_SEED, false, universe.get(),
+                                 &three_one, &two_two, &one_three);
+  }
+  return *universe;
+}  // shared_universe()
+
+/// @brief Copies the shared universe of a given size
+///
+/// @param[in]  number_of_simplices  The number of simplices
+/// @param[in]  number_of_timeslices The number of foliated timeslices
+/// @param[out] D3                   A copy of the shared universe
+/// @param[out] three_one            Cell handles of all (3,1) simplices
+/// @param[out] two_two              Cell handles of all (2,2) simplices
+/// @param[out] one_three            Cell handles of all (1,3) simplices
+inline void clone_S3_triangulation(const unsigned number_of_simplices,
+                                   const unsigned number_of_timeslices,
+                                   Delaunay* const D3,
+                                   std::vector<Cell_handle>* const three_one,
+                                   std::vector<Cell_handle>* const two_two,
+                                   std::vector<Cell_handle>* const one_three)
+                                   noexcept {
+  *D3 = shared_universe(number_of_simplices, number_of_timeslices);
+  three_one->clear();
+  two_two->clear();
+  one_three->clear();
+  classify_3_simplices(D3, three_one, two_two, one_three);
+}  // clone_S3_triangulation()
+
+#endif  // UNITTESTS_SHAREDUNIVERSE_H_
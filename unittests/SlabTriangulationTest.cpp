@@ -0,0 +1,138 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that slabs triangulated in parallel stitch into one valid,
+/// properly foliated triangulation.
+
+/// @file SlabTriangulationTest.cpp
+/// @brief Tests for slab-parallel construction
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <algorithm>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "SlabTriangulation.h"
+
+using namespace testing;  // NOLINT
+
+class SlabTriangulationTest : public Test {
+ protected:
+  /// @returns True if the universe was built
+  bool make_universe(const unsigned threads) {
+    CGAL::Random rng(seed);
+    return make_slab_S3_triangulation(number_of_simplices,
+                                      number_of_timeslices, threads, &rng,
+                                      &T, &three_one, &two_two, &one_three);
+  }
+
+  /// @returns The points of the vertices on **timeslice**, sorted
+  std::vector<Point> timeslice_points(const Delaunay& D3,
+                                      const unsigned timeslice) {
+    std::vector<Point> points;
+    Delaunay::Finite_vertices_iterator vit;
+    for (vit = D3.finite_vertices_begin(); vit != D3.finite_vertices_end();
+         ++vit) {
+      if (vit->info() == timeslice) points.push_back(vit->point());
+    }
+    std::sort(points.begin(), points.end());
+    return points;
+  }
+
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  const unsigned seed{42};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+};
+
+TEST_F(SlabTriangulationTest, MakesAValidTriangulation) {
+  ASSERT_TRUE(make_universe(4));
+
+  EXPECT_TRUE(T.tds().is_valid())
+    << "The stitched slabs should form a valid triangulation.";
+  EXPECT_THAT(T.dimension(), Eq(3));
+  EXPECT_THAT(three_one.size() + two_two.size() + one_three.size(),
+              Eq(T.number_of_finite_cells()));
+}
+
+TEST_F(SlabTriangulationTest, EveryCellSpansOneSlab) {
+  ASSERT_TRUE(make_universe(4));
+
+  Delaunay::Finite_cells_iterator cit;
+  for (cit = T.finite_cells_begin(); cit != T.finite_cells_end(); ++cit) {
+    auto min_time = cit->vertex(0)->info();
+    auto max_time = min_time;
+    for (auto k = 1; k < 4; ++k) {
+      min_time = std::min(min_time, cit->vertex(k)->info());
+      max_time = std::max(max_time, cit->vertex(k)->info());
+    }
+    ASSERT_THAT(max_time - min_time, Eq(1))
+      << "No cell should need fixing.";
+  }
+}
+
+TEST_F(SlabTriangulationTest, KeepsEveryPointBeyondTheInnermost) {
+  ASSERT_TRUE(make_universe(4));
+  const auto points = number_of_simplices / number_of_timeslices * 4;
+
+  EXPECT_THAT(T.number_of_vertices(),
+              Eq((number_of_timeslices - 1) * points +
+                 SLAB_INNERMOST_POINTS))
+    << "Every point beyond the innermost sphere should be a vertex.";
+}
+
+TEST_F(SlabTriangulationTest, MatchesTheSerialTimeslices) {
+  ASSERT_TRUE(make_universe(4));
+  Delaunay serial;
+  std::vector<Cell_handle> serial_three_one;
+  std::vector<Cell_handle> serial_two_two;
+  std::vector<Cell_handle> serial_one_three;
+  make_S3_triangulation(number_of_simplices, number_of_timeslices,
+                        static_cast<std::uint64_t>(seed), false, &serial,
+                        &serial_three_one, &serial_two_two,
+                        &serial_one_three);
+
+  EXPECT_THAT(timeslice_points(T, 1), SizeIs(SLAB_INNERMOST_POINTS));
+  EXPECT_THAT(timeslice_points(serial, 1).size(),
+              Le(SLAB_INNERMOST_POINTS))
+    << "fix_timeslices() should leave at most three innermost vertices.";
+
+  EXPECT_THAT(timeslice_points(T, 0), IsEmpty())
+    << "There should be no vertex below the innermost timeslice.";
+
+  // fix_timeslices() may also have removed the odd outer vertex
+  for (auto t = 2u; t <= number_of_timeslices; ++t) {
+    const auto slab_points = timeslice_points(T, t);
+    const auto serial_points = timeslice_points(serial, t);
+    EXPECT_TRUE(std::includes(slab_points.begin(), slab_points.end(),
+                              serial_points.begin(), serial_points.end()))
+      << "Timeslice " << t << " has points the serial universe lacks.";
+  }
+}
+
+TEST_F(SlabTriangulationTest, ThreadsDoNotChangeTheUniverse) {
+  ASSERT_TRUE(make_universe(1));
+  const auto N3_31 = three_one.size();
+  const auto N3_22 = two_two.size();
+  const auto N3_13 = one_three.size();
+
+  ASSERT_TRUE(make_universe(8));
+
+  EXPECT_THAT(three_one.size(), Eq(N3_31));
+  EXPECT_THAT(two_two.size(), Eq(N3_22));
+  EXPECT_THAT(one_three.size(), Eq(N3_13));
+}
+
+TEST_F(SlabTriangulationTest, NeedsTwoTimeslices) {
+  CGAL::Random rng(seed);
+
+  EXPECT_FALSE(make_slab_S3_triangulation(number_of_simplices, 1, 4, &rng,
+                                          &T, &three_one, &two_two,
+                                          &one_three));
+}
@@ -0,0 +1,103 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that telemetry pages are published, found, read back, and removed,
+/// and that finished runs leave their pages for readers.
+
+/// @file TelemetryTest.cpp
+/// @brief Tests for the shared-memory stats page
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gmock/gmock.h"
+#include "Telemetry.h"
+
+using namespace testing;  // NOLINT
+
+class TelemetryTest : public Test {
+ protected:
+  const std::string name{default_telemetry_name() + "-test"};
+};
+
+TEST_F(TelemetryTest, PublishesAndReadsBack) {
+  Telemetry_publisher publisher(name, 42, 16);
+  ASSERT_TRUE(publisher.available());
+
+  Telemetry_sample sample{};
+  sample.phase = run_phase::SWEEPING;
+  sample.pass = 3;
+  sample.passes = 10;
+  sample.N3_22 = 1234;
+  sample.accepted[1] = 7;
+  publisher.publish(sample);
+
+  Telemetry_snapshot snapshot;
+  ASSERT_TRUE(read_telemetry(name, &snapshot));
+  EXPECT_THAT(snapshot.seed, Eq(42));
+  EXPECT_THAT(snapshot.timeslices, Eq(16));
+  EXPECT_THAT(snapshot.sample.phase, Eq(run_phase::SWEEPING));
+  EXPECT_THAT(snapshot.sample.N3_22, Eq(1234));
+  EXPECT_THAT(snapshot.sample.accepted[1], Eq(7));
+  EXPECT_TRUE(publisher_alive(snapshot));
+  EXPECT_THAT(list_telemetry(), Contains(name));
+}
+
+TEST_F(TelemetryTest, RemovesThePageWhenDone) {
+  {
+    Telemetry_publisher publisher(name, 42, 16);
+  }
+  Telemetry_snapshot snapshot;
+
+  EXPECT_FALSE(read_telemetry(name, &snapshot));
+  EXPECT_THAT(list_telemetry(), Not(Contains(name)));
+}
+
+TEST_F(TelemetryTest, LeavesFinishedPagesForReaders) {
+  {
+    Telemetry_publisher publisher(name, 42, 16);
+    Telemetry_sample sample{};
+    sample.phase = run_phase::FINISHED;
+    publisher.publish(sample);
+  }
+  Telemetry_snapshot snapshot;
+
+  ASSERT_TRUE(read_telemetry(name, &snapshot))
+    << "A finished run should leave its page for readers.";
+  EXPECT_THAT(snapshot.sample.phase, Eq(run_phase::FINISHED));
+
+  EXPECT_TRUE(remove_telemetry(name));
+  EXPECT_FALSE(read_telemetry(name, &snapshot));
+}
+
+TEST_F(TelemetryTest, ReadsAreNeverTorn) {
+  Telemetry_publisher publisher(name, 42, 16);
+  std::atomic<bool> done{false};
+  std::thread writer([&publisher, &done]() {
+    Telemetry_sample sample{};
+    for (auto pass = 1u; !done; ++pass) {
+      sample.pass = pass;
+      sample.passes = pass;
+      sample.N3_22 = pass;
+      publisher.publish(sample);
+      // Runs publish once per sweep, far less often than this
+      std::this_thread::sleep_for(std::chrono::microseconds(1));
+    }
+  });
+
+  for (auto read = 0; read < 10000; ++read) {
+    Telemetry_snapshot snapshot;
+    EXPECT_TRUE(read_telemetry(name, &snapshot));
+    EXPECT_THAT(snapshot.sample.passes, Eq(snapshot.sample.pass));
+    EXPECT_THAT(snapshot.sample.N3_22, Eq(snapshot.sample.pass))
+      << "A sample should never mix two publications.";
+  }
+  done = true;
+  writer.join();
+}
@@ -0,0 +1,130 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests annealed thermalization and its convergence detection.
+
+/// @file ThermalizationTest.cpp
+/// @brief Tests for annealed thermalization
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "Thermalization.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+TEST(ConvergenceMonitor, ConvergesOnSteadyObservations) {
+  Convergence_monitor monitor(2, 0.01);
+  const std::vector<double> profile{0, 10, 20, 10};
+
+  EXPECT_FALSE(monitor.observe(100, profile));
+  EXPECT_FALSE(monitor.observe(100, profile))
+    << "A single window has nothing to compare against.";
+  EXPECT_FALSE(monitor.observe(100, profile));
+  EXPECT_TRUE(monitor.observe(100, profile))
+    << "Identical windows should have converged.";
+  EXPECT_THAT(monitor.N3_change(), DoubleEq(0.0));
+  EXPECT_THAT(monitor.profile_change(), DoubleEq(0.0));
+}
+
+TEST(ConvergenceMonitor, DoesNotConvergeWhileDrifting) {
+  Convergence_monitor monitor(1, 0.01);
+  const std::vector<double> profile{0, 10, 20, 10};
+  const std::vector<double> shifted{0, 20, 10, 10};
+
+  monitor.observe(100, profile);
+  EXPECT_FALSE(monitor.observe(150, profile))
+    << "N3 grew by half.";
+  EXPECT_FALSE(monitor.observe(150, shifted))
+    << "The volume profile moved.";
+
+  monitor.reset();
+  EXPECT_FALSE(monitor.converged());
+}
+
+TEST(AnnealSchedule, RampsKToProduction) {
+  const auto schedule = make_anneal_schedule(1.1, 2.2, 3.3, 40);
+
+  EXPECT_THAT(schedule.anneal_passes, Eq(10));
+  EXPECT_THAT(annealed_K(schedule, 0), Eq(schedule.K_start));
+  EXPECT_THAT(annealed_K(schedule, 5),
+              AllOf(Gt(schedule.K_start), Lt(schedule.K)));
+  EXPECT_THAT(annealed_K(schedule, schedule.anneal_passes), Eq(schedule.K));
+  EXPECT_THAT(annealed_K(schedule, schedule.max_passes), Eq(schedule.K));
+}
+
+class ThermalizationTest : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+    make_timeslice_index(T, number_of_timeslices, &index);
+  }
+
+  const bool no_output{false};
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  Timeslice_index index;
+};
+
+TEST_F(ThermalizationTest, EndsAtProductionCouplings) {
+  const auto production = make_action_coefficients(1.1, 2.2, 3.3);
+  Metropolis metropolis(&T, &index, production, 42);
+  auto passes = static_cast<std::uint64_t>(0);
+
+  thermalize_annealed(&metropolis, make_anneal_schedule(1.1, 2.2, 3.3, 4),
+                      &passes);
+
+  EXPECT_THAT(passes, AllOf(Gt(0), Le(4)));
+  EXPECT_THAT(metropolis.coefficients().N3_22, DoubleEq(production.N3_22))
+    << "Production couplings were not restored.";
+  EXPECT_TRUE(metropolis.scheduler().frozen())
+    << "The move mix should be frozen for measurement.";
+  EXPECT_TRUE(check_timeslices(&T, no_output));
+}
+
+TEST_F(ThermalizationTest, AnnealingAdaptsTheMix) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        42);
+  const auto before = metropolis.scheduler().probability(move_type::TWO_THREE);
+  auto passes = static_cast<std::uint64_t>(0);
+
+  thermalize_annealed(&metropolis, make_anneal_schedule(1.1, 2.2, 3.3, 4),
+                      &passes);
+
+  EXPECT_THAT(metropolis.scheduler().probability(move_type::TWO_THREE),
+              Not(DoubleEq(before)))
+    << "The move mix did not change while annealing.";
+}
+
+TEST_F(ThermalizationTest, ReportsEveryAnnealingPass) {
+  Metropolis metropolis(&T, &index, make_action_coefficients(1.1, 2.2, 3.3),
+                        42);
+  auto passes = static_cast<std::uint64_t>(0);
+  std::vector<std::uint64_t> reported;
+
+  thermalize_annealed(&metropolis, make_anneal_schedule(1.1, 2.2, 3.3, 4),
+                      &passes, [&reported](const std::uint64_t pass) {
+                        reported.push_back(pass);
+                      });
+
+  ASSERT_THAT(reported.size(), Eq(passes))
+    << "Not every annealing pass was reported.";
+  for (auto p = static_cast<std::uint64_t>(0); p < passes; ++p) {
+    EXPECT_THAT(reported[p], Eq(p + 1))
+      << "Passes were reported out of order.";
+  }
+}
@@ -0,0 +1,210 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that per-timeslice indices of vertices and cells are built
+/// correctly and kept current by ergodic moves.
+
+/// @file TimesliceIndexTest.cpp
+/// @brief Tests for per-timeslice vertex and cell indices
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "S3ErgodicMoves.h"
+#include "TimesliceIndex.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+class TimesliceIndex : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+    make_timeslice_index(T, number_of_timeslices, &index);
+  }
+
+  /// Total number of indexed cells over all slabs
+  std::size_t indexed_cells(const Timeslice_index& idx) {
+    auto total = static_cast<std::size_t>(0);
+    for (auto t = 0u; t < idx.two_two.size(); ++t) {
+      total += number_of_cells_in_slab(idx, t);
+    }
+    return total;
+  }
+
+  /// Spacelike triangles on **timeslice**, counted from the facets of
+  /// **T** rather than from the index
+  std::size_t spacelike_triangles(const unsigned timeslice) {
+    auto count = static_cast<std::size_t>(0);
+    Delaunay::Finite_facets_iterator fit;
+    for (fit = T.finite_facets_begin(); fit != T.finite_facets_end(); ++fit) {
+      auto on_timeslice = true;
+      for (auto k = 1; k < 4; ++k) {
+        const auto vertex = fit->first->vertex((fit->second + k) % 4);
+        on_timeslice = on_timeslice && vertex->info() == timeslice;
+      }
+      if (on_timeslice) ++count;
+    }
+    return count;
+  }
+
+  const bool no_output{false};
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  Timeslice_index index;
+};
+
+TEST(IndexedSet, InsertsAndErases) {
+  Indexed_set<int> set;
+
+  EXPECT_TRUE(set.insert(1));
+  EXPECT_TRUE(set.insert(2));
+  EXPECT_TRUE(set.insert(3));
+  EXPECT_FALSE(set.insert(2))
+    << "Duplicate items should not be inserted.";
+
+  EXPECT_TRUE(set.erase(1));
+  EXPECT_FALSE(set.erase(1))
+    << "Erased items should not be found again.";
+
+  EXPECT_THAT(set.size(), Eq(2));
+  EXPECT_TRUE(set.contains(2));
+  EXPECT_TRUE(set.contains(3));
+  EXPECT_THAT(std::vector<int>(set.begin(), set.end()),
+              UnorderedElementsAre(2, 3))
+    << "Erasing should swap the last item into the hole.";
+}
+
+TEST_F(TimesliceIndex, IndexesAllVertices) {
+  auto total = static_cast<std::size_t>(0);
+  for (auto t = 0u; t < index.vertices.size(); ++t) {
+    for (const auto& v : index.vertices[t]) {
+      EXPECT_THAT(v->info(), Eq(t))
+        << "Vertex filed under the wrong timeslice.";
+    }
+    total += index.vertices[t].size();
+  }
+
+  EXPECT_THAT(total, Eq(T.number_of_vertices()))
+    << "Not every vertex was indexed.";
+}
+
+TEST_F(TimesliceIndex, IndexesCellsBySlab) {
+  for (auto t = 0u; t < index.two_two.size(); ++t) {
+    for (const auto& c : index.two_two[t]) {
+      auto slab = static_cast<unsigned>(0);
+      EXPECT_TRUE(get_slab(c, &slab));
+      EXPECT_THAT(slab, Eq(t))
+        << "Cell filed under the wrong slab.";
+      EXPECT_THAT(c->info(), Eq(22));
+    }
+  }
+
+  if (check_timeslices(&T, no_output)) {
+    EXPECT_THAT(indexed_cells(index), Eq(T.number_of_finite_cells()))
+      << "Not every correctly foliated cell was indexed.";
+  } else {
+    EXPECT_THAT(indexed_cells(index), Le(T.number_of_finite_cells()));
+  }
+}
+
+TEST_F(TimesliceIndex, StaysCurrentAfterA23Move) {
+  make_23_move(&T, &two_two, &index);
+
+  Timeslice_index rebuilt;
+  make_timeslice_index(T, number_of_timeslices, &rebuilt);
+
+  EXPECT_THAT(indexed_cells(index), Eq(indexed_cells(rebuilt)))
+    << "Index was not updated by the (2,3) move.";
+
+  for (auto t = 0u; t < rebuilt.two_two.size(); ++t) {
+    EXPECT_THAT(index.two_two[t].size(), Eq(rebuilt.two_two[t].size()))
+      << "(2,2) simplices in slab " << t << " differ.";
+    for (const auto& c : rebuilt.two_two[t]) {
+      EXPECT_TRUE(index.two_two[t].contains(c))
+        << "A new (2,2) simplex is missing from the index.";
+    }
+  }
+}
+
+TEST_F(TimesliceIndex, StaysCurrentAfterA32Move) {
+  std::vector<Edge_tuple> V2;
+  auto N1_SL = static_cast<unsigned>(0);
+  get_timelike_edges(T, &V2, &N1_SL);
+
+  make_32_move(&T, &V2, &index);
+
+  Timeslice_index rebuilt;
+  make_timeslice_index(T, number_of_timeslices, &rebuilt);
+
+  EXPECT_THAT(indexed_cells(index), Eq(indexed_cells(rebuilt)))
+    << "Index was not updated by the (3,2) move.";
+
+  for (auto t = 0u; t < rebuilt.two_two.size(); ++t) {
+    EXPECT_THAT(index.two_two[t].size(), Eq(rebuilt.two_two[t].size()))
+      << "(2,2) simplices in slab " << t << " differ.";
+  }
+}
+
+TEST_F(TimesliceIndex, StaysCurrentAfterA26Move) {
+  const auto vertices_before = T.number_of_vertices();
+
+  // Locates the new point from timeslice_hint()
+  make_26_move(&T, number_of_timeslices, &index);
+
+  EXPECT_TRUE(T.is_valid())
+    << "Triangulation is not Delaunay.";
+
+  EXPECT_THAT(T.number_of_vertices(), Eq(vertices_before + 1))
+    << "A vertex was not added to the triangulation.";
+
+  Timeslice_index rebuilt;
+  make_timeslice_index(T, number_of_timeslices, &rebuilt);
+
+  EXPECT_THAT(indexed_cells(index), Eq(indexed_cells(rebuilt)))
+    << "Index was not updated by the (2,6) move.";
+
+  ASSERT_THAT(index.vertices.size(), Eq(rebuilt.vertices.size()));
+  for (auto t = 0u; t < rebuilt.vertices.size(); ++t) {
+    EXPECT_THAT(index.vertices[t].size(), Eq(rebuilt.vertices[t].size()))
+      << "Vertices on timeslice " << t << " differ.";
+    for (const auto& v : rebuilt.vertices[t]) {
+      EXPECT_TRUE(index.vertices[t].contains(v))
+        << "The new vertex is missing from the index.";
+    }
+  }
+
+  for (auto t = 0u; t < rebuilt.two_two.size(); ++t) {
+    EXPECT_THAT(index.three_one[t].size(), Eq(rebuilt.three_one[t].size()))
+      << "(3,1) simplices in slab " << t << " differ.";
+    EXPECT_THAT(index.two_two[t].size(), Eq(rebuilt.two_two[t].size()))
+      << "(2,2) simplices in slab " << t << " differ.";
+    EXPECT_THAT(index.one_three[t].size(), Eq(rebuilt.one_three[t].size()))
+      << "(1,3) simplices in slab " << t << " differ.";
+    for (const auto& c : rebuilt.two_two[t]) {
+      EXPECT_TRUE(index.two_two[t].contains(c))
+        << "A new (2,2) simplex is missing from the index.";
+    }
+  }
+}
+
+TEST_F(TimesliceIndex, SpatialVolumeMatchesSpacelikeTriangles) {
+  // Timeslices between the innermost and outermost have slabs either side
+  for (auto t = 2u; t < number_of_timeslices; ++t) {
+    EXPECT_THAT(spatial_volume(index, t), Eq(spacelike_triangles(t)))
+      << "Timeslice " << t << " has the wrong spatial volume.";
+  }
+}
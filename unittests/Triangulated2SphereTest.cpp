@@ -11,14 +11,28 @@
 /// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
 /// scan-build</a>: No bugs found.
 
+#include <algorithm>
 #include <vector>
 #include "gmock/gmock.h"
+#include "MemoryReport.h"
 #include "S3Triangulation.h"
 
 using namespace testing;  // NOLINT
 
 class Triangulated2Sphere : public Test {
  public:
+  /// @returns The points of the finite vertices of **D3**, sorted
+  std::vector<Point> sorted_points(const Delaunay& D3) {
+    std::vector<Point> points;
+    Delaunay::Finite_vertices_iterator vit;
+    for (vit = D3.finite_vertices_begin(); vit != D3.finite_vertices_end();
+         ++vit) {
+      points.push_back(vit->point());
+    }
+    std::sort(points.begin(), points.end());
+    return points;
+  }
+
   Delaunay T;
   const bool output{true};
   const bool no_output{false};
@@ -94,3 +108,75 @@ TEST_F(Triangulated2Sphere, CreatesWithLotsOfSimplices) {
   EXPECT_TRUE(T.tds().is_valid())
     << "Triangulation is invalid.";
 }
+
+TEST_F(Triangulated2Sphere, StreamsInBatches) {
+  auto number_of_simplices = static_cast<const unsigned>(6400);
+  auto number_of_timeslices = static_cast<const unsigned>(16);
+  auto points = 4 * number_of_simplices / number_of_timeslices;
+  auto batch = static_cast<const unsigned>(100);
+  auto seed = static_cast<const unsigned>(7);
+  ASSERT_TRUE(counting_allocations())
+    << "unittests/main.cpp should count allocations.";
+  Memory_report report(true);
+
+  // Compare before fix_timeslices(), whose repairs depend on cell order
+  Delaunay bulk;
+  report.begin_phase("bulk");
+  {
+    CGAL::Random rng(seed);
+    std::vector<Point> vertices;
+    std::vector<unsigned> timevalue;
+    for (auto i = 0u; i < number_of_timeslices; ++i) {
+      make_2_sphere(points, 1.0 + i, no_output, &rng, &vertices, &timevalue);
+    }
+    insert_into_S3(vertices, timevalue, &bulk);
+  }
+  report.end_phase();
+
+  Delaunay streamed;
+  report.begin_phase("streamed");
+  {
+    CGAL::Random rng(seed);
+    stream_into_S3(points, number_of_timeslices, batch, no_output, &rng,
+                   &streamed);
+  }
+  report.end_phase();
+
+  EXPECT_THAT(streamed.number_of_vertices(), Eq(bulk.number_of_vertices()))
+    << "Streamed and bulk universes have different numbers of vertices.";
+
+  EXPECT_TRUE(sorted_points(streamed) == sorted_points(bulk))
+    << "Streamed and bulk universes have different points.";
+
+  EXPECT_THAT(streamed.number_of_finite_cells(),
+              Eq(bulk.number_of_finite_cells()))
+    << "Streamed and bulk universes have different numbers of cells.";
+
+  const auto& bulk_phase = report.phases()[0];
+  const auto& streamed_phase = report.phases()[1];
+  EXPECT_THAT(streamed_phase.peak_heap_bytes, Lt(bulk_phase.peak_heap_bytes))
+    << "Streaming should not need the whole point set at once.";
+
+  CGAL::Random rng(seed);
+  make_streamed_S3_triangulation(number_of_simplices,
+                                 number_of_timeslices,
+                                 batch,
+                                 no_output,
+                                 &rng,
+                                 &T,
+                                 &three_one,
+                                 &two_two,
+                                 &one_three);
+
+  auto generated_number_of_simplices = static_cast<const unsigned>
+    (three_one.size() + two_two.size() + one_three.size());
+
+  EXPECT_TRUE(check_timeslices(&T, no_output))
+    << "Cells do not span exactly 1 timeslice.";
+
+  EXPECT_THAT(T.number_of_finite_cells(), Eq(generated_number_of_simplices))
+    << "The types of (3,1), (2,2), and (1,3) simplices do not equal the total.";
+
+  EXPECT_TRUE(T.is_valid())
+    << "Triangulation is not Delaunay.";
+}
@@ -0,0 +1,85 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests that the flat arrays describe the same triangulation as CGAL.
+
+/// @file TriangulationArraysTest.cpp
+/// @brief Tests for the structure-of-arrays export
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "TriangulationArrays.h"
+#include "SharedUniverse.h"
+
+using namespace testing;  // NOLINT
+
+class TriangulationArraysTest : public Test {
+ protected:
+  virtual void SetUp() {
+    clone_S3_triangulation(number_of_simplices,
+                           number_of_timeslices,
+                           &T,
+                           &three_one,
+                           &two_two,
+                           &one_three);
+    make_triangulation_arrays(T, &arrays);
+  }
+
+  const unsigned number_of_simplices{6400};
+  const unsigned number_of_timeslices{16};
+  Delaunay T;
+  std::vector<Cell_handle> three_one;
+  std::vector<Cell_handle> two_two;
+  std::vector<Cell_handle> one_three;
+  Triangulation_arrays arrays;
+};
+
+TEST_F(TriangulationArraysTest, SizesMatchTheTriangulation) {
+  EXPECT_THAT(arrays.x.size(), Eq(T.number_of_vertices()));
+  EXPECT_THAT(arrays.timeslice.size(), Eq(T.number_of_vertices()));
+  EXPECT_THAT(arrays.cell_type.size(), Eq(T.number_of_finite_cells()));
+  EXPECT_THAT(arrays.cell_vertices.size(),
+              Eq(4 * T.number_of_finite_cells()))
+    << "There should be one vertex per corner of every cell.";
+}
+
+TEST_F(TriangulationArraysTest, CellsReferToTheirVertices) {
+  const auto cells = arrays.cell_type.size();
+  auto c = 0u;
+  Delaunay::Finite_cells_iterator cit;
+  for (cit = T.finite_cells_begin(); cit != T.finite_cells_end();
+       ++cit, ++c) {
+    for (auto k = 0u; k < 4; ++k) {
+      const auto v = arrays.cell_vertices[k * cells + c];
+      ASSERT_THAT(v, Lt(arrays.x.size()));
+      EXPECT_THAT(arrays.x[v], Eq(cit->vertex(k)->point().x()));
+      EXPECT_THAT(arrays.timeslice[v], Eq(cit->vertex(k)->info()))
+        << "Corner " << k << " of cell " << c << " is the wrong vertex.";
+    }
+    EXPECT_THAT(arrays.cell_type[c], Eq(cit->info()));
+  }
+}
+
+TEST_F(TriangulationArraysTest, NeighborsAreMutual) {
+  const auto cells = arrays.cell_type.size();
+  for (auto c = 0u; c < cells; ++c) {
+    for (auto k = 0u; k < 4; ++k) {
+      const auto neighbor = arrays.cell_neighbors[k * cells + c];
+      if (neighbor == NO_NEIGHBOR) continue;
+      auto mutual = false;
+      for (auto m = 0u; m < 4; ++m) {
+        if (arrays.cell_neighbors[m * cells + neighbor] ==
+            static_cast<std::int32_t>(c)) {
+          mutual = true;
+        }
+      }
+      EXPECT_TRUE(mutual) << "Cell " << neighbor
+                          << " should have cell " << c << " as a neighbor.";
+    }
+  }
+}
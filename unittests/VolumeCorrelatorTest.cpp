@@ -0,0 +1,132 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright (c) 2015 Adam Getchell
+///
+/// Tests the FFT, centering, and streaming correlations against direct
+/// computations.
+
+/// @file VolumeCorrelatorTest.cpp
+/// @brief Tests for the volume-volume correlator
+/// @author Adam Getchell
+/// @bug <a href="http://clang-analyzer.llvm.org/scan-build.html">
+/// scan-build</a>: No bugs found.
+
+#include <algorithm>
+#include <complex>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "VolumeCorrelator.h"
+
+using namespace testing;  // NOLINT
+
+class VolumeCorrelatorTest : public Test {
+ protected:
+  /// @returns A random blob-shaped profile, centered anywhere
+  std::vector<double> random_profile() {
+    std::uniform_int_distribution<std::size_t> position(0, T - 1);
+    std::uniform_real_distribution<double> noise(0.0, 10.0);
+    const auto center = position(rng);
+    std::vector<double> profile(T, 0.0);
+    for (auto t = 0u; t < T; ++t) {
+      const auto distance = std::min((t + T - center) % T,
+                                     (center + T - t) % T);
+      profile[t] = (distance < T / 4) ? 100.0 - distance * distance +
+                                        noise(rng) : 0.0;
+    }
+    return profile;
+  }
+
+  const std::size_t T{13};
+  std::mt19937_64 rng{42};
+};
+
+TEST_F(VolumeCorrelatorTest, FftRoundTrips) {
+  std::vector<std::complex<double>> data{1, 2, 3, 4, 0, -1, 5, 2};
+  const auto original = data;
+
+  fft(&data, false);
+  EXPECT_THAT(data[0].real(), DoubleNear(16.0, 1e-9))
+    << "The zero mode should be the sum.";
+  fft(&data, true);
+
+  for (auto i = 0u; i < data.size(); ++i) {
+    EXPECT_THAT(data[i].real() / data.size(),
+                DoubleNear(original[i].real(), 1e-9));
+  }
+}
+
+TEST_F(VolumeCorrelatorTest, CentersTheBlobOnTheMiddleTimeslice) {
+  std::vector<double> profile(T, 0.0);
+  profile[1] = 5.0;
+  profile[2] = 10.0;
+  profile[3] = 5.0;
+  std::vector<double> centered;
+
+  center_profile(profile, &centered);
+
+  EXPECT_THAT(centered[T / 2], Eq(10.0))
+    << "The peak should move to T/2.";
+  EXPECT_THAT(centered[T / 2 - 1], Eq(5.0));
+  EXPECT_THAT(centered[T / 2 + 1], Eq(5.0));
+}
+
+TEST_F(VolumeCorrelatorTest, MatchesDirectComputation) {
+  Volume_correlator correlator(T, true);
+  std::vector<std::vector<double>> centered;
+  for (auto m = 0; m < 50; ++m) {
+    const auto profile = random_profile();
+    correlator.add(profile);
+    std::vector<double> c;
+    center_profile(profile, &c);
+    centered.push_back(c);
+  }
+  const auto n = static_cast<double>(centered.size());
+
+  std::vector<double> mean(T, 0.0);
+  for (const auto& c : centered) {
+    for (auto t = 0u; t < T; ++t) mean[t] += c[t] / n;
+  }
+  const auto covariance = correlator.covariance();
+  for (auto t = 0u; t < T; ++t) {
+    EXPECT_THAT(correlator.mean_profile()[t], DoubleNear(mean[t], 1e-9));
+    for (auto u = 0u; u < T; ++u) {
+      auto sum = 0.0;
+      for (const auto& c : centered) {
+        sum += (c[t] - mean[t]) * (c[u] - mean[u]);
+      }
+      EXPECT_THAT(covariance[t * T + u], DoubleNear(sum / (n - 1), 1e-6))
+        << "Covariance of timeslices " << t << " and " << u << " is wrong.";
+    }
+  }
+
+  const auto connected = correlator.correlator();
+  for (auto d = 0u; d < T; ++d) {
+    auto G = 0.0;
+    auto disconnected = 0.0;
+    for (auto t = 0u; t < T; ++t) {
+      for (const auto& c : centered) G += c[t] * c[(t + d) % T] / n / T;
+      disconnected += mean[t] * mean[(t + d) % T] / T;
+    }
+    EXPECT_THAT(connected[d], DoubleNear(G - disconnected, 1e-6))
+      << "The correlator at lag " << d << " is wrong.";
+  }
+}
+
+TEST_F(VolumeCorrelatorTest, DiagonalOnlyGivesTheSameVariance) {
+  Volume_correlator full(T, true);
+  Volume_correlator diagonal(T, false);
+  for (auto m = 0; m < 20; ++m) {
+    const auto profile = random_profile();
+    full.add(profile);
+    diagonal.add(profile);
+  }
+
+  EXPECT_THAT(diagonal.covariance(), IsEmpty());
+  const auto expected = full.variance_profile();
+  const auto actual = diagonal.variance_profile();
+  for (auto t = 0u; t < T; ++t) {
+    EXPECT_THAT(actual[t], DoubleNear(expected[t], 1e-9));
+  }
+}
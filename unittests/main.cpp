@@ -10,6 +10,10 @@
 /// scan-build</a>: No bugs found.
 
 #include "gmock/gmock.h"
+#include "MemoryReport.h"
+
+// Lets tests see the heap use of each Memory_report phase
+CDT_COUNT_ALLOCATIONS()
 
 int main(int argc, char** argv) {
   testing::InitGoogleMock(&argc, argv);